@@ -41,6 +41,18 @@
 // Define if you have the munmap function.
 #cmakedefine EXV_HAVE_MUNMAP
 
+// Define if you have the pread function.
+#cmakedefine EXV_HAVE_PREAD
+
+// Define if you have the copy_file_range function.
+#cmakedefine EXV_HAVE_COPY_FILE_RANGE
+
+// Define if you have the sendfile function in <sys/sendfile.h>.
+#cmakedefine EXV_HAVE_SENDFILE
+
+// Define if you have the FICLONE ioctl in <linux/fs.h>.
+#cmakedefine EXV_HAVE_FICLONE
+
 /* Define if you have the <libproc.h> header file. */
 #cmakedefine EXV_HAVE_LIBPROC_H
 
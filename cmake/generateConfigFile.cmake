@@ -24,8 +24,12 @@ set(EXV_HAVE_LIBZ        ${ZLIB_FOUND})
 set(EXV_UNICODE_PATH     ${EXIV2_ENABLE_WIN_UNICODE})
 
 check_cxx_symbol_exists(mmap        sys/mman.h     EXV_HAVE_MMAP )
+check_cxx_symbol_exists(pread       unistd.h       EXV_HAVE_PREAD )
 check_cxx_symbol_exists(munmap      sys/mman.h     EXV_HAVE_MUNMAP )
 check_cxx_symbol_exists(strerror_r  string.h       EXV_HAVE_STRERROR_R )
+check_cxx_symbol_exists(copy_file_range unistd.h   EXV_HAVE_COPY_FILE_RANGE )
+check_cxx_symbol_exists(sendfile    sys/sendfile.h EXV_HAVE_SENDFILE )
+check_cxx_symbol_exists(FICLONE     linux/fs.h     EXV_HAVE_FICLONE )
 
 check_cxx_source_compiles( "
 #include <string.h>
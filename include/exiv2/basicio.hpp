@@ -31,6 +31,7 @@
 #include "types.hpp"
 
 // + standard includes
+#include <cstdio>
 #include <memory>
 
 // The way to handle data from stdin or data uri path. If EXV_XPATH_MEMIO = 1,
@@ -154,6 +155,24 @@ namespace Exiv2 {
           @param err Error code to use if an exception is thrown.
          */
         void readOrThrow(byte* buf, long rcount, ErrorCode err);
+        /*!
+          @brief Read data from the IO source at an absolute position. The
+              current IO position is neither used nor changed.
+
+          The default implementation seeks, reads and restores the IO
+          position. FileIo and MemIo neither use nor change the IO position,
+          so that several threads can read from one open instance.
+
+          @param offset Position of the first byte to read.
+          @param buf Pointer to a block of memory into which the read data
+              is stored. The memory block must be at least \em rcount bytes
+              long.
+          @param rcount Maximum number of bytes to read. Fewer bytes may be
+              read if \em rcount bytes are not available.
+          @return Number of bytes read from IO source successfully;<BR>
+              0 if failure;
+         */
+        virtual long readAt(int64_t offset, byte* buf, long rcount);
         /*!
           @brief Read one byte from the IO source. Current IO position is
               advanced by one byte.
@@ -409,6 +428,17 @@ namespace Exiv2 {
                  0 if failure;
          */
         long read(byte* buf, long rcount) override;
+        /*!
+          @brief Read data from the file at an absolute position, without
+              using or changing the file position.
+
+          Where available, the data is read with a positional read (pread)
+          from the file descriptor, bypassing the stdio buffer. Data which
+          was written and is still in the stdio buffer is flushed first.
+          Several threads can read from the same open file concurrently, as
+          long as nobody writes to it.
+         */
+        long readAt(int64_t offset, byte* buf, long rcount) override;
         /*!
           @brief Read one byte from the file. The file position is
               advanced by one byte.
@@ -519,6 +549,7 @@ namespace Exiv2 {
         FileIo& operator=(const FileIo& rhs) = delete;
 
     private:
+        friend class TempIo;
         // Pimpl idiom
         class Impl;
         std::unique_ptr<Impl> p_;
@@ -624,6 +655,8 @@ namespace Exiv2 {
                  0 if failure;
          */
         long read(byte* buf, long rcount) override;
+        //! Copy data from an absolute position of the memory block. The IO position is not changed.
+        long readAt(int64_t offset, byte* buf, long rcount) override;
         /*!
           @brief Read one byte from the memory block. The IO position is
               advanced by one byte.
@@ -715,6 +748,134 @@ namespace Exiv2 {
 
     }; // class MemIo
 
+    /*!
+      @brief Provides binary IO for temporary data, like the new contents of
+          an image that a writer builds before it is transferred to the
+          image's own IO source.
+
+      The data is kept in memory as long as it is smaller than a threshold.
+      When a write makes it grow beyond the threshold, the data is moved to
+      an anonymous temporary file, which is removed from the file system as
+      soon as it is created. The file is created in the directory of the
+      target if that is a FileIo, so that the data does not leave the file
+      system of the target, else in the system's temporary directory. If no
+      temporary file can be created, the data stays in memory.
+
+      Unlike FileIo, closing a TempIo instance does not discard the data;
+      open() and close() only reset the IO position, like for MemIo.
+     */
+    class EXIV2API TempIo : public BasicIo {
+    public:
+        //! @name Creators
+        //@{
+        /*!
+          @brief Constructor for temporary data which is meant to replace
+              the contents of \em target, using the default threshold.
+          @param target The IO source the data will be transferred to. It is
+              only used to find a directory for the temporary file.
+         */
+        explicit TempIo(const BasicIo& target);
+        /*!
+          @brief Constructor for temporary data which is meant to replace
+              the contents of \em target.
+          @param target The IO source the data will be transferred to.
+          @param threshold Size in bytes above which the data is moved to a
+              temporary file.
+         */
+        TempIo(const BasicIo& target, size_t threshold);
+        //! Destructor. Releases the memory and removes the temporary file.
+        ~TempIo() override;
+        //@}
+
+        //! @name Manipulators
+        //@{
+        //! Reset the IO position to the start. The data is kept.
+        int open() override;
+        //! Does nothing on TempIo objects.
+        int close() override;
+        /*!
+          @brief Write data at the current IO position, moving the data to
+              a temporary file if its size grows beyond the threshold.
+          @return Number of bytes written successfully;<BR>
+                 0 if failure;
+         */
+        long write(const byte* data, long wcount) override;
+        //! Write the data read from \em src, see write(const byte*, long).
+        long write(BasicIo& src) override;
+        int putb(byte data) override;
+        DataBuf read(long rcount) override;
+        long read(byte* buf, long rcount) override;
+        int getb() override;
+        /*!
+          @brief Clear the data and then transfer the data from the \em src
+              BasicIo object into this object.
+          @throw Error In case of failure
+         */
+        void transfer(BasicIo& src) override;
+        int seek(int64_t offset, Position pos) override;
+        /*!
+          @brief Allow direct access to the data. If the data was moved to a
+              temporary file, it is read into memory and, if \em isWriteable
+              is true, written back by munmap().
+         */
+        byte* mmap(bool isWriteable = false) override;
+        int munmap() override;
+        //@}
+
+        //! @name Accessors
+        //@{
+        long tell() const override;
+        size_t size() const override;
+        //! Always returns true
+        bool isopen() const override;
+        int error() const override;
+        bool eof() const override;
+        //! Returns a dummy path, indicating that temporary data is used
+        std::string path() const override;
+#ifdef EXV_UNICODE_PATH
+        /*
+          @brief Like path() but returns a unicode dummy path in an std::wstring.
+          @note This function is only available on Windows.
+         */
+        virtual std::wstring wpath() const;
+#endif
+        void populateFakeData() override;
+        //! Returns true if the data was moved to a temporary file
+        bool isSpilled() const;
+        //@}
+
+        //! @name Configuration
+        //@{
+        //! Return the threshold used by TempIo(const BasicIo&)
+        static size_t defaultThreshold();
+        /*!
+          @brief Set the threshold used by TempIo(const BasicIo&). It applies
+              to all writers which prepare the new contents of an image in a
+              TempIo; 0 always uses a temporary file.
+         */
+        static void setDefaultThreshold(size_t threshold);
+        //@}
+
+        // NOT IMPLEMENTED
+        //! Copy constructor
+        TempIo(TempIo& rhs) = delete;
+        //! Assignment operator
+        TempIo& operator=(const TempIo& rhs) = delete;
+
+    private:
+        friend class FileIo;
+        friend class MemIo;
+        //! Return the data while it is kept in memory, else nullptr
+        MemIo* memIo();
+        //! Return the temporary file with all data written, else nullptr
+        std::FILE* file();
+
+        // Pimpl idiom
+        class Impl;
+        std::unique_ptr<Impl> p_;
+
+    }; // class TempIo
+
     /*!
       @brief Provides binary IO for the data from stdin and data uri path.
      */
@@ -925,6 +1086,21 @@ namespace Exiv2 {
 
        int seek(int64_t offset, Position pos) override;
 
+       /*!
+         @brief Enable a persistent on-disk cache for the blocks of the remote file.
+
+           Blocks fetched from the server are written to \em dir and are read from
+           there by later instances opening the same URL, as long as the server
+           reports the same ETag, Last-Modified date and size. Files for which the
+           server reports neither ETag nor Last-Modified are not cached. The blocks
+           of the least recently used files are removed when the cache grows beyond
+           \em maxBytes. Must be called before open(). If it is not called, the cache directory
+           is taken from the environment variable EXIV2_REMOTE_CACHE, if set.
+         @param dir Directory for the cache files. It is created if needed.
+         @param maxBytes Upper bound for the total size of the cache directory.
+        */
+       void setBlockCache(const std::string& dir, size_t maxBytes = 64 * 1024 * 1024);
+
        /*!
          @brief Not support
          @return NULL
@@ -957,6 +1133,10 @@ namespace Exiv2 {
        bool eof() const override;
        //!Returns the URL of the file.
        std::string path() const override;
+       //!Returns the number of blocks read from the on-disk block cache.
+       size_t cacheHits() const;
+       //!Returns the number of blocks which were not found in the on-disk block cache.
+       size_t cacheMisses() const;
 #ifdef EXV_UNICODE_PATH
        /*
          @brief Like path() but returns a unicode URL path in an std::wstring.
@@ -50,6 +50,15 @@ namespace Exiv2
         std::string toString() const;
     };  // class Iloc
 
+    //! Position of a box in a BMFF file, see BmffImage::boxes()
+    struct BmffBox
+    {
+        uint32_t type_;    //!< Box type, e.g. 0x6d657461 for "meta"
+        uint64_t offset_;  //!< Offset of the box header in the file
+        uint64_t length_;  //!< Length of the box, including its header
+        int32_t parent_;   //!< Index of the enclosing box in BmffImage::boxes(), -1 at the top level
+    };
+
     // *****************************************************************************
     // class definitions
 
@@ -142,6 +151,13 @@ namespace Exiv2
         std::string mimeType() const override /* override */;
         int pixelWidth() const override;
         int pixelHeight() const override;
+        /*!
+          @brief Boxes found by readMetadata(), in file order.
+
+          The payload of a box is only read if it contains metadata or
+          other boxes. Large payloads like "mdat" are skipped.
+         */
+        const std::vector<BmffBox>& boxes() const { return boxes_; }
         //@}
         
         Exiv2::ByteOrder endian_{Exiv2::bigEndian};
@@ -170,6 +186,8 @@ namespace Exiv2
         uint16_t                 exifID_{0xffff};
         uint16_t                 xmpID_{0};
         std::map<uint32_t, Iloc> ilocs_;
+        std::vector<BmffBox>     boxes_;
+        int32_t                  parentBox_{-1};
         bool                     bReadMetadata_{false};
         //@}
 
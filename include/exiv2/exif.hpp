@@ -35,7 +35,9 @@
 #include "tags.hpp"
 
 // + standard includes
+#include <atomic>
 #include <list>
+#include <map>
 
 // *****************************************************************************
 // namespace extensions
@@ -55,6 +57,13 @@ namespace Exiv2 {
     /*!
       @brief An Exif metadatum, consisting of an ExifKey and a Value and
              methods to manipulate these.
+
+      To keep large collections of Exif metadata small, the key is held as
+      tag, IFD id and a pointer to the static tag info, and numeric, byte and
+      ASCII values with up to 8 bytes of data are held inline instead of in a
+      Value object on the heap. The Value object of such a datum is only
+      created when value() is called. This is safe to do from several threads
+      reading the same datum.
      */
     class EXIV2API Exifdatum : public Metadatum {
         template<typename T> friend Exifdatum& setValue(Exifdatum&, const T&);
@@ -75,14 +84,18 @@ namespace Exiv2 {
         explicit Exifdatum(const ExifKey& key, const Value* pValue = nullptr);
         //! Copy constructor
         Exifdatum(const Exifdatum& rhs);
+        //! Move constructor, takes over the key and value of \em rhs
+        Exifdatum(Exifdatum&& rhs) noexcept;
         //! Destructor
-        ~Exifdatum() override = default;
+        ~Exifdatum() override;
         //@}
 
         //! @name Manipulators
         //@{
         //! Assignment operator
         Exifdatum& operator=(const Exifdatum& rhs);
+        //! Move assignment operator, takes over the key and value of \em rhs
+        Exifdatum& operator=(Exifdatum&& rhs) noexcept;
         /*!
           @brief Assign \em value to the %Exifdatum. The type of the new Value
                  is set to UShortValue.
@@ -163,6 +176,8 @@ namespace Exiv2 {
         const char* ifdName() const;
         //! Return the index (unique id of this key within the original IFD)
         int idx() const;
+        //! Return the tag info of the key. (Do not use, this is meant for library internal use.)
+        const TagInfo* tagInfo() const;
         /*!
           @brief Write value to a data buffer and return the number
                  of bytes written.
@@ -212,9 +227,36 @@ namespace Exiv2 {
         //@}
 
     private:
+        //! @name Manipulators
+        //@{
+        //! Hold the components of \em value inline if it is small enough, return true if it is
+        bool setInline(const Value& value);
+        //! Delete the Value object made from the components held inline
+        void clearValueCache();
+        //! Return the value held inline as Value object and stop holding it inline
+        Value::UniquePtr takeInlineValue();
+        //@}
+
+        //! @name Accessors
+        //@{
+        //! Return the key of the %Exifdatum as ExifKey
+        ExifKey exifKey() const;
+        //! Return a new Value with the components held inline
+        Value::UniquePtr inlineValue() const;
+        //! Return the value, made once from the components held inline if needed, or nullptr if there is none
+        const Value* valuePointer() const;
+        //@}
+
         // DATA
-        ExifKey::UniquePtr key_;                  //!< Key
-        Value::UniquePtr   value_;                //!< Value
+        const TagInfo*   tagInfo_{nullptr};       //!< Tag info of the key
+        uint16_t         tag_{0xffff};            //!< Tag of the key
+        uint16_t         inlineCount_{0};         //!< Number of components held inline
+        int              ifdId_{0};               //!< IFD id of the key
+        int              idx_{0};                 //!< Index of the key
+        TypeId           inlineType_{invalidTypeId}; //!< Type of the value held inline, invalidTypeId if none
+        Value::UniquePtr value_;                  //!< Value, if it is not held inline
+        mutable std::atomic<Value*> valueCache_{nullptr}; //!< Value made from the components held inline
+        byte             inline_[8]{};            //!< Components of a small value, in little endian byte order
 
     }; // class Exifdatum
 
@@ -464,6 +506,12 @@ namespace Exiv2 {
           @throw Error if the makernote cannot be created
          */
         void add(const Exifdatum& exifdatum);
+        /*!
+          @brief Add the \em exifdatum to the Exif metadata, taking over its
+                 key and value without copying them. No duplicate checks are
+                 performed.
+         */
+        void add(Exifdatum&& exifdatum);
         /*!
           @brief Delete the Exifdatum at iterator position \em pos, return the
                  position of the next exifdatum. Note that iterators into
@@ -520,6 +568,50 @@ namespace Exiv2 {
 
     }; // class ExifData
 
+    /*!
+      @brief Scope of one print pass over an ExifData.
+
+      Many print functions depend on other tags, for example the camera model
+      or the lens data, and look them up in the ExifData for every datum they
+      print. While an %ExifPrintContext exists, these lookups on the same
+      %ExifData are remembered, so each key is searched only once. Create one
+      around a loop which prints the metadata:
+
+      @code
+      Exiv2::ExifPrintContext context(exifData);
+      for (auto&& md : exifData) {
+          std::cout << md.key() << " " << md.print(&exifData) << "\n";
+      }
+      @endcode
+
+      The ExifData must not be modified while the context exists. Contexts
+      belong to the thread which created them and can be nested.
+     */
+    class EXIV2API ExifPrintContext {
+    public:
+        //! Start a print pass over \em exifData in the current thread
+        explicit ExifPrintContext(const ExifData& exifData);
+        //! End the print pass
+        ~ExifPrintContext();
+        ExifPrintContext(const ExifPrintContext&) = delete;
+        ExifPrintContext& operator=(const ExifPrintContext&) = delete;
+
+        /*!
+          @brief Find the first Exifdatum with the given \em key in \em exifData,
+                 like ExifData::findKey(). The result is remembered if a print
+                 context for \em exifData exists in the current thread.
+
+          @throw Error if the key is invalid
+         */
+        static ExifData::const_iterator findKey(const ExifData& exifData, const std::string& key);
+
+    private:
+        const ExifData& exifData_;                            //!< The metadata printed
+        const ExifPrintContext* previous_;                    //!< Enclosing context of the thread
+        mutable std::map<std::string, ExifData::const_iterator> found_; //!< Results of findKey()
+
+    }; // class ExifPrintContext
+
     /*!
       @brief Stateless parser class for Exif data. Images use this class to
              decode and encode binary Exif data.
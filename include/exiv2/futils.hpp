@@ -32,7 +32,8 @@ namespace Exiv2
     enum EnVar
     {
         envHTTPPOST = 0,
-        envTIMEOUT = 1
+        envTIMEOUT = 1,
+        envREMOTECACHE = 2
     };
     //! the collection of protocols.
     enum Protocol
@@ -58,6 +58,23 @@ namespace Exiv2 {
     //! List of native previews. This is meant to be used only by the PreviewManager.
     typedef std::vector<NativePreview> NativePreviewList;
 
+    /*!
+      @brief Basic properties of an image, as determined from its headers by
+             ImageFactory::probe(). Properties which cannot be determined from
+             the headers of a format are left at their default values.
+     */
+    struct ImageProbe {
+        int imageType_{ImageType::none};        //!< %Image type
+        std::string mimeType_;                  //!< MIME type
+        uint32_t pixelWidth_{0};                //!< Width in pixels, 0 if not known
+        uint32_t pixelHeight_{0};               //!< Height in pixels, 0 if not known
+        bool hasExif_{false};                   //!< The image contains Exif metadata
+        bool hasIptc_{false};                   //!< The image contains IPTC metadata
+        bool hasXmp_{false};                    //!< The image contains XMP metadata
+        bool hasIccProfile_{false};             //!< The image contains an ICC profile
+        uint64_t bytesRead_{0};                 //!< Number of bytes read from the image
+    };
+
     /*!
       @brief Options for printStructure
      */
@@ -467,6 +484,25 @@ namespace Exiv2 {
         bool writeXmpFromPacket() const;
         //! Return list of native previews. This is meant to be used only by the PreviewManager.
         const NativePreviewList& nativePreviews() const;
+        /*!
+          @brief Return the metadata which changed since it was last read from
+             or written to the image, as a bitmap of MetadataId values.
+
+          Images which track changes (JPEG, PNG and TIFF) mark their metadata
+          as clean at the end of readMetadata() and writeMetadata() and skip
+          writing if nothing changed. The metadata is compared by content, so
+          it does not matter how it was modified. For other images, or before
+          the metadata was read, all supported metadata is reported as
+          changed.
+         */
+        int changedMetadata() const;
+        /*!
+          @brief Return the metadata which the last call to writeMetadata()
+             encoded, as a bitmap of MetadataId values. This is mdNone if the
+             write was skipped because nothing changed. Only set by images
+             which track changes, see changedMetadata().
+         */
+        int writtenMetadata() const;
         //@}
 
         //! set type support for this image format
@@ -508,7 +544,29 @@ namespace Exiv2 {
         //! Return tag type for given tag id.
         static const char* typeName(uint16_t tag);
 
+        /*!
+          @brief Record the current state of the metadata as unchanged. Called
+             at the end of readMetadata() and writeMetadata() by images which
+             track changes, see changedMetadata().
+
+          The state of a kind of metadata is only hashed when it is handed out
+          by reference or changed through a setter for the first time, so
+          metadata which is only read costs nothing to track. Metadata which
+          was handed out by reference before is hashed right away, as it can
+          be changed through that reference at any time.
+         */
+        void setMetadataClean();
+        //! Set the metadata reported by writtenMetadata().
+        void setWrittenMetadata(int metadata);
+
     private:
+        //! Return a hash of the metadata \em metadataId, to detect changes.
+        uint64_t metadataHash(MetadataId metadataId) const;
+        //! Hash the clean state of \em metadata, a bitmap of MetadataId values, if it was not hashed yet.
+        void hashCleanMetadata(int metadata);
+        //! Hash the clean state of \em metadata before it is handed out by reference.
+        void exposeMetadata(int metadata);
+
         // DATA
         int               imageType_;         //!< Image type
         uint16_t          supportedMetadata_; //!< Bitmap with all supported metadata types
@@ -517,6 +575,12 @@ namespace Exiv2 {
 
         std::map<int,std::string> tags_;      //!< Map of tags
         bool                      init_;      //!< Flag marking if map of tags needs to be initialized
+        bool                      metadataClean_;   //!< True once setMetadataClean() was called
+        std::map<int, uint64_t>   cleanHashes_;     //!< Hashes of the clean state of the metadata
+        int                       unhashedMetadata_;//!< Clean metadata which was not hashed yet, it is unchanged
+        int                       exposedMetadata_; //!< Metadata which was handed out by reference
+        uint64_t                  cleanNsRegistryHash_; //!< Hash of the custom XMP namespaces of the clean metadata
+        int                       writtenMetadata_; //!< Metadata encoded by the last writeMetadata()
 
     }; // class Image
 
@@ -677,6 +741,21 @@ namespace Exiv2 {
           @return %Image type or Image::none if the type is not recognized.
          */
         static int getType(BasicIo& io);
+        /*!
+          @brief Determine the type, MIME type, pixel dimensions and the kinds
+              of metadata present in an image, without decoding the metadata.
+
+          Only the headers of the image are read: the structure of the file is
+          walked until the answer is known, skipping the image data and the
+          content of the metadata blocks. The passed in \em io instance is
+          (re)opened by this method.
+
+          @param io A BasicIo instance that provides image data.
+          @return The properties of the image. The image type is
+              ImageType::none if it is not recognized.
+          @throw Error If opening \em io fails.
+         */
+        static ImageProbe probe(BasicIo& io);
         /*!
           @brief Returns the access mode or supported metadata functions for an
               image type and a metadata type.
@@ -67,6 +67,8 @@ namespace Exiv2 {
         explicit Iptcdatum(const IptcKey& key, const Value* pValue = nullptr);
         //! Copy constructor
         Iptcdatum(const Iptcdatum& rhs);
+        //! Move constructor, takes over the key and value of \em rhs
+        Iptcdatum(Iptcdatum&& rhs) noexcept;
         //! Destructor
         ~Iptcdatum() override = default;
         //@}
@@ -75,6 +77,8 @@ namespace Exiv2 {
         //@{
         //! Assignment operator
         Iptcdatum& operator=(const Iptcdatum& rhs);
+        //! Move assignment operator, takes over the key and value of \em rhs
+        Iptcdatum& operator=(Iptcdatum&& rhs) noexcept;
         /*!
           @brief Assign \em value to the %Iptcdatum. The type of the new Value
                  is set to UShortValue.
@@ -202,6 +206,14 @@ namespace Exiv2 {
                  6 if the dataset already exists and is not repeatable;<BR>
          */
         int add(const Iptcdatum& iptcdatum);
+        /*!
+          @brief Add the Iptcdatum to the IPTC metadata, taking over its key
+                 and value without copying them. A check for non-repeatable
+                 datasets is performed.
+          @return 0 if successful;<BR>
+                 6 if the dataset already exists and is not repeatable;<BR>
+         */
+        int add(Iptcdatum&& iptcdatum);
         /*!
           @brief Delete the Iptcdatum at iterator position pos, return the
                  position of the next Iptcdatum. Note that iterators into
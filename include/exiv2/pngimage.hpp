@@ -31,6 +31,11 @@
 namespace Exiv2
 {
 
+    namespace Internal {
+        class PngChunk;
+        class PngChunkIndex;
+    }
+
 // *****************************************************************************
 // class definitions
 
@@ -64,6 +69,8 @@ namespace Exiv2
               or if a new file should be created (true).
          */
         PngImage(BasicIo::UniquePtr io, bool create);
+        //! Destructor
+        ~PngImage() override;
         //@}
 
         //! @name Manipulators
@@ -98,12 +105,17 @@ namespace Exiv2
                 writing all buffered metadata to the provided BasicIo.
           @throw Error on input-output errors or when the image data is not valid.
           @param oIo BasicIo instance to write to (a temporary location).
-
+          @param changed Metadata which changed, see changedMetadata().
          */
-        void doWriteMetadata(BasicIo& outIo);
+        void doWriteMetadata(BasicIo& outIo, int changed);
         //@}
 
+        //! The chunk decoder fills in the metadata directly, reading it doesn't hand it out
+        friend class Internal::PngChunk;
+
         std::string profileName_;
+        std::unique_ptr<Internal::PngChunkIndex> chunkIndex_; //!< Chunks found by readMetadata()
+        DataBuf iccCompressed_; //!< Compressed ICC profile, written again while the profile doesn't change
 
     }; // class PngImage
 
@@ -30,6 +30,10 @@
 // namespace extensions
 namespace Exiv2 {
 
+    namespace Internal {
+        class PsdResourceIndex;
+    }
+
 // *****************************************************************************
 // class definitions
 
@@ -66,6 +70,8 @@ namespace Exiv2 {
               method to get a temporary reference.
          */
         explicit PsdImage(BasicIo::UniquePtr io);
+        //! Destructor
+        ~PsdImage() override;
         //@}
 
         //! @name Manipulators
@@ -100,12 +106,18 @@ namespace Exiv2 {
         void readResourceBlock(uint16_t resourceId, uint32_t resourceSize);
         /*!
           @brief Provides the main implementation of writeMetadata() by
-                writing all buffered metadata to the provided BasicIo.
-          @param oIo BasicIo instance to write to (a temporary location).
-
-          @return 4 if opening or writing to the associated BasicIo fails
+                writing the image with the resource blocks of \em index to
+                the provided BasicIo. Only the IPTC, Exif and XMP resources
+                of the \em changed metadata are encoded, all other data is
+                copied.
+          @param index Resource blocks of the image.
+          @param changed Metadata to write, a combination of MetadataId.
+          @param outIo BasicIo instance to write to (a temporary location).
+          @throw Error if reading the image or writing to \em outIo fails.
          */
-        void doWriteMetadata(BasicIo& outIo);
+        void doWriteMetadata(const Internal::PsdResourceIndex& index, int changed, BasicIo& outIo);
+        //! Write the resource block \em resourceId for the current metadata to \em out, return its size.
+        uint32_t writeResource(uint16_t resourceId, BasicIo& out);
         uint32_t writeExifData(const ExifData& exifData, BasicIo& out);
         //@}
 
@@ -115,6 +127,8 @@ namespace Exiv2 {
         uint32_t writeXmpData(const XmpData& xmpData, BasicIo& out) const;
         //@}
 
+        std::unique_ptr<Internal::PsdResourceIndex> resourceIndex_; //!< Resource blocks found by readMetadata()
+
     }; // class PsdImage
 
 // *****************************************************************************
@@ -158,6 +158,18 @@ namespace Exiv2 {
                  and group name.
          */
         explicit ExifKey(const TagInfo& ti);
+        /*!
+          @brief Constructor to create an Exif key from the tag number, IFD id
+                 and tag info. No strings are built, the key and group name
+                 are only made when they are requested. (Do not use, this is
+                 meant for library internal use.)
+          @param tag The tag value
+          @param ifdId The IFD id of the group
+          @param tagInfo The tag info of \em tag in the IFD, or 0 to look it up
+          @throw Error if the key cannot be constructed from the tag number
+                 and IFD id.
+         */
+        ExifKey(uint16_t tag, int ifdId, const TagInfo* tagInfo);
 
         //! Copy constructor
         ExifKey(const ExifKey& rhs);
@@ -189,6 +201,8 @@ namespace Exiv2 {
         std::string tagDesc() const;        // Todo: should be in the base class
         //! Return the default type id for this tag.
         TypeId defaultTypeId() const;       // Todo: should be in the base class
+        //! Return the tag info of the key. (Do not use, this is meant for library internal use.)
+        const TagInfo* tagInfo() const;
 
         UniquePtr clone() const;
         //! Return the index (unique id of this key within the original Exif data, 0 if not set)
@@ -31,6 +31,10 @@
 // namespace extensions
 namespace Exiv2 {
 
+    namespace Internal {
+        class TiffParsedTree;
+    }
+
 // *****************************************************************************
 // class definitions
 
@@ -69,6 +73,8 @@ namespace Exiv2 {
               or if a new file should be created (true).
          */
         TiffImage(BasicIo::UniquePtr io, bool create);
+        //! Destructor
+        ~TiffImage() override;
         //@}
 
         //! @name Manipulators
@@ -89,6 +95,13 @@ namespace Exiv2 {
               Calling this function will throw an Error(kerInvalidSettingForImage).
          */
         void setComment(const std::string& comment) override;
+        /*!
+          @brief Keep the TIFF structure parsed by readMetadata() to be reused
+              by the next writeMetadata(), instead of parsing the file again.
+              The structure is only used if the size and modification time
+              of the file are unchanged. Default is false.
+         */
+        void retainParsedTree(bool retain);
         //@}
 
         //! @name Accessors
@@ -118,6 +131,8 @@ namespace Exiv2 {
         mutable std::string mimeType_;         //!< The MIME type
         mutable int pixelWidthPrimary_;        //!< Width of the primary image in pixels
         mutable int pixelHeightPrimary_;       //!< Height of the primary image in pixels
+        bool retainParsedTree_;                //!< Keep the parsed tree for writeMetadata()
+        std::unique_ptr<Internal::TiffParsedTree> parsedTree_; //!< Tree from readMetadata(), if kept
 
     }; // class TiffImage
 
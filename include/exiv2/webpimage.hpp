@@ -30,6 +30,10 @@
 // namespace extensions
 namespace Exiv2 {
 
+    namespace Internal {
+        class WebPChunkIndex;
+    }
+
 // *****************************************************************************
 // class definitions
 
@@ -58,6 +62,8 @@ namespace Exiv2 {
               method to get a temporary reference.
          */
         explicit WebPImage(BasicIo::UniquePtr io);
+        //! Destructor
+        ~WebPImage() override;
         //@}
 
         //! @name Manipulators
@@ -85,13 +91,34 @@ namespace Exiv2 {
         //@}
 
     private:
-        void doWriteMetadata(BasicIo& outIo);
+        /*!
+          @brief Write the image with the chunks of \em index, the Exif data
+                 \em exif and the XMP packet \em xmp to \em outIo.
+         */
+        void doWriteMetadata(const Internal::WebPChunkIndex& index, BasicIo& outIo,
+                             const Blob& exif, const std::string& xmp);
+        /*!
+          @brief Replace the EXIF and XMP chunks of the \em changed metadata in
+                 place, if the new chunks fit where the old ones are, or at the
+                 end of the image.
+          @return false if the image must be rewritten instead.
+         */
+        bool writeInPlace(const Internal::WebPChunkIndex& index, int changed,
+                          const Blob& exif, const std::string& xmp);
+        /*!
+          @brief Check the image chunks of \em index and find the features a
+                 VP8X chunk, if it must be added, has to describe.
+          @throw Error if an image chunk is corrupted.
+         */
+        void inspectChunks(const Internal::WebPChunkIndex& index, bool& has_vp8x,
+                           bool& has_alpha, int& width, int& height);
         //! @name NOT Implemented
         //@{
         static long getHeaderOffset(const byte* data, long data_size, const byte* header, long header_size);
         static bool equalsWebPTag(Exiv2::DataBuf& buf, const char* str);
+        static bool equalsWebPTag(const std::string& type, const char* str);
         void debugPrintHex(byte *data, long size);
-        void decodeChunks(long filesize);
+        void decodeChunks(Internal::WebPChunkIndex& index);
         void inject_VP8X(BasicIo& iIo, bool has_xmp, bool has_exif,
                          bool has_alpha, bool has_icc, int width,
                          int height);
@@ -110,6 +137,9 @@ namespace Exiv2 {
         static const char* const WEBP_CHUNK_HEADER_ICCP;
         static const char* const WEBP_CHUNK_HEADER_EXIF;
         static const char* const WEBP_CHUNK_HEADER_XMP;
+        static const char* const WEBP_CHUNK_HEADER_JUNK;
+
+        std::unique_ptr<Internal::WebPChunkIndex> chunkIndex_; //!< Chunks found by readMetadata()
 
     }; //Class WebPImage
 
@@ -61,6 +61,8 @@ namespace Exiv2 {
         explicit Xmpdatum(const XmpKey& key, const Value* pValue = nullptr);
         //! Copy constructor
         Xmpdatum(const Xmpdatum& rhs);
+        //! Move constructor, takes over the key and value of \em rhs
+        Xmpdatum(Xmpdatum&& rhs) noexcept;
         //! Destructor
         ~Xmpdatum() override;
         //@}
@@ -69,6 +71,8 @@ namespace Exiv2 {
         //@{
         //! Assignment operator
         Xmpdatum& operator=(const Xmpdatum& rhs);
+        //! Move assignment operator, takes over the key and value of \em rhs
+        Xmpdatum& operator=(Xmpdatum&& rhs) noexcept;
         /*!
           @brief Assign std::string \em value to the %Xmpdatum.
                  Calls setValue(const std::string&).
@@ -194,6 +198,12 @@ namespace Exiv2 {
           @return 0 if successful.
          */
         int add(const Xmpdatum& xmpdatum);
+        /*!
+          @brief Add the Xmpdatum to the XMP metadata, taking over its key
+                 and value without copying them.
+          @return 0 if successful.
+         */
+        int add(Xmpdatum&& xmpdatum);
         /*
         @brief Delete the Xmpdatum at iterator position pos, return the
                 position of the next Xmpdatum.
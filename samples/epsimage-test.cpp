@@ -0,0 +1,113 @@
+// ***************************************************************** -*- C++ -*-
+// epsimage-test.cpp
+// Time to read and write the XMP packet of a large synthetic EPS file
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <exiv2/exiv2.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+using namespace Exiv2;
+
+namespace {
+    //! Run \em action and print how long it took
+    void measure(const std::string& name, size_t size, const std::function<void()>& action)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        action();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << name << ": " << elapsed.count() * 1000 << " ms, " << size / (1024.0 * 1024.0) / elapsed.count()
+                  << " MiB/s\n";
+    }
+}  // namespace
+
+int main(int argc, char* const argv[])
+try {
+    Exiv2::XmpParser::initialize();
+    ::atexit(Exiv2::XmpParser::terminate);
+
+    if (argc < 2 || argc > 3) {
+        std::cout << "Usage: " << argv[0] << " directory [MiB]\n";
+        return 1;
+    }
+    const std::string path = std::string(argv[1]) + "/epsimage-test.eps";
+    const long megabytes = argc == 3 ? std::atol(argv[2]) : 256;
+
+    // An EPS file with a page of path operators, like a large Illustrator drawing
+    {
+        FileIo file(path);
+        if (file.open("wb") != 0) {
+            throw Error(kerFileOpenFailed, path, "wb", strError());
+        }
+        std::string header = "%!PS-Adobe-3.0 EPSF-3.0\n"
+                             "%%BoundingBox: 0 0 1000 1000\n"
+                             "%%Pages: 1\n"
+                             "%%EndComments\n"
+                             "%%BeginProlog\n"
+                             "%%EndProlog\n"
+                             "%%Page: 1 1\n"
+                             "%%BeginPageSetup\n"
+                             "%%EndPageSetup\n";
+        file.write(reinterpret_cast<const byte*>(header.data()), static_cast<long>(header.size()));
+        std::string block;
+        for (int i = 0; block.size() < 1024 * 1024; ++i) {
+            block += std::to_string(i % 997) + " " + std::to_string(i % 991) + " m " + std::to_string(i % 983) +
+                     " " + std::to_string(i % 977) + " l S\n";
+        }
+        for (long i = 0; i < megabytes; ++i) {
+            file.write(reinterpret_cast<const byte*>(block.data()), static_cast<long>(block.size()));
+        }
+        const std::string trailer = "%%PageTrailer\n%%Trailer\n%%EOF\n";
+        file.write(reinterpret_cast<const byte*>(trailer.data()), static_cast<long>(trailer.size()));
+    }
+    const size_t size = FileIo(path).size();
+
+    measure("Add XMP      ", size, [&] {
+        auto image = ImageFactory::open(path);
+        image->readMetadata();
+        image->xmpData()["Xmp.dc.title"] = "epsimage-test";
+        image->writeMetadata();
+    });
+    measure("Read XMP     ", size, [&] {
+        auto image = ImageFactory::open(path);
+        image->readMetadata();
+        if (image->xmpData()["Xmp.dc.title"].toString() != "lang=\"x-default\" epsimage-test") {
+            std::cout << "Unexpected title " << image->xmpData()["Xmp.dc.title"] << "\n";
+        }
+    });
+    measure("Update XMP   ", size, [&] {
+        auto image = ImageFactory::open(path);
+        image->readMetadata();
+        image->xmpData()["Xmp.dc.title"] = "epsimage-test 2";
+        image->writeMetadata();
+    });
+
+    std::remove(path.c_str());
+    return 0;
+}
+catch (Exiv2::AnyError& e) {
+    std::cout << "Caught Exiv2 exception '" << e << "'\n";
+    return -1;
+}
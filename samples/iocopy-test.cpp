@@ -0,0 +1,117 @@
+// ***************************************************************** -*- C++ -*-
+// iocopy-test.cpp
+// Throughput of copying data between files with BasicIo
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <exiv2/exiv2.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+
+namespace {
+    //! Run \em copy, which copies \em size bytes, and print its throughput
+    void measure(const std::string& name, size_t size, const std::function<size_t()>& copy)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t copied = copy();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << name << ": " << size / (1024.0 * 1024.0) / elapsed.count() << " MiB/s";
+        if (copied != size) {
+            std::cout << " (copied " << copied << " of " << size << " bytes)";
+        }
+        std::cout << "\n";
+    }
+}  // namespace
+
+int main(int argc, char* const argv[])
+try {
+    Exiv2::XmpParser::initialize();
+    ::atexit(Exiv2::XmpParser::terminate);
+
+    if (argc < 2 || argc > 3) {
+        std::cout << "Usage: " << argv[0] << " directory [MiB]\n";
+        return 1;
+    }
+    const std::string srcPath = std::string(argv[1]) + "/iocopy-test.src";
+    const std::string dstPath = std::string(argv[1]) + "/iocopy-test.dst";
+    const long megabytes = argc == 3 ? std::atol(argv[2]) : 256;
+
+    // Create the source file
+    std::vector<byte> block(1024 * 1024);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<byte>(i * 7 + i / 4096);
+    }
+    {
+        FileIo src(srcPath);
+        if (src.open("wb") != 0) {
+            throw Error(kerFileOpenFailed, srcPath, "wb", strError());
+        }
+        for (long i = 0; i < megabytes; ++i) {
+            src.write(block.data(), static_cast<long>(block.size()));
+        }
+    }
+    FileIo src(srcPath);
+    FileIo dst(dstPath);
+    const size_t size = src.size();
+
+    measure("4 KiB buffer       ", size, [&] {
+        src.open();
+        dst.open("wb");
+        byte buf[4096];
+        size_t total = 0;
+        long n = 0;
+        while ((n = src.read(buf, sizeof(buf))) > 0) {
+            total += dst.write(buf, n);
+        }
+        dst.close();
+        return total;
+    });
+    measure("FileIo::write      ", size, [&] {
+        src.open();
+        dst.open("wb");
+        const size_t total = dst.write(src);
+        dst.close();
+        return total;
+    });
+    measure("TempIo and transfer", size, [&] {
+        // Like an image writer: build the new file in a TempIo, then replace the old one
+        src.open();
+        TempIo temp(dst);
+        const size_t total = temp.write(src);
+        dst.transfer(temp);
+        return total == size ? dst.size() : total;
+    });
+
+    src.close();
+    std::remove(srcPath.c_str());
+    std::remove(dstPath.c_str());
+    return 0;
+}
+catch (Exiv2::AnyError& e) {
+    std::cout << "Caught Exiv2 exception '" << e << "'\n";
+    return -1;
+}
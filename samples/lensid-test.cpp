@@ -0,0 +1,83 @@
+// ***************************************************************** -*- C++ -*-
+// lensid-test.cpp
+// Micro-benchmark of the Nikon lens id lookup
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <exiv2/exiv2.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace Exiv2;
+
+namespace {
+    //! Set the NikonLd3 lens data of \em exifData to \em raw
+    void setLensData(ExifData& exifData, const byte raw[8])
+    {
+        static const char* tags[] = {"LensIDNumber",          "LensFStops",            "MinFocalLength",
+                                     "MaxFocalLength",        "MaxApertureAtMinFocal", "MaxApertureAtMaxFocal",
+                                     "MCUVersion"};
+        for (int i = 0; i < 7; ++i) {
+            exifData[std::string("Exif.NikonLd3.") + tags[i]].setValue(std::to_string(raw[i]));
+        }
+        exifData["Exif.Nikon3.LensType"].setValue(std::to_string(raw[7]));
+    }
+}  // namespace
+
+int main(int argc, char* const argv[])
+try {
+    Exiv2::XmpParser::initialize();
+    ::atexit(Exiv2::XmpParser::terminate);
+
+    if (argc > 2) {
+        std::cout << "Usage: " << argv[0] << " [iterations]\n";
+        return 1;
+    }
+    const long iterations = argc == 2 ? std::atol(argv[1]) : 100000;
+
+    // A lens at the start and one at the end of the table, a Sigma lens and an unknown lens
+    const byte lenses[][8] = {
+        {0x01, 0x58, 0x50, 0x50, 0x14, 0x14, 0x02, 0x00},
+        {0xC8, 0x54, 0x62, 0x62, 0x0C, 0x0C, 0x4B, 0x46},
+        {0xFE, 0x10, 0x00, 0x00, 0x24, 0x24, 0x4B, 0x06},
+        {0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    };
+    for (auto&& lens : lenses) {
+        ExifData exifData;
+        setLensData(exifData, lens);
+        const Exifdatum& lensId = exifData["Exif.NikonLd3.LensIDNumber"];
+
+        size_t length = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; ++i) {
+            length += lensId.print(&exifData).size();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << lensId.print(&exifData) << ": " << elapsed.count() / iterations << " ns/lookup"
+                  << " (" << length << " characters)\n";
+    }
+    return 0;
+}
+catch (Exiv2::AnyError& e) {
+    std::cout << "Caught Exiv2 exception '" << e << "'\n";
+    return -1;
+}
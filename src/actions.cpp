@@ -273,6 +273,7 @@ namespace Action {
         assert(image);
         image->readMetadata();
         Exiv2::ExifData& exifData = image->exifData();
+        const Exiv2::ExifPrintContext printContext(exifData);
         align_ = 16;
 
         // Filename
@@ -422,6 +423,7 @@ namespace Action {
         bool noExif = false;
         if (Params::instance().printTags_ & Exiv2::mdExif) {
             const Exiv2::ExifData& exifData = image->exifData();
+            const Exiv2::ExifPrintContext printContext(exifData);
             for (auto&& md : exifData) {
                 ret |= printMetadatum(md, image);
             }
@@ -32,12 +32,20 @@
 #include "http.hpp"
 #include "properties.hpp"
 #include "image_int.hpp"
+#include "remotecache_int.hpp"
 
 // + standard includes
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 #include <iostream>
+#include <sstream>
 #include <cstring>                      // std::memcpy
+#include <cerrno>
+#include <limits>
 #include <cassert>
 #include <fstream>                      // write the temporary file
 #include <fcntl.h>                      // _O_BINARY in FileIo::FileIo
@@ -56,6 +64,13 @@
 #ifdef EXV_HAVE_UNISTD_H
 # include <unistd.h>                    // for getpid, stat
 #endif
+#ifdef EXV_HAVE_SENDFILE
+# include <sys/sendfile.h>              // for sendfile
+#endif
+#ifdef EXV_HAVE_FICLONE
+# include <linux/fs.h>                  // for FICLONE
+# include <sys/ioctl.h>                 // for ioctl
+#endif
 
 #ifdef EXV_USE_CURL
 # include <curl/curl.h>
@@ -89,6 +104,16 @@ namespace Exiv2 {
         enforce(r == 0, err);
     }
 
+    long BasicIo::readAt(int64_t offset, byte* buf, long rcount)
+    {
+        const long restore = tell();
+        if (restore < 0 || seek(offset, beg) != 0)
+            return 0;
+        const long nread = read(buf, rcount);
+        seek(restore, beg);
+        return nread;
+    }
+
     //! Internal Pimpl structure of class FileIo.
     class FileIo::Impl {
     public:
@@ -590,19 +615,114 @@ namespace Exiv2 {
         return static_cast<long>(std::fwrite(data, 1, wcount, p_->fp_));
     }
 
+    namespace {
+        /*!
+          @brief Copy \em count bytes at \em offIn of the file \em fdIn to
+              \em offOut of the file \em fdOut in the kernel, without passing
+              the data through user space. Neither file offset is used. A
+              whole file copied into an empty file shares its blocks (reflink)
+              where the file system supports that.
+          @return Number of bytes copied; the rest, if any, must be copied
+              through a buffer
+         */
+        size_t copyFileData(int fdOut, int64_t offOut, int fdIn, int64_t offIn, size_t count)
+        {
+            size_t copied = 0;
+#ifdef EXV_HAVE_FICLONE
+            struct stat statIn;
+            struct stat statOut;
+            if (   offIn == 0 && offOut == 0
+                && ::fstat(fdIn, &statIn) == 0 && static_cast<size_t>(statIn.st_size) == count
+                && ::fstat(fdOut, &statOut) == 0 && statOut.st_size == 0
+                && ::ioctl(fdOut, FICLONE, fdIn) == 0) {
+                return count;
+            }
+#endif
+#ifdef EXV_HAVE_COPY_FILE_RANGE
+            loff_t posIn = offIn;
+            loff_t posOut = offOut;
+            while (copied < count) {
+                const ssize_t n = ::copy_file_range(fdIn, &posIn, fdOut, &posOut, count - copied, 0);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    break;
+                copied += static_cast<size_t>(n);
+            }
+#endif
+#ifdef EXV_HAVE_SENDFILE
+            // sendfile writes at the offset of fdOut
+            if (copied < count && ::lseek(fdOut, static_cast<off_t>(offOut + copied), SEEK_SET) != -1) {
+                off_t pos = static_cast<off_t>(offIn + copied);
+                while (copied < count) {
+                    const ssize_t n = ::sendfile(fdOut, fdIn, &pos, count - copied);
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        break;
+                    copied += static_cast<size_t>(n);
+                }
+            }
+#endif
+            (void)fdOut;
+            (void)offOut;
+            (void)fdIn;
+            (void)offIn;
+            return copied;
+        }
+
+        //! Size of the buffer used to copy data between BasicIo instances
+        const long copyBufferSize = 64 * 1024;
+    }  // namespace
+
     long FileIo::write(BasicIo& src)
     {
         assert(p_->fp_ != 0);
         if (static_cast<BasicIo*>(this) == &src) return 0;
         if (!src.isopen()) return 0;
-        if (p_->switchMode(Impl::opWrite) != 0) return 0;
 
-        byte buf[4096];
+        // Write data in memory in one go
+        auto tempIo = dynamic_cast<TempIo*>(&src);
+        MemIo* memIo = tempIo ? tempIo->memIo() : dynamic_cast<MemIo*>(&src);
+        if (memIo) {
+            if (p_->switchMode(Impl::opWrite) != 0) return 0;
+            const long pos = memIo->tell();
+            const long avail = static_cast<long>(memIo->size()) - pos;
+            if (avail <= 0) return 0;
+            const auto writeCount = static_cast<long>(std::fwrite(memIo->mmap() + pos, 1, avail, p_->fp_));
+            memIo->seek(pos + writeCount, BasicIo::beg);
+            return writeCount;
+        }
+
+        long writeTotal = 0;
+#ifdef EXV_HAVE_UNISTD_H
+        // Let the kernel copy the data between files
+        FILE* srcFp = nullptr;
+        auto fileIo = dynamic_cast<FileIo*>(&src);
+        if (fileIo && fileIo->p_->switchMode(Impl::opSeek) == 0) {
+            srcFp = fileIo->p_->fp_;
+        }
+        else if (tempIo) {
+            srcFp = tempIo->file();
+        }
+        if (srcFp != nullptr && p_->switchMode(Impl::opSeek) == 0) {
+            const long srcPos = src.tell();
+            const long pos = tell();
+            const long avail = static_cast<long>(src.size()) - srcPos;
+            if (srcPos >= 0 && pos >= 0 && avail > 0) {
+                writeTotal = static_cast<long>(copyFileData(fileno(p_->fp_), pos, fileno(srcFp), srcPos, avail));
+                seek(pos + writeTotal, BasicIo::beg);
+                src.seek(srcPos + writeTotal, BasicIo::beg);
+            }
+        }
+#endif
+        if (p_->switchMode(Impl::opWrite) != 0) return writeTotal;
+
+        std::vector<byte> buf(copyBufferSize);
         long readCount = 0;
         long writeCount = 0;
-        long writeTotal = 0;
-        while ((readCount = src.read(buf, sizeof(buf)))) {
-            writeTotal += writeCount = static_cast<long>(std::fwrite(buf, 1, readCount, p_->fp_));
+        while ((readCount = src.read(buf.data(), copyBufferSize))) {
+            writeTotal += writeCount = static_cast<long>(std::fwrite(buf.data(), 1, readCount, p_->fp_));
             if (writeCount != readCount) {
                 // try to reset back to where write stopped
                 src.seek(writeCount-readCount, BasicIo::cur);
@@ -1001,6 +1121,32 @@ namespace Exiv2 {
         return static_cast<long>(std::fread(buf, 1, rcount, p_->fp_));
     }
 
+    long FileIo::readAt(int64_t offset, byte* buf, long rcount)
+    {
+        assert(p_->fp_ != 0);
+#ifdef EXV_HAVE_PREAD
+        if (offset < 0 || rcount <= 0 || offset > std::numeric_limits<off_t>::max())
+            return 0;
+        // Data still in the stdio buffer must reach the file first. The mode is left alone,
+        // the file position is not changed by the flush.
+        if (p_->opMode_ == Impl::opWrite && std::fflush(p_->fp_) != 0)
+            return 0;
+        const int fd = fileno(p_->fp_);
+        long nread = 0;
+        while (nread < rcount) {
+            const ssize_t n = ::pread(fd, buf + nread, rcount - nread, static_cast<off_t>(offset + nread));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            nread += static_cast<long>(n);
+        }
+        return nread;
+#else
+        return BasicIo::readAt(offset, buf, rcount);
+#endif
+    }
+
     int FileIo::getb()
     {
         assert(p_->fp_ != 0);
@@ -1094,6 +1240,7 @@ namespace Exiv2 {
         void    populate (byte* source, size_t num)
         {
             assert(source != nullptr);
+            delete [] data_;
             size_ = num;
             data_ = new byte [size_];
             type_ = bMemory;
@@ -1206,6 +1353,12 @@ namespace Exiv2 {
 
     void MemIo::transfer(BasicIo& src)
     {
+        auto tempIo = dynamic_cast<TempIo*>(&src);
+        if (tempIo && tempIo->memIo()) {
+            // Take over the memory block of temporary data which was not moved to a file
+            transfer(*tempIo->memIo());
+            return;
+        }
         auto memIo = dynamic_cast<MemIo*>(&src);
         if (memIo) {
             // Optimization if src is another instance of MemIo
@@ -1227,8 +1380,10 @@ namespace Exiv2 {
                 throw Error(kerDataSourceOpenFailed, src.path(), strError());
             }
             p_->idx_ = 0;
+            p_->size_ = 0;
             write(src);
             src.close();
+            p_->idx_ = 0;
         }
         if (error() || src.error()) throw Error(kerMemoryTransferFailed, strError());
     }
@@ -1339,6 +1494,15 @@ namespace Exiv2 {
         return allow;
     }
 
+    long MemIo::readAt(int64_t offset, byte* buf, long rcount)
+    {
+        if (offset < 0 || rcount <= 0 || offset >= p_->size_)
+            return 0;
+        const long allow = std::min(rcount, static_cast<long>(p_->size_ - offset));
+        std::memcpy(buf, &p_->data_[offset], allow);
+        return allow;
+    }
+
     int MemIo::getb()
     {
         if (p_->idx_ >= p_->size_) {
@@ -1374,6 +1538,422 @@ namespace Exiv2 {
 
     }
 
+    namespace {
+        //! Size above which the data of a TempIo is moved to a file, by default
+        std::atomic<size_t> tempIoThreshold(16 * 1024 * 1024);
+
+        /*!
+          @brief Create a temporary file in the directory \em dir, which is
+              removed when it is closed, or already when it is created where
+              the platform allows that.
+          @return The open file or nullptr if it could not be created
+         */
+        FILE* openTempFile(const std::string& dir)
+        {
+#if defined WIN32 && !defined __CYGWIN__
+            char name[MAX_PATH];
+            if (::GetTempFileNameA(dir.c_str(), "exv", 0, name) == 0) return nullptr;
+            // "D" deletes the file when it is closed
+            FILE* fp = std::fopen(name, "w+bD");
+            if (fp == nullptr) ::DeleteFileA(name);
+            return fp;
+#elif defined EXV_HAVE_UNISTD_H
+            std::string name = dir + "/exiv2-XXXXXX";
+            const int fd = ::mkstemp(&name[0]);
+            if (fd == -1) return nullptr;
+            ::unlink(name.c_str());
+            FILE* fp = ::fdopen(fd, "w+b");
+            if (fp == nullptr) ::close(fd);
+            return fp;
+#else
+            return nullptr;
+#endif
+        }
+
+        //! Set the position of the file \em fp to \em offset
+        int seekFile(FILE* fp, int64_t offset)
+        {
+#ifdef _WIN64
+            return _fseeki64(fp, offset, SEEK_SET);
+#else
+            return std::fseek(fp, static_cast<long>(offset), SEEK_SET);
+#endif
+        }
+    }  // namespace
+
+    //! Internal Pimpl structure of class TempIo.
+    class TempIo::Impl final {
+    public:
+        Impl(const BasicIo& target, size_t threshold);  //!< Constructor
+        ~Impl();                                         //!< Destructor
+
+        // Enumerations
+        //! Last operation on the temporary file
+        enum OpMode { opRead, opWrite, opSeek };
+
+        // DATA
+        std::string dir_;                     //!< Directory for the file, empty for the system's one
+        size_t threshold_;                    //!< Size above which the data is moved to a file
+        std::unique_ptr<MemIo> memIo_;        //!< The data, as long as it is kept in memory
+        FILE* fp_{nullptr};                   //!< The temporary file, once the data was moved
+        OpMode opMode_{opSeek};               //!< Last operation, no written data is buffered in opSeek
+        int64_t idx_{0};                      //!< IO position in the file
+        int64_t size_{0};                     //!< Size of the file
+        bool eof_{false};                     //!< EOF indicator
+        DataBuf mapped_;                      //!< Data of the file returned by mmap()
+        bool isWriteable_{false};             //!< Write the mapped data back to the file?
+
+        // METHODS
+        //! Move the data to a temporary file, return false if that was not possible
+        bool spill();
+        //! Position the file for an operation at the IO position, after another one
+        int switchMode(OpMode opMode);
+        //! Discard the data
+        void clear();
+
+        // NOT IMPLEMENTED
+        Impl(const Impl& rhs) = delete;             //!< Copy constructor
+        Impl& operator=(const Impl& rhs) = delete;  //!< Assignment
+    }; // class TempIo::Impl
+
+    TempIo::Impl::Impl(const BasicIo& target, size_t threshold)
+        : threshold_(threshold), memIo_(new MemIo)
+    {
+        auto fileIo = dynamic_cast<const FileIo*>(&target);
+        if (fileIo) {
+            const std::string path = fileIo->path();
+#if defined WIN32 && !defined __CYGWIN__
+            const std::string::size_type idx = path.find_last_of("\\/");
+#else
+            const std::string::size_type idx = path.find_last_of('/');
+#endif
+            if (idx == std::string::npos) {
+                dir_ = ".";
+            }
+            else {
+                dir_ = path.substr(0, std::max<std::string::size_type>(idx, 1));
+            }
+        }
+    }
+
+    TempIo::Impl::~Impl()
+    {
+        if (fp_ != nullptr) {
+            std::fclose(fp_);
+        }
+    }
+
+    bool TempIo::Impl::spill()
+    {
+        if (!dir_.empty()) {
+            fp_ = openTempFile(dir_);
+        }
+        if (fp_ == nullptr) {
+            fp_ = std::tmpfile();
+        }
+        const size_t size = memIo_->size();
+        if (fp_ != nullptr && size > 0 && std::fwrite(memIo_->mmap(), 1, size, fp_) != size) {
+            std::fclose(fp_);
+            fp_ = nullptr;
+        }
+        if (fp_ == nullptr) {
+            // Keep the data in memory and don't try again
+            threshold_ = std::numeric_limits<size_t>::max();
+            return false;
+        }
+        idx_ = memIo_->tell();
+        size_ = size;
+        eof_ = memIo_->eof();
+        opMode_ = opWrite;
+        memIo_.reset();
+        return true;
+    }
+
+    int TempIo::Impl::switchMode(OpMode opMode)
+    {
+        if (opMode_ == opMode) return 0;
+        opMode_ = opMode;
+        // Flushes the data written, also required by stdio between writing and reading
+        return seekFile(fp_, idx_);
+    }
+
+    void TempIo::Impl::clear()
+    {
+        if (fp_ != nullptr) {
+            std::fclose(fp_);
+            fp_ = nullptr;
+        }
+        mapped_.reset();
+        memIo_ = std::make_unique<MemIo>();
+        opMode_ = opSeek;
+        idx_ = 0;
+        size_ = 0;
+        eof_ = false;
+    }
+
+    TempIo::TempIo(const BasicIo& target)
+        : p_(new Impl(target, tempIoThreshold))
+    {
+    }
+
+    TempIo::TempIo(const BasicIo& target, size_t threshold)
+        : p_(new Impl(target, threshold))
+    {
+    }
+
+    TempIo::~TempIo() = default;
+
+    size_t TempIo::defaultThreshold()
+    {
+        return tempIoThreshold;
+    }
+
+    void TempIo::setDefaultThreshold(size_t threshold)
+    {
+        tempIoThreshold = threshold;
+    }
+
+    bool TempIo::isSpilled() const
+    {
+        return p_->fp_ != nullptr;
+    }
+
+    MemIo* TempIo::memIo()
+    {
+        return p_->memIo_.get();
+    }
+
+    std::FILE* TempIo::file()
+    {
+        if (p_->fp_ == nullptr || p_->switchMode(Impl::opSeek) != 0) return nullptr;
+        return p_->fp_;
+    }
+
+    int TempIo::open()
+    {
+        if (p_->memIo_) return p_->memIo_->open();
+        if (p_->switchMode(Impl::opSeek) != 0) return 1;
+        p_->idx_ = 0;
+        p_->eof_ = false;
+        return 0;
+    }
+
+    int TempIo::close()
+    {
+        return munmap();
+    }
+
+    long TempIo::write(const byte* data, long wcount)
+    {
+        if (p_->memIo_) {
+            const size_t end = static_cast<size_t>(p_->memIo_->tell()) + wcount;
+            if (std::max(end, p_->memIo_->size()) <= p_->threshold_ || !p_->spill()) {
+                return p_->memIo_->write(data, wcount);
+            }
+        }
+        if (data == nullptr || wcount <= 0) return 0;
+        if (p_->switchMode(Impl::opWrite) != 0) return 0;
+        const auto writeCount = static_cast<long>(std::fwrite(data, 1, wcount, p_->fp_));
+        p_->idx_ += writeCount;
+        p_->size_ = std::max(p_->size_, p_->idx_);
+        return writeCount;
+    }
+
+    long TempIo::write(BasicIo& src)
+    {
+        if (static_cast<BasicIo*>(this) == &src) return 0;
+        if (!src.isopen()) return 0;
+
+        long writeTotal = 0;
+#ifdef EXV_HAVE_UNISTD_H
+        // Let the kernel copy data from a file which would not fit in memory
+        auto fileIo = dynamic_cast<FileIo*>(&src);
+        if (fileIo && fileIo->p_->switchMode(FileIo::Impl::opSeek) == 0) {
+            const long srcPos = src.tell();
+            const long avail = static_cast<long>(src.size()) - srcPos;
+            if (   srcPos >= 0 && avail > 0
+                && (   p_->fp_ != nullptr
+                    || std::max(static_cast<size_t>(tell()) + avail, size()) <= p_->threshold_
+                    || p_->spill())
+                && p_->fp_ != nullptr && p_->switchMode(Impl::opSeek) == 0) {
+                writeTotal = static_cast<long>(copyFileData(fileno(p_->fp_), p_->idx_, fileno(fileIo->p_->fp_), srcPos, avail));
+                p_->idx_ += writeTotal;
+                p_->size_ = std::max(p_->size_, p_->idx_);
+                src.seek(srcPos + writeTotal, BasicIo::beg);
+            }
+        }
+#endif
+
+        std::vector<byte> buf(copyBufferSize);
+        long readCount = 0;
+        while ((readCount = src.read(buf.data(), copyBufferSize))) {
+            const long writeCount = write(buf.data(), readCount);
+            writeTotal += writeCount;
+            if (writeCount != readCount) {
+                // try to reset back to where write stopped
+                src.seek(writeCount - readCount, BasicIo::cur);
+                break;
+            }
+        }
+
+        return writeTotal;
+    }
+
+    int TempIo::putb(byte data)
+    {
+        return write(&data, 1) == 1 ? data : EOF;
+    }
+
+    DataBuf TempIo::read(long rcount)
+    {
+        if (static_cast<size_t>(rcount) > size())
+            throw Error(kerInvalidMalloc);
+        DataBuf buf(rcount);
+        long readCount = read(buf.data(), buf.size());
+        buf.resize(readCount);
+        return buf;
+    }
+
+    long TempIo::read(byte* buf, long rcount)
+    {
+        if (p_->memIo_) return p_->memIo_->read(buf, rcount);
+        if (p_->switchMode(Impl::opRead) != 0) return 0;
+        const auto readCount = static_cast<long>(std::fread(buf, 1, rcount, p_->fp_));
+        p_->idx_ += readCount;
+        if (readCount < rcount) {
+            p_->eof_ = true;
+        }
+        return readCount;
+    }
+
+    int TempIo::getb()
+    {
+        if (p_->memIo_) return p_->memIo_->getb();
+        if (p_->switchMode(Impl::opRead) != 0) return EOF;
+        const int data = std::getc(p_->fp_);
+        if (data == EOF) {
+            p_->eof_ = true;
+        }
+        else {
+            ++p_->idx_;
+        }
+        return data;
+    }
+
+    void TempIo::transfer(BasicIo& src)
+    {
+        p_->clear();
+        // Generic reopen to reset position to start
+        if (src.open() != 0) {
+            throw Error(kerDataSourceOpenFailed, src.path(), strError());
+        }
+        write(src);
+        src.close();
+        if (error() || src.error()) throw Error(kerTransferFailed, path(), strError());
+    }
+
+    int TempIo::seek(int64_t offset, Position pos)
+    {
+        if (p_->memIo_) return p_->memIo_->seek(offset, pos);
+
+        int64_t newIdx = 0;
+        switch (pos) {
+        case BasicIo::cur: newIdx = p_->idx_ + offset; break;
+        case BasicIo::beg: newIdx = offset; break;
+        case BasicIo::end: newIdx = p_->size_ + offset; break;
+        }
+
+        if (newIdx < 0)
+            return 1;
+
+        if (newIdx > p_->size_) {
+            p_->eof_ = true;
+            return 1;
+        }
+
+        if (p_->switchMode(Impl::opSeek) != 0)
+            return 1;
+        p_->idx_ = newIdx;
+        p_->eof_ = false;
+        return 0;
+    }
+
+    byte* TempIo::mmap(bool isWriteable)
+    {
+        if (p_->memIo_) return p_->memIo_->mmap(isWriteable);
+        munmap();
+        p_->mapped_.alloc(static_cast<long>(p_->size_));
+        // The file position is restored by the next operation
+        p_->opMode_ = Impl::opRead;
+        if (   seekFile(p_->fp_, 0) != 0
+            || std::fread(p_->mapped_.data(), 1, p_->mapped_.size(), p_->fp_) != static_cast<size_t>(p_->size_)) {
+            p_->mapped_.reset();
+            throw Error(kerCallFailed, path(), strError(), "fread");
+        }
+        p_->isWriteable_ = isWriteable;
+        return p_->mapped_.data();
+    }
+
+    int TempIo::munmap()
+    {
+        int rc = 0;
+        if (p_->isWriteable_ && p_->fp_ != nullptr && p_->mapped_.size() > 0) {
+            p_->opMode_ = Impl::opWrite;
+            if (   seekFile(p_->fp_, 0) != 0
+                || std::fwrite(p_->mapped_.c_data(), 1, p_->mapped_.size(), p_->fp_)
+                       != static_cast<size_t>(p_->mapped_.size())) {
+                rc = 1;
+            }
+        }
+        p_->mapped_.reset();
+        p_->isWriteable_ = false;
+        return rc;
+    }
+
+    long TempIo::tell() const
+    {
+        if (p_->memIo_) return p_->memIo_->tell();
+        return static_cast<long>(p_->idx_);
+    }
+
+    size_t TempIo::size() const
+    {
+        if (p_->memIo_) return p_->memIo_->size();
+        return static_cast<size_t>(p_->size_);
+    }
+
+    bool TempIo::isopen() const
+    {
+        return true;
+    }
+
+    int TempIo::error() const
+    {
+        return p_->fp_ != nullptr ? std::ferror(p_->fp_) : 0;
+    }
+
+    bool TempIo::eof() const
+    {
+        if (p_->memIo_) return p_->memIo_->eof();
+        return p_->eof_;
+    }
+
+    std::string TempIo::path() const
+    {
+        return "TempIo";
+    }
+
+#ifdef EXV_UNICODE_PATH
+    std::wstring TempIo::wpath() const
+    {
+        return EXV_WIDEN("TempIo");
+    }
+
+#endif
+    void TempIo::populateFakeData() {
+
+    }
+
 #if EXV_XPATH_MEMIO
     XPathIo::XPathIo(const std::string& path) {
         Protocol prot = fileProtocol(path);
@@ -1555,6 +2135,9 @@ namespace Exiv2 {
         bool            eof_;           //!< EOF indicator
         Protocol        protocol_;      //!< the protocol of url
         uint32_t        totalRead_;     //!< bytes requested from host
+        std::string     validator_;     //!< ETag and Last-Modified of the remote file, if known
+        std::unique_ptr<Internal::RemoteBlockCache> cache_; //!< Optional on-disk block cache
+        bool            useCache_{false}; //!< Whether cache_ is used for the file as it was opened
 
         // METHODS
         /*!
@@ -1572,6 +2155,15 @@ namespace Exiv2 {
           @note Set lowBlock = -1 and highBlock = -1 to get the whole file content.
          */
         virtual void getDataByRange(long lowBlock, long highBlock, std::string& response) = 0;
+        /*!
+          @brief Get several ranges of blocks in a single request.
+          @param ranges The block ranges, as pairs of start and end block index.
+          @param pieces The data from the server, as pairs of the file offset and the data.
+          @return false if the protocol can't request several ranges at once.
+          @throw Error if the server returns the error code.
+         */
+        virtual bool getDataByRanges(const std::vector<std::pair<size_t, size_t> >& ranges,
+                                     std::vector<std::pair<size_t, std::string> >& pieces);
         /*!
           @brief Submit the data to the remote machine. The data replace a part of the remote file.
                 The replaced part of remote file is indicated by from and to parameters.
@@ -1592,6 +2184,10 @@ namespace Exiv2 {
           @throw Error if it fails.
          */
         virtual size_t populateBlocks(size_t lowBlock, size_t highBlock);
+        //! Return the size of block \em block, the last block may be shorter than blockSize_.
+        size_t blockLength(size_t block) const;
+        //! Populate the blocks with \em data, which starts at the file offset \em offset.
+        void populateData(size_t offset, const std::string& data);
 
     }; // class RemoteIo::Impl
 
@@ -1615,9 +2211,30 @@ namespace Exiv2 {
     }
 #endif
 
+    size_t RemoteIo::Impl::blockLength(size_t block) const
+    {
+        const size_t start = block * blockSize_;
+        return start < size_ ? std::min(blockSize_, size_ - start) : 0;
+    }
+
     size_t RemoteIo::Impl::populateBlocks(size_t lowBlock, size_t highBlock)
     {
         assert(isMalloced_);
+        const size_t nBlocks = (size_ + blockSize_ - 1) / blockSize_;
+        if (nBlocks == 0) return 0;
+        if (highBlock >= nBlocks) highBlock = nBlocks - 1;
+        if (lowBlock > highBlock) lowBlock = highBlock;
+
+        // serve what the on-disk cache has before asking the server
+        if (useCache_) {
+            for (size_t i = lowBlock; i <= highBlock; i++) {
+                if (!blocksMap_[i].isNone()) continue;
+                DataBuf buf = cache_->load(i, blockLength(i));
+                if (buf.size() > 0) {
+                    blocksMap_[i].populate(buf.data(), buf.size());
+                }
+            }
+        }
 
         // optimize: ignore all true blocks on left & right sides.
         while(!blocksMap_[lowBlock].isNone()  && lowBlock  < highBlock) lowBlock++;
@@ -1626,28 +2243,65 @@ namespace Exiv2 {
         size_t rcount = 0;
         if (blocksMap_[highBlock].isNone())
         {
-            std::string data;
-            getDataByRange(static_cast<long>(lowBlock), static_cast<long>(highBlock), data);
-            rcount = data.length();
-            if (rcount == 0) {
-                throw Error(kerErrorMessage, "Data By Range is empty. Please check the permission.");
+            // blocks in the middle may already be in memory: ask only for the missing runs
+            std::vector<std::pair<size_t, size_t> > ranges;
+            for (size_t i = lowBlock; i <= highBlock; i++) {
+                if (!blocksMap_[i].isNone()) continue;
+                if (!ranges.empty() && ranges.back().second + 1 == i) {
+                    ranges.back().second = i;
+                } else {
+                    ranges.emplace_back(i, i);
+                }
+            }
+            std::vector<std::pair<size_t, std::string> > pieces;
+            if (ranges.size() > 1 && getDataByRanges(ranges, pieces)) {
+                for (auto&& piece : pieces) {
+                    rcount += piece.second.length();
+                    populateData(piece.first, piece.second);
+                }
             }
-            auto source = reinterpret_cast<byte*>(const_cast<char*>(data.c_str()));
-            size_t remain = rcount, totalRead = 0;
-            size_t iBlock = (rcount == size_) ? 0 : lowBlock;
 
-            while (remain) {
-                size_t allow = std::min(remain, blockSize_);
-                blocksMap_[iBlock].populate(&source[totalRead], allow);
-                remain -= allow;
-                totalRead += allow;
-                iBlock++;
+            // fall back to a single range if the server didn't deliver all of them
+            while (lowBlock < highBlock && !blocksMap_[lowBlock].isNone()) lowBlock++;
+            if (blocksMap_[lowBlock].isNone()) {
+                std::string data;
+                getDataByRange(static_cast<long>(lowBlock), static_cast<long>(highBlock), data);
+                if (data.empty()) {
+                    throw Error(kerErrorMessage, "Data By Range is empty. Please check the permission.");
+                }
+                rcount += data.length();
+                populateData(data.length() == size_ ? 0 : lowBlock * blockSize_, data);
             }
+            if (useCache_) cache_->evict();
         }
 
         return rcount;
     }
 
+    void RemoteIo::Impl::populateData(size_t offset, const std::string& data)
+    {
+        const size_t nBlocks = (size_ + blockSize_ - 1) / blockSize_;
+        auto source = reinterpret_cast<const byte*>(data.data());
+        size_t remain = data.length(), totalRead = 0;
+        size_t iBlock = offset / blockSize_;
+        if (offset % blockSize_ != 0) return;
+
+        while (remain && iBlock < nBlocks) {
+            size_t allow = std::min(remain, blockSize_);
+            blocksMap_[iBlock].populate(const_cast<byte*>(&source[totalRead]), allow);
+            if (useCache_) cache_->store(iBlock, &source[totalRead], allow);
+            remain -= allow;
+            totalRead += allow;
+            iBlock++;
+        }
+    }
+
+    bool RemoteIo::Impl::getDataByRanges(const std::vector<std::pair<size_t, size_t> >& /*ranges*/,
+                                         std::vector<std::pair<size_t, std::string> >& /*pieces*/)
+    {
+        return false;
+    }
+
     RemoteIo::Impl::~Impl() {
         delete[] blocksMap_;
     }
@@ -1665,6 +2319,7 @@ namespace Exiv2 {
         close(); // reset the IO position
         bigBlock_ = nullptr;
         if (!p_->isMalloced_) {
+            p_->useCache_ = false;
             long length = p_->getFileLength();
             if (length < 0) { // unable to get the length of remote file, get the whole file content.
                 std::string data;
@@ -1689,11 +2344,30 @@ namespace Exiv2 {
                 size_t nBlocks = (p_->size_ + p_->blockSize_ - 1) / p_->blockSize_;
                 p_->blocksMap_  = new BlockMap[nBlocks];
                 p_->isMalloced_ = true;
+
+                if (!p_->cache_) {
+                    const std::string cacheDir = getEnv(envREMOTECACHE);
+                    if (!cacheDir.empty()) {
+                        p_->cache_ = std::make_unique<Internal::RemoteBlockCache>(cacheDir, 64 * 1024 * 1024);
+                    }
+                }
+                // without ETag or Last-Modified, a changed remote file can't be told from the cached one
+                p_->useCache_ = p_->cache_ && !p_->validator_.empty();
+                if (p_->useCache_) {
+                    std::ostringstream key;
+                    key << p_->path_ << '\n' << p_->validator_ << '\n' << p_->size_ << '\n' << p_->blockSize_;
+                    p_->cache_->setKey(key.str(), p_->blockSize_);
+                }
             }
         }
         return 0; // means OK
     }
 
+    void RemoteIo::setBlockCache(const std::string& dir, size_t maxBytes)
+    {
+        p_->cache_ = std::make_unique<Internal::RemoteBlockCache>(dir, maxBytes);
+    }
+
     int RemoteIo::close()
     {
         if (p_->isMalloced_) {
@@ -1949,6 +2623,16 @@ namespace Exiv2 {
         return p_->path_;
     }
 
+    size_t RemoteIo::cacheHits() const
+    {
+        return p_->cache_ ? p_->cache_->hits() : 0;
+    }
+
+    size_t RemoteIo::cacheMisses() const
+    {
+        return p_->cache_ ? p_->cache_->misses() : 0;
+    }
+
 #ifdef EXV_UNICODE_PATH
     std::wstring RemoteIo::wpath() const
     {
@@ -1994,6 +2678,16 @@ namespace Exiv2 {
           @note Set lowBlock = -1 and highBlock = -1 to get the whole file content.
          */
         void getDataByRange(long lowBlock, long highBlock, std::string& response) override;
+        /*!
+          @brief Get several ranges of blocks with a single multi-range request.
+                The server answers with a multipart/byteranges body, a single range or the whole file.
+          @param ranges The block ranges, as pairs of start and end block index.
+          @param pieces The data from the server, as pairs of the file offset and the data.
+          @return true
+          @throw Error if the server returns the error code.
+         */
+        bool getDataByRanges(const std::vector<std::pair<size_t, size_t> >& ranges,
+                             std::vector<std::pair<size_t, std::string> >& pieces) override;
         /*!
           @brief Submit the data to the remote machine. The data replace a part of the remote file.
                 The replaced part of remote file is indicated by from and to parameters.
@@ -2031,6 +2725,69 @@ namespace Exiv2 {
     }
 #endif
 
+    //! Return the value of response header \em name (case insensitive), without surrounding white space.
+    static std::string responseHeader(const Exiv2::Dictionary& response, const std::string& name)
+    {
+        for (auto&& header : response) {
+            if (header.first.size() == name.size() &&
+                std::equal(name.begin(), name.end(), header.first.begin(),
+                           [](char a, char b) { return ::tolower(a) == ::tolower(b); })) {
+                const std::string& v = header.second;
+                const size_t first = v.find_first_not_of(" \t\r\n");
+                const size_t last = v.find_last_not_of(" \t\r\n");
+                return first == std::string::npos ? std::string() : v.substr(first, last - first + 1);
+            }
+        }
+        return std::string();
+    }
+
+    //! Parse a "bytes first-last/total" Content-Range value.
+    static bool parseContentRange(const std::string& value, size_t& first, size_t& last)
+    {
+        const size_t pos = value.find("bytes");
+        if (pos == std::string::npos) return false;
+        const char* p = value.c_str() + pos + 5;
+        char* end = nullptr;
+        first = std::strtoul(p, &end, 10);
+        if (end == p || *end != '-') return false;
+        p = end + 1;
+        last = std::strtoul(p, &end, 10);
+        return end != p && last >= first;
+    }
+
+    //! Split a multipart/byteranges body into pairs of file offset and data.
+    static void parseByteRanges(const std::string& body, const std::string& boundary,
+                                std::vector<std::pair<size_t, std::string> >& pieces)
+    {
+        const std::string delimiter = "--" + boundary;
+        size_t pos = body.find(delimiter);
+        while (pos != std::string::npos) {
+            pos += delimiter.size();
+            if (body.compare(pos, 2, "--") == 0) break; // closing delimiter
+            const size_t headerEnd = body.find("\r\n\r\n", pos);
+            if (headerEnd == std::string::npos) break;
+
+            // parse the part headers for the Content-Range
+            Exiv2::Dictionary headers;
+            size_t line = body.find("\r\n", pos);
+            while (line != std::string::npos && line < headerEnd) {
+                const size_t next = body.find("\r\n", line + 2);
+                const std::string text = body.substr(line + 2, next - line - 2);
+                const size_t colon = text.find(':');
+                if (colon != std::string::npos) headers[text.substr(0, colon)] = text.substr(colon + 1);
+                line = next;
+            }
+            size_t first = 0;
+            size_t last = 0;
+            if (!parseContentRange(responseHeader(headers, "Content-Range"), first, last)) break;
+            const size_t start = headerEnd + 4;
+            const size_t length = last - first + 1;
+            if (start + length > body.size()) break;
+            pieces.emplace_back(first, body.substr(start, length));
+            pos = body.find(delimiter, start + length);
+        }
+    }
+
     long HttpIo::HttpImpl::getFileLength()
     {
         Exiv2::Dictionary response;
@@ -2041,13 +2798,23 @@ namespace Exiv2 {
         if (!hostInfo_.Port.empty())
             request["port"] = hostInfo_.Port;
         request["verb"]   = "HEAD";
+        request["version"] = "1.1";
         int serverCode = http(request, response, errors);
         if (serverCode < 0 || serverCode >= 400 || !errors.empty()) {
             throw Error(kerFileOpenFailed, "http",Exiv2::Internal::stringFormat("%d",serverCode), hostInfo_.Path);
         }
 
-        auto lengthIter = response.find("Content-Length");
-        return (lengthIter == response.end()) ? -1 : atol((lengthIter->second).c_str());
+        validator_.clear();
+        for (auto&& header : response) {
+            std::string name(header.first);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            if (name == "etag" || name == "last-modified") {
+                validator_ += name + ":" + header.second + "\n";
+            }
+        }
+
+        const std::string length = responseHeader(response, "Content-Length");
+        return length.empty() ? -1 : atol(length.c_str());
     }
 
     void HttpIo::HttpImpl::getDataByRange(long lowBlock, long highBlock, std::string& response)
@@ -2059,6 +2826,7 @@ namespace Exiv2 {
         if (!hostInfo_.Port.empty())
             request["port"] = hostInfo_.Port;
         request["verb"]   = "GET";
+        request["version"] = "1.1";
         std::string errors;
         if (lowBlock > -1 && highBlock > -1) {
             std::stringstream ss;
@@ -2073,6 +2841,53 @@ namespace Exiv2 {
         response = responseDic["body"];
     }
 
+    bool HttpIo::HttpImpl::getDataByRanges(const std::vector<std::pair<size_t, size_t> >& ranges,
+                                           std::vector<std::pair<size_t, std::string> >& pieces)
+    {
+        Exiv2::Dictionary responseDic;
+        Exiv2::Dictionary request;
+        request["server"] = hostInfo_.Host;
+        request["page"  ] = hostInfo_.Path;
+        if (!hostInfo_.Port.empty())
+            request["port"] = hostInfo_.Port;
+        request["verb"]   = "GET";
+        request["version"] = "1.1";
+        std::string errors;
+        std::stringstream ss;
+        ss << "Range: bytes=";
+        for (size_t i = 0; i < ranges.size(); i++) {
+            ss << (i ? "," : "") << ranges[i].first * blockSize_ << "-" << ((ranges[i].second + 1) * blockSize_ - 1);
+        }
+        ss << "\r\n";
+        request["header"] = ss.str();
+
+        int serverCode = http(request, responseDic, errors);
+        if (serverCode < 0 || serverCode >= 400 || !errors.empty()) {
+            throw Error(kerFileOpenFailed, "http",Exiv2::Internal::stringFormat("%d",serverCode), hostInfo_.Path);
+        }
+
+        const std::string& body = responseDic["body"];
+        if (serverCode != 206) { // the server ignored the ranges
+            pieces.emplace_back(0, body);
+            return true;
+        }
+        const std::string contentType = responseHeader(responseDic, "Content-Type");
+        const size_t boundaryPos = contentType.find("boundary=");
+        if (contentType.find("multipart/byteranges") != std::string::npos && boundaryPos != std::string::npos) {
+            std::string boundary = contentType.substr(boundaryPos + 9);
+            boundary = boundary.substr(0, boundary.find(';'));
+            if (boundary.size() > 1 && boundary.front() == '"') boundary = boundary.substr(1, boundary.size() - 2);
+            parseByteRanges(body, boundary, pieces);
+        } else {
+            size_t first = 0;
+            size_t last = 0;
+            if (parseContentRange(responseHeader(responseDic, "Content-Range"), first, last)) {
+                pieces.emplace_back(first, body);
+            }
+        }
+        return true;
+    }
+
     void HttpIo::HttpImpl::writeRemote(const byte* data, size_t size, long from, long to)
     {
         std::string scriptPath(getEnv(envHTTPPOST));
@@ -2236,6 +3051,7 @@ namespace Exiv2 {
         std::string response;
         curl_easy_setopt(curl_, CURLOPT_URL, path_.c_str());
         curl_easy_setopt(curl_, CURLOPT_NOBODY, 1); // HEAD
+        curl_easy_setopt(curl_, CURLOPT_FILETIME, 1L);
         curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, curlWriter);
         curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
         curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, 0L);
@@ -2254,6 +3070,10 @@ namespace Exiv2 {
         if (serverCode >= 400 || serverCode < 0) {
             throw Error(kerFileOpenFailed, "http",Exiv2::Internal::stringFormat("%d",serverCode),path_);
         }
+        // get the modification time, used to validate the on-disk block cache
+        long fileTime = -1;
+        curl_easy_getinfo(curl_, CURLINFO_FILETIME, &fileTime);
+        validator_ = fileTime < 0 ? std::string() : "last-modified:" + std::to_string(fileTime) + "\n";
         // get length
         double temp;
         curl_easy_getinfo(curl_, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &temp); // return -1 if unknown
@@ -26,6 +26,7 @@
 #include "bmffimage.hpp"
 
 #include "basicio.hpp"
+#include "bmffimage_int.hpp"
 #include "config.h"
 #include "error.hpp"
 #include "enforce.hpp"
@@ -133,6 +134,27 @@ namespace Exiv2
         return box == TAG_mdat; // mdat is where the main image lives and can be huge
     }
 
+    //! Number of bytes at the start of the payload of a box which boxHandler() needs in memory
+    static long payloadSize(uint32_t box, long size)
+    {
+        switch (box) {
+            case TAG_ftyp:
+            case TAG_iinf:
+            case TAG_infe:
+            case TAG_iloc:
+            case TAG_ispe:
+            case TAG_colr:
+                return size;
+            case TAG_thmb:
+            case TAG_prvw:
+                // version/flags and the header of the preview image, not the image itself
+                return std::min(size, 16L);
+            default:
+                // other boxes are read through io_ or not at all
+                return std::min(size, 4L);
+        }
+    }
+
     std::string BmffImage::mimeType() const
     {
         switch (fileType_) {
@@ -232,6 +254,9 @@ namespace Exiv2
             DataBuf data(8);
             io_->read(data.data(), data.size());
             box_length = data.read_uint64(0, endian_);
+        } else if (box_length == 0) {
+            // The box extends to the end of the file
+            box_length = static_cast<uint64_t>(pbox_end - address);
         }
 
         // read data in box and restore file position
@@ -240,6 +265,8 @@ namespace Exiv2
         enforce(box_length - hdrsize <= static_cast<size_t>(pbox_end - restore), Exiv2::kerCorruptedMetadata);
 
         const long buffer_size = static_cast<long>(box_length - hdrsize);
+        const auto index = static_cast<int32_t>(boxes_.size());
+        boxes_.push_back({box_type, static_cast<uint64_t>(address), box_length, parentBox_});
         if (skipBox(box_type)) {
             if (bTrace) {
                 out << std::endl;
@@ -249,10 +276,14 @@ namespace Exiv2
             return restore + buffer_size;
         }
 
-        DataBuf data(buffer_size);
-        const long box_end = restore + data.size();
-        io_->read(data.data(), data.size());
-        io_->seek(restore, BasicIo::beg);
+        // The enforce() above checks that box_end doesn't exceed pbox_end
+        const long box_end = restore + buffer_size;
+        DataBuf data(payloadSize(box_type, buffer_size));
+        io_->readAt(restore, data.data(), data.size());
+
+        // boxes found while handling this one are its children
+        const int32_t parent = parentBox_;
+        parentBox_ = index;
 
         long skip = 0;  // read position in data.pData_
         uint8_t version = 0;
@@ -283,9 +314,10 @@ namespace Exiv2
                     bLF = false;
                 }
 
-                enforce(data.size() - skip >= 2, Exiv2::kerCorruptedMetadata);
-                uint16_t n = data.read_uint16(skip, endian_);
-                skip += 2;
+                // the entry count has 32 bits since version 1
+                enforce(data.size() - skip >= (version == 0 ? 2 : 4), Exiv2::kerCorruptedMetadata);
+                uint32_t n = version == 0 ? data.read_uint16(skip, endian_) : data.read_uint32(skip, endian_);
+                skip += version == 0 ? 2 : 4;
 
                 io_->seek(skip, BasicIo::cur);
                 while (n-- > 0) {
@@ -509,6 +541,7 @@ namespace Exiv2
             default: break ; /* do nothing */
         }
         if (bLF && bTrace) out << std::endl;
+        parentBox_ = parent;
 
         // return address of next box
         return box_end;
@@ -522,10 +555,8 @@ namespace Exiv2
         enforce(length <= static_cast<unsigned long>(std::numeric_limits<long>::max()), kerCorruptedMetadata);
 
         // read and parse exif data
-        long    restore = io_->tell();
         DataBuf exif(static_cast<long>(length));
-        io_->seek(static_cast<long>(start),BasicIo::beg);
-        if ( exif.size() > 8 && io_->read(exif.data(),exif.size()) == exif.size() ) {
+        if ( exif.size() > 8 && io_->readAt(static_cast<long>(start),exif.data(),exif.size()) == exif.size() ) {
             // hunt for "II" or "MM"
             long  eof  = 0xffffffff; // impossible value for punt
             long  punt = eof;
@@ -540,7 +571,6 @@ namespace Exiv2
                   Internal::TiffMapping::findDecoder);
             }
         }
-        io_->seek(restore,BasicIo::beg);
     }
 
     void BmffImage::parseTiff(uint32_t root_tag, uint64_t length)
@@ -568,14 +598,11 @@ namespace Exiv2
             enforce(start <= io_->size(), kerCorruptedMetadata);
             enforce(length <= io_->size() - start, kerCorruptedMetadata);
 
-            long restore = io_->tell() ;
             enforce(start <= static_cast<unsigned long>(std::numeric_limits<long>::max()), kerCorruptedMetadata);
-            io_->seek(static_cast<long>(start),BasicIo::beg);
-
             enforce(length < static_cast<unsigned long>(std::numeric_limits<long>::max()), kerCorruptedMetadata);
             DataBuf  xmp(static_cast<long>(length+1));
             xmp.write_uint8(static_cast<size_t>(length), 0); // ensure xmp is null terminated!
-            if ( io_->read(xmp.data(), static_cast<long>(length)) != static_cast<long>(length) )
+            if ( io_->readAt(static_cast<long>(start), xmp.data(), static_cast<long>(length)) != static_cast<long>(length) )
                 throw Error(kerInputDataReadFailed);
             if ( io_->error() )
                 throw Error(kerFailedToReadImageData);
@@ -584,8 +611,6 @@ namespace Exiv2
             } catch (...) {
                 throw Error(kerFailedToReadImageData);
             }
-
-            io_->seek(restore,BasicIo::beg);
         }
     }
 
@@ -629,7 +654,7 @@ namespace Exiv2
 
     void BmffImage::setComment(const std::string& /*comment*/)
     {
-        // bmff files are read-only
+        // BMFF files have no image comment
         throw(Error(kerInvalidSettingForImage, "Image comment", "BMFF"));
     }  // BmffImage::setComment
 
@@ -653,6 +678,8 @@ namespace Exiv2
 
         clearMetadata();
         ilocs_.clear();
+        boxes_.clear();
+        parentBox_ = -1;
         visits_max_ = io_->size() / 16;
         unknownID_ = 0xffff;
         exifID_    = unknownID_;
@@ -665,6 +692,7 @@ namespace Exiv2
             address = boxHandler(std::cout,kpsNone,file_end,0);
         }
         bReadMetadata_ = true;
+        setMetadataClean();
     }  // BmffImage::readMetadata
 
     void BmffImage::printStructure(std::ostream& out, Exiv2::PrintStructureOption option,int depth)
@@ -692,6 +720,8 @@ namespace Exiv2
                 openOrThrow();
                 IoCloser closer(*io_);
 
+                boxes_.clear();
+                parentBox_ = -1;
                 long   address = 0;
                 const long file_end = static_cast<long>(io_->size());
                 while (address < file_end) {
@@ -702,10 +732,85 @@ namespace Exiv2
         }
     }
 
+    /*!
+      @brief Return the data of an Exif item with \em exifData, which replaces
+             the data of the Exif item \em item. The TIFF structure of \em item
+             is updated in place if possible and what precedes it is kept.
+     */
+    static DataBuf exifItemData(DataBuf item, const ExifData& exifData)
+    {
+        if (exifData.empty()) return {};
+
+        // The item starts with the offset of the TIFF header after the offset field
+        const auto size = static_cast<size_t>(item.size());
+        size_t tiff = size;
+        auto isTiff = [&item, size](size_t pos) {
+            if (pos + 8 > size) return false;
+            const byte c = item.read_uint8(pos);
+            return (c == 'I' || c == 'M') && item.read_uint8(pos + 1) == c;
+        };
+        if (size >= 8 && item.read_uint32(0, bigEndian) <= size - 8 && isTiff(4 + item.read_uint32(0, bigEndian))) {
+            tiff = 4 + item.read_uint32(0, bigEndian);
+        }
+        // hunt for "II" or "MM" like parseTiff()
+        for (size_t i = 0; tiff == size && i + 8 < size; i += 2) {
+            if (isTiff(i)) tiff = i;
+        }
+
+        Blob blob;
+        Blob data;
+        if (tiff < size) {
+            const ByteOrder bo = item.read_uint8(tiff) == 'I' ? littleEndian : bigEndian;
+            const WriteMethod wm = ExifParser::encode(blob, item.c_data(tiff), static_cast<uint32_t>(size - tiff), bo,
+                                                      exifData);
+            if (wm == wmNonIntrusive) return item;
+            data.assign(item.c_data(), item.c_data(tiff));
+        } else {
+            ExifParser::encode(blob, nullptr, 0, bigEndian, exifData);
+            data = {0, 0, 0, 6, 'E', 'x', 'i', 'f', 0, 0};
+        }
+        data.insert(data.end(), blob.begin(), blob.end());
+        return DataBuf(data.data(), static_cast<long>(data.size()));
+    }
+
     void BmffImage::writeMetadata()
     {
-        // bmff files are read-only
-        throw(Error(kerInvalidSettingForImage, "Image comment", "BMFF"));
+        // IPTC and the ICC profile are not written
+        const int changed = changedMetadata() & (mdExif | mdXmp);
+        if (changed == mdNone) {
+            setWrittenMetadata(mdNone);
+            return;
+        }
+        openOrThrow();
+        IoCloser closer(*io_);
+
+        Internal::BmffWriter writer(*io_);
+        if (!writer.good()) {
+            throw Error(kerWritingImageFormatUnsupported, mimeType());
+        }
+        int written = changed;
+        if (changed & mdExif) {
+            if (writer.isCr3()) {
+                // CR3 files keep Exif metadata in the CMT boxes of the moov box
+#ifndef SUPPRESS_WARNINGS
+                EXV_WARNING << "Writing Exif metadata to CR3 files is not supported.\n";
+#endif
+                written &= ~mdExif;
+            } else {
+                writer.setExifItem(exifItemData(writer.exifItem(), exifData_));
+            }
+        }
+        if (changed & mdXmp) {
+            if (!writeXmpFromPacket() && XmpParser::encode(xmpPacket_, xmpData_) > 1) {
+#ifndef SUPPRESS_WARNINGS
+                EXV_ERROR << "Failed to encode XMP metadata.\n";
+#endif
+            }
+            writer.setXmpPacket(xmpPacket_);
+        }
+        writer.write();
+        setWrittenMetadata(written);
+        setMetadataClean();
     }  // BmffImage::writeMetadata
 
     // *************************************************************************
@@ -0,0 +1,1017 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+// *****************************************************************************
+// included header files
+#include "config.h"
+
+#ifdef EXV_ENABLE_BMFF
+#include "bmffimage_int.hpp"
+
+#include "basicio.hpp"
+#include "enforce.hpp"
+#include "error.hpp"
+#include "futils.hpp"
+#include "image_int.hpp"
+#include "safe_op.hpp"
+
+// + standard includes
+#include <algorithm>
+#include <cstring>
+
+// *****************************************************************************
+namespace {
+    using namespace Exiv2;
+
+    const uint32_t boxFtyp = 0x66747970;  //!< "ftyp" File type
+    const uint32_t boxMeta = 0x6d657461;  //!< "meta" Metadata
+    const uint32_t boxMoov = 0x6d6f6f76;  //!< "moov" Movie
+    const uint32_t boxMdat = 0x6d646174;  //!< "mdat" Media data
+    const uint32_t boxFree = 0x66726565;  //!< "free" Free space
+    const uint32_t boxSkip = 0x736b6970;  //!< "skip" Free space
+    const uint32_t boxUuid = 0x75756964;  //!< "uuid" UUID
+    const uint32_t boxIinf = 0x69696e66;  //!< "iinf" Item information
+    const uint32_t boxInfe = 0x696e6665;  //!< "infe" Item information entry
+    const uint32_t boxIloc = 0x696c6f63;  //!< "iloc" Item location
+    const uint32_t boxIref = 0x69726566;  //!< "iref" Item reference
+    const uint32_t boxPitm = 0x7069746d;  //!< "pitm" Primary item
+    const uint32_t boxIdat = 0x69646174;  //!< "idat" Item data
+    const uint32_t boxTrak = 0x7472616b;  //!< "trak" Track
+    const uint32_t boxMdia = 0x6d646961;  //!< "mdia" Media
+    const uint32_t boxMinf = 0x6d696e66;  //!< "minf" Media information
+    const uint32_t boxStbl = 0x7374626c;  //!< "stbl" Sample table
+    const uint32_t boxStco = 0x7374636f;  //!< "stco" Chunk offsets
+    const uint32_t boxCo64 = 0x636f3634;  //!< "co64" 64-bit chunk offsets
+    const uint32_t boxCtbo = 0x4354424f;  //!< "CTBO" Canon table of box offsets
+
+    const uint32_t brandCrx = 0x63727820;  //!< "crx " Canon CR3
+    const uint32_t brandJxl = 0x6a786c20;  //!< "jxl " JPEG XL
+    const uint32_t itemExif = 0x45786966;  //!< "Exif" item type
+    const uint32_t itemMime = 0x6d696d65;  //!< "mime" item type
+    const uint32_t refCdsc = 0x63647363;   //!< "cdsc" content describes reference
+
+    const byte uuidCano[] = {0x85, 0xc0, 0xb6, 0x87, 0x82, 0x0f, 0x11, 0xe0,
+                             0x81, 0x11, 0xf4, 0xce, 0x46, 0x2b, 0x6a, 0x48};
+    const byte uuidXmp[] = {0xbe, 0x7a, 0xcf, 0xcb, 0x97, 0xa9, 0x42, 0xe8,
+                            0x9c, 0x71, 0x99, 0x94, 0x91, 0xe3, 0xaf, 0xac};
+
+    const char* xmpContentType = "application/rdf+xml";
+
+    //! Limit for the size of the boxes and items which are read into memory
+    const uint64_t maxBoxSize = 256 * 1024 * 1024;
+
+    //! Return the big endian value of \em size bytes at \em data
+    uint64_t readValue(const byte* data, size_t size)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; ++i) {
+            value = (value << 8) | data[i];
+        }
+        return value;
+    }
+
+    //! Write \em value to \em size bytes at \em data, big endian
+    void writeValue(byte* data, uint64_t value, size_t size)
+    {
+        for (size_t i = size; i-- > 0;) {
+            data[i] = static_cast<byte>(value);
+            value >>= 8;
+        }
+    }
+
+    //! Return true if \em value can be stored in \em size bytes
+    bool fits(uint64_t value, size_t size)
+    {
+        return size >= 8 || value >> (8 * size) == 0;
+    }
+
+    //! Return the smallest field size of an iloc box, 0, 4 or 8, for \em value
+    uint8_t fieldSize(uint64_t value, uint8_t size)
+    {
+        if (fits(value, size)) return size;
+        return fits(value, 4) ? 4 : 8;
+    }
+
+    //! Bounds checked reading of the fields of a box
+    class FieldReader {
+    public:
+        FieldReader(const byte* data, size_t size) : data_(data), size_(size)
+        {
+        }
+        uint64_t read(size_t size)
+        {
+            enforce(size <= size_ - pos_, kerCorruptedMetadata);
+            const uint64_t value = readValue(data_ + pos_, size);
+            pos_ += size;
+            return value;
+        }
+        std::string readString()
+        {
+            const auto str = reinterpret_cast<const char*>(data_ + pos_);
+            const size_t length = strnlen(str, size_ - pos_);
+            enforce(length < size_ - pos_, kerCorruptedMetadata);
+            pos_ += length + 1;
+            return std::string(str, length);
+        }
+        const byte* current() const { return data_ + pos_; }
+        size_t remaining() const { return size_ - pos_; }
+
+    private:
+        const byte* data_;
+        size_t size_;
+        size_t pos_{0};
+    };
+
+    //! Writing of the fields of a box
+    class FieldWriter {
+    public:
+        void write(uint64_t value, size_t size)
+        {
+            const size_t pos = data_.size();
+            data_.resize(pos + size);
+            writeValue(data_.data() + pos, value, size);
+        }
+        void write(const std::string& str)
+        {
+            data_.insert(data_.end(), str.begin(), str.end());
+            data_.push_back(0);
+        }
+        void write(const byte* data, size_t size)
+        {
+            data_.insert(data_.end(), data, data + size);
+        }
+        DataBuf box(uint32_t type) const
+        {
+            return Internal::makeBox(type, data_.data(), data_.size());
+        }
+
+    private:
+        Blob data_;
+    };
+
+    /*!
+      @brief Return the first \em bytes bytes of a free box of \em size bytes.
+             The header is followed by zeros.
+     */
+    DataBuf freeBox(uint64_t size, uint64_t bytes)
+    {
+        const uint32_t headerSize = size > 0xffffffff ? 16 : 8;
+        enforce(size >= headerSize && bytes >= headerSize && bytes <= size, kerImageWriteFailed);
+        enforce(bytes <= maxBoxSize, kerImageWriteFailed);
+        DataBuf box(static_cast<long>(bytes));
+        std::memset(box.data(), 0, box.size());
+        if (headerSize == 16) {
+            writeValue(box.data(), 1, 4);
+            writeValue(box.data(8), size, 8);
+        } else {
+            writeValue(box.data(), size, 4);
+        }
+        writeValue(box.data(4), boxFree, 4);
+        return box;
+    }
+
+    //! Return the concatenation of \em a and \em b
+    DataBuf concat(const DataBuf& a, const DataBuf& b)
+    {
+        DataBuf result(a.size() + b.size());
+        if (a.size() > 0) std::memcpy(result.data(), a.c_data(), a.size());
+        if (b.size() > 0) std::memcpy(result.data(a.size()), b.c_data(), b.size());
+        return result;
+    }
+
+    //! Read the payload of \em box into memory
+    DataBuf readPayload(BasicIo& io, const Internal::BmffBoxHeader& box)
+    {
+        const uint64_t size = box.length_ - box.headerSize_;
+        enforce(size <= maxBoxSize, kerCorruptedMetadata);
+        DataBuf data(static_cast<long>(size));
+        if (size > 0 && io.readAt(static_cast<int64_t>(box.payload()), data.data(), data.size()) != data.size()) {
+            throw Error(kerInputDataReadFailed);
+        }
+        return data;
+    }
+
+    /*!
+      @brief Update the chunk offsets in the boxes in \em data after \em edits.
+             The size of the CTBO entry of the box at \em xmpOffset is set to
+             \em xmpLength, if that is not 0.
+      @return true if anything changed.
+     */
+    bool updateOffsets(byte* data, size_t size, const std::vector<Internal::BmffEdit>& edits,
+                       uint64_t xmpOffset, uint64_t xmpLength, int depth)
+    {
+        enforce(depth < 16, kerCorruptedMetadata);
+        bool changed = false;
+        for (auto&& box : Internal::boxHeaders(data, size)) {
+            byte* payload = data + box.payload();
+            const auto length = static_cast<size_t>(box.length_ - box.headerSize_);
+            switch (box.type_) {
+                case boxTrak:
+                case boxMdia:
+                case boxMinf:
+                case boxStbl:
+                    changed |= updateOffsets(payload, length, edits, xmpOffset, xmpLength, depth + 1);
+                    break;
+                case boxUuid:
+                    if (length >= 16 && std::memcmp(payload, uuidCano, 16) == 0) {
+                        changed |= updateOffsets(payload + 16, length - 16, edits, xmpOffset, xmpLength, depth + 1);
+                    }
+                    break;
+                case boxStco:
+                case boxCo64: {
+                    const size_t entrySize = box.type_ == boxStco ? 4 : 8;
+                    enforce(length >= 8, kerCorruptedMetadata);
+                    const uint64_t count = readValue(payload + 4, 4);
+                    enforce(count <= (length - 8) / entrySize, kerCorruptedMetadata);
+                    for (uint64_t i = 0; i < count; ++i) {
+                        byte* entry = payload + 8 + i * entrySize;
+                        const uint64_t offset = readValue(entry, entrySize);
+                        const uint64_t moved = Internal::editedOffset(edits, offset);
+                        if (moved != offset) {
+                            enforce(fits(moved, entrySize), kerImageWriteFailed);
+                            writeValue(entry, moved, entrySize);
+                            changed = true;
+                        }
+                    }
+                } break;
+                case boxCtbo: {
+                    // u32 count, then entries of u32 index, u64 offset and u64 size
+                    enforce(length >= 4, kerCorruptedMetadata);
+                    const uint64_t count = readValue(payload, 4);
+                    enforce(count <= (length - 4) / 20, kerCorruptedMetadata);
+                    for (uint64_t i = 0; i < count; ++i) {
+                        byte* entry = payload + 4 + i * 20;
+                        const uint64_t offset = readValue(entry + 4, 8);
+                        if (offset == 0) continue;
+                        const uint64_t moved = Internal::editedOffset(edits, offset);
+                        if (moved != offset) {
+                            writeValue(entry + 4, moved, 8);
+                            changed = true;
+                        }
+                        if (xmpLength != 0 && offset == xmpOffset && readValue(entry + 12, 8) != xmpLength) {
+                            writeValue(entry + 12, xmpLength, 8);
+                            changed = true;
+                        }
+                    }
+                } break;
+                default:
+                    break;
+            }
+        }
+        return changed;
+    }
+}  // namespace
+
+// *****************************************************************************
+// class member definitions
+namespace Exiv2 {
+    namespace Internal {
+
+    std::vector<BmffBoxHeader> readBoxHeaders(BasicIo& io, uint64_t start, uint64_t end)
+    {
+        std::vector<BmffBoxHeader> boxes;
+        uint64_t pos = start;
+        while (end - pos >= 8) {
+            byte buf[16];
+            if (io.readAt(static_cast<int64_t>(pos), buf, 8) != 8) throw Error(kerInputDataReadFailed);
+            BmffBoxHeader box;
+            box.type_ = static_cast<uint32_t>(readValue(buf + 4, 4));
+            box.offset_ = pos;
+            box.length_ = readValue(buf, 4);
+            box.headerSize_ = 8;
+            if (box.length_ == 1) {
+                enforce(end - pos >= 16, kerCorruptedMetadata);
+                if (io.readAt(static_cast<int64_t>(pos + 8), buf + 8, 8) != 8) throw Error(kerInputDataReadFailed);
+                box.length_ = readValue(buf + 8, 8);
+                box.headerSize_ = 16;
+            } else if (box.length_ == 0) {
+                box.length_ = end - pos;
+                box.extendsToEnd_ = true;
+            }
+            enforce(box.length_ >= box.headerSize_ && box.length_ <= end - pos, kerCorruptedMetadata);
+            boxes.push_back(box);
+            pos += box.length_;
+        }
+        return boxes;
+    }
+
+    std::vector<BmffBoxHeader> boxHeaders(const byte* data, size_t size)
+    {
+        std::vector<BmffBoxHeader> boxes;
+        size_t pos = 0;
+        while (size - pos >= 8) {
+            BmffBoxHeader box;
+            box.type_ = static_cast<uint32_t>(readValue(data + pos + 4, 4));
+            box.offset_ = pos;
+            box.length_ = readValue(data + pos, 4);
+            box.headerSize_ = 8;
+            if (box.length_ == 1) {
+                enforce(size - pos >= 16, kerCorruptedMetadata);
+                box.length_ = readValue(data + pos + 8, 8);
+                box.headerSize_ = 16;
+            } else if (box.length_ == 0) {
+                box.length_ = size - pos;
+                box.extendsToEnd_ = true;
+            }
+            enforce(box.length_ >= box.headerSize_ && box.length_ <= size - pos, kerCorruptedMetadata);
+            boxes.push_back(box);
+            pos += static_cast<size_t>(box.length_);
+        }
+        return boxes;
+    }
+
+    DataBuf makeBox(uint32_t type, const byte* payload, size_t size)
+    {
+        enforce(size <= maxBoxSize, kerImageWriteFailed);
+        DataBuf box(static_cast<long>(8 + size));
+        writeValue(box.data(), 8 + size, 4);
+        writeValue(box.data(4), type, 4);
+        if (size > 0) std::memcpy(box.data(8), payload, size);
+        return box;
+    }
+
+    IlocBox::IlocBox(const byte* payload, size_t size)
+    {
+        FieldReader reader(payload, size);
+        const uint64_t versionFlags = reader.read(4);
+        version_ = static_cast<uint8_t>(versionFlags >> 24);
+        flags_ = versionFlags & 0xffffff;
+        enforce(version_ <= 2, kerCorruptedMetadata);
+        const uint64_t sizes = reader.read(2);
+        offsetSize_ = static_cast<uint8_t>(sizes >> 12);
+        lengthSize_ = (sizes >> 8) & 0xf;
+        baseOffsetSize_ = (sizes >> 4) & 0xf;
+        indexSize_ = version_ > 0 ? sizes & 0xf : 0;
+        for (auto fieldSize : {offsetSize_, lengthSize_, baseOffsetSize_, indexSize_}) {
+            enforce(fieldSize == 0 || fieldSize == 4 || fieldSize == 8, kerCorruptedMetadata);
+        }
+        const uint64_t count = reader.read(version_ < 2 ? 2 : 4);
+        for (uint64_t i = 0; i < count; ++i) {
+            Item item;
+            item.id_ = static_cast<uint32_t>(reader.read(version_ < 2 ? 2 : 4));
+            if (version_ > 0) {
+                item.constructionMethod_ = reader.read(2) & 0xf;
+            }
+            item.dataReferenceIndex_ = static_cast<uint16_t>(reader.read(2));
+            item.baseOffset_ = reader.read(baseOffsetSize_);
+            const uint64_t extents = reader.read(2);
+            for (uint64_t j = 0; j < extents; ++j) {
+                Extent extent;
+                extent.index_ = reader.read(indexSize_);
+                extent.offset_ = reader.read(offsetSize_);
+                extent.length_ = reader.read(lengthSize_);
+                item.extents_.push_back(extent);
+            }
+            items_.push_back(std::move(item));
+        }
+    }
+
+    IlocBox::Item* IlocBox::find(uint32_t id)
+    {
+        auto item = std::find_if(items_.begin(), items_.end(), [id](const Item& i) { return i.id_ == id; });
+        return item == items_.end() ? nullptr : &*item;
+    }
+
+    void IlocBox::remove(uint32_t id)
+    {
+        items_.erase(std::remove_if(items_.begin(), items_.end(), [id](const Item& i) { return i.id_ == id; }),
+                     items_.end());
+    }
+
+    DataBuf IlocBox::box()
+    {
+        for (auto&& item : items_) {
+            if (item.id_ > 0xffff || items_.size() > 0xffff) version_ = 2;
+            if (item.constructionMethod_ != 0 && version_ == 0) version_ = 1;
+            baseOffsetSize_ = fieldSize(item.baseOffset_, baseOffsetSize_);
+            for (auto&& extent : item.extents_) {
+                if (extent.index_ != 0 && version_ > 0) indexSize_ = fieldSize(extent.index_, indexSize_);
+                offsetSize_ = fieldSize(extent.offset_, offsetSize_);
+                lengthSize_ = fieldSize(extent.length_, lengthSize_);
+            }
+            enforce(item.extents_.size() <= 0xffff, kerImageWriteFailed);
+        }
+        FieldWriter writer;
+        writer.write((static_cast<uint64_t>(version_) << 24) | flags_, 4);
+        writer.write((offsetSize_ << 4) | lengthSize_, 1);
+        writer.write((baseOffsetSize_ << 4) | (version_ > 0 ? indexSize_ : 0), 1);
+        writer.write(items_.size(), version_ < 2 ? 2 : 4);
+        for (auto&& item : items_) {
+            writer.write(item.id_, version_ < 2 ? 2 : 4);
+            if (version_ > 0) {
+                writer.write(item.constructionMethod_, 2);
+            }
+            writer.write(item.dataReferenceIndex_, 2);
+            writer.write(item.baseOffset_, baseOffsetSize_);
+            writer.write(item.extents_.size(), 2);
+            for (auto&& extent : item.extents_) {
+                if (version_ > 0) writer.write(extent.index_, indexSize_);
+                writer.write(extent.offset_, offsetSize_);
+                writer.write(extent.length_, lengthSize_);
+            }
+        }
+        return writer.box(boxIloc);
+    }
+
+    IinfBox::IinfBox(const byte* payload, size_t size)
+    {
+        FieldReader reader(payload, size);
+        const uint64_t versionFlags = reader.read(4);
+        version_ = static_cast<uint8_t>(versionFlags >> 24);
+        flags_ = versionFlags & 0xffffff;
+        reader.read(version_ == 0 ? 2 : 4);  // entry count, the boxes are what counts
+        const byte* boxes = reader.current();
+        for (auto&& infe : boxHeaders(boxes, reader.remaining())) {
+            Entry entry;
+            entry.box_ = DataBuf(boxes + infe.offset_, static_cast<long>(infe.length_));
+            if (infe.type_ == boxInfe) {
+                FieldReader fields(boxes + infe.payload(), static_cast<size_t>(infe.length_ - infe.headerSize_));
+                const auto version = static_cast<uint8_t>(fields.read(4) >> 24);
+                entry.id_ = static_cast<uint32_t>(fields.read(version == 3 ? 4 : 2));
+                if (version >= 2) {
+                    fields.read(2);  // protection index
+                    entry.type_ = static_cast<uint32_t>(fields.read(4));
+                    fields.readString();  // name
+                    if (entry.type_ == itemMime && fields.remaining() > 0) {
+                        entry.contentType_ = fields.readString();
+                    }
+                }
+            }
+            entries_.push_back(std::move(entry));
+        }
+    }
+
+    const IinfBox::Entry* IinfBox::find(uint32_t type, const std::string& contentType) const
+    {
+        for (auto&& entry : entries_) {
+            if (entry.type_ == type && (contentType.empty() || entry.contentType_ == contentType)) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    uint32_t IinfBox::maxId() const
+    {
+        uint32_t id = 0;
+        for (auto&& entry : entries_) {
+            id = std::max(id, entry.id_);
+        }
+        return id;
+    }
+
+    void IinfBox::add(uint32_t id, uint32_t type, const std::string& name, const std::string& contentType)
+    {
+        const uint64_t version = id > 0xffff ? 3 : 2;
+        FieldWriter writer;
+        writer.write(version << 24, 4);
+        writer.write(id, version == 3 ? 4 : 2);
+        writer.write(uint64_t{0}, 2);  // protection index
+        writer.write(type, 4);
+        writer.write(name);
+        if (!contentType.empty()) {
+            writer.write(contentType);
+        }
+        Entry entry;
+        entry.id_ = id;
+        entry.type_ = type;
+        entry.contentType_ = contentType;
+        entry.box_ = writer.box(boxInfe);
+        entries_.push_back(std::move(entry));
+    }
+
+    void IinfBox::remove(uint32_t id)
+    {
+        entries_.erase(std::remove_if(entries_.begin(), entries_.end(), [id](const Entry& e) { return e.id_ == id; }),
+                       entries_.end());
+    }
+
+    DataBuf IinfBox::box()
+    {
+        if (version_ == 0 && entries_.size() > 0xffff) version_ = 1;
+        FieldWriter writer;
+        writer.write((static_cast<uint64_t>(version_) << 24) | flags_, 4);
+        writer.write(entries_.size(), version_ == 0 ? 2 : 4);
+        for (auto&& entry : entries_) {
+            writer.write(entry.box_.c_data(), entry.box_.size());
+        }
+        return writer.box(boxIinf);
+    }
+
+    IrefBox::IrefBox(const byte* payload, size_t size)
+    {
+        FieldReader reader(payload, size);
+        const uint64_t versionFlags = reader.read(4);
+        version_ = static_cast<uint8_t>(versionFlags >> 24);
+        flags_ = versionFlags & 0xffffff;
+        const size_t idSize = version_ == 0 ? 2 : 4;
+        const byte* boxes = reader.current();
+        for (auto&& box : boxHeaders(boxes, reader.remaining())) {
+            FieldReader fields(boxes + box.payload(), static_cast<size_t>(box.length_ - box.headerSize_));
+            Reference reference;
+            reference.type_ = box.type_;
+            reference.from_ = static_cast<uint32_t>(fields.read(idSize));
+            const uint64_t count = fields.read(2);
+            for (uint64_t i = 0; i < count; ++i) {
+                reference.to_.push_back(static_cast<uint32_t>(fields.read(idSize)));
+            }
+            references_.push_back(std::move(reference));
+        }
+    }
+
+    void IrefBox::add(uint32_t type, uint32_t from, uint32_t to)
+    {
+        references_.push_back({type, from, {to}});
+    }
+
+    void IrefBox::remove(uint32_t id)
+    {
+        for (auto&& reference : references_) {
+            auto& to = reference.to_;
+            to.erase(std::remove(to.begin(), to.end(), id), to.end());
+        }
+        references_.erase(std::remove_if(references_.begin(), references_.end(),
+                                         [id](const Reference& r) { return r.from_ == id || r.to_.empty(); }),
+                          references_.end());
+    }
+
+    DataBuf IrefBox::box()
+    {
+        for (auto&& reference : references_) {
+            if (reference.from_ > 0xffff) version_ = 1;
+            for (auto to : reference.to_) {
+                if (to > 0xffff) version_ = 1;
+            }
+            enforce(reference.to_.size() <= 0xffff, kerImageWriteFailed);
+        }
+        const size_t idSize = version_ == 0 ? 2 : 4;
+        FieldWriter writer;
+        writer.write((static_cast<uint64_t>(version_) << 24) | flags_, 4);
+        for (auto&& reference : references_) {
+            FieldWriter fields;
+            fields.write(reference.from_, idSize);
+            fields.write(reference.to_.size(), 2);
+            for (auto to : reference.to_) {
+                fields.write(to, idSize);
+            }
+            const DataBuf box = fields.box(reference.type_);
+            writer.write(box.c_data(), box.size());
+        }
+        return writer.box(boxIref);
+    }
+
+    BmffWriter::BmffWriter(BasicIo& io) : io_(io), size_(io.size())
+    {
+        boxes_ = readBoxHeaders(io_, 0, size_);
+        for (size_t i = 0; i < boxes_.size(); ++i) {
+            const BmffBoxHeader& box = boxes_[i];
+            if (box.type_ == boxFtyp && brand_ == 0 && box.length_ >= box.headerSize_ + 4) {
+                byte brand[4];
+                if (io_.readAt(static_cast<int64_t>(box.payload()), brand, 4) != 4) {
+                    throw Error(kerInputDataReadFailed);
+                }
+                brand_ = static_cast<uint32_t>(readValue(brand, 4));
+            } else if (box.type_ == boxMeta && meta_ < 0) {
+                meta_ = static_cast<int>(i);
+            } else if (box.type_ == boxMoov && moov_ < 0) {
+                moov_ = static_cast<int>(i);
+            }
+        }
+        if (meta_ < 0 || isCr3()) return;
+
+        const BmffBoxHeader& meta = boxes_[meta_];
+        metaData_ = readPayload(io_, meta);
+        enforce(metaData_.size() >= 4, kerCorruptedMetadata);
+        metaBoxes_ = boxHeaders(metaData_.c_data(4), metaData_.size() - 4);
+        for (auto&& box : metaBoxes_) {
+            box.offset_ += 4;
+            const byte* payload = metaData_.c_data(box.payload());
+            const auto size = static_cast<size_t>(box.length_ - box.headerSize_);
+            switch (box.type_) {
+                case boxIinf:
+                    iinf_ = std::make_unique<IinfBox>(payload, size);
+                    break;
+                case boxIloc:
+                    iloc_ = std::make_unique<IlocBox>(payload, size);
+                    break;
+                case boxIref:
+                    iref_ = std::make_unique<IrefBox>(payload, size);
+                    break;
+                case boxPitm: {
+                    FieldReader reader(payload, size);
+                    const auto version = static_cast<uint8_t>(reader.read(4) >> 24);
+                    primaryId_ = static_cast<uint32_t>(reader.read(version == 0 ? 2 : 4));
+                } break;
+                case boxIdat:
+                    idat_ = meta.payload() + box.payload();
+                    idatSize_ = size;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    bool BmffWriter::good() const
+    {
+        if (isCr3()) return true;
+        return brand_ != brandJxl && iinf_ && iloc_;
+    }
+
+    bool BmffWriter::isCr3() const
+    {
+        return brand_ == brandCrx;
+    }
+
+    DataBuf BmffWriter::exifItem()
+    {
+        if (!iinf_ || !iloc_) return {};
+        const IinfBox::Entry* entry = iinf_->find(itemExif);
+        const IlocBox::Item* item = entry ? iloc_->find(entry->id_) : nullptr;
+        return item ? readItem(*item) : DataBuf();
+    }
+
+    void BmffWriter::setExifItem(DataBuf item)
+    {
+        setExif_ = true;
+        exif_ = std::move(item);
+    }
+
+    void BmffWriter::setXmpPacket(const std::string& packet)
+    {
+        setXmp_ = true;
+        xmp_ = packet;
+    }
+
+    DataBuf BmffWriter::readItem(const IlocBox::Item& item) const
+    {
+        if (item.dataReferenceIndex_ != 0 || item.constructionMethod_ > 1) return {};
+        const uint64_t start = item.constructionMethod_ == 0 ? 0 : idat_;
+        const uint64_t end = item.constructionMethod_ == 0 ? size_ : idat_ + idatSize_;
+        Blob data;
+        for (auto&& extent : item.extents_) {
+            const uint64_t offset = Safe::add(Safe::add(start, item.baseOffset_), extent.offset_);
+            enforce(offset <= end, kerCorruptedMetadata);
+            const uint64_t length = extent.length_ != 0 ? extent.length_ : end - offset;
+            enforce(length <= end - offset && length <= maxBoxSize - data.size(), kerCorruptedMetadata);
+            const size_t pos = data.size();
+            data.resize(pos + static_cast<size_t>(length));
+            if (length > 0 && io_.readAt(static_cast<int64_t>(offset), data.data() + pos, static_cast<long>(length)) !=
+                                  static_cast<long>(length)) {
+                throw Error(kerInputDataReadFailed);
+            }
+        }
+        return DataBuf(data.data(), static_cast<long>(data.size()));
+    }
+
+    BmffEdit BmffWriter::replaceBox(size_t index, const DataBuf& box) const
+    {
+        const BmffBoxHeader& old = boxes_[index];
+        const auto size = static_cast<uint64_t>(box.size());
+        uint64_t room = old.length_;
+        if (size != room && size + 8 > room && index + 1 < boxes_.size()) {
+            // a free box which follows is used too
+            const BmffBoxHeader& next = boxes_[index + 1];
+            if (next.type_ == boxFree || next.type_ == boxSkip) room += next.length_;
+        }
+        const uint64_t rest = room - size;
+        const uint64_t headerSize = rest > 0xffffffff ? 16 : 8;
+        if (size > room || (rest != 0 && rest < headerSize)) {
+            return {old.offset_, old.length_, DataBuf(box.c_data(), box.size())};
+        }
+        if (rest == 0) {
+            return {old.offset_, room, DataBuf(box.c_data(), box.size())};
+        }
+        // Pad with a free box. The rest of the old box is cleared, the content
+        // of a free box which follows is kept.
+        const uint64_t length = std::max(old.length_, size + headerSize);
+        return {old.offset_, length, concat(box, freeBox(rest, length - size))};
+    }
+
+    DataBuf BmffWriter::metaBox()
+    {
+        FieldWriter writer;
+        writer.write(metaData_.c_data(), 4);  // version and flags
+        bool hasIref = false;
+        for (auto&& box : metaBoxes_) {
+            DataBuf data;
+            switch (box.type_) {
+                case boxIinf:
+                    data = iinf_->box();
+                    break;
+                case boxIloc:
+                    data = iloc_->box();
+                    break;
+                case boxIref:
+                    hasIref = true;
+                    if (!iref_->references_.empty()) data = iref_->box();
+                    break;
+                default:
+                    data = DataBuf(metaData_.c_data(box.offset_), static_cast<long>(box.length_));
+                    break;
+            }
+            writer.write(data.c_data(), data.size());
+        }
+        if (!hasIref && iref_ && !iref_->references_.empty()) {
+            const DataBuf iref = iref_->box();
+            writer.write(iref.c_data(), iref.size());
+        }
+        return writer.box(boxMeta);
+    }
+
+    void BmffWriter::heifEdits(std::vector<BmffEdit>& edits)
+    {
+        const std::vector<IlocBox::Item> original = iloc_->items_;
+        //! New location of an item, in the file or in the appended mdat box
+        struct Placement {
+            uint32_t id_;
+            bool appended_;
+            uint64_t offset_;
+        };
+        std::vector<Placement> placements;
+        std::vector<BmffEdit> itemEdits;
+        Blob appended;
+
+        // Clear the old data of an item which is removed or moved
+        auto clear = [&](const IlocBox::Item& item, uint64_t from) {
+            if (item.constructionMethod_ != 0 || item.dataReferenceIndex_ != 0) return;
+            for (auto&& extent : item.extents_) {
+                const uint64_t offset = Safe::add(item.baseOffset_, extent.offset_);
+                if (extent.length_ <= from || offset > size_ || extent.length_ > size_ - offset) continue;
+                DataBuf zeros(static_cast<long>(extent.length_ - from));
+                std::memset(zeros.data(), 0, zeros.size());
+                itemEdits.push_back({offset + from, extent.length_ - from, std::move(zeros)});
+                from = 0;
+            }
+        };
+
+        auto place = [&](uint32_t type, const std::string& name, const std::string& contentType, const byte* data,
+                         size_t size) {
+            const IinfBox::Entry* entry = iinf_->find(type, contentType);
+            if (size == 0) {
+                if (!entry) return;
+                const uint32_t id = entry->id_;
+                if (const IlocBox::Item* item = iloc_->find(id)) clear(*item, 0);
+                iinf_->remove(id);
+                iloc_->remove(id);
+                if (iref_) iref_->remove(id);
+                return;
+            }
+            uint32_t id = 0;
+            if (entry) {
+                id = entry->id_;
+            } else {
+                id = iinf_->maxId();
+                for (auto&& item : iloc_->items_) {
+                    id = std::max(id, item.id_);
+                }
+                id = Safe::add(id, 1U);
+                iinf_->add(id, type, name, contentType);
+                if (primaryId_ != 0) {
+                    if (!iref_) iref_ = std::make_unique<IrefBox>();
+                    iref_->add(refCdsc, id, primaryId_);
+                }
+            }
+            IlocBox::Item* item = iloc_->find(id);
+            if (!item) {
+                iloc_->items_.emplace_back();
+                item = &iloc_->items_.back();
+                item->id_ = id;
+            }
+            // The old location is used if the data fits into its only extent
+            const IlocBox::Extent* extent = item->extents_.size() == 1 ? &item->extents_[0] : nullptr;
+            const uint64_t offset = extent ? Safe::add(item->baseOffset_, extent->offset_) : 0;
+            if (item->constructionMethod_ == 0 && item->dataReferenceIndex_ == 0 && extent &&
+                extent->length_ >= size && offset <= size_ && extent->length_ <= size_ - offset) {
+                itemEdits.push_back({offset, size, DataBuf(data, static_cast<long>(size))});
+                clear(*item, size);
+                placements.push_back({id, false, offset});
+            } else {
+                clear(*item, 0);
+                placements.push_back({id, true, appended.size()});
+                appended.insert(appended.end(), data, data + size);
+            }
+            item->constructionMethod_ = 0;
+            item->dataReferenceIndex_ = 0;
+            item->baseOffset_ = 0;
+            item->extents_ = {{0, 0, size}};
+        };
+
+        if (setExif_) {
+            place(itemExif, "", "", exif_.c_data(), exif_.size());
+        }
+        if (setXmp_) {
+            place(itemMime, "XMP", xmpContentType, reinterpret_cast<const byte*>(xmp_.data()), xmp_.size());
+        }
+
+        // The data of the items is appended in a new mdat box
+        DataBuf mdat;
+        bool setMoovLength = false;
+        if (!appended.empty()) {
+            mdat = makeBox(boxMdat, appended.data(), appended.size());
+            const BmffBoxHeader& last = boxes_.back();
+            const int index = static_cast<int>(boxes_.size()) - 1;
+            if (last.extendsToEnd_ && index != meta_) {
+                // the last box ends where it did before
+                enforce(last.headerSize_ == 8 && fits(last.length_, 4), kerImageWriteFailed);
+                if (index == moov_) {
+                    // the edit of the moov box sets it
+                    setMoovLength = true;
+                } else {
+                    DataBuf length(4);
+                    writeValue(length.data(), last.length_, 4);
+                    itemEdits.push_back({last.offset_, 4, std::move(length)});
+                }
+            }
+        }
+
+        // The meta box depends on the positions of the items, which depend on the
+        // size of the meta box. Repeat until the size doesn't change anymore.
+        DataBuf meta = metaBox();
+        for (int pass = 0;; ++pass) {
+            enforce(pass < 4, kerImageWriteFailed);
+            std::vector<BmffEdit>& layout = itemEdits;
+            layout.push_back(replaceBox(static_cast<size_t>(meta_), meta));
+            const uint64_t mdatData = editedOffset(layout, size_) + (mdat.size() - appended.size());
+            for (auto&& item : iloc_->items_) {
+                auto placement = std::find_if(placements.begin(), placements.end(),
+                                              [&item](const Placement& p) { return p.id_ == item.id_; });
+                if (placement != placements.end()) {
+                    const uint64_t offset = placement->appended_ ? mdatData + placement->offset_
+                                                                 : editedOffset(layout, placement->offset_);
+                    // like the other items, if they have base offsets
+                    if (iloc_->baseOffsetSize_ > 0) {
+                        item.baseOffset_ = offset;
+                    } else {
+                        item.extents_[0].offset_ = offset;
+                    }
+                    continue;
+                }
+                auto old = std::find_if(original.begin(), original.end(),
+                                        [&item](const IlocBox::Item& i) { return i.id_ == item.id_; });
+                if (old == original.end() || old->constructionMethod_ != 0 || old->dataReferenceIndex_ != 0) {
+                    continue;
+                }
+                if (old->baseOffset_ != 0) {
+                    item.baseOffset_ = editedOffset(layout, old->baseOffset_);
+                } else {
+                    for (size_t i = 0; i < item.extents_.size(); ++i) {
+                        item.extents_[i].offset_ = editedOffset(layout, old->extents_[i].offset_);
+                    }
+                }
+            }
+            layout.pop_back();
+            DataBuf next = metaBox();
+            const bool done = next.size() == meta.size();
+            meta = std::move(next);
+            if (done) break;
+        }
+
+        for (auto&& edit : itemEdits) {
+            edits.push_back(std::move(edit));
+        }
+        edits.push_back(replaceBox(static_cast<size_t>(meta_), meta));
+        if (mdat.size() > 0) {
+            edits.push_back({size_, 0, std::move(mdat)});
+        }
+        moovEdit(edits, 0, 0, setMoovLength);
+    }
+
+    void BmffWriter::cr3Edits(std::vector<BmffEdit>& edits)
+    {
+        if (!setXmp_) return;
+        int xmp = -1;
+        for (size_t i = 0; i < boxes_.size() && xmp < 0; ++i) {
+            byte uuid[16];
+            if (boxes_[i].type_ == boxUuid && boxes_[i].length_ >= boxes_[i].headerSize_ + 16 &&
+                io_.readAt(static_cast<int64_t>(boxes_[i].payload()), uuid, 16) == 16 &&
+                std::memcmp(uuid, uuidXmp, 16) == 0) {
+                xmp = static_cast<int>(i);
+            }
+        }
+
+        DataBuf box;
+        if (!xmp_.empty()) {
+            Blob payload(uuidXmp, uuidXmp + 16);
+            payload.insert(payload.end(), xmp_.begin(), xmp_.end());
+            box = makeBox(boxUuid, payload.data(), payload.size());
+        }
+        if (xmp >= 0) {
+            const BmffBoxHeader& old = boxes_[xmp];
+            if (box.size() == 0) {
+                // The box is cleared, the file keeps its layout
+                edits.push_back({old.offset_, old.length_, freeBox(old.length_, old.length_)});
+            } else {
+                edits.push_back(replaceBox(static_cast<size_t>(xmp), box));
+            }
+        } else if (box.size() > 0) {
+            const uint64_t offset = boxes_[moov_ >= 0 ? moov_ : 0].end();
+            edits.push_back({offset, 0, DataBuf(box.c_data(), box.size())});
+        }
+        moovEdit(edits, xmp >= 0 ? boxes_[xmp].offset_ : 0, static_cast<uint64_t>(box.size()));
+    }
+
+    void BmffWriter::moovEdit(std::vector<BmffEdit>& edits, uint64_t xmpOffset, uint64_t xmpLength,
+                              bool setLength) const
+    {
+        if (moov_ < 0) return;
+        const BmffBoxHeader& moov = boxes_[moov_];
+        DataBuf payload = readPayload(io_, moov);
+        if (updateOffsets(payload.data(), payload.size(), edits, xmpOffset, xmpLength, 0) || setLength) {
+            DataBuf header(static_cast<long>(moov.headerSize_));
+            if (io_.readAt(static_cast<int64_t>(moov.offset_), header.data(), header.size()) != header.size()) {
+                throw Error(kerInputDataReadFailed);
+            }
+            if (setLength) writeValue(header.data(), moov.length_, 4);
+            edits.push_back({moov.offset_, moov.length_, concat(header, payload)});
+        }
+    }
+
+    bool BmffWriter::apply(std::vector<BmffEdit>& edits)
+    {
+        std::stable_sort(edits.begin(), edits.end(),
+                         [](const BmffEdit& a, const BmffEdit& b) { return a.offset_ < b.offset_; });
+        if (edits.empty()) return true;
+        bool inPlace = true;
+        uint64_t pos = 0;
+        for (auto&& edit : edits) {
+            enforce(edit.offset_ >= pos && edit.length_ <= size_ - edit.offset_, kerImageWriteFailed);
+            pos = edit.offset_ + edit.length_;
+            if (static_cast<uint64_t>(edit.data_.size()) != edit.length_ && edit.offset_ != size_) inPlace = false;
+        }
+
+        auto file = dynamic_cast<FileIo*>(&io_);
+        if (inPlace && (file || dynamic_cast<MemIo*>(&io_))) {
+            if (file) {
+                io_.close();
+                if (file->open("r+b") != 0) {
+                    throw Error(kerFileOpenFailed, io_.path(), "r+b", strError());
+                }
+            }
+            for (auto&& edit : edits) {
+                if (io_.seek(static_cast<int64_t>(edit.offset_), BasicIo::beg) != 0 ||
+                    io_.write(edit.data_.c_data(), edit.data_.size()) != edit.data_.size()) {
+                    throw Error(kerImageWriteFailed);
+                }
+            }
+            io_.close();
+            return true;
+        }
+
+        auto tempIo = std::make_unique<TempIo>(io_);
+        pos = 0;
+        for (auto&& edit : edits) {
+            copyData(io_, static_cast<long>(pos), static_cast<long>(edit.offset_ - pos), *tempIo);
+            if (tempIo->write(edit.data_.c_data(), edit.data_.size()) != edit.data_.size()) {
+                throw Error(kerImageWriteFailed);
+            }
+            pos = edit.offset_ + edit.length_;
+        }
+        copyData(io_, static_cast<long>(pos), static_cast<long>(size_ - pos), *tempIo);
+        io_.close();
+        io_.transfer(*tempIo);
+        return false;
+    }
+
+    bool BmffWriter::write()
+    {
+        enforce(good(), kerWritingImageFormatUnsupported, "BMFF");
+        std::vector<BmffEdit> edits;
+        if (isCr3()) {
+            cr3Edits(edits);
+        } else {
+            heifEdits(edits);
+        }
+        return apply(edits);
+    }
+
+    uint64_t editedOffset(const std::vector<BmffEdit>& edits, uint64_t offset)
+    {
+        uint64_t result = offset;
+        for (auto&& edit : edits) {
+            if (edit.offset_ + edit.length_ <= offset) {
+                result = result + edit.data_.size() - edit.length_;
+            }
+        }
+        return result;
+    }
+
+}}                                      // namespace Internal, Exiv2
+#endif  // EXV_ENABLE_BMFF
@@ -0,0 +1,270 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef BMFFIMAGE_INT_HPP_
+#define BMFFIMAGE_INT_HPP_
+
+// *****************************************************************************
+// included header files
+#include "types.hpp"
+
+// + standard includes
+#include <memory>
+#include <string>
+#include <vector>
+
+// *****************************************************************************
+// namespace extensions
+namespace Exiv2 {
+
+// *****************************************************************************
+// class declarations
+    class BasicIo;
+
+    namespace Internal {
+
+// *****************************************************************************
+// class definitions
+
+    //! Header of a box (ISO/IEC 14496-12 4.2)
+    struct BmffBoxHeader {
+        uint32_t type_{0};         //!< Box type
+        uint64_t offset_{0};       //!< Offset of the box
+        uint64_t length_{0};       //!< Length of the box, including the header
+        uint32_t headerSize_{0};   //!< Size of the header, 8 or 16 bytes
+        bool     extendsToEnd_{false}; //!< True if the size field is 0, i.e., the box extends to the end
+
+        //! Offset of the payload of the box
+        uint64_t payload() const { return offset_ + headerSize_; }
+        //! Offset of the first byte after the box
+        uint64_t end() const { return offset_ + length_; }
+    };
+
+    /*!
+      @brief Read the headers of the boxes in the range [\em start, \em end) of \em io.
+      @throw Error if a box is corrupted or exceeds the range.
+     */
+    std::vector<BmffBoxHeader> readBoxHeaders(BasicIo& io, uint64_t start, uint64_t end);
+
+    /*!
+      @brief Return the headers of the boxes in \em data, with offsets relative to \em data.
+      @throw Error if a box is corrupted or exceeds the data.
+     */
+    std::vector<BmffBoxHeader> boxHeaders(const byte* data, size_t size);
+
+    //! Return a box of \em type with \em payload and a header of 8 bytes
+    DataBuf makeBox(uint32_t type, const byte* payload, size_t size);
+
+    /*!
+      @brief Item location box "iloc" (ISO/IEC 14496-12 8.11.3), all versions
+             and field sizes.
+     */
+    struct IlocBox {
+        //! Extent of an item
+        struct Extent {
+            uint64_t index_{0};    //!< Extent index
+            uint64_t offset_{0};   //!< Offset, relative to the base offset
+            uint64_t length_{0};   //!< Length, 0 means the whole remaining data
+        };
+        //! Location of an item
+        struct Item {
+            uint32_t id_{0};                 //!< Item ID
+            uint8_t constructionMethod_{0};  //!< 0: file, 1: idat box, 2: item
+            uint16_t dataReferenceIndex_{0}; //!< 0: this file
+            uint64_t baseOffset_{0};         //!< Base offset of the extents
+            std::vector<Extent> extents_;    //!< Extents of the item
+        };
+
+        //! Default constructor, an empty box of version 0 with 4 byte offsets and lengths
+        IlocBox() = default;
+        //! Parse the payload of an iloc box. @throw Error if it is corrupted.
+        IlocBox(const byte* payload, size_t size);
+
+        //! Return the item with \em id, nullptr if there is none
+        Item* find(uint32_t id);
+        //! Remove the item with \em id
+        void remove(uint32_t id);
+        /*!
+          @brief Return the box. Field sizes and the version are increased where
+                 necessary for the values of the items.
+         */
+        DataBuf box();
+
+        uint8_t version_{0};          //!< Version
+        uint32_t flags_{0};           //!< Flags
+        uint8_t offsetSize_{4};       //!< Size of the offset fields, 0, 4 or 8
+        uint8_t lengthSize_{4};       //!< Size of the length fields, 0, 4 or 8
+        uint8_t baseOffsetSize_{0};   //!< Size of the base offset fields, 0, 4 or 8
+        uint8_t indexSize_{0};        //!< Size of the extent index fields, 0, 4 or 8
+        std::vector<Item> items_;     //!< Items, in the order of the box
+    };
+
+    //! Item information box "iinf" (ISO/IEC 14496-12 8.11.6)
+    struct IinfBox {
+        //! An item information entry "infe"
+        struct Entry {
+            uint32_t id_{0};           //!< Item ID
+            uint32_t type_{0};         //!< Item type, 0 for infe versions 0 and 1
+            std::string contentType_;  //!< Content type of "mime" items
+            DataBuf box_;              //!< The whole infe box
+        };
+
+        //! Parse the payload of an iinf box. @throw Error if it is corrupted.
+        IinfBox(const byte* payload, size_t size);
+
+        //! Return the first entry of \em type (and \em contentType, if not empty), nullptr if there is none
+        const Entry* find(uint32_t type, const std::string& contentType = "") const;
+        //! Return the largest item ID of the entries
+        uint32_t maxId() const;
+        //! Add an infe entry of version 2 (or 3 if \em id needs it)
+        void add(uint32_t id, uint32_t type, const std::string& name, const std::string& contentType);
+        //! Remove the entry of item \em id
+        void remove(uint32_t id);
+        //! Return the box
+        DataBuf box();
+
+        uint8_t version_{0};          //!< Version
+        uint32_t flags_{0};           //!< Flags
+        std::vector<Entry> entries_;  //!< Entries
+    };
+
+    //! Item reference box "iref" (ISO/IEC 14496-12 8.11.12)
+    struct IrefBox {
+        //! References of one type from an item to others
+        struct Reference {
+            uint32_t type_{0};          //!< Reference type, e.g., "cdsc"
+            uint32_t from_{0};          //!< Referencing item
+            std::vector<uint32_t> to_;  //!< Referenced items
+        };
+
+        //! Default constructor, an empty box of version 0
+        IrefBox() = default;
+        //! Parse the payload of an iref box. @throw Error if it is corrupted.
+        IrefBox(const byte* payload, size_t size);
+
+        //! Add a reference of \em type from item \em from to item \em to
+        void add(uint32_t type, uint32_t from, uint32_t to);
+        //! Remove all references from and to item \em id
+        void remove(uint32_t id);
+        //! Return the box
+        DataBuf box();
+
+        uint8_t version_{0};                 //!< Version
+        uint32_t flags_{0};                  //!< Flags
+        std::vector<Reference> references_;  //!< References
+    };
+
+    /*!
+      @brief Replace bytes of a file, remaining ranges are copied unchanged.
+     */
+    struct BmffEdit {
+        uint64_t offset_{0};  //!< Offset of the replaced range
+        uint64_t length_{0};  //!< Length of the replaced range, 0 to insert
+        DataBuf data_;        //!< Replacement
+    };
+
+    /*!
+      @brief Writes Exif and XMP metadata to a BMFF file.
+
+      HEIF and AVIF files keep their metadata in items of the "meta" box.
+      The writer rewrites the "iinf", "iloc" and "iref" boxes of the meta
+      box and puts the item data where the old data of the item was if it
+      fits, otherwise in a new "mdat" box at the end of the file. CR3 files
+      keep XMP in a "uuid" box, which is replaced. Chunk offsets in a
+      "moov" box and the Canon "CTBO" table are updated if data moves.
+
+      If all edits keep the size of what they replace, the file is changed
+      in place and the image data is neither read nor written. Otherwise
+      the file is copied to a temporary file with the edits applied.
+     */
+    class BmffWriter {
+    public:
+        //! Read the structure of the BMFF file \em io, which must be open.
+        explicit BmffWriter(BasicIo& io);
+
+        //! Return true if the metadata of the file can be written
+        bool good() const;
+        //! Return true if this is a Canon CR3 file
+        bool isCr3() const;
+        //! Return the data of the Exif item, empty if there is none
+        DataBuf exifItem();
+        //! Replace the Exif item data with \em item, remove the item if it is empty
+        void setExifItem(DataBuf item);
+        //! Replace the XMP packet with \em packet, remove it if it is empty
+        void setXmpPacket(const std::string& packet);
+        /*!
+          @brief Write the changes. The file must be open for reading, it is
+                 closed afterwards.
+          @return true if the file was changed in place.
+          @throw Error if writing fails.
+         */
+        bool write();
+
+    private:
+        //! Read an item at the current location of \em item
+        DataBuf readItem(const IlocBox::Item& item) const;
+        //! Return an edit which replaces top level box \em index with \em box
+        BmffEdit replaceBox(size_t index, const DataBuf& box) const;
+        //! Return the serialized meta box
+        DataBuf metaBox();
+        //! Add the edits for HEIF files to \em edits
+        void heifEdits(std::vector<BmffEdit>& edits);
+        //! Add the edits for CR3 files to \em edits
+        void cr3Edits(std::vector<BmffEdit>& edits);
+        /*!
+          @brief Add an edit for the chunk offsets in the moov box to \em edits.
+                 The size of the CTBO entry of the box at \em xmpOffset is set
+                 to \em xmpLength, if that is not 0. If \em setLength is true,
+                 the size field of the box is set to its length, for a last box
+                 of size 0 which no longer extends to the end of the file.
+         */
+        void moovEdit(std::vector<BmffEdit>& edits, uint64_t xmpOffset, uint64_t xmpLength,
+                      bool setLength = false) const;
+        //! Apply the edits to the file
+        bool apply(std::vector<BmffEdit>& edits);
+
+        BasicIo& io_;                          //!< The file
+        uint64_t size_{0};                     //!< Size of the file
+        uint32_t brand_{0};                    //!< Major brand
+        std::vector<BmffBoxHeader> boxes_;     //!< Top level boxes
+        int meta_{-1};                         //!< Index of the meta box
+        int moov_{-1};                         //!< Index of the moov box
+        DataBuf metaData_;                     //!< Payload of the meta box
+        std::vector<BmffBoxHeader> metaBoxes_; //!< Boxes in the meta box, relative to metaData_
+        std::unique_ptr<IinfBox> iinf_;        //!< Item information
+        std::unique_ptr<IlocBox> iloc_;        //!< Item locations
+        std::unique_ptr<IrefBox> iref_;        //!< Item references
+        uint32_t primaryId_{0};                //!< Primary item, 0 if there is none
+        uint64_t idat_{0};                     //!< Offset of the payload of the idat box
+        uint64_t idatSize_{0};                 //!< Size of the payload of the idat box
+        bool setExif_{false};                  //!< Whether the Exif item is replaced
+        DataBuf exif_;                         //!< New Exif item
+        bool setXmp_{false};                   //!< Whether the XMP packet is replaced
+        std::string xmp_;                      //!< New XMP packet
+    };
+
+    /*!
+      @brief Return the position of the byte at \em offset after \em edits,
+             which must not overlap.
+     */
+    uint64_t editedOffset(const std::vector<BmffEdit>& edits, uint64_t offset);
+
+}}                                      // namespace Internal, Exiv2
+
+#endif                                  // #ifndef BMFFIMAGE_INT_HPP_
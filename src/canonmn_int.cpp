@@ -2613,7 +2613,7 @@ namespace Exiv2 {
             return os;
         }
 
-        auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
         if (pos == metadata->end())
             return os << "(" << value << ")";
 
@@ -2653,8 +2653,7 @@ namespace Exiv2 {
             return os << value;
         }
 
-        ExifKey key("Exif.CanonCs.Lens");
-        auto pos = metadata->findKey(key);
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.CanonCs.Lens");
         if (pos != metadata->end() && pos->value().count() >= 3 && pos->value().typeId() == unsignedShort) {
             float fu = pos->value().toFloat(2);
             if (fu != 0.0F) {
@@ -2719,9 +2718,9 @@ namespace Exiv2 {
     {
         try {
             // 1140
-            const auto itModel = metadata->findKey(ExifKey("Exif.Image.Model"));
-            const auto itLens  = metadata->findKey(ExifKey("Exif.CanonCs.Lens"));
-            const auto itApert = metadata->findKey(ExifKey("Exif.CanonCs.MaxAperture"));
+            const auto itModel = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
+            const auto itLens  = ExifPrintContext::findKey(*metadata, "Exif.CanonCs.Lens");
+            const auto itApert = ExifPrintContext::findKey(*metadata, "Exif.CanonCs.MaxAperture");
 
             if( itModel != metadata->end() && itModel->value().toString() == "Canon EOS 30D"
             &&  itLens  != metadata->end() && itLens->value().toString() == "24 24 1"
@@ -2746,8 +2745,7 @@ namespace Exiv2 {
         }
 
         // get the values we need from the metadata container
-        ExifKey lensKey("Exif.CanonCs.Lens");
-        auto pos = metadata->findKey(lensKey);
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.CanonCs.Lens");
         // catch possible error cases
         if (pos == metadata->end() || pos->value().count() < 3 || pos->value().typeId() != unsignedShort ||
             pos->value().toFloat(2) == 0.0F) {
@@ -2758,8 +2756,7 @@ namespace Exiv2 {
         int const exifFlMin = static_cast<int>(static_cast<float>(pos->value().toLong(1)) / pos->value().toFloat(2));
         int const exifFlMax = static_cast<int>(static_cast<float>(pos->value().toLong(0)) / pos->value().toFloat(2));
 
-        ExifKey aperKey("Exif.CanonCs.MaxAperture");
-        pos = metadata->findKey(aperKey);
+        pos = ExifPrintContext::findKey(*metadata, "Exif.CanonCs.MaxAperture");
         if (pos == metadata->end() || pos->value().count() != 1 || pos->value().typeId() != unsignedShort) {
             os << "Unknown Lens (" << lensType << ")";
             return os;
@@ -2787,10 +2784,9 @@ namespace Exiv2 {
         bool unmatched = true;
         // we loop over all our lenses to print out all matching lenses
         // if we have multiple possibilities, they are concatenated by "*OR*"
-        for (auto const& lens : canonCsLensType) {
-            if (lens.val_ != lensType) {
-                continue;
-            }
+        const auto lenses = EXV_TAG_DETAILS_INDEX(canonCsLensType)::equalRange(lensType);
+        for (auto pos = lenses.first; pos != lenses.second; ++pos) {
+            const TagDetails& lens = canonCsLensType[*pos];
 
             std::cmatch base_match;
             if (!std::regex_search(lens.label_, base_match, lens_regex)) {
@@ -102,8 +102,9 @@ namespace Exiv2 {
             throw Error(kerNotAnImage, "CR2");
         }
         clearMetadata();
-        ByteOrder bo =
-            Cr2Parser::decode(exifData_, iptcData_, xmpData_, io_->mmap(), static_cast<uint32_t>(io_->size()));
+        Cr2Header cr2Header;
+        ByteOrder bo = TiffParserWorker::decode(exifData_, iptcData_, xmpData_, *io_, Tag::root,
+                                                TiffMapping::findDecoder, &cr2Header);
         setByteOrder(bo);
     } // Cr2Image::readMetadata
 
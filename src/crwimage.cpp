@@ -132,7 +132,7 @@ namespace Exiv2 {
         CrwParser::encode(blob, buf.c_data(), buf.size(), this);
 
         // Write new buffer to file
-        auto tempIo = std::make_unique<MemIo>();
+        auto tempIo = std::make_unique<TempIo>(*io_);
         tempIo->write((!blob.empty() ? &blob[0] : nullptr), static_cast<long>(blob.size()));
         io_->close();
         io_->transfer(*tempIo); // may throw
@@ -29,6 +29,7 @@
 
 #include "epsimage.hpp"
 #include "image.hpp"
+#include "image_int.hpp"
 #include "basicio.hpp"
 #include "error.hpp"
 #include "futils.hpp"
@@ -105,6 +106,10 @@ namespace {
     // closing part of all valid XMP trailers
     const std::string xmpTrailerEnd = "?>";
 
+    // common start of all XMP headers and of all XMP trailers
+    const std::string xmpHeaderStart = "<?xpacket begin=";
+    const std::string xmpTrailerStart = "<?xpacket end=";
+
     //! Write data into temp file, taking care of errors
     void writeTemp(BasicIo& tempIo, const byte* data, size_t size)
     {
@@ -148,12 +153,10 @@ namespace {
     size_t readLine(std::string& line, const byte* data, size_t startPos, size_t size)
     {
         line.clear();
-        size_t pos = startPos;
+        if (startPos >= size) return startPos;
         // step through line
-        while (pos < size && data[pos] != '\r' && data[pos] != '\n') {
-            line += data[pos];
-            pos++;
-        }
+        size_t pos = Internal::findEither(data + startPos, data + size, '\r', '\n') - data;
+        line.assign(reinterpret_cast<const char*>(data + startPos), pos - startPos);
         // skip line ending, if present
         if (pos >= size) return pos;
         pos++;
@@ -193,7 +196,8 @@ namespace {
         // search for valid XMP header
         xmpSize = 0;
         for (xmpPos = startPos; xmpPos < size; xmpPos++) {
-            if (data[xmpPos] != '\x00' && data[xmpPos] != '<') continue;
+            xmpPos = Internal::findPattern(data + xmpPos, data + size, xmpHeaderStart) - data;
+            if (xmpPos >= size) break;
             for (auto&& header : xmpHeaders) {
                 if (xmpPos + header.size() > size) continue;
                 if (memcmp(data + xmpPos, header.data(), header.size()) != 0) continue;
@@ -203,7 +207,8 @@ namespace {
 
                 // search for valid XMP trailer
                 for (size_t trailerPos = xmpPos + header.size(); trailerPos < size; trailerPos++) {
-                    if (data[xmpPos] != '\x00' && data[xmpPos] != '<') continue;
+                    trailerPos = Internal::findPattern(data + trailerPos, data + size, xmpTrailerStart) - data;
+                    if (trailerPos >= size) break;
                     for (auto&& xmpTrailer : xmpTrailers) {
                         const std::string& trailer = xmpTrailer.trailer;
                         const bool readOnly = xmpTrailer.readOnly;
@@ -223,11 +228,10 @@ namespace {
                         }
 
                         // search for end of XMP trailer
-                        for (size_t trailerEndPos = trailerPos + trailer.size(); trailerEndPos + xmpTrailerEnd.size() <= size; trailerEndPos++) {
-                            if (memcmp(data + trailerEndPos, xmpTrailerEnd.data(), xmpTrailerEnd.size()) == 0) {
-                                xmpSize = (trailerEndPos + xmpTrailerEnd.size()) - xmpPos;
-                                return;
-                            }
+                        const byte* trailerEnd = Internal::findPattern(data + trailerPos + trailer.size(), data + size, xmpTrailerEnd);
+                        if (trailerEnd != data + size) {
+                            xmpSize = static_cast<size_t>(trailerEnd - data) + xmpTrailerEnd.size() - xmpPos;
+                            return;
                         }
                         #ifndef SUPPRESS_WARNINGS
                         EXV_WARNING << "Found XMP header but incomplete XMP trailer.\n";
@@ -384,9 +388,9 @@ namespace {
         bool inRemovableEmbedding = false;
         std::string removableEmbeddingEndLine;
         unsigned int removableEmbeddingsWithUnmarkedTrailer = 0;
+        std::string line;
         for (size_t pos = posEps; pos < posEof;) {
             const size_t startPos = pos;
-            std::string line;
             pos = readLine(line, data, startPos, posEndEps);
             #ifdef DEBUG
             bool significantLine = true;
@@ -632,7 +636,6 @@ namespace {
         }
 
         // interpret comment "%ADO_ContainsXMP:"
-        std::string line;
         readLine(line, data, posContainsXmp, posEndEps);
         bool containsXmp;
         if (line == "%ADO_ContainsXMP: MainFirst" || line == "%ADO_ContainsXMP:MainFirst") {
@@ -802,7 +805,7 @@ namespace {
             }
 
             // create temporary output file
-            MemIo tempIo;
+            TempIo tempIo(io);
             if (!tempIo.isopen()) {
                 #ifndef SUPPRESS_WARNINGS
                 EXV_WARNING << "Unable to create temporary file for writing.\n";
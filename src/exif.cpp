@@ -38,6 +38,7 @@
 #include "tiffimage.hpp"
 #include "tiffimage_int.hpp"
 #include "tiffcomposite_int.hpp" // for Tag::root
+#include "i18n.h"                // NLS support.
 
 // + standard includes
 #include <iostream>
@@ -47,15 +48,20 @@
 #include <cstring>
 #include <cassert>
 #include <cstdio>
+#include <typeinfo>
 
 // *****************************************************************************
 namespace {
 
-    //! Unary predicate that matches a Exifdatum with a given key
+    /*!
+      @brief Unary predicate that matches a Exifdatum with a given key. The key
+             string of an Exif key is determined by its tag and IFD id, so
+             these are compared instead of the strings.
+     */
     class FindExifdatumByKey {
     public:
         //! Constructor, initializes the object with the key to look for
-        explicit FindExifdatumByKey(const std::string& key) : key_(key)
+        explicit FindExifdatumByKey(const Exiv2::ExifKey& key) : tag_(key.tag()), ifdId_(key.ifdId())
         {
         }
         /*!
@@ -64,14 +70,77 @@ namespace {
         */
         bool operator()(const Exiv2::Exifdatum& exifdatum) const
         {
-            return key_ == exifdatum.key();
+            return tag_ == exifdatum.tag() && ifdId_ == exifdatum.ifdId();
         }
 
     private:
-        const std::string& key_;
+        uint16_t tag_;
+        int ifdId_;
 
     }; // class FindExifdatumByKey
 
+    /*!
+      @brief Return the name of \em tag with the tag info \em ti, the same as
+             ExifKey::tagName(). The name of an unknown tag is written to \em buf.
+     */
+    const char* exifTagName(const Exiv2::TagInfo* ti, uint16_t tag, char (&buf)[8])
+    {
+        if (ti != nullptr && ti->tag_ != 0xffff) return ti->name_;
+        snprintf(buf, sizeof(buf), "0x%04x", tag);
+        return buf;
+    }
+
+    /*!
+      @brief Compare two Exif datums by key, in the same order as
+             cmpMetadataByKey(), but from the static group and tag names
+             instead of key strings made for every comparison.
+     */
+    bool cmpExifdatumByKey(const Exiv2::Exifdatum& lhs, const Exiv2::Exifdatum& rhs)
+    {
+        using Exiv2::Internal::IfdId;
+        const char* lg = Exiv2::Internal::groupName(static_cast<IfdId>(lhs.ifdId()));
+        const char* rg = Exiv2::Internal::groupName(static_cast<IfdId>(rhs.ifdId()));
+        if (std::strcmp(lg, rg) != 0) {
+            // Keys are "Exif.group.tag" and group names have no '.', which
+            // follows the group name in the key when the other one is longer
+            size_t i = 0;
+            while (lg[i] != '\0' && lg[i] == rg[i]) ++i;
+            const auto l = static_cast<unsigned char>(lg[i] == '\0' ? '.' : lg[i]);
+            const auto r = static_cast<unsigned char>(rg[i] == '\0' ? '.' : rg[i]);
+            return l < r;
+        }
+        char lbuf[8];
+        char rbuf[8];
+        return std::strcmp(exifTagName(lhs.tagInfo(), lhs.tag(), lbuf),
+                           exifTagName(rhs.tagInfo(), rhs.tag(), rbuf)) < 0;
+    }
+
+    /*!
+      @brief Return true if \em value is of the class that Value::create()
+             makes for its type id and this type id can be held inline in an
+             Exifdatum.
+     */
+    bool isInlineType(const Exiv2::Value& value)
+    {
+        using namespace Exiv2;
+        switch (value.typeId()) {
+        case signedByte:
+        case unsignedByte:
+        case undefined:        return typeid(value) == typeid(DataValue);
+        case asciiString:      return typeid(value) == typeid(AsciiValue);
+        case unsignedShort:    return typeid(value) == typeid(ValueType<uint16_t>);
+        case unsignedLong:
+        case tiffIfd:          return typeid(value) == typeid(ValueType<uint32_t>);
+        case unsignedRational: return typeid(value) == typeid(ValueType<URational>);
+        case signedShort:      return typeid(value) == typeid(ValueType<int16_t>);
+        case signedLong:       return typeid(value) == typeid(ValueType<int32_t>);
+        case signedRational:   return typeid(value) == typeid(ValueType<Rational>);
+        case tiffFloat:        return typeid(value) == typeid(ValueType<float>);
+        case tiffDouble:       return typeid(value) == typeid(ValueType<double>);
+        default:               return false;
+        }
+    }
+
     /*!
       @brief Exif %Thumbnail image. This abstract base class provides the
              interface for the thumbnail image that is optionally embedded in
@@ -175,6 +244,9 @@ namespace {
     //! Helper function to delete all tags of a specific IFD from the metadata.
     void eraseIfd(Exiv2::ExifData& ed, Exiv2::Internal::IfdId ifdId);
 
+    //! Innermost print context of the current thread
+    thread_local const Exiv2::ExifPrintContext* printContext = nullptr;
+
 }  // namespace
 
 // *****************************************************************************
@@ -184,9 +256,8 @@ namespace Exiv2 {
     using namespace Internal;
 
     /*!
-      @brief Set the value of \em exifDatum to \em value. If the object already
-             has a value, it is replaced. Otherwise a new ValueType\<T\> value
-             is created and set to \em value.
+      @brief Set the value of \em exifDatum to \em value. An existing value is
+             replaced. The new value is held inline as ValueType\<T\>.
 
       This is a helper function, called from Exifdatum members. It is meant to
       be used with T = (u)int16_t, (u)int32_t or (U)Rational. Do not use directly.
@@ -194,30 +265,59 @@ namespace Exiv2 {
     template<typename T>
     Exiv2::Exifdatum& setValue(Exiv2::Exifdatum& exifDatum, const T& value)
     {
-        auto v = std::unique_ptr<Exiv2::ValueType<T> >(new Exiv2::ValueType<T>);
-        v->value_.push_back(value);
-        exifDatum.value_ = std::move(v);
+        static_assert(sizeof(T) <= sizeof(exifDatum.inline_), "Value too large to be held inline");
+        exifDatum.value_.reset();
+        exifDatum.clearValueCache();
+        toData(exifDatum.inline_, value, littleEndian);
+        exifDatum.inlineCount_ = 1;
+        exifDatum.inlineType_ = getType<T>();
         return exifDatum;
     }
 
     Exifdatum::Exifdatum(const ExifKey& key, const Value* pValue)
-        : key_(key.clone())
+        : tagInfo_(key.tagInfo()), tag_(key.tag()), ifdId_(key.ifdId()), idx_(key.idx())
     {
-        if (pValue) value_ = pValue->clone();
+        if (pValue) setValue(pValue);
     }
 
     Exifdatum::Exifdatum(const Exifdatum& rhs)
-        : Metadatum(rhs)
-    {
-        if (rhs.key_.get() != nullptr)
-            key_ = rhs.key_->clone();  // deep copy
+        : Metadatum(rhs),
+          tagInfo_(rhs.tagInfo_),
+          tag_(rhs.tag_),
+          inlineCount_(rhs.inlineCount_),
+          ifdId_(rhs.ifdId_),
+          idx_(rhs.idx_),
+          inlineType_(rhs.inlineType_)
+    {
+        std::memcpy(inline_, rhs.inline_, sizeof(inline_));
         if (rhs.value_.get() != nullptr)
             value_ = rhs.value_->clone();  // deep copy
     }
 
+    Exifdatum::Exifdatum(Exifdatum&& rhs) noexcept
+        : Metadatum(rhs),
+          tagInfo_(rhs.tagInfo_),
+          tag_(rhs.tag_),
+          inlineCount_(rhs.inlineCount_),
+          ifdId_(rhs.ifdId_),
+          idx_(rhs.idx_),
+          inlineType_(rhs.inlineType_),
+          value_(std::move(rhs.value_)),
+          valueCache_(rhs.valueCache_.exchange(nullptr))
+    {
+        std::memcpy(inline_, rhs.inline_, sizeof(inline_));
+    }
+
+    Exifdatum::~Exifdatum()
+    {
+        delete valueCache_.load();
+    }
+
     std::ostream& Exifdatum::write(std::ostream& os, const ExifData* pMetadata) const
     {
-        if (value().count() == 0) return os;
+        if (count() == 0) return os;
+
+        const Value& val = value();
 
         PrintFct       fct = printValue;
         const TagInfo* ti  = Internal::tagInfo(tag(), static_cast<IfdId>(ifdId()));
@@ -225,7 +325,7 @@ namespace Exiv2 {
         if ( ti ) {
             fct = ti->printFct_;
             if ( ti->typeId_ == comment ) {
-              os << value().toString();
+              os << val.toString();
               fct = nullptr;
             }
         }
@@ -237,7 +337,7 @@ namespace Exiv2 {
           // metadata is parsed.) These type mismatches can sometimes
           // cause a std::out_of_range exception to be thrown.
           try {
-            fct(os, value(), pMetadata);
+            fct(os, val, pMetadata);
           } catch (std::out_of_range&) {
             os << "Bad value";
 #ifdef EXIV2_DEBUG_MESSAGES
@@ -250,9 +350,10 @@ namespace Exiv2 {
 
     const Value& Exifdatum::value() const
     {
-        if (value_.get() == nullptr)
+        const Value* value = valuePointer();
+        if (value == nullptr)
             throw Error(kerValueNotSet);
-        return *value_;
+        return *value;
     }
 
     Exifdatum& Exifdatum::operator=(const Exifdatum& rhs)
@@ -260,17 +361,43 @@ namespace Exiv2 {
         if (this == &rhs) return *this;
         Metadatum::operator=(rhs);
 
-        key_.reset();
-        if (rhs.key_.get() != nullptr)
-            key_ = rhs.key_->clone();  // deep copy
+        tagInfo_ = rhs.tagInfo_;
+        tag_ = rhs.tag_;
+        ifdId_ = rhs.ifdId_;
+        idx_ = rhs.idx_;
+
+        inlineCount_ = rhs.inlineCount_;
+        inlineType_ = rhs.inlineType_;
+        std::memcpy(inline_, rhs.inline_, sizeof(inline_));
 
         value_.reset();
+        clearValueCache();
         if (rhs.value_.get() != nullptr)
             value_ = rhs.value_->clone();  // deep copy
 
         return *this;
     } // Exifdatum::operator=
 
+    Exifdatum& Exifdatum::operator=(Exifdatum&& rhs) noexcept
+    {
+        if (this == &rhs) return *this;
+        Metadatum::operator=(rhs);
+
+        tagInfo_ = rhs.tagInfo_;
+        tag_ = rhs.tag_;
+        ifdId_ = rhs.ifdId_;
+        idx_ = rhs.idx_;
+
+        inlineCount_ = rhs.inlineCount_;
+        inlineType_ = rhs.inlineType_;
+        std::memcpy(inline_, rhs.inline_, sizeof(inline_));
+
+        value_ = std::move(rhs.value_);
+        delete valueCache_.exchange(rhs.valueCache_.exchange(nullptr));
+
+        return *this;
+    }
+
     Exifdatum& Exifdatum::operator=(const std::string& value)
     {
         setValue(value);
@@ -316,13 +443,19 @@ namespace Exiv2 {
     void Exifdatum::setValue(const Value* pValue)
     {
         value_.reset();
-        if (pValue) value_ = pValue->clone();
+        clearValueCache();
+        inlineType_ = invalidTypeId;
+        inlineCount_ = 0;
+        if (pValue && !setInline(*pValue)) value_ = pValue->clone();
     }
 
     int Exifdatum::setValue(const std::string& value)
     {
         if (value_.get() == nullptr) {
-            TypeId type = key_->defaultTypeId();
+            value_ = takeInlineValue();
+        }
+        if (value_.get() == nullptr) {
+            TypeId type = exifKey().defaultTypeId();
             value_ = Value::create(type);
         }
         return value_->read(value);
@@ -330,62 +463,134 @@ namespace Exiv2 {
 
     int Exifdatum::setDataArea(const byte* buf, long len)
     {
+        if (value_.get() == nullptr) {
+            value_ = takeInlineValue();
+        }
         return value_.get() == nullptr ? -1 : value_->setDataArea(buf, len);
     }
 
+    bool Exifdatum::setInline(const Value& value)
+    {
+        if (value.count() == 0 || value.size() > static_cast<long>(sizeof(inline_))
+            || value.sizeDataArea() != 0 || !isInlineType(value)) {
+            return false;
+        }
+        value.copy(inline_, littleEndian);
+        inlineType_ = value.typeId();
+        inlineCount_ = static_cast<uint16_t>(value.count());
+        return true;
+    }
+
+    void Exifdatum::clearValueCache()
+    {
+        delete valueCache_.exchange(nullptr);
+    }
+
+    Value::UniquePtr Exifdatum::takeInlineValue()
+    {
+        // A reference returned by value() stays valid
+        Value::UniquePtr value(valueCache_.exchange(nullptr));
+        if (value.get() == nullptr) value = inlineValue();
+        inlineType_ = invalidTypeId;
+        inlineCount_ = 0;
+        return value;
+    }
+
+    ExifKey Exifdatum::exifKey() const
+    {
+        ExifKey key(tag_, ifdId_, tagInfo_);
+        key.setIdx(idx_);
+        return key;
+    }
+
+    Value::UniquePtr Exifdatum::inlineValue() const
+    {
+        if (inlineType_ == invalidTypeId) return nullptr;
+        auto value = Value::create(inlineType_);
+        value->read(inline_, inlineCount_ * TypeInfo::typeSize(inlineType_), littleEndian);
+        return value;
+    }
+
+    const Value* Exifdatum::valuePointer() const
+    {
+        if (value_.get() != nullptr)
+            return value_.get();
+        // Made once, threads which race to make it agree on the first one stored
+        Value* value = valueCache_.load(std::memory_order_acquire);
+        if (value == nullptr) {
+            auto made = inlineValue();
+            if (made.get() == nullptr)
+                return nullptr;
+            if (valueCache_.compare_exchange_strong(value, made.get(), std::memory_order_acq_rel))
+                value = made.release();
+        }
+        return value;
+    }
+
     std::string Exifdatum::key() const
     {
-        return key_.get() == nullptr ? "" : key_->key();
+        char buf[8];
+        return std::string(familyName()) + "." + Internal::groupName(static_cast<IfdId>(ifdId_)) + "."
+               + exifTagName(tagInfo_, tag_, buf);
     }
 
     const char* Exifdatum::familyName() const
     {
-        return key_.get() == nullptr ? "" : key_->familyName();
+        return "Exif";
     }
 
     std::string Exifdatum::groupName() const
     {
-        return key_.get() == nullptr ? "" : key_->groupName();
+        return Internal::groupName(static_cast<IfdId>(ifdId_));
     }
 
     std::string Exifdatum::tagName() const
     {
-        return key_.get() == nullptr ? "" : key_->tagName();
+        char buf[8];
+        return exifTagName(tagInfo_, tag_, buf);
     }
 
     std::string Exifdatum::tagLabel() const
     {
-        return key_.get() == nullptr ? "" : key_->tagLabel();
+        if (tagInfo_ == nullptr || tagInfo_->tag_ == 0xffff)
+            return "";
+        return _(tagInfo_->title_);
     }
 
     uint16_t Exifdatum::tag() const
     {
-        return key_.get() == nullptr ? 0xffff : key_->tag();
+        return tag_;
     }
 
     int Exifdatum::ifdId() const
     {
-        return key_.get() == nullptr ? ifdIdNotSet : key_->ifdId();
+        return ifdId_;
     }
 
     const char* Exifdatum::ifdName() const
     {
-        return key_.get() == nullptr ? "" : Internal::ifdName(static_cast<Internal::IfdId>(key_->ifdId()));
+        return Internal::ifdName(static_cast<Internal::IfdId>(ifdId_));
     }
 
     int Exifdatum::idx() const
     {
-        return key_.get() == nullptr ? 0 : key_->idx();
+        return idx_;
+    }
+
+    const TagInfo* Exifdatum::tagInfo() const
+    {
+        return tagInfo_;
     }
 
     long Exifdatum::copy(byte* buf, ByteOrder byteOrder) const
     {
-        return value_.get() == nullptr ? 0 : value_->copy(buf, byteOrder);
+        const Value* v = valuePointer();
+        return v ? v->copy(buf, byteOrder) : 0;
     }
 
     TypeId Exifdatum::typeId() const
     {
-        return value_.get() == nullptr ? invalidTypeId : value_->typeId();
+        return value_.get() == nullptr ? inlineType_ : value_->typeId();
     }
 
     const char* Exifdatum::typeName() const
@@ -400,42 +605,47 @@ namespace Exiv2 {
 
     long Exifdatum::count() const
     {
-        return value_.get() == nullptr ? 0 : value_->count();
+        return value_.get() == nullptr ? inlineCount_ : value_->count();
     }
 
     long Exifdatum::size() const
     {
-        return value_.get() == nullptr ? 0 : value_->size();
+        return value_.get() == nullptr ? inlineCount_ * typeSize() : value_->size();
     }
 
     std::string Exifdatum::toString() const
     {
-        return value_.get() == nullptr ? "" : value_->toString();
+        const Value* v = valuePointer();
+        return v ? v->toString() : "";
     }
 
     std::string Exifdatum::toString(long n) const
     {
-        return value_.get() == nullptr ? "" : value_->toString(n);
+        const Value* v = valuePointer();
+        return v ? v->toString(n) : "";
     }
 
     long Exifdatum::toLong(long n) const
     {
-        return value_.get() == nullptr ? -1 : value_->toLong(n);
+        const Value* v = valuePointer();
+        return v ? v->toLong(n) : -1;
     }
 
     float Exifdatum::toFloat(long n) const
     {
-        return value_.get() == nullptr ? -1 : value_->toFloat(n);
+        const Value* v = valuePointer();
+        return v ? v->toFloat(n) : -1;
     }
 
     Rational Exifdatum::toRational(long n) const
     {
-        return value_.get() == nullptr ? Rational(-1, 1) : value_->toRational(n);
+        const Value* v = valuePointer();
+        return v ? v->toRational(n) : Rational(-1, 1);
     }
 
     Value::UniquePtr Exifdatum::getValue() const
     {
-        return value_.get() == nullptr ? nullptr : value_->clone();
+        return value_.get() == nullptr ? inlineValue() : value_->clone();
     }
 
     long Exifdatum::sizeDataArea() const
@@ -607,16 +817,22 @@ namespace Exiv2 {
         exifMetadata_.push_back(exifdatum);
     }
 
+    void ExifData::add(Exifdatum&& exifdatum)
+    {
+        // allow duplicates
+        exifMetadata_.push_back(std::move(exifdatum));
+    }
+
     ExifData::const_iterator ExifData::findKey(const ExifKey& key) const
     {
         return std::find_if(exifMetadata_.begin(), exifMetadata_.end(),
-                            FindExifdatumByKey(key.key()));
+                            FindExifdatumByKey(key));
     }
 
     ExifData::iterator ExifData::findKey(const ExifKey& key)
     {
         return std::find_if(exifMetadata_.begin(), exifMetadata_.end(),
-                            FindExifdatumByKey(key.key()));
+                            FindExifdatumByKey(key));
     }
 
     void ExifData::clear()
@@ -626,7 +842,7 @@ namespace Exiv2 {
 
     void ExifData::sortByKey()
     {
-        exifMetadata_.sort(cmpMetadataByKey);
+        exifMetadata_.sort(cmpExifdatumByKey);
     }
 
     void ExifData::sortByTag()
@@ -644,6 +860,34 @@ namespace Exiv2 {
         return exifMetadata_.erase(pos);
     }
 
+    ExifPrintContext::ExifPrintContext(const ExifData& exifData)
+        : exifData_(exifData), previous_(printContext)
+    {
+        printContext = this;
+    }
+
+    ExifPrintContext::~ExifPrintContext()
+    {
+        printContext = previous_;
+    }
+
+    ExifData::const_iterator ExifPrintContext::findKey(const ExifData& exifData, const std::string& key)
+    {
+        // The innermost context for this ExifData, usually the only one
+        const ExifPrintContext* context = printContext;
+        while (context != nullptr && &context->exifData_ != &exifData) {
+            context = context->previous_;
+        }
+        if (context == nullptr) {
+            return exifData.findKey(ExifKey(key));
+        }
+        auto pos = context->found_.find(key);
+        if (pos == context->found_.end()) {
+            pos = context->found_.emplace(key, exifData.findKey(ExifKey(key))).first;
+        }
+        return pos->second;
+    }
+
     ByteOrder ExifParser::decode(
               ExifData& exifData,
         const byte*     pData,
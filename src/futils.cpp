@@ -70,21 +70,23 @@
 #endif
 
 namespace Exiv2 {
-    constexpr std::array<const char*, 2> ENVARDEF{
+    constexpr std::array<const char*, 3> ENVARDEF{
         "/exiv2.php",
         "40",
-    };  //!< @brief default URL for http exiv2 handler and time-out
-    constexpr std::array<const char*, 2> ENVARKEY{
+        "",
+    };  //!< @brief default URL for http exiv2 handler, time-out and remote block cache directory
+    constexpr std::array<const char*, 3> ENVARKEY{
         "EXIV2_HTTP_POST",
         "EXIV2_TIMEOUT",
-    };  //!< @brief request keys for http exiv2 handler and time-out
+        "EXIV2_REMOTE_CACHE",
+    };  //!< @brief request keys for http exiv2 handler, time-out and remote block cache directory
 
     // *****************************************************************************
     // free functions
     std::string getEnv(int env_var)
     {
         // this check is relying on undefined behavior and might not be effective
-        if (env_var < envHTTPPOST || env_var > envTIMEOUT) {
+        if (env_var < envHTTPPOST || env_var > envREMOTECACHE) {
             throw std::out_of_range("Unexpected env variable");
         }
         return getenv(ENVARKEY[env_var]) ? getenv(ENVARKEY[env_var]) : ENVARDEF[env_var];
@@ -31,6 +31,9 @@
 #include <sys/types.h>
 #include <stdio.h>
 #include <array>
+#include <map>
+#include <mutex>
+#include <vector>
 #include <cstdlib>
 #include <time.h>
 #include <sys/stat.h>
@@ -55,6 +58,7 @@
 #define  close    _close
 #define  strdup   _strdup
 #define  stat     _stat
+#define  strcasecmp _stricmp
 #define  fopen_S(f,n,a)  fopen_s(&f,n,a)
 #endif
 #else
@@ -185,75 +189,97 @@ static int makeNonBlocking(int sockfd)
 #endif
 }
 
-int Exiv2::http(Exiv2::Dictionary& request,Exiv2::Dictionary& response,std::string& errors)
-{
-    if ( !request.count("verb")   ) request["verb"   ] = "GET";
-    if ( !request.count("header") ) request["header" ] = ""   ;
-    if ( !request.count("version")) request["version"] = "1.0";
-    if ( !request.count("port")   ) request["port"   ] = ""   ;
-
-    std::string file;
-    errors     = "";
-    int result = 0;
+////////////////////////////////////////
+// keep-alive connection pool (HTTP/1.1 requests only)
 
-    ////////////////////////////////////
-    // Windows specific code
-#if defined(WIN32) || defined(_MSC_VER) || defined(__MINGW__) || defined(__CYGWIN__)
-    WSADATA wsaData;
-    WSAStartup(MAKEWORD(2,2), &wsaData);
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL   0   // no SIGPIPE suppression on this platform
 #endif
 
-    const char* servername = request["server" ].c_str();
-    const char* page       = request["page"   ].c_str();
-    const char* verb       = request["verb"   ].c_str();
-    const char* header     = request["header" ].c_str();
-    const char* version    = request["version"].c_str();
-    const char* port       = request["port"   ].c_str();
+static std::mutex                                  poolMutex;
+static std::map<std::string, std::vector<int> >    pool;      // idle connections by "server:port"
+static constexpr size_t                            poolSize = 4; // max idle connections per host
 
-    const char* servername_p = servername;
-    const char* port_p       = port      ;
-    std::string url = std::string("http://") + request["server"] + request["page"];
+static int takeConnection(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    auto it = pool.find(key);
+    if ( it == pool.end() || it->second.empty() ) return -1;
+    int sockfd = it->second.back();
+    it->second.pop_back();
+    return sockfd;
+}
 
-    // parse and change server if using a proxy
-    const char* PROXI  = "HTTP_PROXY";
-    const char* proxi  = "http_proxy";
-    const char* PROXY  = getenv(PROXI);
-    const char* proxy  = getenv(proxi);
-    bool        bProx  = PROXY || proxy;
-    const char* prox   = bProx ? (proxy?proxy:PROXY):"";
-    Exiv2::Uri  Proxy  =  Exiv2::Uri::Parse(prox);
+static void releaseConnection(const std::string& key, int sockfd)
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    std::vector<int>& idle = pool[key];
+    if ( idle.size() < poolSize ) {
+        idle.push_back(sockfd);
+    } else {
+        closesocket(sockfd);
+    }
+}
 
-    // find the dictionary of no_proxy servers
-    const char* NO_PROXI = "NO_PROXY";
-    const char* no_proxi = "no_proxy";
-    const char* NO_PROXY = getenv(NO_PROXI);
-    const char* no_proxy = getenv(no_proxi);
-    bool        bNoProxy = NO_PROXY||no_proxy;
-    std::string no_prox  = std::string(bNoProxy?(no_proxy?no_proxy:NO_PROXY):"");
-    Exiv2::Dictionary noProxy= stringToDict(no_prox + ",localhost,127.0.0.1");
+// case insensitive lookup of a response header, without surrounding white space
+static std::string headerValue(const Exiv2::Dictionary& response, const char* name)
+{
+    for (auto&& header : response) {
+        if ( strcasecmp(header.first.c_str(), name) == 0 ) {
+            const std::string& v = header.second;
+            size_t b = v.find_first_not_of(" \t\r\n");
+            size_t e = v.find_last_not_of(" \t\r\n");
+            return b == std::string::npos ? "" : v.substr(b, e - b + 1);
+        }
+    }
+    return "";
+}
 
-    // if the server is on the no_proxy list ... ignore the proxy!
-    if ( noProxy.count(servername) ) bProx = false;
+// decoder of a chunked body, which continues where the previous call stopped
+struct ChunkDecoder
+{
+    size_t      pos_ = 0; // start of the next chunk in the received body
+    std::string decoded_; // data of the chunks decoded so far
 
-    if (  bProx ) {
-        servername_p = Proxy.Host.c_str();
-        port_p       = Proxy.Port.c_str();
-        page         = url.c_str();
-        std::string  p(proxy?proxi:PROXI);
-    //  std::cerr << p << '=' << prox << " page = " << page << std::endl;
+    // returns false while the terminating chunk has not been received
+    bool decode(const std::string& body)
+    {
+        for (;;) {
+            size_t eol = body.find("\r\n", pos_);
+            if ( eol == std::string::npos ) return false;
+            unsigned long size = strtoul(body.c_str() + pos_, nullptr, 16);
+            size_t data = eol + 2;
+            if ( size == 0 ) return body.find("\r\n", data) != std::string::npos; // end of trailers
+            if ( body.size() < data + size + 2 ) return false;
+            decoded_.append(body, data, size);
+            pos_ = data + size + 2;
+        }
     }
-    if ( !port  [0] ) port   = "80";
-    if ( !port_p[0] ) port_p = "80";
+};
 
-    ////////////////////////////////////
-    // open the socket
+// true when the whole body of a keep-alive response has been received
+static bool bodyComplete(const Exiv2::Dictionary& response, std::string& file, ChunkDecoder& chunks, bool isHead,
+                         int status)
+{
+    if ( isHead || status == 204 || status == 304 ) return true;
+
+    const std::string length = headerValue(response, "Content-Length");
+    if ( !length.empty() ) return file.size() >= strtoul(length.c_str(), nullptr, 10);
+
+    if ( strcasecmp(headerValue(response, "Transfer-Encoding").c_str(), "chunked") == 0 ) {
+        if ( !chunks.decode(file) ) return false;
+        file.swap(chunks.decoded_);
+        return true;
+    }
+    return false; // read until the server closes the connection
+}
+
+static int openConnection(const char* servername_p, const char* port_p, std::string& errors)
+{
     int sockfd = static_cast<int>(socket(AF_INET , SOCK_STREAM,IPPROTO_TCP));
     if (sockfd < 0)
         return error(errors, "unable to create socket\n", nullptr, nullptr, 0);
 
-    // connect the socket to the server
-    int     server  = -1 ;
-
     // fill in the address
     struct  sockaddr_in serv_addr   ;
     int                 serv_len = sizeof(serv_addr);
@@ -267,8 +293,10 @@ int Exiv2::http(Exiv2::Dictionary& request,Exiv2::Dictionary& response,std::stri
     // http://publib.boulder.ibm.com/infocenter/iseries/v5r3/index.jsp?topic=/rzab6/rzab6uafinet.htm
     if (serv_addr.sin_addr.s_addr == static_cast<unsigned long>(INADDR_NONE)) {
         struct hostent* host = gethostbyname(servername_p);
-        if (!host)
+        if (!host) {
+            closesocket(sockfd);
             return error(errors, "no such host", servername_p);
+        }
         memcpy(&serv_addr.sin_addr, host->h_addr, sizeof(serv_addr.sin_addr));
     }
 
@@ -276,42 +304,64 @@ int Exiv2::http(Exiv2::Dictionary& request,Exiv2::Dictionary& response,std::stri
 
     ////////////////////////////////////
     // and connect
-    server = connect(sockfd, reinterpret_cast<const struct sockaddr*>(&serv_addr), serv_len);
-    if ( server == SOCKET_ERROR && WSAGetLastError() != WSAEWOULDBLOCK )
+    int server = connect(sockfd, reinterpret_cast<const struct sockaddr*>(&serv_addr), serv_len);
+    if ( server == SOCKET_ERROR && WSAGetLastError() != WSAEWOULDBLOCK ) {
+        int wsa_error = WSAGetLastError();
+        closesocket(sockfd);
         return error(errors, "error - unable to connect to server = %s port = %s wsa_error = %d", servername_p, port_p,
-                     WSAGetLastError());
-
-    char   buffer[32*1024+1];
-    size_t buff_l= sizeof buffer - 1 ;
-
-    ////////////////////////////////////
-    // format the request
-    int    n  = snprintf(buffer,buff_l,httpTemplate,verb,page,version,servername,header) ;
-    buffer[n] = 0 ;
-    response["requestheaders"]=std::string(buffer,n);
+                     wsa_error);
+    }
+    return sockfd;
+}
 
+/*
+ send the request on sockfd and read the response.
+ reused    - sockfd is an idle keep-alive connection, which the server may have closed meanwhile
+ keepAlive - stop reading once the body is complete instead of waiting for the server to hang up
+ reusable  - set if the connection can be used for another request
+ received  - set if any data arrived
+*/
+static int transact(int sockfd, const std::string& requestText, bool reused, bool keepAlive, bool isHead,
+                    const char* servername, const char* port, Exiv2::Dictionary& response, std::string& file,
+                    std::string& errors, bool& reusable, bool& received)
+{
+    int    result = 0;
+    reusable = false;
+    received = false;
+    file.clear();
 
     ////////////////////////////////////
     // send the header (we'll have to wait for the connection by the non-blocking socket)
-    while ( sleep_ >= 0 && send(sockfd,buffer,n,0) == SOCKET_ERROR /* && WSAGetLastError() == WSAENOTCONN */ ) {
-        Sleep(snooze) ;
-        sleep_ -= snooze ;
+    if ( reused ) {
+        if ( send(sockfd,requestText.data(),static_cast<int>(requestText.size()),MSG_NOSIGNAL) == SOCKET_ERROR )
+            return -1; // stale connection, the caller reconnects
+    } else {
+        while ( sleep_ >= 0 && send(sockfd,requestText.data(),static_cast<int>(requestText.size()),MSG_NOSIGNAL) == SOCKET_ERROR /* && WSAGetLastError() == WSAENOTCONN */ ) {
+            Sleep(snooze) ;
+            sleep_ -= snooze ;
+        }
+
+        if ( sleep_ < 0 )
+            return error(errors, "error - timeout connecting to server = %s port = %s wsa_error = %d", servername, port,
+                         WSAGetLastError());
     }
 
-    if ( sleep_ < 0 )
-        return error(errors, "error - timeout connecting to server = %s port = %s wsa_error = %d", servername, port,
-                     WSAGetLastError());
+    char   buffer[32*1024+1];
+    size_t buff_l= sizeof buffer - 1 ;
 
     int    end   = 0         ; // write position in buffer
     bool   bSearching = true ; // looking for headers in the response
+    bool   bComplete  = false; // the whole body has been received (keep-alive only)
+    ChunkDecoder chunks      ; // state of a chunked body across reads
     int    status= 200       ; // assume happiness
 
     ////////////////////////////////////
     // read and process the response
     int err = 0;
-    n = forgive(recv(sockfd, buffer, static_cast<int>(buff_l), 0), err);
+    int n = forgive(recv(sockfd, buffer, static_cast<int>(buff_l), 0), err);
     while ( n >= 0 && OK(status) ) {
         if ( n ) {
+            received = true;
             end += n ;
             buffer[end] = 0 ;
 
@@ -374,8 +424,14 @@ int Exiv2::http(Exiv2::Dictionary& request,Exiv2::Dictionary& response,std::stri
             }
             if ( !bSearching && OK(status) ) {
                 flushBuffer(buffer,body,end,file);
+                bComplete = keepAlive && bodyComplete(response, file, chunks, isHead, status);
             }
         }
+        if ( bComplete ) {
+            n = FINISH;
+            reusable = strcasecmp(headerValue(response, "Connection").c_str(), "close") != 0;
+            break;
+        }
         n = forgive(recv(sockfd, buffer + end, static_cast<int>(buff_l - end), 0), err);
         if ( !n ) {
             Sleep(snooze) ;
@@ -384,6 +440,8 @@ int Exiv2::http(Exiv2::Dictionary& request,Exiv2::Dictionary& response,std::stri
         }
     }
 
+    if ( reused && !received ) return -1; // stale connection, the caller reconnects
+
     if ( n != FINISH || !OK(status) ) {
         snprintf(buffer,sizeof buffer,"wsa_error = %d,n = %d,sleep_ = %d status = %d"
                 ,   WSAGetLastError()
@@ -401,11 +459,109 @@ int Exiv2::http(Exiv2::Dictionary& request,Exiv2::Dictionary& response,std::stri
                          WSAGetLastError());
         }
     }
+    return result;
+}
+
+int Exiv2::http(Exiv2::Dictionary& request,Exiv2::Dictionary& response,std::string& errors)
+{
+    if ( !request.count("verb")   ) request["verb"   ] = "GET";
+    if ( !request.count("header") ) request["header" ] = ""   ;
+    if ( !request.count("version")) request["version"] = "1.0";
+    if ( !request.count("port")   ) request["port"   ] = ""   ;
+
+    std::string file;
+    errors     = "";
+
+    ////////////////////////////////////
+    // Windows specific code
+#if defined(WIN32) || defined(_MSC_VER) || defined(__MINGW__) || defined(__CYGWIN__)
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2,2), &wsaData);
+#endif
+
+    const char* servername = request["server" ].c_str();
+    const char* page       = request["page"   ].c_str();
+    const char* verb       = request["verb"   ].c_str();
+    const char* header     = request["header" ].c_str();
+    const char* version    = request["version"].c_str();
+    const char* port       = request["port"   ].c_str();
+
+    const char* servername_p = servername;
+    const char* port_p       = port      ;
+    std::string url = std::string("http://") + request["server"] + request["page"];
+
+    // parse and change server if using a proxy
+    const char* PROXI  = "HTTP_PROXY";
+    const char* proxi  = "http_proxy";
+    const char* PROXY  = getenv(PROXI);
+    const char* proxy  = getenv(proxi);
+    bool        bProx  = PROXY || proxy;
+    const char* prox   = bProx ? (proxy?proxy:PROXY):"";
+    Exiv2::Uri  Proxy  =  Exiv2::Uri::Parse(prox);
+
+    // find the dictionary of no_proxy servers
+    const char* NO_PROXI = "NO_PROXY";
+    const char* no_proxi = "no_proxy";
+    const char* NO_PROXY = getenv(NO_PROXI);
+    const char* no_proxy = getenv(no_proxi);
+    bool        bNoProxy = NO_PROXY||no_proxy;
+    std::string no_prox  = std::string(bNoProxy?(no_proxy?no_proxy:NO_PROXY):"");
+    Exiv2::Dictionary noProxy= stringToDict(no_prox + ",localhost,127.0.0.1");
+
+    // if the server is on the no_proxy list ... ignore the proxy!
+    if ( noProxy.count(servername) ) bProx = false;
+
+    if (  bProx ) {
+        servername_p = Proxy.Host.c_str();
+        port_p       = Proxy.Port.c_str();
+        page         = url.c_str();
+        std::string  p(proxy?proxi:PROXI);
+    //  std::cerr << p << '=' << prox << " page = " << page << std::endl;
+    }
+    if ( !port  [0] ) port   = "80";
+    if ( !port_p[0] ) port_p = "80";
+
+    ////////////////////////////////////
+    // format the request
+    char   buffer[32*1024+1];
+    size_t buff_l= sizeof buffer - 1 ;
+    int    n  = snprintf(buffer,buff_l,httpTemplate,verb,page,version,servername,header) ;
+    buffer[n] = 0 ;
+    response["requestheaders"]=std::string(buffer,n);
+    const std::string requestText(buffer,n);
+
+    ////////////////////////////////////
+    // HTTP/1.1 connections are kept open and reused for the next request to the same server
+    const bool        keepAlive = strcmp(version,"1.1") == 0;
+    const bool        isHead    = strcmp(verb,"HEAD") == 0;
+    const std::string poolKey   = std::string(servername_p) + ':' + port_p;
+
+    bool reusable = false;
+    bool received = false;
+    int  result   = -1;
+    int  sockfd   = keepAlive ? takeConnection(poolKey) : -1;
+    if ( sockfd >= 0 ) {
+        result = transact(sockfd, requestText, true, keepAlive, isHead, servername, port, response, file, errors,
+                          reusable, received);
+        if ( !received ) { // the server has closed the idle connection
+            closesocket(sockfd);
+            sockfd = -1;
+        }
+    }
+    if ( sockfd < 0 ) {
+        sockfd = openConnection(servername_p, port_p, errors);
+        if ( sockfd < 0 ) return sockfd;
+        result = transact(sockfd, requestText, false, keepAlive, isHead, servername, port, response, file, errors,
+                          reusable, received);
+    }
 
     ////////////////////////////////////
-    // close sockets
-    closesocket(server) ;
-    closesocket(sockfd) ;
+    // close or recycle the socket
+    if ( keepAlive && reusable && errors.empty() ) {
+        releaseConnection(poolKey, sockfd);
+    } else {
+        closesocket(sockfd) ;
+    }
     response["body"]=file;
     return result;
 }
@@ -57,8 +57,10 @@
 #include "rw2image.hpp"
 #include "pgfimage.hpp"
 #include "xmpsidecar.hpp"
+#include "probe_int.hpp"
 
 // + standard includes
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
@@ -66,6 +68,8 @@
 #include <iostream>
 #include <limits>
 #include <set>
+#include <type_traits>
+#include <vector>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -81,6 +85,54 @@ namespace {
 
     using namespace Exiv2;
 
+    //! 64 bit FNV-1a hash, used to detect changes of the metadata of an image
+    class MetadataHash {
+    public:
+        //! Add \em size bytes at \em data to the hash, preceded by the size
+        void add(const byte* data, size_t size)
+        {
+            addBytes(reinterpret_cast<const byte*>(&size), sizeof(size));
+            addBytes(data, size);
+        }
+        //! Add a string to the hash
+        void add(const std::string& s)
+        {
+            add(reinterpret_cast<const byte*>(s.data()), s.size());
+        }
+        //! Add a number or enumerator to the hash
+        template <typename T>
+        void add(T value)
+        {
+            static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Not a number");
+            addBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
+        }
+        //! Return the hash value
+        uint64_t value() const { return h_; }
+
+    private:
+        void addBytes(const byte* data, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i) {
+                h_ ^= data[i];
+                h_ *= 0x100000001b3ULL;
+            }
+        }
+
+        uint64_t h_{0xcbf29ce484222325ULL};
+    };
+
+    //! Return a hash of the custom XMP namespaces, the XMP data is written with them
+    uint64_t nsRegistryHash()
+    {
+        MetadataHash hash;
+        std::lock_guard<std::mutex> scoped_read_lock(XmpProperties::mutex_);
+        for (auto&& ns : XmpProperties::nsRegistry_) {
+            hash.add(ns.first);
+            hash.add(std::string(ns.second.prefix_));
+        }
+        return hash.value();
+    }
+
     //! Struct for storing image types and function pointers.
     struct Registry {
         //! Comparison operator to compare a Registry structure with an image type
@@ -127,12 +179,147 @@ namespace {
         { ImageType::bmp,  newBmpInstance,  isBmpType,  amNone,      amNone,      amNone,      amNone      },
         { ImageType::jp2,  newJp2Instance,  isJp2Type,  amReadWrite, amReadWrite, amReadWrite, amNone      },
 #ifdef EXV_ENABLE_BMFF
-        { ImageType::bmff, newBmffInstance, isBmffType, amRead,      amRead,      amRead,      amNone      },
+        { ImageType::bmff, newBmffInstance, isBmffType, amReadWrite, amRead,      amReadWrite, amNone      },
 #endif // EXV_ENABLE_BMFF
         // End of list marker
         { ImageType::none, nullptr,               nullptr,          amNone,      amNone,      amNone,      amNone      }
     };
 
+    //! Magic bytes found at a fixed offset at the start of an image of a given type.
+    struct Signature {
+        int         imageType_;
+        long        offset_;
+        const char* magic_;
+        long        size_;
+    };
+
+    /*!
+      @brief Signatures used to preselect the candidate types of an image.
+
+      An image type is only confirmed with its type check if one of its
+      signatures matches the start of the image. Image types without an entry
+      here are always checked. All signatures must fit into probeSize bytes.
+     */
+    const Signature signatures[] = {
+        { ImageType::jpeg,  0, "\xff\xd8",                         2 },
+        { ImageType::exv,   0, "\xff\x01" "Exiv2",                 7 },
+        { ImageType::cr2,   0, "II",                               2 },
+        { ImageType::cr2,   0, "MM",                               2 },
+        { ImageType::crw,   0, "II",                               2 },
+        { ImageType::crw,   0, "MM",                               2 },
+        { ImageType::mrw,   0, "\0MRM",                            4 },
+        { ImageType::tiff,  0, "II",                               2 },
+        { ImageType::tiff,  0, "MM",                               2 },
+        { ImageType::webp,  0, "RIFF",                             4 },
+        { ImageType::rw2,   0, "II",                               2 },
+        { ImageType::rw2,   0, "MM",                               2 },
+        { ImageType::orf,   0, "II",                               2 },
+        { ImageType::orf,   0, "MM",                               2 },
+#ifdef EXV_HAVE_LIBZ
+        { ImageType::png,   0, "\x89PNG\r\n\x1a\n",                8 },
+#endif // EXV_HAVE_LIBZ
+        { ImageType::pgf,   0, "PGF",                              3 },
+        { ImageType::raf,   0, "FUJIFILM",                         8 },
+        { ImageType::eps,   0, "%!PS-Adobe-3.",                   13 },
+        { ImageType::eps,   0, "\xc5\xd0\xd3\xc6",                 4 },
+        { ImageType::xmp,   0, "<",                                1 },
+        { ImageType::xmp,   0, "\xef\xbb\xbf",                     3 },
+        { ImageType::gif,   0, "GIF8",                             4 },
+        { ImageType::psd,   0, "8BPS",                             4 },
+        { ImageType::bmp,   0, "BM",                               2 },
+        { ImageType::jp2,   0, "\0\0\0\x0cjP  ",                   8 },
+#ifdef EXV_ENABLE_BMFF
+        { ImageType::bmff,  4, "ftyp",                             4 },
+        { ImageType::bmff,  4, "JXL ",                             4 },
+#endif // EXV_ENABLE_BMFF
+    };
+
+    //! Number of bytes read from the start of an image to determine its type
+    constexpr long probeSize = 128;
+
+    /*!
+      @brief Check if the start of an image, \em prefix, may be an image of type
+             \em imageType according to the signature table.
+     */
+    bool hasSignature(int imageType, const byte* prefix, long size)
+    {
+        bool known = false;
+        for (auto&& sig : signatures) {
+            if (sig.imageType_ != imageType)
+                continue;
+            known = true;
+            if (sig.offset_ + sig.size_ <= size && memcmp(prefix + sig.offset_, sig.magic_, sig.size_) == 0) {
+                return true;
+            }
+        }
+        return !known;
+    }
+
+    //! True if the type check of \em imageType needs more than the start of the image.
+    bool needsFullIo(int imageType)
+    {
+        // TGA files are recognized by their file name or a trailer
+        return imageType == ImageType::tga;
+    }
+
+    /*!
+      @brief Determine the registry entry for the image in \em io.
+
+      The first probeSize bytes of the image are read with a single call and
+      matched against the signature table; the type checks of the candidates
+      then run on that buffer. If the start of the image cannot be read in one
+      go, all type checks run on \em io, as before. On return, \em io is
+      positioned at the start of the image.
+
+      @param io     The image.
+      @param prefix Buffer of probeSize bytes, returns the start of the image.
+      @param size   Returns the number of bytes in \em prefix.
+      @return Pointer to the registry entry or nullptr if the type is unknown.
+     */
+    const Registry* findRegistry(BasicIo& io, byte* prefix, long& size)
+    {
+        io.seek(0, BasicIo::beg);
+        size = io.read(prefix, probeSize);
+        const bool complete = !io.error() && size >= 0
+                              && (size == probeSize || static_cast<size_t>(size) == io.size());
+        io.seek(0, BasicIo::beg);
+
+        if (!complete) {
+            for (unsigned int i = 0; registry[i].imageType_ != ImageType::none; ++i) {
+                if (registry[i].isThisType_(io, false)) {
+                    return &registry[i];
+                }
+            }
+            return nullptr;
+        }
+
+        MemIo head(prefix, size);
+        for (unsigned int i = 0; registry[i].imageType_ != ImageType::none; ++i) {
+            if (!hasSignature(registry[i].imageType_, prefix, size))
+                continue;
+            bool matched = false;
+            if (needsFullIo(registry[i].imageType_)) {
+                matched = registry[i].isThisType_(io, false);
+                io.seek(0, BasicIo::beg);
+            } else {
+                head.seek(0, BasicIo::beg);
+                matched = registry[i].isThisType_(head, false);
+            }
+            if (matched) {
+                return &registry[i];
+            }
+        }
+        return nullptr;
+    }
+
+    //! Determine the registry entry for the image in \em io.
+    const Registry* findRegistry(BasicIo& io)
+    {
+        byte prefix[probeSize];
+        long size = 0;
+        return findRegistry(io, prefix, size);
+    }
+
 }  // namespace
 
 // *****************************************************************************
@@ -150,7 +337,12 @@ namespace Exiv2 {
           writeXmpFromPacket_(true),
 #endif
           byteOrder_(invalidByteOrder),
-          init_(true)
+          init_(true),
+          metadataClean_(false),
+          unhashedMetadata_(mdNone),
+          exposedMetadata_(mdNone),
+          cleanNsRegistryHash_(0),
+          writtenMetadata_(mdNone)
     {
     }
 
@@ -550,21 +742,25 @@ namespace Exiv2 {
 
     ExifData& Image::exifData()
     {
+        exposeMetadata(mdExif);
         return exifData_;
     }
 
     IptcData& Image::iptcData()
     {
+        exposeMetadata(mdIptc);
         return iptcData_;
     }
 
     XmpData& Image::xmpData()
     {
+        exposeMetadata(mdXmp);
         return xmpData_;
     }
 
     std::string& Image::xmpPacket()
     {
+        exposeMetadata(mdXmp);
         // Serialize the current XMP
         if (xmpData_.count() > 0 && !writeXmpFromPacket()) {
             XmpParser::encode(xmpPacket_, xmpData_,
@@ -596,32 +792,38 @@ namespace Exiv2 {
 
     void Image::clearExifData()
     {
+        hashCleanMetadata(mdExif);
         exifData_.clear();
     }
 
     void Image::setExifData(const ExifData& exifData)
     {
+        hashCleanMetadata(mdExif);
         exifData_ = exifData;
     }
 
     void Image::clearIptcData()
     {
+        hashCleanMetadata(mdIptc);
         iptcData_.clear();
     }
 
     void Image::setIptcData(const IptcData& iptcData)
     {
+        hashCleanMetadata(mdIptc);
         iptcData_ = iptcData;
     }
 
     void Image::clearXmpPacket()
     {
+        hashCleanMetadata(mdXmp);
         xmpPacket_.clear();
         writeXmpFromPacket(true);
     }
 
     void Image::setXmpPacket(const std::string& xmpPacket)
     {
+        hashCleanMetadata(mdXmp);
         xmpPacket_ = xmpPacket;
         if ( XmpParser::decode(xmpData_, xmpPacket) ) {
             throw Error(kerInvalidXMP);
@@ -631,12 +833,14 @@ namespace Exiv2 {
 
     void Image::clearXmpData()
     {
+        hashCleanMetadata(mdXmp);
         xmpData_.clear();
         writeXmpFromPacket(false);
     }
 
     void Image::setXmpData(const XmpData& xmpData)
     {
+        hashCleanMetadata(mdXmp);
         xmpData_ = xmpData;
         writeXmpFromPacket(false);
     }
@@ -644,6 +848,7 @@ namespace Exiv2 {
 #ifdef EXV_HAVE_XMP_TOOLKIT
     void Image::writeXmpFromPacket(bool flag)
     {
+        hashCleanMetadata(mdXmp);
         writeXmpFromPacket_ = flag;
     }
 #else
@@ -652,11 +857,13 @@ namespace Exiv2 {
 
     void Image::clearComment()
     {
+        hashCleanMetadata(mdComment);
         comment_.erase();
     }
 
     void Image::setComment(const std::string& comment)
     {
+        hashCleanMetadata(mdComment);
         comment_ = comment;
     }
 
@@ -671,16 +878,19 @@ namespace Exiv2 {
                 throw Error(kerInvalidIccProfile);
             }
         }
+        hashCleanMetadata(mdIccProfile);
         iccProfile_ = std::move(iccProfile);
     }
 
     void Image::clearIccProfile()
     {
+        hashCleanMetadata(mdIccProfile);
         iccProfile_.reset();
     }
 
     void Image::setByteOrder(ByteOrder byteOrder)
     {
+        hashCleanMetadata(mdExif);
         byteOrder_ = byteOrder;
     }
 
@@ -739,6 +949,118 @@ namespace Exiv2 {
         return nativePreviews_;
     }
 
+    int Image::changedMetadata() const
+    {
+        if (!metadataClean_) return supportedMetadata_;
+        // Metadata which was not hashed yet was not accessed since it was clean
+        int changed = mdNone;
+        for (auto&& clean : cleanHashes_) {
+            if (metadataHash(static_cast<MetadataId>(clean.first)) != clean.second) {
+                changed |= clean.first;
+            }
+        }
+        // The XMP data is encoded with the namespaces registered when it is written
+        if (!writeXmpFromPacket_ && !xmpData_.empty() && nsRegistryHash() != cleanNsRegistryHash_) {
+            changed |= mdXmp;
+        }
+        return changed;
+    }
+
+    int Image::writtenMetadata() const
+    {
+        return writtenMetadata_;
+    }
+
+    void Image::setMetadataClean()
+    {
+        metadataClean_ = true;
+        cleanHashes_.clear();
+        unhashedMetadata_ = mdExif | mdIptc | mdComment | mdXmp | mdIccProfile;
+        cleanNsRegistryHash_ = nsRegistryHash();
+        hashCleanMetadata(exposedMetadata_);
+    }
+
+    void Image::hashCleanMetadata(int metadata)
+    {
+        const int unhashed = unhashedMetadata_ & metadata;
+        if (unhashed == mdNone) return;
+        for (auto metadataId : {mdExif, mdIptc, mdComment, mdXmp, mdIccProfile}) {
+            if (unhashed & metadataId) {
+                cleanHashes_[metadataId] = metadataHash(metadataId);
+            }
+        }
+        unhashedMetadata_ &= ~unhashed;
+    }
+
+    void Image::exposeMetadata(int metadata)
+    {
+        hashCleanMetadata(metadata);
+        exposedMetadata_ |= metadata;
+    }
+
+    void Image::setWrittenMetadata(int metadata)
+    {
+        writtenMetadata_ = metadata;
+    }
+
+    uint64_t Image::metadataHash(MetadataId metadataId) const
+    {
+        MetadataHash hash;
+        std::vector<byte> buf;
+        switch (metadataId) {
+            case mdExif:
+                hash.add(byteOrder_);
+                for (auto&& datum : exifData_) {
+                    hash.add(datum.tag());
+                    hash.add(datum.ifdId());
+                    hash.add(datum.idx());
+                    hash.add(datum.typeId());
+                    buf.resize(datum.size());
+                    if (!buf.empty()) datum.copy(buf.data(), littleEndian);
+                    hash.add(buf.data(), buf.size());
+                    if (datum.sizeDataArea() > 0) {
+                        const DataBuf dataArea = datum.dataArea();
+                        hash.add(dataArea.c_data(), dataArea.size());
+                    }
+                }
+                break;
+            case mdIptc:
+                for (auto&& datum : iptcData_) {
+                    hash.add(datum.record());
+                    hash.add(datum.tag());
+                    hash.add(datum.typeId());
+                    buf.resize(datum.size());
+                    if (!buf.empty()) datum.copy(buf.data(), bigEndian);
+                    hash.add(buf.data(), buf.size());
+                }
+                break;
+            case mdXmp:
+                // The packet is only written if writeXmpFromPacket() is set
+                hash.add(writeXmpFromPacket_);
+                if (writeXmpFromPacket_) {
+                    hash.add(xmpPacket_);
+                } else {
+                    for (auto&& datum : xmpData_) {
+                        hash.add(datum.key());
+                        // The namespace registered for the prefix is written too
+                        hash.add(XmpProperties::ns(datum.groupName()));
+                        hash.add(datum.typeId());
+                        hash.add(datum.toString());
+                    }
+                }
+                break;
+            case mdComment:
+                hash.add(comment_);
+                break;
+            case mdIccProfile:
+                hash.add(iccProfile_.c_data(), iccProfile_.size());
+                break;
+            case mdNone:
+                break;
+        }
+        return hash.value();
+    }
+
     bool Image::good() const
     {
         if (io_->open() != 0)
@@ -836,14 +1158,29 @@ namespace Exiv2 {
     {
         if (io.open() != 0) return ImageType::none;
         IoCloser closer(io);
-        for (unsigned int i = 0; registry[i].imageType_ != ImageType::none; ++i) {
-            if (registry[i].isThisType_(io, false)) {
-                return registry[i].imageType_;
-            }
-        }
-        return ImageType::none;
+        const Registry* r = findRegistry(io);
+        return r ? r->imageType_ : ImageType::none;
     } // ImageFactory::getType
 
+    ImageProbe ImageFactory::probe(BasicIo& io)
+    {
+        if (io.open() != 0) {
+            throw Error(kerDataSourceOpenFailed, io.path(), strError());
+        }
+        IoCloser closer(io);
+        byte prefix[probeSize];
+        long size = 0;
+        ImageProbe result;
+        const Registry* r = findRegistry(io, prefix, size);
+        if (!r || size < 0) {
+            result.bytesRead_ = std::max(size, 0L);
+            return result;
+        }
+        result.imageType_ = r->imageType_;
+        Internal::probeImage(io, prefix, size, result);
+        return result;
+    } // ImageFactory::probe
+
     BasicIo::UniquePtr ImageFactory::createIo(const std::string& path, bool useCurl)
     {
         Protocol fProt = fileProtocol(path);
@@ -916,10 +1253,9 @@ namespace Exiv2 {
         if (io->open() != 0) {
             throw Error(kerDataSourceOpenFailed, io->path(), strError());
         }
-        for (unsigned int i = 0; registry[i].imageType_ != ImageType::none; ++i) {
-            if (registry[i].isThisType_(*io, false)) {
-                return registry[i].newInstance_(std::move(io), false);
-            }
+        const Registry* r = findRegistry(*io);
+        if (r) {
+            return r->newInstance_(std::move(io), false);
         }
         return nullptr;
     }
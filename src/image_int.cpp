@@ -18,13 +18,37 @@
  */
 
 #include "image_int.hpp"
+#include "basicio.hpp"
+#include "error.hpp"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EXV_FIND_SSE2
+#endif
+
+#include <algorithm>
 #include <cstdarg>
 #include <cstddef>
 #include <cstring>
 #include <vector>
 #include <cstdio>
 
+namespace
+{
+#if defined(__AVX2__) || defined(EXV_FIND_SSE2)
+    //! Index of the lowest bit set in \em mask, which must not be 0
+    int firstBit(uint32_t mask)
+    {
+        int i = 0;
+        for (; (mask & 0xff) == 0; mask >>= 8) i += 8;
+        for (; (mask & 1) == 0; mask >>= 1) ++i;
+        return i;
+    }
+#endif
+}  // namespace
+
 namespace Exiv2
 {
     namespace Internal
@@ -112,6 +136,99 @@ namespace Exiv2
             return result;
         }
 
+        bool lastWriteTime(const BasicIo& io, std::filesystem::file_time_type& mtime)
+        {
+            if (dynamic_cast<const FileIo*>(&io) == nullptr) return false;
+            std::error_code ec;
+            mtime = std::filesystem::last_write_time(io.path(), ec);
+            return !ec;
+        }
+
+        BlockIndex::BlockIndex(const BasicIo& io, long end) : end_(end), size_(io.size())
+        {
+            haveMtime_ = lastWriteTime(io, mtime_);
+        }
+
+        void BlockIndex::readAll(BasicIo& io)
+        {
+            while (!io.eof() && io.tell() < end_) {
+                const long next = nextBlock(io);
+                if (next < 0) {
+                    return;
+                }
+                io.seek(next, BasicIo::beg);
+                if (io.error()) {
+                    throw Error(kerFailedToReadImageData);
+                }
+            }
+        }
+
+        bool BlockIndex::isCurrent(const BasicIo& io) const
+        {
+            std::filesystem::file_time_type mtime;
+            return haveMtime_ && io.size() == size_ && lastWriteTime(io, mtime) && mtime == mtime_;
+        }
+
+        const byte* findEither(const byte* first, const byte* last, byte a, byte b)
+        {
+#if defined(__AVX2__)
+            const __m256i va = _mm256_set1_epi8(static_cast<char>(a));
+            const __m256i vb = _mm256_set1_epi8(static_cast<char>(b));
+            for (; last - first >= 32; first += 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                const auto mask = static_cast<uint32_t>(
+                    _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb))));
+                if (mask != 0) {
+                    return first + firstBit(mask);
+                }
+            }
+#elif defined(EXV_FIND_SSE2)
+            const __m128i va = _mm_set1_epi8(static_cast<char>(a));
+            const __m128i vb = _mm_set1_epi8(static_cast<char>(b));
+            for (; last - first >= 16; first += 16) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const auto mask = static_cast<uint32_t>(
+                    _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb))));
+                if (mask != 0) {
+                    return first + firstBit(mask);
+                }
+            }
+#endif
+            for (; first != last; ++first) {
+                if (*first == a || *first == b) return first;
+            }
+            return last;
+        }
+
+        const byte* findPattern(const byte* first, const byte* last, const std::string& pattern)
+        {
+            if (pattern.empty()) return last;
+            const auto head = static_cast<unsigned char>(pattern[0]);
+            while (static_cast<size_t>(last - first) >= pattern.size()) {
+                const auto p = static_cast<const byte*>(
+                    std::memchr(first, head, static_cast<size_t>(last - first) - pattern.size() + 1));
+                if (p == nullptr) break;
+                if (std::memcmp(p, pattern.data(), pattern.size()) == 0) return p;
+                first = p + 1;
+            }
+            return last;
+        }
+
+        void copyData(BasicIo& src, long offset, long count, BasicIo& dest)
+        {
+            if (count <= 0) return;
+            if (src.seek(offset, BasicIo::beg) != 0) throw Error(kerFailedToReadImageData);
+            DataBuf buf(std::min(count, 64L * 1024));
+            while (count > 0) {
+                const long n = std::min(count, buf.size());
+                const long bufRead = src.read(buf.data(), n);
+                if (src.error()) throw Error(kerFailedToReadImageData);
+                if (bufRead != n) throw Error(kerInputDataReadFailed);
+                if (dest.write(buf.c_data(), n) != n) throw Error(kerImageWriteFailed);
+                count -= n;
+            }
+        }
+
     }  // namespace Internal
 
 }  // namespace Exiv2
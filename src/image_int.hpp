@@ -25,6 +25,7 @@
 #include "types.hpp"
 
 // + standard includes
+#include <filesystem>
 #include <string>
 
 #if (defined(__GNUG__) || defined(__GNUC__)) || defined(__clang__)
@@ -36,6 +37,9 @@
 // *****************************************************************************
 // namespace extensions
 namespace Exiv2 {
+
+    class BasicIo;
+
     namespace Internal {
 
 // *****************************************************************************
@@ -130,6 +134,92 @@ namespace Exiv2 {
      */
     std::string indent(int32_t depth);
 
+    //! Get the modification time of the file behind \em io, return false if it is not a file.
+    bool lastWriteTime(const BasicIo& io, std::filesystem::file_time_type& mtime);
+
+    /*!
+      @brief Base class of the indexes of the blocks (chunks, resource blocks)
+             of an image, which readMetadata() builds as it reads the blocks and
+             writeMetadata() reuses, provided the image didn't change since.
+             Images which aren't read completely are indexed in one pass over
+             the block headers, seeking over the block data (readAll()).
+     */
+    class BlockIndex {
+    public:
+        //! @name Creators
+        //@{
+        //! Constructor for an empty index of the blocks of \em io, which end at \em end.
+        BlockIndex(const BasicIo& io, long end);
+        //! Virtual destructor.
+        virtual ~BlockIndex() = default;
+        //@}
+
+        //! @name Manipulators
+        //@{
+        /*!
+          @brief Add all blocks from the current position of \em io, which must
+                 be at a block header, up to the last block or end() to the index.
+          @throw Error if a block header can't be read or a block exceeds the data.
+         */
+        void readAll(BasicIo& io);
+        //@}
+
+        //! @name Accessors
+        //@{
+        //! Return the end of the blocks
+        long end() const { return end_; }
+        /*!
+          @brief Return true if \em io, the image the index was built from, is
+                 a file which didn't change since, as far as its size and
+                 modification time tell.
+         */
+        bool isCurrent(const BasicIo& io) const;
+        //@}
+
+    protected:
+        /*!
+          @brief Add the block at the current position of \em io, which is at
+                 its header, to the index.
+          @return The offset of the next block; -1 if the block is the last one.
+          @throw Error if the header can't be read or the block exceeds the data.
+         */
+        virtual long nextBlock(BasicIo& io) = 0;
+
+    private:
+        // DATA
+        long end_;                               //!< End of the blocks
+        size_t size_;                            //!< Size of the image
+        bool haveMtime_;                         //!< True if the image is a file with a modification time
+        std::filesystem::file_time_type mtime_;  //!< Modification time of the file
+    }; // class BlockIndex
+
+    /*!
+      @brief Find the first byte in [\em first, \em last) which is \em a or \em b.
+
+      Compares 16 or 32 bytes at a time with SSE2 or AVX2 if the compiler
+      targets them, one byte at a time otherwise.
+
+      @return Pointer to the byte found, \em last if there is none.
+     */
+    const byte* findEither(const byte* first, const byte* last, byte a, byte b);
+
+    /*!
+      @brief Find the first occurrence of \em pattern in [\em first, \em last).
+
+      Candidates are located with memchr(), which the C library vectorizes.
+
+      @return Pointer to the start of the occurrence, \em last if there is none
+              or \em pattern is empty.
+     */
+    const byte* findPattern(const byte* first, const byte* last, const std::string& pattern);
+
+    /*!
+      @brief Copy \em count bytes at \em offset of \em src to \em dest, through
+             a buffer of fixed size.
+      @throw Error if reading or writing fails.
+     */
+    void copyData(BasicIo& src, long offset, long count, BasicIo& dest);
+
 }}                                      // namespace Internal, Exiv2
 
 #endif                                  // #ifndef IMAGE_INT_HPP_
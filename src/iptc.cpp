@@ -96,6 +96,8 @@ namespace Exiv2 {
             value_ = rhs.value_->clone();  // deep copy
     }
 
+    Iptcdatum::Iptcdatum(Iptcdatum&& rhs) noexcept = default;
+
     long Iptcdatum::copy(byte* buf, ByteOrder byteOrder) const
     {
         return value_.get() == nullptr ? 0 : value_->copy(buf, byteOrder);
@@ -224,6 +226,8 @@ namespace Exiv2 {
         return *this;
     } // Iptcdatum::operator=
 
+    Iptcdatum& Iptcdatum::operator=(Iptcdatum&& rhs) noexcept = default;
+
     Iptcdatum& Iptcdatum::operator=(const uint16_t& value)
     {
         auto v = std::make_unique<UShortValue>();
@@ -303,6 +307,18 @@ namespace Exiv2 {
         return 0;
     }
 
+    int IptcData::add(Iptcdatum&& iptcDatum)
+    {
+        if (!IptcDataSets::dataSetRepeatable(
+               iptcDatum.tag(), iptcDatum.record()) &&
+               findId(iptcDatum.tag(), iptcDatum.record()) != end()) {
+             return 6;
+        }
+        // allow duplicates
+        iptcMetadata_.push_back(std::move(iptcDatum));
+        return 0;
+    }
+
     IptcData::const_iterator IptcData::findKey(const IptcKey& key) const
     {
         return std::find_if(iptcMetadata_.begin(), iptcMetadata_.end(),
@@ -638,7 +638,7 @@ static void boxes_check(size_t b,size_t m)
             throw Error(kerDataSourceOpenFailed, io_->path(), strError());
         }
         IoCloser closer(*io_);
-        auto tempIo = std::make_unique<MemIo>();
+        auto tempIo = std::make_unique<TempIo>(*io_);
 
         doWriteMetadata(*tempIo); // may throw
         io_->close();
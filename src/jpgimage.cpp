@@ -533,6 +533,7 @@ namespace Exiv2 {
             EXV_WARNING << "JPEG format error, rc = " << rc << "\n";
 #endif
         }
+        setMetadataClean();
     } // JpegBase::readMetadata
 
 #define REPORT_MARKER if ( (option == kpsBasic||option == kpsRecursive) ) \
@@ -818,7 +819,7 @@ namespace Exiv2 {
             // exiv2 -pS E.jpg
 
             // binary copy io_ to a temporary file
-            auto tempIo = std::make_unique<MemIo>();
+            auto tempIo = std::make_unique<TempIo>(*io_);
             for (size_t i = 0; i < (count / 2) + 1; i++) {
                 long start = pos[2 * i] + 2;  // step JPG 2 byte marker
                 if (start == 2)
@@ -844,16 +845,23 @@ namespace Exiv2 {
 
     void JpegBase::writeMetadata()
     {
+        const int changed = changedMetadata();
+        if (changed == mdNone) {
+            setWrittenMetadata(mdNone);
+            return;
+        }
         if (io_->open() != 0) {
             throw Error(kerDataSourceOpenFailed, io_->path(), strError());
         }
         IoCloser closer(*io_);
-        BasicIo::UniquePtr tempIo(new MemIo);
+        BasicIo::UniquePtr tempIo(new TempIo(*io_));
         assert (tempIo.get() != 0);
 
         doWriteMetadata(*tempIo); // may throw
         io_->close();
         io_->transfer(*tempIo); // may throw
+        setWrittenMetadata(changed);
+        setMetadataClean();
     } // JpegBase::writeMetadata
 
     void JpegBase::doWriteMetadata(BasicIo& outIo)
@@ -887,7 +895,10 @@ namespace Exiv2 {
         size_t skipCom = notfound;
         Blob psBlob;
         DataBuf rawExif;
-        xmpData().usePacket(writeXmpFromPacket());
+        DataBuf rawXmp;
+        xmpData_.usePacket(writeXmpFromPacket());
+        // Metadata which did not change is copied from the original segments
+        const int changed = changedMetadata();
 
         // Write image header
         if (writeHeader(outIo))
@@ -939,6 +950,10 @@ namespace Exiv2 {
                        buf.cmpBytes(2, xmpId_, 29) == 0) {
                 skipApp1Xmp = count;
                 ++search;
+                // A packet which could not be decoded is dropped, as if it was re-encoded
+                if (!(changed & mdXmp) && (writeXmpFromPacket() || !xmpData_.empty())) {
+                    rawXmp = std::move(buf);
+                }
             } else if (marker == app2_ &&
                        size >= 13 && // prevent out-of-bounds read in memcmp on next line
                        buf.cmpBytes(2, iccId_, 11) == 0) {
@@ -1043,7 +1058,11 @@ namespace Exiv2 {
                         bo = littleEndian;
                         setByteOrder(bo);
                     }
-                    WriteMethod wm = ExifParser::encode(blob, rawExif.c_data(), rawExif.size(), bo, exifData_);
+                    // Unchanged Exif data is written as it was read
+                    WriteMethod wm = wmNonIntrusive;
+                    if ((changed & mdExif) || rawExif.size() == 0) {
+                        wm = ExifParser::encode(blob, rawExif.c_data(), rawExif.size(), bo, exifData_);
+                    }
                     const byte* pExifData = rawExif.c_data();
                     size_t exifSize = rawExif.size();
                     if (wm == wmIntrusive) {
@@ -1071,7 +1090,15 @@ namespace Exiv2 {
                         --search;
                     }
                 }
-                if (!writeXmpFromPacket()) {
+                if (rawXmp.size() > 0) {
+                    // Unchanged XMP packet, copy the segment as it was read
+                    const byte tmpBuf[2] = {0xff, app1_};
+                    if (outIo.write(tmpBuf, 2) != 2 ||
+                        outIo.write(rawXmp.c_data(), rawXmp.size()) != rawXmp.size())
+                        throw Error(kerImageWriteFailed);
+                    --search;
+                }
+                else if (!writeXmpFromPacket()) {
                     if (XmpParser::encode(xmpPacket_, xmpData_,
                                           XmpParser::useCompactFormat | XmpParser::omitAllFormatting) > 1) {
 #ifndef SUPPRESS_WARNINGS
@@ -1079,7 +1106,7 @@ namespace Exiv2 {
 #endif
                     }
                 }
-                if (!xmpPacket_.empty()) {
+                if (rawXmp.size() == 0 && !xmpPacket_.empty()) {
                     byte tmpBuf[33];
                     // Write APP1 marker, size of APP1 field, XMP id and XMP packet
                     tmpBuf[0] = 0xff;
@@ -1144,8 +1171,12 @@ namespace Exiv2 {
                 if (foundCompletePsData || iptcData_.count() > 0) {
                     // Set the new IPTC IRB, keeps existing IRBs but removes the
                     // IPTC block if there is no new IPTC data to write
-                    DataBuf newPsData = Photoshop::setIptcIrb(!psBlob.empty() ? &psBlob[0] : nullptr,
-                                                              static_cast<long>(psBlob.size()), iptcData_);
+                    // Unchanged IPTC data is written as it was read
+                    DataBuf newPsData = (changed & mdIptc) || !foundCompletePsData
+                                            ? Photoshop::setIptcIrb(!psBlob.empty() ? &psBlob[0] : nullptr,
+                                                                    static_cast<long>(psBlob.size()), iptcData_)
+                                            : DataBuf(!psBlob.empty() ? &psBlob[0] : nullptr,
+                                                      static_cast<long>(psBlob.size()));
                     const long maxChunkSize = 0xffff - 16;
                     const byte* chunkStart = newPsData.c_data();
                     const byte* chunkEnd = newPsData.c_data(newPsData.size());
@@ -1245,12 +1276,9 @@ namespace Exiv2 {
         if (outIo.write(tmpBuf, 2) != 2)
             throw Error(kerImageWriteFailed);
 
-        DataBuf buf(4096);
-        long readSize = 0;
-        while ((readSize = io_->read(buf.data(), buf.size()))) {
-            if (outIo.write(buf.c_data(), readSize) != readSize)
-                throw Error(kerImageWriteFailed);
-        }
+        const long rest = static_cast<long>(io_->size()) - io_->tell();
+        if (outIo.write(*io_) != rest)
+            throw Error(kerImageWriteFailed);
         if (outIo.error())
             throw Error(kerImageWriteFailed);
 
@@ -85,8 +85,6 @@ namespace {
     // Todo: Can be generalized further - get any tag as a string/long/...
     //! Get the Value for a tag within a particular group
     const Exiv2::Value* getExifValue(Exiv2::Internal::TiffComponent* const pRoot, const uint16_t& tag, const Exiv2::Internal::IfdId& group);
-    //! Get the model name from tag Exif.Image.Model
-    std::string getExifModel(Exiv2::Internal::TiffComponent* pRoot);
 
     //! Nikon en/decryption function
     void ncrypt(Exiv2::byte* pData, uint32_t size, uint32_t count, uint32_t serial);
@@ -180,10 +178,9 @@ namespace Exiv2 {
 
     bool TiffMnRegistry::operator==(const std::string& key) const
     {
-        std::string make(make_);
         if (!key.empty() && key[0] == '-')
             return false;
-        return make == key.substr(0, make.length());
+        return key.compare(0, std::strlen(make_), make_) == 0;
     }
 
     bool TiffMnRegistry::operator==(IfdId key) const
@@ -1145,14 +1142,16 @@ namespace Exiv2 {
         { 0x00a8, "0108",    0, 3,  NA },
     };
 
-    int nikonSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const /*pRoot*/)
+    int nikonSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const /*pRoot*/,
+                      const TiffCameraInfo& /*camera*/)
     {
         if (size < 4) return -1;
         const NikonArrayIdx* aix = find(nikonArrayIdx, NikonArrayIdx::Key(tag, reinterpret_cast<const char*>(pData), size));
         return aix == nullptr ? -1 : aix->idx_;
     }
 
-    int nikonAf2Selector(uint16_t tag, const byte* /*pData*/, uint32_t size, TiffComponent* const /*pRoot*/)
+    int nikonAf2Selector(uint16_t tag, const byte* /*pData*/, uint32_t size, TiffComponent* const /*pRoot*/,
+                         const TiffCameraInfo& /*camera*/)
     {
         int result = tag == 0x00b7 ? 0 : -1 ;
         if (result > -1 && size == 84 ) {
@@ -1161,7 +1160,8 @@ namespace Exiv2 {
         return result;
     }
 
-    DataBuf nikonCrypt(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot)
+    DataBuf nikonCrypt(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const /*pRoot*/,
+                       const TiffCameraInfo& camera)
     {
         DataBuf buf;
 
@@ -1169,22 +1169,13 @@ namespace Exiv2 {
         const NikonArrayIdx* nci = find(nikonArrayIdx, NikonArrayIdx::Key(tag, reinterpret_cast<const char*>(pData), size));
         if (nci == nullptr || nci->start_ == NA || size <= nci->start_) return buf;
 
-        // Find Exif.Nikon3.ShutterCount
-        TiffFinder finder(0x00a7, nikon3Id);
-        pRoot->accept(finder);
-        auto te = dynamic_cast<TiffEntryBase*>(finder.result());
-        if (!te || !te->pValue() || te->pValue()->count() == 0) return buf;
-        auto count = static_cast<uint32_t>(te->pValue()->toLong());
-
-        // Find Exif.Nikon3.SerialNumber
-        finder.init(0x001d, nikon3Id);
-        pRoot->accept(finder);
-        te = dynamic_cast<TiffEntryBase*>(finder.result());
-        if (!te || !te->pValue() || te->pValue()->count() == 0) return buf;
+        // The key is made of Exif.Nikon3.ShutterCount and Exif.Nikon3.SerialNumber
+        if (!camera.nikonKey_) return buf;
+        const uint32_t count = camera.shutterCount_;
         bool ok(false);
-        auto serial = stringTo<uint32_t>(te->pValue()->toString(), ok);
+        auto serial = stringTo<uint32_t>(camera.serialNumber_, ok);
         if (!ok) {
-            std::string model = getExifModel(pRoot);
+            const std::string& model = camera.model_;
             if (model.empty()) return buf;
             if (model.find("D50") != std::string::npos) {
                 serial = 0x22;
@@ -1199,9 +1190,10 @@ namespace Exiv2 {
         return buf;
     }
 
-    int sonyCsSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const pRoot)
+    int sonyCsSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const /*pRoot*/,
+                       const TiffCameraInfo& camera)
     {
-        std::string model = getExifModel(pRoot);
+        const std::string& model = camera.model_;
         if (model.empty()) return -1;
         int idx = 0;
         if (   model.find("DSLR-A330") != std::string::npos
@@ -1210,26 +1202,28 @@ namespace Exiv2 {
         }
         return idx;
     }
-    int sony2010eSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const pRoot)
+    int sony2010eSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const /*pRoot*/,
+                          const TiffCameraInfo& camera)
     {
         static constexpr const char* models[] = {
             "SLT-A58",   "SLT-A99",  "ILCE-3000", "ILCE-3500", "NEX-3N",    "NEX-5R",   "NEX-5T",
             "NEX-6",     "VG30E",    "VG900",     "DSC-RX100", "DSC-RX1",   "DSC-RX1R", "DSC-HX300",
             "DSC-HX50V", "DSC-TX30", "DSC-WX60",  "DSC-WX200", "DSC-WX300",
         };
-        return std::find(std::begin(models), std::end(models), getExifModel(pRoot)) != std::end(models) ? 0 : -1;
+        return std::find(std::begin(models), std::end(models), camera.model_) != std::end(models) ? 0 : -1;
     }
-    int sony2FpSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const pRoot)
+    int sony2FpSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const /*pRoot*/,
+                        const TiffCameraInfo& camera)
     {
         // Not valid for models beginning
-        std::string model = getExifModel(pRoot);
         for (auto& m : { "SLT-", "HV", "ILCA-" }) {
-            if (Util::startsWith(model, m))
+            if (Util::startsWith(camera.model_, m))
                 return -1;
         }
         return 0;
     }
-    int sonyMisc2bSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const pRoot)
+    int sonyMisc2bSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const pRoot,
+                           const TiffCameraInfo& /*camera*/)
     {
         // From Exiftool: https://github.com/exiftool/exiftool/blob/master/lib/Image/ExifTool/Sony.pm
         // >  First byte must be 9 or 12 or 13 or 15 or 16 and 4th byte must be 2 (deciphered)
@@ -1257,7 +1251,8 @@ namespace Exiv2 {
         }
         return -1;
     }
-    int sonyMisc3cSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const pRoot)
+    int sonyMisc3cSelector(uint16_t /*tag*/, const byte* /*pData*/, uint32_t /*size*/, TiffComponent* const pRoot,
+                           const TiffCameraInfo& /*camera*/)
     {
         // From Exiftool (Tag 9400c): https://github.com/exiftool/exiftool/blob/master/lib/Image/ExifTool/Sony.pm
         // >  first byte decoded: 62, 48, 215, 28, 106 respectively
@@ -1301,13 +1296,6 @@ namespace {
         return (!te || !te->pValue()) ? nullptr : te->pValue();
     }
 
-    std::string getExifModel(Exiv2::Internal::TiffComponent* const pRoot)
-    {
-        // Lookup the Exif.Image.Model tag
-        const auto value = getExifValue(pRoot, 0x0110, Exiv2::Internal::ifd0Id);
-        return (!value || value->count() == 0) ? std::string("") : std::string(value->toString());
-    }
-
     void ncrypt(Exiv2::byte* pData, uint32_t size, uint32_t count, uint32_t serial)
     {
         static const Exiv2::byte xlat[2][256] = {
@@ -692,9 +692,10 @@ namespace Exiv2 {
       @param pData Pointer to the raw array data.
       @param size Size of the array data.
       @param pRoot Pointer to the root component of the TIFF tree.
+      @param camera Camera model of the TIFF tree.
       @return An index into the array set, -1 if no match was found.
      */
-    int sonyCsSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot);
+    int sonyCsSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot, const TiffCameraInfo& camera);
 
     /*!
         @brief Function to select cfg + def of the Sony 2010 Miscellaneous Information complex binary array.
@@ -703,9 +704,10 @@ namespace Exiv2 {
         @param pData Pointer to the raw array data.
         @param size Size of the array data.
         @param pRoot Pointer to the root component of the TIFF tree.
+        @param camera Camera model of the TIFF tree.
         @return An index into the array set, -1 if no match was found.
     */
-    int sony2010eSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot);
+    int sony2010eSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot, const TiffCameraInfo& camera);
        
     /*!
         @brief Function to select cfg + def of the Sony2Fp (tag 9402) complex binary array.
@@ -714,9 +716,10 @@ namespace Exiv2 {
         @param pData Pointer to the raw array data.
         @param size Size of the array data.
         @param pRoot Pointer to the root component of the TIFF tree.
+        @param camera Camera model of the TIFF tree.
         @return An index into the array set, -1 if no match was found.
     */
-    int sony2FpSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot);
+    int sony2FpSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot, const TiffCameraInfo& camera);
 
     /*!
         @brief Function to select cfg + def of the SonyMisc2b (tag 9404b) complex binary array.
@@ -725,9 +728,10 @@ namespace Exiv2 {
         @param pData Pointer to the raw array data.
         @param size Size of the array data.
         @param pRoot Pointer to the root component of the TIFF tree.
+        @param camera Camera model of the TIFF tree.
         @return An index into the array set, -1 if no match was found.
     */
-    int sonyMisc2bSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot);
+    int sonyMisc2bSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot, const TiffCameraInfo& camera);
 
     /*!
         @brief Function to select cfg + def of the SonyMisc3c (tag 9400) complex binary array.
@@ -736,9 +740,10 @@ namespace Exiv2 {
         @param pData Pointer to the raw array data.
         @param size Size of the array data.
         @param pRoot Pointer to the root component of the TIFF tree.
+        @param camera Camera model of the TIFF tree.
         @return An index into the array set, -1 if no match was found.
     */
-    int sonyMisc3cSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot);
+    int sonyMisc3cSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot, const TiffCameraInfo& camera);
 
     /*!
       @brief Function to select cfg + def of a Nikon complex binary array.
@@ -747,9 +752,10 @@ namespace Exiv2 {
       @param pData Pointer to the raw array data.
       @param size Size of the array data.
       @param pRoot Pointer to the root component of the TIFF tree.
+      @param camera Camera model of the TIFF tree.
       @return An index into the array set, -1 if no match was found.
      */
-    int nikonSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot);
+    int nikonSelector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot, const TiffCameraInfo& camera);
 
     /*!
       @brief Function to select cfg + def of a Nikon complex binary array.
@@ -758,9 +764,10 @@ namespace Exiv2 {
       @param pData Pointer to the raw array data.
       @param size Size of the array data.
       @param pRoot Pointer to the root component of the TIFF tree.
+      @param camera Camera model of the TIFF tree.
       @return An index into the array set, -1 if no match was found.
      */
-     int nikonAf2Selector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot);
+     int nikonAf2Selector(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot, const TiffCameraInfo& camera);
 
     /*!
       @brief Encrypt and decrypt Nikon data.
@@ -775,10 +782,12 @@ namespace Exiv2 {
       @param pData Pointer to the start of the data to en/decrypt.
       @param size Size of the data buffer.
       @param pRoot Pointer to the root element of the composite.
+      @param camera Camera model and Nikon encryption key of the composite.
       @return En/decrypted data. Ownership of the memory is passed to the caller.
               The buffer may be empty in case no decryption was needed.
      */
-    DataBuf nikonCrypt(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot);
+    DataBuf nikonCrypt(uint16_t tag, const byte* pData, uint32_t size, TiffComponent* const pRoot,
+                       const TiffCameraInfo& camera);
 
 }}                                      // namespace Internal, Exiv2
 
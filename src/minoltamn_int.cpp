@@ -1603,7 +1603,7 @@ namespace Exiv2 {
        25720/25721, 25790/25791, 25960/25961, 25980/25981, 26150/26151
        - No need to i18n these string.
     */
-    extern TagDetails const minoltaSonyLensID[] = {
+    constexpr TagDetails minoltaSonyLensID[] = {
         { 0,     "Minolta AF 28-85mm F3.5-4.5 New" },
         { 1,     "Minolta AF 80-200mm F2.8 HS-APO G" },
         { 2,     "Minolta AF 28-70mm F2.8 G" },
@@ -1966,8 +1966,9 @@ namespace Exiv2 {
     static std::string getKeyString(const std::string& key,const ExifData* metadata)
     {
         std::string result;
-        if ( metadata->findKey(ExifKey(key)) != metadata->end() ) {
-            result = metadata->findKey(ExifKey(key))->toString();
+        const auto pos = ExifPrintContext::findKey(*metadata, key);
+        if ( pos != metadata->end() ) {
+            result = pos->toString();
         }
         return result;
     }
@@ -1976,8 +1977,9 @@ namespace Exiv2 {
     static long getKeyLong(const std::string& key,const ExifData* metadata,int which)
     {
         long result = -1;
-        if ( metadata->findKey(ExifKey(key)) != metadata->end() ) {
-            result = static_cast<long>(metadata->findKey(ExifKey(key))->toFloat(which));
+        const auto pos = ExifPrintContext::findKey(*metadata, key);
+        if ( pos != metadata->end() ) {
+            result = static_cast<long>(pos->toFloat(which));
         }
         return result;
     }
@@ -2028,7 +2030,7 @@ namespace Exiv2 {
 
     static std::ostream& resolvedLens(std::ostream& os,long lensID,long index)
     {
-        const TagDetails* td = find(minoltaSonyLensID, lensID);
+        const TagDetails* td = EXV_TAG_DETAILS_INDEX(minoltaSonyLensID)::find(lensID);
         std::vector<std::string> tokens = split(td[0].label_,"|");
         return os << exvGettext(trim(tokens.at(index-1)).c_str());
     }
@@ -40,6 +40,7 @@
 #include <math.h> //for log, pow, abs
 #include <cmath>
 #include <limits>
+#include <array>
 
 // *****************************************************************************
 // class member definitions
@@ -286,8 +287,9 @@ namespace Exiv2 {
     static std::string getKeyString(const std::string& key,const ExifData* metadata)
     {
         std::string result;
-        if ( metadata->findKey(ExifKey(key)) != metadata->end() ) {
-            result = metadata->findKey(ExifKey(key))->toString();
+        const auto pos = ExifPrintContext::findKey(*metadata, key);
+        if ( pos != metadata->end() ) {
+            result = pos->toString();
         }
         return result;
     }
@@ -1744,7 +1746,7 @@ namespace Exiv2 {
 
         bool dModel = false;
         if (metadata) {
-            auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+            auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
             if (pos != metadata->end() && pos->count() != 0) {
                 std::string model = pos->toString();
                 if (model.find("NIKON D") != std::string::npos) {
@@ -1775,8 +1777,7 @@ namespace Exiv2 {
         if (!(l & 0x87)) os << _("Single-frame") << ", ";
         bool d70 = false;
         if (metadata) {
-            ExifKey key("Exif.Image.Model");
-            auto pos = metadata->findKey(key);
+            auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
             if (pos != metadata->end() && pos->count() != 0) {
                 std::string model = pos->toString();
                 if (model.find("D70") != std::string::npos) {
@@ -1850,6 +1851,58 @@ namespace Exiv2 {
         return testConfigFile(os,value) ? os : printLensId(os, value, metadata, "NikonLd4");
     }
 
+#ifdef EXV_HAVE_LENSDATA
+    namespace {
+        //! Compare two strings at compile time
+        constexpr bool equal(const char* a, const char* b)
+        {
+            while (*a != '\0' && *a == *b) {
+                ++a;
+                ++b;
+            }
+            return *a == *b;
+        }
+
+        /*!
+          @brief Index of a lens table by LensIDNumber, the first byte of the
+                 lens data. The entries with the same id keep their order in the
+                 table, so the first match is found as before.
+         */
+        template <size_t N>
+        struct LensIndex {
+            //! Entries with id \em lid are entry_[first_[lid]] up to entry_[first_[lid + 1]]
+            std::array<uint16_t, 257> first_{};
+            //! Positions of the table entries, sorted by id
+            std::array<uint16_t, N> entry_{};
+            //! Flags for the entries made by Sigma, which ignore LensFStops
+            std::array<bool, N> sigma_{};
+        };
+
+        //! Build the index of a lens table terminated by an entry without a lens name
+        template <typename Lens, size_t N>
+        constexpr LensIndex<N> makeLensIndex(const Lens (&lenses)[N])
+        {
+            static_assert(N <= std::numeric_limits<uint16_t>::max(), "Lens table too large");
+            LensIndex<N> index;
+            for (size_t i = 0; lenses[i].lensname != nullptr; ++i) {
+                ++index.first_[lenses[i].lid + 1];
+                index.sigma_[i] = equal(lenses[i].manuf, "Sigma");
+            }
+            for (size_t lid = 1; lid < index.first_.size(); ++lid) {
+                index.first_[lid] += index.first_[lid - 1];
+            }
+            std::array<uint16_t, 256> next{};
+            for (size_t lid = 0; lid < next.size(); ++lid) {
+                next[lid] = index.first_[lid];
+            }
+            for (size_t i = 0; lenses[i].lensname != nullptr; ++i) {
+                index.entry_[next[lenses[i].lid]++] = static_cast<uint16_t>(i);
+            }
+            return index;
+        }
+    }  // namespace
+#endif // EXV_HAVE_LENSDATA
+
     std::ostream& Nikon3MakerNote::printLensId(std::ostream& os,
                                                const Value& value,
                                                const ExifData* metadata,
@@ -1913,7 +1966,7 @@ namespace Exiv2 {
 // Nikkor lenses by their LensID
 //------------------------------------------------------------------------------
 //
-static const struct FMntLens {unsigned char lid,stps,focs,focl,aps,apl,lfw, ltype, tcinfo, dblid, mid; const char *manuf, *lnumber, *lensname;}
+static constexpr struct FMntLens {unsigned char lid,stps,focs,focl,aps,apl,lfw, ltype, tcinfo, dblid, mid; const char *manuf, *lnumber, *lensname;}
 fmountlens[] = {
 {0x01,0x58,0x50,0x50,0x14,0x14,0x02,0x00,0x00,0x00,0x00, "Nikon", "JAA00901", "AF Nikkor 50mm f/1.8"},
 {0x01,0x58,0x50,0x50,0x14,0x14,0x05,0x00,0x00,0x00,0x00, "Nikon", "JAA00901", "AF Nikkor 50mm f/1.8"},
@@ -2614,33 +2667,27 @@ fmountlens[] = {
 #endif
 // 8< - - - 8< do not remove this line >8 - - - >8
 
+        /* the 'FMntLens' name is added to the anonymous struct for
+         * fmountlens[]
+         *
+         * remember to name the struct and make it constexpr when
+         * importing/updating the lens info from:
+         *
+         * www.rottmerhusen.com/objektives/lensid/files/c-header/fmountlens4.h
+         */
+        static constexpr auto index = makeLensIndex(fmountlens);
+
     /* if no meta obj is provided, try to use the value param that *may*
      * be the pre-parsed lensid
      */
         if (metadata == nullptr)
         {
             const unsigned char vid = static_cast<unsigned>(value.toLong(0));
-
-            /* the 'FMntLens' name is added to the anonymous struct for
-             * fmountlens[]
-             *
-             * remember to name the struct when importing/updating the lens info
-             * from:
-             *
-             * www.rottmerhusen.com/objektives/lensid/files/c-header/fmountlens4.h
-             */
-            const struct FMntLens*  pf = fmountlens;
-            while (pf->lid && pf->lensname) {
-                if (pf->lid == vid) {
-                    break;
-                }
-                ++pf;
-            }
-
-            if (pf->lensname == nullptr) {
+            if (index.first_[vid] == index.first_[vid + 1]) {
                 return os << value;
             }
-            return os << pf->manuf << " " << pf->lensname;
+            const FMntLens& lens = fmountlens[index.entry_[index.first_[vid]]];
+            return os << lens.manuf << " " << lens.lensname;
         }
 
 
@@ -2658,35 +2705,36 @@ fmountlens[] = {
 
         const std::string pre = std::string("Exif.") + group + std::string(".");
         for (unsigned int i = 0; i < 7; ++i) {
-            ExifKey key(pre + std::string(tags[i]));
-            auto md = metadata->findKey(key);
+            auto md = ExifPrintContext::findKey(*metadata, pre + tags[i]);
             if (md == metadata->end() || md->typeId() != unsignedByte || md->count() == 0) {
                 return os << value;
             }
             raw[i] = static_cast<byte>(md->toLong());
         }
 
-        auto md = metadata->findKey(ExifKey("Exif.Nikon3.LensType"));
+        auto md = ExifPrintContext::findKey(*metadata, "Exif.Nikon3.LensType");
         if (md == metadata->end() || md->typeId() != unsignedByte || md->count() == 0) {
             return os << value;
         }
         raw[7] = static_cast<byte>(md->toLong());
 
-        for (int i = 0; fmountlens[i].lensname != nullptr; ++i) {
-            if (   raw[0] == fmountlens[i].lid ) {
-                // #1034
-                const std::string  undefined("undefined") ;
-                const std::string  section  ("nikon");
-                std::ostringstream lensIDStream;
-                lensIDStream << static_cast<int>(raw[7]);
-                if ( Internal::readExiv2Config(section,lensIDStream.str(),undefined) != undefined ) {
-                    return os << Internal::readExiv2Config(section,lensIDStream.str(),undefined);
-                }
+        const uint16_t first = index.first_[raw[0]];
+        const uint16_t last = index.first_[raw[0] + 1];
+        if (first != last) {
+            // #1034
+            const std::string  undefined("undefined") ;
+            const std::string  section  ("nikon");
+            std::ostringstream lensIDStream;
+            lensIDStream << static_cast<int>(raw[7]);
+            const std::string configured = Internal::readExiv2Config(section,lensIDStream.str(),undefined);
+            if ( configured != undefined ) {
+                return os << configured;
             }
-
-            if (   raw[0] == fmountlens[i].lid
-                // stps varies with focal length for some Sigma zoom lenses.
-                &&(raw[1] == fmountlens[i].stps || strcmp(fmountlens[i].manuf, "Sigma") == 0)
+        }
+        for (uint16_t e = first; e < last; ++e) {
+            const uint16_t i = index.entry_[e];
+            if (   // stps varies with focal length for some Sigma zoom lenses.
+                   (raw[1] == fmountlens[i].stps || index.sigma_[i])
                 && raw[2] == fmountlens[i].focs
                 && raw[3] == fmountlens[i].focl
                 && raw[4] == fmountlens[i].aps
@@ -2983,7 +3031,7 @@ fmountlens[] = {
         oss.copyfmt(os);
         double temp = value.toFloat()/double(-6.0);
 
-        auto pos = metadata->findKey(ExifKey("Exif.NikonFl7.FlashGroupAControlData"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.NikonFl7.FlashGroupAControlData");
         if (pos == metadata->end() || pos-> count() != 1 || pos->typeId() != unsignedByte) {
             os << "(" << value << ")";
         }
@@ -3024,7 +3072,7 @@ fmountlens[] = {
         oss.copyfmt(os);
         double temp = value.toFloat()/double(-6.0);
 
-        auto pos = metadata->findKey(ExifKey("Exif.NikonFl7.FlashGroupBCControlData"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.NikonFl7.FlashGroupBCControlData");
         if (pos == metadata->end() || pos-> count() != 1 || pos->typeId() != unsignedByte) {
             os << "(" << value << ")";
         }
@@ -3065,7 +3113,7 @@ fmountlens[] = {
         oss.copyfmt(os);
         double temp = value.toFloat()/double(-6.0);
 
-        auto pos = metadata->findKey(ExifKey("Exif.NikonFl7.FlashGroupBCControlData"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.NikonFl7.FlashGroupBCControlData");
         if (pos == metadata->end() || pos-> count() != 1 || pos->typeId() != unsignedByte) {
             os << "(" << value << ")";
         }
@@ -1650,7 +1650,7 @@ value, const ExifData* metadata)
         bool E3_E30model = false;
 
         if (metadata != nullptr) {
-            auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+            auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
             if (pos != metadata->end() && pos->count() != 0) {
                 std::string model = pos->toString();
                 if (model.find("E-3 ") != std::string::npos ||
@@ -108,8 +108,9 @@ namespace Exiv2 {
             throw Error(kerNotAnImage, "ORF");
         }
         clearMetadata();
-        ByteOrder bo =
-            OrfParser::decode(exifData_, iptcData_, xmpData_, io_->mmap(), static_cast<uint32_t>(io_->size()));
+        OrfHeader orfHeader;
+        ByteOrder bo = TiffParserWorker::decode(exifData_, iptcData_, xmpData_, *io_, Tag::root,
+                                                TiffMapping::findDecoder, &orfHeader);
         setByteOrder(bo);
     } // OrfImage::readMetadata
 
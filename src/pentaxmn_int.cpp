@@ -1158,14 +1158,14 @@ namespace Exiv2 {
     {
         if ( ! metadata ) return os << "undefined" ;
 
-        auto dateIt = metadata->findKey(ExifKey("Exif.PentaxDng.Date"));
+        auto dateIt = ExifPrintContext::findKey(*metadata, "Exif.PentaxDng.Date");
         if (dateIt == metadata->end()) {
-            dateIt = metadata->findKey(ExifKey("Exif.Pentax.Date"));
+            dateIt = ExifPrintContext::findKey(*metadata, "Exif.Pentax.Date");
         }
 
-        auto timeIt = metadata->findKey(ExifKey("Exif.PentaxDng.Time"));
+        auto timeIt = ExifPrintContext::findKey(*metadata, "Exif.PentaxDng.Time");
         if (timeIt == metadata->end()) {
-            timeIt = metadata->findKey(ExifKey("Exif.Pentax.Time"));
+            timeIt = ExifPrintContext::findKey(*metadata, "Exif.Pentax.Time");
         }
 
         if (    dateIt == metadata->end() || dateIt->size() != 4 ||
@@ -1196,8 +1196,9 @@ namespace Exiv2 {
     static std::string getKeyString(const std::string& key,const ExifData* metadata)
     {
         std::string result;
-        if ( metadata->findKey(ExifKey(key)) != metadata->end() ) {
-            result = metadata->findKey(ExifKey(key))->toString();
+        const auto pos = ExifPrintContext::findKey(*metadata, key);
+        if ( pos != metadata->end() ) {
+            result = pos->toString();
         }
         return result;
     }
@@ -1205,8 +1206,9 @@ namespace Exiv2 {
     static long getKeyLong(const std::string& key,const ExifData* metadata)
     {
         long result = -1;
-        if ( metadata->findKey(ExifKey(key)) != metadata->end() ) {
-            result = static_cast<long>(metadata->findKey(ExifKey(key))->toFloat(0));
+        const auto pos = ExifPrintContext::findKey(*metadata, key);
+        if ( pos != metadata->end() ) {
+            result = static_cast<long>(pos->toFloat(0));
         }
         return result;
     }
@@ -1219,11 +1221,11 @@ namespace Exiv2 {
 
     // Throws std::exception if the LensInfo can't be found.
     static ExifData::const_iterator findLensInfo(const ExifData* metadata) {
-      const auto dngLensInfo = metadata->findKey(ExifKey("Exif.PentaxDng.LensInfo"));
+      const auto dngLensInfo = ExifPrintContext::findKey(*metadata, "Exif.PentaxDng.LensInfo");
       if (dngLensInfo != metadata->end()) {
         return dngLensInfo;
       }
-      const auto lensInfo = metadata->findKey(ExifKey("Exif.Pentax.LensInfo"));
+      const auto lensInfo = ExifPrintContext::findKey(*metadata, "Exif.Pentax.LensInfo");
       if (lensInfo != metadata->end()) {
         return lensInfo;
       }
@@ -1247,7 +1249,7 @@ namespace Exiv2 {
 
             if ( index > 0 )  {
                 const unsigned long lensID    = 0x32c;
-                const TagDetails* td = find(pentaxLensType, lensID);
+                const TagDetails* td = EXV_TAG_DETAILS_INDEX(pentaxLensType)::find(lensID);
                 os << exvGettext(td[index].label_);
                 return os;
             }
@@ -1303,7 +1305,7 @@ namespace Exiv2 {
 
             if ( index > 0 )  {
                 const unsigned long lensID = 0x3ff;
-                const TagDetails* td = find(pentaxLensType, lensID);
+                const TagDetails* td = EXV_TAG_DETAILS_INDEX(pentaxLensType)::find(lensID);
                 os << exvGettext(td[index].label_);
                 return os;
             }
@@ -1328,7 +1330,7 @@ namespace Exiv2 {
 
             if ( index > 0 )  {
                 const unsigned long lensID = 0x8ff;
-                const TagDetails* td = find(pentaxLensType, lensID);
+                const TagDetails* td = EXV_TAG_DETAILS_INDEX(pentaxLensType)::find(lensID);
                 os << exvGettext(td[index].label_);
                 return os;
             }
@@ -1361,7 +1363,7 @@ namespace Exiv2 {
 
             if ( index > 0 )  {
                 const unsigned long lensID = 0x319;
-                const TagDetails* td = find(pentaxLensType, lensID);
+                const TagDetails* td = EXV_TAG_DETAILS_INDEX(pentaxLensType)::find(lensID);
                 os << exvGettext(td[index].label_);
                 return os;
             }
@@ -157,7 +157,7 @@ namespace Exiv2 {
             throw Error(kerDataSourceOpenFailed, io_->path(), strError());
         }
         IoCloser closer(*io_);
-        auto tempIo = std::make_unique<MemIo>();
+        auto tempIo = std::make_unique<TempIo>(*io_);
 
         doWriteMetadata(*tempIo); // may throw
         io_->close();
@@ -235,12 +235,8 @@ namespace Exiv2 {
 
         // Copy the rest of PGF image data.
 
-        DataBuf buf(4096);
-        long readSize = 0;
-        while ((readSize=io_->read(buf.data(), buf.size())))
-        {
-            if (outIo.write(buf.c_data(), readSize) != readSize) throw Error(kerImageWriteFailed);
-        }
+        const long rest = static_cast<long>(io_->size()) - io_->tell();
+        if (outIo.write(*io_) != rest) throw Error(kerImageWriteFailed);
         if (outIo.error()) throw Error(kerImageWriteFailed);
 
     } // PgfImage::doWriteMetadata
@@ -29,6 +29,7 @@
 #include "exif.hpp"
 #include "helper_functions.hpp"
 #include "image.hpp"
+#include "image_int.hpp"
 #include "iptc.hpp"
 #include "jpgimage.hpp"
 #include "pngchunk_int.hpp"
@@ -75,7 +76,7 @@ namespace Exiv2
             *outHeight = data.read_uint32(4, bigEndian);
         }
 
-        void PngChunk::decodeTXTChunk(Image* pImage, const DataBuf& data, TxtChunkType type)
+        void PngChunk::decodeTXTChunk(PngImage* pImage, const DataBuf& data, TxtChunkType type)
         {
             DataBuf key = keyTXTChunk(data);
             DataBuf arr = parseTXTChunk(data, key.size(), type);
@@ -224,13 +225,13 @@ namespace Exiv2
             return arr;
         }
 
-        void PngChunk::parseChunkContent(Image* pImage, const byte* key, long keySize, const DataBuf& arr)
+        void PngChunk::parseChunkContent(PngImage* pImage, const byte* key, long keySize, const DataBuf& arr)
         {
             // We look if an ImageMagick EXIF raw profile exist.
 
             if (keySize >= 21 &&
                 (memcmp("Raw profile type exif", key, 21) == 0 || memcmp("Raw profile type APP1", key, 21) == 0) &&
-                pImage->exifData().empty()) {
+                pImage->exifData_.empty()) {
                 DataBuf exifData = readRawProfile(arr, false);
                 long length = exifData.size();
 
@@ -255,21 +256,21 @@ namespace Exiv2
                                   << "\n";
 #endif
                         pos = pos + sizeof(exifHeader);
-                        ByteOrder bo = TiffParser::decode(pImage->exifData(), pImage->iptcData(), pImage->xmpData(),
+                        ByteOrder bo = TiffParser::decode(pImage->exifData_, pImage->iptcData_, pImage->xmpData_,
                                                           exifData.c_data(pos), length - pos);
                         pImage->setByteOrder(bo);
                     } else {
 #ifndef SUPPRESS_WARNINGS
                         EXV_WARNING << "Failed to decode Exif metadata.\n";
 #endif
-                        pImage->exifData().clear();
+                        pImage->exifData_.clear();
                     }
                 }
             }
 
             // We look if an ImageMagick IPTC raw profile exist.
 
-            if (keySize >= 21 && memcmp("Raw profile type iptc", key, 21) == 0 && pImage->iptcData().empty()) {
+            if (keySize >= 21 && memcmp("Raw profile type iptc", key, 21) == 0 && pImage->iptcData_.empty()) {
                 DataBuf psData = readRawProfile(arr, false);
                 if (psData.size() > 0) {
                     Blob iptcBlob;
@@ -291,14 +292,14 @@ namespace Exiv2
                         pCur += (sizeIptc & 1);
                     }
                     if (!iptcBlob.empty() &&
-                        IptcParser::decode(pImage->iptcData(), &iptcBlob[0], static_cast<uint32_t>(iptcBlob.size()))) {
+                        IptcParser::decode(pImage->iptcData_, &iptcBlob[0], static_cast<uint32_t>(iptcBlob.size()))) {
 #ifndef SUPPRESS_WARNINGS
                         EXV_WARNING << "Failed to decode IPTC metadata.\n";
 #endif
                         pImage->clearIptcData();
                     }
                     // If there is no IRB, try to decode the complete chunk data
-                    if (iptcBlob.empty() && IptcParser::decode(pImage->iptcData(), psData.c_data(), psData.size())) {
+                    if (iptcBlob.empty() && IptcParser::decode(pImage->iptcData_, psData.c_data(), psData.size())) {
 #ifndef SUPPRESS_WARNINGS
                         EXV_WARNING << "Failed to decode IPTC metadata.\n";
 #endif
@@ -309,12 +310,12 @@ namespace Exiv2
 
             // We look if an ImageMagick XMP raw profile exist.
 
-            if (keySize >= 20 && memcmp("Raw profile type xmp", key, 20) == 0 && pImage->xmpData().empty()) {
+            if (keySize >= 20 && memcmp("Raw profile type xmp", key, 20) == 0 && pImage->xmpData_.empty()) {
                 DataBuf xmpBuf = readRawProfile(arr, false);
                 long length = xmpBuf.size();
 
                 if (length > 0) {
-                    std::string& xmpPacket = pImage->xmpPacket();
+                    std::string& xmpPacket = pImage->xmpPacket_;
                     xmpPacket.assign(xmpBuf.c_str(), length);
                     std::string::size_type idx = xmpPacket.find_first_of('<');
                     if (idx != std::string::npos && idx > 0) {
@@ -323,7 +324,7 @@ namespace Exiv2
 #endif
                         xmpPacket = xmpPacket.substr(idx);
                     }
-                    if (XmpParser::decode(pImage->xmpData(), xmpPacket)) {
+                    if (XmpParser::decode(pImage->xmpData_, xmpPacket)) {
 #ifndef SUPPRESS_WARNINGS
                         EXV_WARNING << "Failed to decode XMP metadata.\n";
 #endif
@@ -333,9 +334,9 @@ namespace Exiv2
 
             // We look if an Adobe XMP string exist.
 
-            if (keySize >= 17 && memcmp("XML:com.adobe.xmp", key, 17) == 0 && pImage->xmpData().empty()) {
+            if (keySize >= 17 && memcmp("XML:com.adobe.xmp", key, 17) == 0 && pImage->xmpData_.empty()) {
                 if (arr.size() > 0) {
-                    std::string& xmpPacket = pImage->xmpPacket();
+                    std::string& xmpPacket = pImage->xmpPacket_;
                     xmpPacket.assign(arr.c_str(), arr.size());
                     std::string::size_type idx = xmpPacket.find_first_of('<');
                     if (idx != std::string::npos && idx > 0) {
@@ -345,7 +346,7 @@ namespace Exiv2
 #endif
                         xmpPacket = xmpPacket.substr(idx);
                     }
-                    if (XmpParser::decode(pImage->xmpData(), xmpPacket)) {
+                    if (XmpParser::decode(pImage->xmpData_, xmpPacket)) {
 #ifndef SUPPRESS_WARNINGS
                         EXV_WARNING << "Failed to decode XMP metadata.\n";
 #endif
@@ -394,71 +395,75 @@ namespace Exiv2
 
         void PngChunk::zlibUncompress(const byte* compressedText, unsigned int compressedTextSize, DataBuf& arr)
         {
-            uLongf uncompressedLen = compressedTextSize * 2;  // just a starting point
-            int zlibResult;
-            int dos = 0;
-
-            do {
-                arr.alloc(uncompressedLen);
-                zlibResult = uncompress(arr.data(), &uncompressedLen, compressedText, compressedTextSize);
-                if (zlibResult == Z_OK) {
-                    assert((uLongf)arr.size() >= uncompressedLen);
-                    arr.resize(uncompressedLen);
-                } else if (zlibResult == Z_BUF_ERROR) {
-                    // the uncompressedArray needs to be larger
-                    uncompressedLen *= 2;
-                    // DoS protection. can't be bigger than 64k
-                    if (uncompressedLen > 131072) {
-                        if (++dos > 1)
-                            break;
-                        uncompressedLen = 131072;
-                    }
-                } else {
-                    // something bad happened
-                    throw Error(kerFailedToReadImageData);
-                }
-            } while (zlibResult == Z_BUF_ERROR);
-
-            if (zlibResult != Z_OK) {
+            // DoS protection. can't be bigger than 128k, unless the compressed text is half of that already
+            const size_t maxSize = std::max<size_t>(2ul * compressedTextSize, 128 * 1024);
+            if (!zlibInflate(compressedText, compressedTextSize, arr, maxSize)) {
                 throw Error(kerFailedToReadImageData);
             }
         }  // PngChunk::zlibUncompress
 
         std::string PngChunk::zlibCompress(const std::string& text)
         {
-            auto compressedLen = static_cast<uLongf>(text.size() * 2);  // just a starting point
-            int zlibResult;
-
             DataBuf arr;
-            do {
-                arr.resize(compressedLen);
-                zlibResult = compress2(arr.data(), &compressedLen, reinterpret_cast<const Bytef*>(text.data()),
-                                       static_cast<uLong>(text.size()), Z_BEST_COMPRESSION);
-
-                switch (zlibResult) {
-                    case Z_OK:
-                        assert((uLongf)arr.size() >= compressedLen);
-                        arr.resize(compressedLen);
-                        break;
-                    case Z_BUF_ERROR:
-                        // The compressed array needs to be larger
-#ifdef EXIV2_DEBUG_MESSAGES
-                        std::cout << "Exiv2::PngChunk::parsePngChunk: doubling size for compression.\n";
-#endif
-                        compressedLen *= 2;
-                        // DoS protection. Cap max compressed size
-                        if (compressedLen > 131072)
-                            throw Error(kerFailedToReadImageData);
+            if (!zlibDeflate(reinterpret_cast<const byte*>(text.data()), text.size(), arr, Z_BEST_COMPRESSION)) {
+                throw Error(kerFailedToReadImageData);
+            }
+            return std::string(arr.c_str(), arr.size());
+
+        }  // PngChunk::zlibCompress
+
+        bool PngChunk::zlibInflate(const byte* data, size_t size, DataBuf& result, size_t maxSize)
+        {
+            z_stream stream{};
+            if (inflateInit(&stream) != Z_OK)
+                return false;
+            stream.next_in = const_cast<Bytef*>(data);
+            stream.avail_in = static_cast<uInt>(size);
+
+            // Start with twice the compressed size and grow the buffer as the data inflates
+            size_t capacity = std::min(std::max<size_t>(2 * size, 1024), maxSize);
+            result = DataBuf(static_cast<long>(capacity));
+            int zlibResult = Z_OK;
+            while (zlibResult == Z_OK) {
+                if (stream.total_out == capacity) {
+                    if (capacity == maxSize)
                         break;
-                    default:
-                        // Something bad happened
-                        throw Error(kerFailedToReadImageData);
+                    capacity = std::min(2 * capacity, maxSize);
+                    result.resize(static_cast<long>(capacity));
                 }
-            } while (zlibResult == Z_BUF_ERROR);
+                stream.next_out = result.data(stream.total_out);
+                stream.avail_out = static_cast<uInt>(capacity - stream.total_out);
+                zlibResult = inflate(&stream, Z_NO_FLUSH);
+            }
+            const auto total = static_cast<long>(stream.total_out);
+            inflateEnd(&stream);
+            if (zlibResult != Z_STREAM_END)
+                return false;
+            result.resize(total);
+            return true;
 
-            return std::string(arr.c_str(), arr.size());
+        }  // PngChunk::zlibInflate
 
-        }  // PngChunk::zlibCompress
+        bool PngChunk::zlibDeflate(const byte* data, size_t size, DataBuf& result, int level)
+        {
+            z_stream stream{};
+            if (deflateInit(&stream, level) != Z_OK)
+                return false;
+            // A buffer of deflateBound() bytes is large enough to compress the data in one go
+            result = DataBuf(static_cast<long>(deflateBound(&stream, static_cast<uLong>(size))));
+            stream.next_in = const_cast<Bytef*>(data);
+            stream.avail_in = static_cast<uInt>(size);
+            stream.next_out = result.data();
+            stream.avail_out = static_cast<uInt>(result.size());
+            const int zlibResult = deflate(&stream, Z_FINISH);
+            const auto total = static_cast<long>(stream.total_out);
+            deflateEnd(&stream);
+            if (zlibResult != Z_STREAM_END)
+                return false;
+            result.resize(total);
+            return true;
+
+        }  // PngChunk::zlibDeflate
 
         std::string PngChunk::makeAsciiTxtChunk(const std::string& keyword, const std::string& text, bool compress)
         {
@@ -660,6 +665,46 @@ namespace Exiv2
 
         }  // PngChunk::writeRawProfile
 
+        PngChunkIndex::PngChunkIndex(const BasicIo& io) : BlockIndex(io, static_cast<long>(io.size()))
+        {
+        }
+
+        const PngChunkIndex::Entry& PngChunkIndex::readHeader(BasicIo& io)
+        {
+            const long offset = io.tell();
+            byte header[8];  // Chunk header: 4 bytes (data size) + 4 bytes (chunk type).
+            const long bufRead = io.read(header, sizeof(header));
+            if (io.error()) {
+                throw Error(kerFailedToReadImageData);
+            }
+            if (bufRead != sizeof(header)) {
+                throw Error(kerInputDataReadFailed);
+            }
+
+            // Decode chunk data length.
+            const uint32_t length = getULong(header, bigEndian);
+            const long pos = io.tell();
+            if (offset == -1 || pos == -1 || length > uint32_t(0x7FFFFFFF) ||
+                static_cast<long>(length) > end() - pos) {
+                throw Error(kerFailedToReadImageData);
+            }
+            chunks_.push_back({std::string(reinterpret_cast<const char*>(header + 4), 4), offset, length});
+            return chunks_.back();
+        }
+
+        long PngChunkIndex::nextBlock(BasicIo& io)
+        {
+            const Entry& chunk = readHeader(io);
+            if (chunk.type_ == "IEND") {
+                return -1;  // Last chunk found: we stop parsing.
+            }
+            const long next = chunk.offset_ + chunk.size();
+            if (next >= end()) {
+                throw Error(kerFailedToReadImageData);
+            }
+            return next;
+        }
+
     }  // namespace Internal
 }  // namespace Exiv2
 #endif  // ifdef EXV_HAVE_LIBZ
@@ -23,10 +23,13 @@
 // *****************************************************************************
 // included header files
 #include "types.hpp"
+#include "image_int.hpp"
 #include "pngimage.hpp"
 
 // + standard includes
 #include <iosfwd>
+#include <string>
+#include <vector>
 #include <cassert>
 #include <cstdarg>
 
@@ -79,7 +82,7 @@ namespace Exiv2 {
           @param data      PNG Chunk data buffer.
           @param type      PNG Chunk TXT type.
         */
-        static void decodeTXTChunk(Image*         pImage,
+        static void decodeTXTChunk(PngImage*      pImage,
                                    const DataBuf& data,
                                    TxtChunkType   type);
 
@@ -131,7 +134,7 @@ namespace Exiv2 {
                     Xmp  packet generated by Adobe                 ==> Image Xmp metadata.
                     Description string                             ==> Image Comments.
          */
-        static void parseChunkContent(Image* pImage, const byte* key, long keySize, const DataBuf& arr);
+        static void parseChunkContent(PngImage* pImage, const byte* key, long keySize, const DataBuf& arr);
 
         /*!
           @brief Return a compressed (zTXt) or uncompressed (tEXt) PNG ASCII text chunk
@@ -171,6 +174,21 @@ namespace Exiv2 {
          */
         static std::string zlibCompress(const std::string& text);
 
+        /*!
+          @brief Inflate the zlib stream \em data of \em size bytes into \em result
+                 in a single pass, growing \em result as needed.
+          @return true if the whole stream was inflated, false if it is corrupted,
+                  incomplete or inflates to more than \em maxSize bytes.
+         */
+        static bool zlibInflate(const byte* data, size_t size, DataBuf& result, size_t maxSize);
+
+        /*!
+          @brief Deflate \em size bytes of \em data into the zlib stream \em result
+                 with compression \em level, in a single pass.
+          @return true if the data was compressed, else false.
+         */
+        static bool zlibDeflate(const byte* data, size_t size, DataBuf& result, int level);
+
         /*!
           @brief Decode from ImageMagick raw text profile which host encoded Exif/Iptc/Xmp metadata byte array.
          */
@@ -187,6 +205,57 @@ namespace Exiv2 {
 
     }; // class PngChunk
 
+    /*!
+      @brief Index of the chunks of a PNG image, up to and including IEND.
+             It is built in one pass over the chunk headers, either while the
+             chunks are read (readHeader()) or seeking over the chunk data
+             (readAll()).
+     */
+    class PngChunkIndex : public BlockIndex {
+    public:
+        //! Position of a chunk in the image
+        struct Entry {
+            std::string type_;  //!< Chunk type, 4 characters
+            long offset_;       //!< Offset of the chunk, i.e., of its length field
+            uint32_t length_;   //!< Length of the chunk data
+
+            //! Return the size of the whole chunk: length, type, data and CRC
+            long size() const { return 12 + static_cast<long>(length_); }
+        };
+
+        //! @name Creators
+        //@{
+        //! Constructor for an empty index of the chunks of \em io.
+        explicit PngChunkIndex(const BasicIo& io);
+        //@}
+
+        //! @name Manipulators
+        //@{
+        /*!
+          @brief Read the header of the chunk at the current position of \em io
+                 and add the chunk to the index. On return, \em io is positioned
+                 at the chunk data.
+          @return The new entry.
+          @throw Error if the header can't be read or the chunk exceeds the data.
+         */
+        const Entry& readHeader(BasicIo& io);
+        //@}
+
+        //! @name Accessors
+        //@{
+        //! Return the chunks, in the order of the image.
+        const std::vector<Entry>& chunks() const { return chunks_; }
+        //@}
+
+    protected:
+        //! Add the chunk at the current position of \em io, fail if the image ends before IEND.
+        long nextBlock(BasicIo& io) override;
+
+    private:
+        // DATA
+        std::vector<Entry> chunks_;  //!< The chunks
+    }; // class PngChunkIndex
+
 }}                                      // namespace Internal, Exiv2
 
 #endif                                  // #ifndef PNGCHUNK_INT_HPP_
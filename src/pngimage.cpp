@@ -58,6 +58,10 @@ namespace
 {
     const auto nullComp = (const Exiv2::byte*)"\0\0";
     const auto typeICCP = (const Exiv2::byte*)"iCCP";
+
+    //! Sanity limit for the size of inflated chunk data
+    const size_t maxInflatedSize = 32 * 1024 * 1024;
+
     inline bool compare(const char* str, const Exiv2::DataBuf& buf, size_t length)
     {
         assert(strlen(str) <= length);
@@ -93,61 +97,13 @@ namespace Exiv2 {
         }
     }
 
+    PngImage::~PngImage() = default;
+
     std::string PngImage::mimeType() const
     {
         return "image/png";
     }
 
-    static bool zlibToDataBuf(const byte* bytes,long length, DataBuf& result)
-    {
-        uLongf uncompressedLen = length * 2; // just a starting point
-        int    zlibResult = Z_BUF_ERROR;
-
-        do {
-            result.alloc(uncompressedLen);
-            zlibResult = uncompress(result.data(),&uncompressedLen,bytes,length);
-            // if result buffer is large than necessary, redo to fit perfectly.
-            if (zlibResult == Z_OK && static_cast<long>(uncompressedLen) < result.size()) {
-                result.reset();
-
-                result.alloc(uncompressedLen);
-                zlibResult = uncompress(result.data(),&uncompressedLen,bytes,length);
-            }
-            if (zlibResult == Z_BUF_ERROR) {
-                // the uncompressed buffer needs to be larger
-                result.reset();
-
-                // Sanity - never bigger than 16mb
-                if  (uncompressedLen > 16*1024*1024) zlibResult = Z_DATA_ERROR;
-                else uncompressedLen *= 2;
-            }
-        } while (zlibResult == Z_BUF_ERROR);
-
-        return zlibResult == Z_OK ;
-    }
-
-    static bool zlibToCompressed(const byte* bytes,long length, DataBuf& result)
-    {
-        uLongf compressedLen = length; // just a starting point
-        int    zlibResult = Z_BUF_ERROR;
-
-        do {
-            result.alloc(compressedLen);
-            zlibResult = compress(result.data(),&compressedLen,bytes,length);
-            if (zlibResult == Z_BUF_ERROR) {
-                // the compressedArray needs to be larger
-                result.reset();
-                compressedLen *= 2;
-            } else {
-                result.reset();
-                result.alloc(compressedLen);
-                zlibResult = compress(result.data(),&compressedLen,bytes,length);
-            }
-        } while (zlibResult == Z_BUF_ERROR);
-
-        return zlibResult == Z_OK ;
-    }
-
     static bool tEXtToDataBuf(const byte* bytes,long length,DataBuf& result)
     {
         static const char* hexdigits = "0123456789ABCDEF";
@@ -338,7 +294,7 @@ namespace Exiv2 {
                         bGood = tEXtToDataBuf(data.c_data(name_l), static_cast<unsigned long>(dataOffset - name_l), dataBuf);
                     }
                     if ( zTXt || iCCP ) {
-                        bGood = zlibToDataBuf(data.c_data(name_l + 1), static_cast<unsigned long>(dataOffset - name_l - 1), dataBuf); // +1 = 'compressed' flag
+                        bGood = PngChunk::zlibInflate(data.c_data(name_l + 1), dataOffset - name_l - 1, dataBuf, maxInflatedSize); // +1 = 'compressed' flag
                     }
                     if ( iTXt ) {
                         bGood = (3 <= dataOffset) && (start < dataOffset-3); // good if not a nul chunk
@@ -433,25 +389,16 @@ namespace Exiv2 {
             throw Error(kerNotAnImage, "PNG");
         }
         clearMetadata();
+        chunkIndex_.reset();
+        iccCompressed_.reset();
 
-        const long imgSize = static_cast<long>(io_->size());
-        DataBuf cheaderBuf(8);       // Chunk header: 4 bytes (data size) + 4 bytes (chunk type).
-
+        // Index the chunks as they are read, for writeMetadata()
+        auto index = std::make_unique<PngChunkIndex>(*io_);
         while(!io_->eof())
         {
-            cheaderBuf.clear();
-            readChunk(cheaderBuf, *io_); // Read chunk header.
-
-            // Decode chunk data length.
-            uint32_t chunkLength = cheaderBuf.read_uint32(0, Exiv2::bigEndian);
-            long pos = io_->tell();
-            if (pos == -1 ||
-                chunkLength > uint32_t(0x7FFFFFFF) ||
-                static_cast<long>(chunkLength) > imgSize - pos) {
-                throw Exiv2::Error(kerFailedToReadImageData);
-            }
-
-            std::string chunkType(cheaderBuf.c_str(4), 4);
+            const auto& chunk = index->readHeader(*io_);
+            const std::string chunkType = chunk.type_;
+            uint32_t chunkLength = chunk.length_;
 #ifdef EXIV2_DEBUG_MESSAGES
             std::cout << "Exiv2::PngImage::readMetadata: chunk type: " << chunkType
                       << " length: " << chunkLength << std::endl;
@@ -468,6 +415,9 @@ namespace Exiv2 {
                 readChunk(chunkData, *io_);  // Extract chunk data.
 
                 if (chunkType == "IEND") {
+                    // Keep the index, it spares writeMetadata() another pass over the chunks
+                    chunkIndex_ = std::move(index);
+                    setMetadataClean();
                     return;  // Last chunk found: we stop parsing.
                 }
                 if (chunkType == "IHDR" && chunkData.size() >= 8) {
@@ -479,9 +429,9 @@ namespace Exiv2 {
                 } else if (chunkType == "iTXt") {
                     PngChunk::decodeTXTChunk(this, chunkData, PngChunk::iTXt_Chunk);
                 } else if (chunkType == "eXIf") {
-                    ByteOrder bo = TiffParser::decode(exifData(),
-                                                      iptcData(),
-                                                      xmpData(),
+                    ByteOrder bo = TiffParser::decode(exifData_,
+                                                      iptcData_,
+                                                      xmpData_,
                                                       chunkData.c_data(),
                                                       chunkData.size());
                     setByteOrder(bo);
@@ -497,7 +447,12 @@ namespace Exiv2 {
                     ++iccOffset; // +1 = 'compressed' flag
                     enforce(iccOffset <= chunkLength, Exiv2::kerCorruptedMetadata);
 
-                    zlibToDataBuf(chunkData.c_data(iccOffset), chunkLength - iccOffset, iccProfile_);
+                    iccCompressed_.reset();
+                    if (PngChunk::zlibInflate(chunkData.c_data(iccOffset), chunkLength - iccOffset, iccProfile_,
+                                              maxInflatedSize)) {
+                        // Keep the compressed profile, to write it again as long as it doesn't change
+                        iccCompressed_ = DataBuf(chunkData.c_data(iccOffset), chunkLength - iccOffset);
+                    }
 #ifdef EXIV2_DEBUG_MESSAGES
                     std::cout << "Exiv2::PngImage::readMetadata: profile name: " << profileName_ << std::endl;
                     std::cout << "Exiv2::PngImage::readMetadata: iccProfile.size_ (uncompressed) : "
@@ -520,24 +475,31 @@ namespace Exiv2 {
                 throw Error(kerFailedToReadImageData);
             }
         }
+        setMetadataClean();
     } // PngImage::readMetadata
 
     void PngImage::writeMetadata()
     {
+        const int changed = changedMetadata();
+        if (changed == mdNone) {
+            setWrittenMetadata(mdNone);
+            return;
+        }
         if (io_->open() != 0)
         {
             throw Error(kerDataSourceOpenFailed, io_->path(), strError());
         }
         IoCloser closer(*io_);
-        auto tempIo = std::make_unique<MemIo>();
+        auto tempIo = std::make_unique<TempIo>(*io_);
 
-        doWriteMetadata(*tempIo); // may throw
+        doWriteMetadata(*tempIo, changed); // may throw
         io_->close();
         io_->transfer(*tempIo); // may throw
-
+        setWrittenMetadata(changed);
+        setMetadataClean();
     } // PngImage::writeMetadata
 
-    void PngImage::doWriteMetadata(BasicIo& outIo)
+    void PngImage::doWriteMetadata(BasicIo& outIo, int changed)
     {
         if (!io_->isopen()) throw Error(kerInputDataReadFailed);
         if (!outIo.isopen()) throw Error(kerImageWriteFailed);
@@ -554,43 +516,37 @@ namespace Exiv2 {
         // Write PNG Signature.
         if (outIo.write(pngSignature, 8) != 8) throw Error(kerImageWriteFailed);
 
-        DataBuf cheaderBuf(8);       // Chunk header : 4 bytes (data size) + 4 bytes (chunk type).
-
-        while(!io_->eof())
-        {
-            // Read chunk header.
-
-            cheaderBuf.clear();
-            long bufRead = io_->read(cheaderBuf.data(), 8);
-            if (io_->error()) throw Error(kerFailedToReadImageData);
-            if (bufRead != 8) throw Error(kerInputDataReadFailed);
-
-            // Decode chunk data length.
-
-            uint32_t dataOffset = cheaderBuf.read_uint32(0, Exiv2::bigEndian);
-            if (dataOffset > 0x7FFFFFFF) throw Exiv2::Error(kerFailedToReadImageData);
-
-            // Read whole chunk : Chunk header + Chunk data (not fixed size - can be null) + CRC (4 bytes).
-
-            DataBuf chunkBuf(8 + dataOffset + 4);  // Chunk header (8 bytes) + Chunk data + CRC (4 bytes).
-            chunkBuf.copyBytes(0, cheaderBuf.c_data(), 8);           // Copy header.
-            bufRead = io_->read(chunkBuf.data(8), dataOffset + 4); // Extract chunk data + CRC
-            if (io_->error()) throw Error(kerFailedToReadImageData);
-            if (bufRead != static_cast<long>(dataOffset) + 4L)
-                throw Error(kerInputDataReadFailed);
+        auto index = std::move(chunkIndex_);
+        if (!index || !index->isCurrent(*io_)) {
+            index = std::make_unique<PngChunkIndex>(*io_);
+            index->readAll(*io_);
+        }
 
-            char szChunk[5];
-            memcpy(szChunk,cheaderBuf.c_data(4),4);
-            szChunk[4]  = 0;
+        // Chunks which are written unchanged are collected into runs of adjacent
+        // chunks and each run is streamed to the output in one go
+        long runOffset = 0;
+        long runSize = 0;
+        auto copyRun = [&]() {
+            Internal::copyData(*io_, runOffset, runSize, outIo);
+            runSize = 0;
+        };
+        auto addToRun = [&](const PngChunkIndex::Entry& chunk) {
+            if (runSize > 0 && runOffset + runSize != chunk.offset_) copyRun();
+            if (runSize == 0) runOffset = chunk.offset_;
+            runSize += chunk.size();
+        };
+
+        for (auto&& chunk : index->chunks()) {
+            const char* szChunk = chunk.type_.c_str();
 
             if ( !strcmp(szChunk,"IEND") )
             {
                 // Last chunk found: we write it and done.
 #ifdef EXIV2_DEBUG_MESSAGES
-                std::cout << "Exiv2::PngImage::doWriteMetadata: Write IEND chunk (length: " << dataOffset << ")\n";
+                std::cout << "Exiv2::PngImage::doWriteMetadata: Write IEND chunk (length: " << chunk.length_ << ")\n";
 #endif
-                if (outIo.write(chunkBuf.data(), chunkBuf.size()) != chunkBuf.size())
-                    throw Error(kerImageWriteFailed);
+                addToRun(chunk);
+                copyRun();
                 return;
             }
             if (!strcmp(szChunk, "eXIf")) {
@@ -598,9 +554,10 @@ namespace Exiv2 {
                 ; // as zTXt chunk with signature Raw profile type exif__
             } else if (!strcmp(szChunk, "IHDR")) {
 #ifdef EXIV2_DEBUG_MESSAGES
-                std::cout << "Exiv2::PngImage::doWriteMetadata: Write IHDR chunk (length: " << dataOffset << ")\n";
+                std::cout << "Exiv2::PngImage::doWriteMetadata: Write IHDR chunk (length: " << chunk.length_ << ")\n";
 #endif
-                if (outIo.write(chunkBuf.data(), chunkBuf.size()) != chunkBuf.size()) throw Error(kerImageWriteFailed);
+                addToRun(chunk);
+                copyRun();
 
                 // Write all updated metadata here, just after IHDR.
                 if (!comment_.empty())
@@ -646,8 +603,15 @@ namespace Exiv2 {
                 }
 
                 if ( iccProfileDefined() ) {
-                    DataBuf compressed;
-                    if ( zlibToCompressed(iccProfile_.c_data(),iccProfile_.size(),compressed) ) {
+                    // Compress the profile only if it changed since it was read or written
+                    if (iccCompressed_.size() == 0 || (changed & mdIccProfile) != 0) {
+                        if (!PngChunk::zlibDeflate(iccProfile_.c_data(), iccProfile_.size(), iccCompressed_,
+                                                   Z_DEFAULT_COMPRESSION)) {
+                            iccCompressed_.reset();
+                        }
+                    }
+                    const DataBuf& compressed = iccCompressed_;
+                    if ( compressed.size() > 0 ) {
                         const auto nameLength = static_cast<uint32_t>(profileName_.size());
                         const uint32_t chunkLength = nameLength + 2 + compressed.size() ;
                         byte     length[4];
@@ -695,6 +659,13 @@ namespace Exiv2 {
                 }
             } else if (!strcmp(szChunk, "tEXt") || !strcmp(szChunk, "zTXt") || !strcmp(szChunk, "iTXt") ||
                        !strcmp(szChunk, "iCCP")) {
+                // Read whole chunk : Chunk header + Chunk data (not fixed size - can be null) + CRC (4 bytes).
+                DataBuf chunkBuf(chunk.size());
+                io_->seek(chunk.offset_, BasicIo::beg);
+                const long bufRead = io_->read(chunkBuf.data(), chunkBuf.size());
+                if (io_->error()) throw Error(kerFailedToReadImageData);
+                if (bufRead != chunkBuf.size()) throw Error(kerInputDataReadFailed);
+
                 DataBuf key = PngChunk::keyTXTChunk(chunkBuf, true);
                 if (compare("Raw profile type exif", key, 21) ||
                     compare("Raw profile type APP1", key, 21) ||
@@ -707,26 +678,26 @@ namespace Exiv2 {
                 {
 #ifdef EXIV2_DEBUG_MESSAGES
                     std::cout << "Exiv2::PngImage::doWriteMetadata: strip " << szChunk
-                              << " chunk (length: " << dataOffset << ")" << std::endl;
+                              << " chunk (length: " << chunk.length_ << ")" << std::endl;
 #endif
                 } else
                 {
 #ifdef EXIV2_DEBUG_MESSAGES
                     std::cout << "Exiv2::PngImage::doWriteMetadata: write " << szChunk
-                              << " chunk (length: " << dataOffset << ")" << std::endl;
+                              << " chunk (length: " << chunk.length_ << ")" << std::endl;
 #endif
-                    if (outIo.write(chunkBuf.c_data(), chunkBuf.size()) != chunkBuf.size())
-                        throw Error(kerImageWriteFailed);
+                    addToRun(chunk);
                 }
             } else {
                 // Write all others chunk as well.
 #ifdef EXIV2_DEBUG_MESSAGES
                 std::cout << "Exiv2::PngImage::doWriteMetadata:  copy " << szChunk
-                          << " chunk (length: " << dataOffset << ")" << std::endl;
+                          << " chunk (length: " << chunk.length_ << ")" << std::endl;
 #endif
-                if (outIo.write(chunkBuf.c_data(), chunkBuf.size()) != chunkBuf.size()) throw Error(kerImageWriteFailed);
+                addToRun(chunk);
             }
         }
+        copyRun();
 
     } // PngImage::doWriteMetadata
 
@@ -0,0 +1,687 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2021 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+// *****************************************************************************
+// included header files
+#include "config.h"
+
+#include "probe_int.hpp"
+#include "bmffimage.hpp"
+#include "bmpimage.hpp"
+#include "cr2image.hpp"
+#include "crwimage.hpp"
+#include "epsimage.hpp"
+#include "gifimage.hpp"
+#include "jp2image.hpp"
+#include "jpgimage.hpp"
+#include "mrwimage.hpp"
+#include "orfimage.hpp"
+#include "pgfimage.hpp"
+#ifdef EXV_HAVE_LIBZ
+# include "pngimage.hpp"
+#endif // EXV_HAVE_LIBZ
+#include "psdimage.hpp"
+#include "rafimage.hpp"
+#include "rw2image.hpp"
+#include "tgaimage.hpp"
+#include "tiffimage.hpp"
+#include "webpimage.hpp"
+#include "xmpsidecar.hpp"
+
+// + standard includes
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// *****************************************************************************
+namespace {
+
+    using namespace Exiv2;
+
+    //! Largest box read into memory to look at its children (BMFF meta, JP2 header)
+    constexpr uint64_t maxHeaderBox = 16 * 1024 * 1024;
+    //! Largest number of entries of a TIFF IFD which is looked at
+    constexpr uint16_t maxIfdEntries = 1024;
+
+    //! UUIDs of the boxes with metadata in BMFF and JP2 files
+    const byte uuidXmp[] = {0xbe, 0x7a, 0xcf, 0xcb, 0x97, 0xa9, 0x42, 0xe8,
+                            0x9c, 0x71, 0x99, 0x94, 0x91, 0xe3, 0xaf, 0xac};
+    const byte uuidCanon[] = {0x85, 0xc0, 0xb6, 0x87, 0x82, 0x0f, 0x11, 0xe0,
+                              0x81, 0x11, 0xf4, 0xce, 0x46, 0x2b, 0x6a, 0x48};
+    const byte uuidJp2Exif[] = {'J', 'p', 'g', 'T', 'i', 'f', 'f', 'E', 'x', 'i', 'f', '-', '>', 'J', 'P', '2'};
+    const byte uuidJp2Iptc[] = {0x33, 0xc7, 0xa4, 0xd2, 0xb8, 0x1d, 0x47, 0x23,
+                                0xa0, 0xba, 0xf1, 0xa3, 0xe0, 0x97, 0xad, 0x38};
+
+    //! %Photoshop resource ids of the metadata blocks
+    constexpr uint16_t irbIccProfile = 0x040f;
+    constexpr uint16_t irbExif = 0x0422;
+    constexpr uint16_t irbXmp = 0x0424;
+
+    //! MIME types of the image types with a fixed MIME type
+    struct MimeType {
+        int imageType_;
+        const char* mimeType_;
+    };
+
+    const MimeType mimeTypes[] = {
+        { ImageType::jpeg, "image/jpeg"             },
+        { ImageType::exv,  "image/x-exv"            },
+        { ImageType::cr2,  "image/x-canon-cr2"      },
+        { ImageType::crw,  "image/x-canon-crw"      },
+        { ImageType::mrw,  "image/x-minolta-mrw"    },
+        { ImageType::tiff, "image/tiff"             },
+        { ImageType::webp, "image/webp"             },
+        { ImageType::rw2,  "image/x-panasonic-rw2"  },
+        { ImageType::orf,  "image/x-olympus-orf"    },
+#ifdef EXV_HAVE_LIBZ
+        { ImageType::png,  "image/png"              },
+#endif // EXV_HAVE_LIBZ
+        { ImageType::pgf,  "image/pgf"              },
+        { ImageType::raf,  "image/x-fuji-raf"       },
+        { ImageType::eps,  "application/postscript" },
+        { ImageType::xmp,  "application/rdf+xml"    },
+        { ImageType::gif,  "image/gif"              },
+        { ImageType::psd,  "image/x-photoshop"      },
+        { ImageType::tga,  "image/targa"            },
+        { ImageType::bmp,  "image/x-ms-bmp"         },
+        { ImageType::jp2,  "image/jp2"              },
+    };
+
+    //! MIME type of a BMFF file, from the major brand of its ftyp box (see BmffImage::mimeType())
+    const char* bmffMimeType(const byte* brand)
+    {
+        const std::string b(reinterpret_cast<const char*>(brand), 4);
+        if (b == "avif" || b == "avio" || b == "avis")
+            return "image/avif";
+        if (b == "heic" || b == "heim" || b == "heis" || b == "heix")
+            return "image/heic";
+        if (b == "heif" || b == "mif1")
+            return "image/heif";
+        if (b == "crx ")
+            return "image/x-canon-cr3";
+        if (b == "jxl ")
+            return "image/jxl";
+        return "image/generic";
+    }
+
+    /*!
+      @brief Bounds checked, counted random access to an image. Reads which
+             fall into the already known start of the image are served from
+             memory.
+     */
+    class ProbeReader {
+    public:
+        ProbeReader(BasicIo& io, const byte* prefix, long prefixSize)
+            : io_(io), prefix_(prefix), prefixSize_(static_cast<uint64_t>(prefixSize)),
+              size_(std::max(static_cast<uint64_t>(io.size()), prefixSize_)), bytesRead_(prefixSize_)
+        {
+        }
+
+        //! Read \em n bytes at \em offset into \em buf. Return false if they are not available.
+        bool read(uint64_t offset, byte* buf, size_t n)
+        {
+            if (offset > size_ || n > size_ - offset)
+                return false;
+            if (offset + n <= prefixSize_) {
+                std::memcpy(buf, prefix_ + offset, n);
+                return true;
+            }
+            if (offset > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+                return false;
+            const long got = io_.readAt(static_cast<int64_t>(offset), buf, static_cast<long>(n));
+            if (got > 0)
+                bytesRead_ += got;
+            return got == static_cast<long>(n) && !io_.error();
+        }
+
+        uint64_t size() const { return size_; }
+        uint64_t bytesRead() const { return bytesRead_; }
+
+    private:
+        BasicIo& io_;
+        const byte* prefix_;
+        const uint64_t prefixSize_;
+        const uint64_t size_;
+        uint64_t bytesRead_;
+    };
+
+    //! True if \em result holds all the information a probe can deliver
+    bool complete(const ImageProbe& result)
+    {
+        return result.pixelWidth_ != 0 && result.pixelHeight_ != 0 && result.hasExif_ && result.hasIptc_ &&
+               result.hasXmp_ && result.hasIccProfile_;
+    }
+
+    //! Look for metadata in the %Photoshop image resource blocks between \em pos and \em end.
+    void probeIrbs(ProbeReader& r, uint64_t pos, uint64_t end, ImageProbe& result)
+    {
+        byte buf[7];
+        while (pos + 12 <= end && r.read(pos, buf, sizeof(buf)) && Photoshop::isIrb(buf, 4)) {
+            const uint16_t id = getUShort(buf + 4, bigEndian);
+            // Pascal string, padded to an even size
+            const uint64_t sizePos = pos + 6 + ((buf[6] + 2) & ~1);
+            if (sizePos + 4 > end || !r.read(sizePos, buf, 4))
+                return;
+            const uint32_t size = getULong(buf, bigEndian);
+            if (size > 0) {
+                switch (id) {
+                    case Photoshop::iptc_: result.hasIptc_ = true; break;
+                    case irbIccProfile:    result.hasIccProfile_ = true; break;
+                    case irbExif:          result.hasExif_ = true; break;
+                    case irbXmp:           result.hasXmp_ = true; break;
+                    default: break;
+                }
+            }
+            pos = sizePos + 4 + size + (size & 1);
+        }
+    }
+
+    //! Advance \em pos to the next 0xff byte, skipping padding between JPEG segments.
+    bool skipPadding(ProbeReader& r, uint64_t& pos)
+    {
+        byte buf[64];
+        while (pos < r.size()) {
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(sizeof(buf), r.size() - pos));
+            if (!r.read(pos, buf, n))
+                return false;
+            const auto ff = std::find(buf, buf + n, 0xff);
+            pos += ff - buf;
+            if (ff != buf + n)
+                return true;
+        }
+        return false;
+    }
+
+    //! Walk the JPEG segments starting at \em pos up to the start of the scan.
+    void probeJpeg(ProbeReader& r, uint64_t pos, ImageProbe& result)
+    {
+        byte buf[29];
+        while (!complete(result) && r.read(pos, buf, 2)) {
+            if (buf[0] != 0xff) {
+                if (!skipPadding(r, pos))
+                    return;
+                continue;
+            }
+            const byte marker = buf[1];
+            if (marker == 0xff) {  // fill byte
+                pos++;
+                continue;
+            }
+            if (marker == 0xd9 || marker == 0xda)  // EOI, SOS
+                return;
+            if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd8)) {  // TEM, RSTn, SOI
+                pos += 2;
+                continue;
+            }
+            if (!r.read(pos + 2, buf, 2))
+                return;
+            const uint16_t length = getUShort(buf, bigEndian);
+            if (length < 2)
+                return;
+            const uint64_t data = pos + 4;
+            const size_t dataSize = length - 2;
+            if (marker == 0xe1) {  // APP1
+                const size_t n = std::min(dataSize, sizeof(buf));
+                if (r.read(data, buf, n)) {
+                    if (n >= 6 && std::memcmp(buf, "Exif\0\0", 6) == 0)
+                        result.hasExif_ = true;
+                    else if (n == 29 && std::memcmp(buf, "http://ns.adobe.com/xap/1.0/\0", 29) == 0)
+                        result.hasXmp_ = true;
+                }
+            } else if (marker == 0xe2) {  // APP2
+                if (dataSize >= 12 && r.read(data, buf, 12) && std::memcmp(buf, "ICC_PROFILE\0", 12) == 0)
+                    result.hasIccProfile_ = true;
+            } else if (marker == 0xed) {  // APP13
+                if (dataSize >= 14 && r.read(data, buf, 14) && std::memcmp(buf, Photoshop::ps3Id_, 14) == 0)
+                    probeIrbs(r, data + 14, data + dataSize, result);
+            } else if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+                // SOFn
+                if (dataSize >= 5 && r.read(data, buf, 5)) {
+                    result.pixelHeight_ = getUShort(buf + 1, bigEndian);
+                    result.pixelWidth_ = getUShort(buf + 3, bigEndian);
+                }
+            }
+            pos = data + dataSize;
+        }
+    }
+
+    //! Walk the PNG chunks, reading only chunk headers and text keywords.
+    void probePng(ProbeReader& r, ImageProbe& result)
+    {
+        byte buf[80];
+        uint64_t pos = 8;
+        while (!complete(result) && r.read(pos, buf, 8)) {
+            const uint32_t length = getULong(buf, bigEndian);
+            const std::string type(reinterpret_cast<const char*>(buf + 4), 4);
+            if (type == "IEND")
+                return;
+            if (type == "IHDR") {
+                if (length >= 8 && r.read(pos + 8, buf, 8)) {
+                    result.pixelWidth_ = getULong(buf, bigEndian);
+                    result.pixelHeight_ = getULong(buf + 4, bigEndian);
+                }
+            } else if (type == "eXIf") {
+                result.hasExif_ = true;
+            } else if (type == "iCCP") {
+                result.hasIccProfile_ = true;
+            } else if (type == "tEXt" || type == "zTXt" || type == "iTXt") {
+                const size_t n = std::min<size_t>(length, sizeof(buf));
+                if (r.read(pos + 8, buf, n)) {
+                    const auto end = std::find(buf, buf + n, 0);
+                    const std::string key(reinterpret_cast<const char*>(buf), end - buf);
+                    if (key == "Raw profile type exif" || key == "Raw profile type APP1")
+                        result.hasExif_ = true;
+                    else if (key == "Raw profile type iptc")
+                        result.hasIptc_ = true;
+                    else if (key == "XML:com.adobe.xmp" || key == "Raw profile type xmp")
+                        result.hasXmp_ = true;
+                }
+            }
+            pos += 12 + static_cast<uint64_t>(length);
+        }
+    }
+
+    //! The interesting tags of a TIFF IFD
+    struct IfdInfo {
+        uint32_t subfileType_{0};
+        uint32_t width_{0};
+        uint32_t height_{0};
+        std::vector<uint32_t> subIfds_;
+    };
+
+    //! Read the IFD at \em offset. Metadata found is recorded in \em result if it is not null.
+    bool probeIfd(ProbeReader& r, uint64_t offset, ByteOrder byteOrder, IfdInfo& info, ImageProbe* result)
+    {
+        byte buf[12];
+        if (!r.read(offset, buf, 2))
+            return false;
+        const uint16_t count = std::min(getUShort(buf, byteOrder), maxIfdEntries);
+        std::vector<byte> entries(count * 12);
+        if (!r.read(offset + 2, entries.data(), entries.size()))
+            return false;
+        for (uint16_t i = 0; i < count; ++i) {
+            const byte* e = entries.data() + i * 12;
+            const uint16_t tag = getUShort(e, byteOrder);
+            const uint16_t type = getUShort(e + 2, byteOrder);
+            const uint32_t n = getULong(e + 4, byteOrder);
+            const uint32_t value = type == 3 ? getUShort(e + 8, byteOrder) : getULong(e + 8, byteOrder);
+            switch (tag) {
+                case 0x00fe: info.subfileType_ = value; break;
+                case 0x0100: info.width_ = value; break;
+                case 0x0101: info.height_ = value; break;
+                case 0x014a:  // SubIFDs
+                    if (n == 1) {
+                        info.subIfds_.push_back(value);
+                    } else {
+                        for (uint32_t k = 0; k < std::min(n, 8u) && r.read(value + k * 4, buf, 4); ++k) {
+                            info.subIfds_.push_back(getULong(buf, byteOrder));
+                        }
+                    }
+                    break;
+                case 0x010e:  // ImageDescription
+                case 0x010f:  // Make
+                case 0x0110:  // Model
+                case 0x0131:  // Software
+                case 0x0132:  // DateTime
+                case 0x013b:  // Artist
+                case 0x8298:  // Copyright
+                case 0x8769:  // ExifTag
+                case 0x8825:  // GPSTag
+                    if (result) result->hasExif_ = true;
+                    break;
+                case 0x02bc: if (result) result->hasXmp_ = true; break;
+                case 0x83bb: if (result) result->hasIptc_ = true; break;
+                case 0x8773: if (result) result->hasIccProfile_ = true; break;
+                default: break;
+            }
+        }
+        return true;
+    }
+
+    //! Read IFD0 of a TIFF structure and, if IFD0 holds a reduced image, its sub-IFDs.
+    void probeTiff(ProbeReader& r, ImageProbe& result)
+    {
+        byte buf[8];
+        if (!r.read(0, buf, 8))
+            return;
+        const ByteOrder byteOrder = buf[0] == 'I' ? littleEndian : bigEndian;
+        IfdInfo ifd0;
+        if (!probeIfd(r, getULong(buf + 4, byteOrder), byteOrder, ifd0, &result))
+            return;
+        result.pixelWidth_ = ifd0.width_;
+        result.pixelHeight_ = ifd0.height_;
+        if ((ifd0.subfileType_ & 1) == 0 && ifd0.width_ != 0)
+            return;
+        for (auto&& offset : ifd0.subIfds_) {
+            IfdInfo sub;
+            if (probeIfd(r, offset, byteOrder, sub, nullptr) && (sub.subfileType_ & 1) == 0 && sub.width_ != 0) {
+                result.pixelWidth_ = sub.width_;
+                result.pixelHeight_ = sub.height_;
+                return;
+            }
+        }
+    }
+
+    //! Header of an ISO BMFF or JP2 box
+    struct Box {
+        uint32_t type_{0};
+        uint64_t data_{0};   //!< Offset of the box content
+        uint64_t end_{0};    //!< Offset after the box
+    };
+
+    //! Read the header of the box at \em pos, which must end before \em end.
+    bool readBox(ProbeReader& r, uint64_t pos, uint64_t end, Box& box)
+    {
+        byte buf[16];
+        if (pos + 8 > end || !r.read(pos, buf, 8))
+            return false;
+        uint64_t size = getULong(buf, bigEndian);
+        box.type_ = getULong(buf + 4, bigEndian);
+        box.data_ = pos + 8;
+        if (size == 1) {
+            if (pos + 16 > end || !r.read(pos + 8, buf + 8, 8))
+                return false;
+            size = (static_cast<uint64_t>(getULong(buf + 8, bigEndian)) << 32) | getULong(buf + 12, bigEndian);
+            box.data_ = pos + 16;
+        } else if (size == 0) {
+            size = end - pos;
+        }
+        if (size < box.data_ - pos || size > end - pos)
+            return false;
+        box.end_ = pos + size;
+        return true;
+    }
+
+    //! Same as readBox(), for boxes in memory. \em pos is advanced to the next box.
+    bool nextBox(const std::vector<byte>& data, size_t& pos, size_t end, uint32_t& type, size_t& boxData, size_t& boxEnd)
+    {
+        if (pos + 8 > end)
+            return false;
+        const uint32_t size = getULong(data.data() + pos, bigEndian);
+        type = getULong(data.data() + pos + 4, bigEndian);
+        if (size < 8 || size > end - pos)
+            return false;
+        boxData = pos + 8;
+        boxEnd = pos + size;
+        pos = boxEnd;
+        return true;
+    }
+
+    //! Read the content of \em box into memory.
+    bool readContent(ProbeReader& r, const Box& box, std::vector<byte>& data)
+    {
+        if (box.end_ - box.data_ > maxHeaderBox)
+            return false;
+        data.resize(static_cast<size_t>(box.end_ - box.data_));
+        return r.read(box.data_, data.data(), data.size());
+    }
+
+    constexpr uint32_t fourcc(const char (&s)[5])
+    {
+        return static_cast<uint32_t>(static_cast<byte>(s[0])) << 24 | static_cast<uint32_t>(static_cast<byte>(s[1])) << 16 |
+               static_cast<uint32_t>(static_cast<byte>(s[2])) << 8 | static_cast<uint32_t>(static_cast<byte>(s[3]));
+    }
+
+    //! Look at the item types and properties in the content of a BMFF meta box.
+    void probeBmffMeta(const std::vector<byte>& data, ImageProbe& result)
+    {
+        uint32_t type = 0;
+        size_t boxData = 0;
+        size_t boxEnd = 0;
+        size_t pos = 4;  // version and flags
+        while (nextBox(data, pos, data.size(), type, boxData, boxEnd)) {
+            if (type == fourcc("iinf") && boxData + 4 < boxEnd) {
+                size_t p = boxData + 4 + (data[boxData] == 0 ? 2 : 4);
+                uint32_t infe = 0;
+                size_t infeData = 0;
+                size_t infeEnd = 0;
+                while (nextBox(data, p, boxEnd, infe, infeData, infeEnd)) {
+                    if (infe != fourcc("infe") || infeData >= infeEnd)
+                        continue;
+                    const byte version = data[infeData];
+                    if (version < 2)
+                        continue;
+                    const size_t typePos = infeData + 4 + (version == 2 ? 2 : 4) + 2;
+                    if (typePos + 4 > infeEnd)
+                        continue;
+                    const uint32_t itemType = getULong(data.data() + typePos, bigEndian);
+                    if (itemType == fourcc("Exif")) {
+                        result.hasExif_ = true;
+                    } else if (itemType == fourcc("mime")) {
+                        // item_name, then content_type
+                        auto name = data.begin() + typePos + 4;
+                        auto nameEnd = std::find(name, data.begin() + infeEnd, 0);
+                        if (nameEnd == data.begin() + infeEnd)
+                            continue;
+                        auto contentEnd = std::find(nameEnd + 1, data.begin() + infeEnd, 0);
+                        if (std::string(nameEnd + 1, contentEnd) == "application/rdf+xml")
+                            result.hasXmp_ = true;
+                    }
+                }
+            } else if (type == fourcc("iprp")) {
+                size_t p = boxData;
+                uint32_t ipco = 0;
+                size_t ipcoData = 0;
+                size_t ipcoEnd = 0;
+                while (nextBox(data, p, boxEnd, ipco, ipcoData, ipcoEnd)) {
+                    if (ipco != fourcc("ipco"))
+                        continue;
+                    size_t q = ipcoData;
+                    uint32_t prop = 0;
+                    size_t propData = 0;
+                    size_t propEnd = 0;
+                    while (nextBox(data, q, ipcoEnd, prop, propData, propEnd)) {
+                        if (prop == fourcc("ispe") && propData + 12 <= propEnd) {
+                            // HEIF files can have several ispe properties, use the largest
+                            const uint32_t width = getULong(data.data() + propData + 4, bigEndian);
+                            const uint32_t height = getULong(data.data() + propData + 8, bigEndian);
+                            if (width > result.pixelWidth_ && height > result.pixelHeight_) {
+                                result.pixelWidth_ = width;
+                                result.pixelHeight_ = height;
+                            }
+                        } else if (prop == fourcc("colr") && propData + 4 <= propEnd) {
+                            const uint32_t colourType = getULong(data.data() + propData, bigEndian);
+                            if (colourType == fourcc("prof") || colourType == fourcc("rICC"))
+                                result.hasIccProfile_ = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //! Walk the top level boxes of a BMFF file, skipping the media data.
+    void probeBmff(ProbeReader& r, ImageProbe& result)
+    {
+        result.mimeType_ = "image/generic";
+        byte buf[16];
+        Box box;
+        uint64_t pos = 0;
+        while (!complete(result) && readBox(r, pos, r.size(), box)) {
+            if (box.type_ == fourcc("ftyp")) {
+                if (box.data_ + 4 <= box.end_ && r.read(box.data_, buf, 4))
+                    result.mimeType_ = bmffMimeType(buf);
+            } else if (box.type_ == fourcc("meta")) {
+                std::vector<byte> data;
+                if (box.end_ - box.data_ >= 4 && readContent(r, box, data))
+                    probeBmffMeta(data, result);
+            } else if (box.type_ == fourcc("uuid") || box.type_ == fourcc("moov")) {
+                // Canon CR3 keeps its metadata in a uuid box inside moov
+                Box uuid = box;
+                uint64_t p = box.data_;
+                if (box.type_ == fourcc("moov")) {
+                    while (readBox(r, p, box.end_, uuid) && uuid.type_ != fourcc("uuid"))
+                        p = uuid.end_;
+                }
+                if (uuid.type_ == fourcc("uuid") && uuid.data_ + 16 <= uuid.end_ && r.read(uuid.data_, buf, 16)) {
+                    if (std::memcmp(buf, uuidXmp, 16) == 0)
+                        result.hasXmp_ = true;
+                    else if (std::memcmp(buf, uuidCanon, 16) == 0)
+                        result.hasExif_ = true;
+                }
+            } else if (box.type_ == fourcc("Exif")) {
+                result.hasExif_ = true;
+            } else if (box.type_ == fourcc("xml ")) {
+                result.hasXmp_ = true;
+            }
+            pos = box.end_;
+        }
+    }
+
+    //! Walk the top level boxes of a JP2 file, skipping the codestream.
+    void probeJp2(ProbeReader& r, ImageProbe& result)
+    {
+        byte buf[16];
+        Box box;
+        uint64_t pos = 0;
+        while (!complete(result) && readBox(r, pos, r.size(), box)) {
+            if (box.type_ == fourcc("jp2h")) {
+                Box sub;
+                uint64_t p = box.data_;
+                while (readBox(r, p, box.end_, sub)) {
+                    if (sub.type_ == fourcc("ihdr") && sub.data_ + 8 <= sub.end_ && r.read(sub.data_, buf, 8)) {
+                        result.pixelHeight_ = getULong(buf, bigEndian);
+                        result.pixelWidth_ = getULong(buf + 4, bigEndian);
+                    } else if (sub.type_ == fourcc("colr") && sub.data_ < sub.end_ && r.read(sub.data_, buf, 1)) {
+                        // Method 2 and 3 carry an ICC profile
+                        if (buf[0] == 2 || buf[0] == 3)
+                            result.hasIccProfile_ = true;
+                    }
+                    p = sub.end_;
+                }
+            } else if (box.type_ == fourcc("uuid")) {
+                if (box.data_ + 16 <= box.end_ && r.read(box.data_, buf, 16)) {
+                    if (std::memcmp(buf, uuidJp2Exif, 16) == 0)
+                        result.hasExif_ = true;
+                    else if (std::memcmp(buf, uuidJp2Iptc, 16) == 0)
+                        result.hasIptc_ = true;
+                    else if (std::memcmp(buf, uuidXmp, 16) == 0)
+                        result.hasXmp_ = true;
+                }
+            }
+            pos = box.end_;
+        }
+    }
+
+    //! Read the first chunk of a WebP file, which describes the whole image.
+    void probeWebp(ProbeReader& r, ImageProbe& result)
+    {
+        byte buf[18];
+        if (!r.read(12, buf, 18))
+            return;
+        const std::string type(reinterpret_cast<const char*>(buf), 4);
+        const byte* data = buf + 8;
+        if (type == "VP8X") {
+            result.hasIccProfile_ = (data[0] & 0x20) != 0;
+            result.hasExif_ = (data[0] & 0x08) != 0;
+            result.hasXmp_ = (data[0] & 0x04) != 0;
+            result.pixelWidth_ = 1 + (data[4] | data[5] << 8 | data[6] << 16);
+            result.pixelHeight_ = 1 + (data[7] | data[8] << 8 | data[9] << 16);
+        } else if (type == "VP8 ") {
+            if (data[3] == 0x9d && data[4] == 0x01 && data[5] == 0x2a) {
+                result.pixelWidth_ = getUShort(data + 6, littleEndian) & 0x3fff;
+                result.pixelHeight_ = getUShort(data + 8, littleEndian) & 0x3fff;
+            }
+        } else if (type == "VP8L") {
+            if (data[0] == 0x2f) {
+                const uint32_t bits = getULong(data + 1, littleEndian);
+                result.pixelWidth_ = 1 + (bits & 0x3fff);
+                result.pixelHeight_ = 1 + ((bits >> 14) & 0x3fff);
+            }
+        }
+    }
+
+    //! Read the header and the image resources of a PSD file.
+    void probePsd(ProbeReader& r, ImageProbe& result)
+    {
+        byte buf[30];
+        if (!r.read(0, buf, 30))
+            return;
+        result.pixelHeight_ = getULong(buf + 14, bigEndian);
+        result.pixelWidth_ = getULong(buf + 18, bigEndian);
+        const uint64_t resources = 30 + static_cast<uint64_t>(getULong(buf + 26, bigEndian));
+        if (!r.read(resources, buf, 4))
+            return;
+        const uint64_t start = resources + 4;
+        probeIrbs(r, start, start + getULong(buf, bigEndian), result);
+    }
+
+    //! Read the dimensions of a GIF, BMP or TGA file from its header.
+    void probeSimple(ProbeReader& r, ImageProbe& result)
+    {
+        byte buf[74];
+        if (result.imageType_ == ImageType::gif && r.read(0, buf, 10)) {
+            result.pixelWidth_ = getUShort(buf + 6, littleEndian);
+            result.pixelHeight_ = getUShort(buf + 8, littleEndian);
+        } else if (result.imageType_ == ImageType::bmp && r.read(0, buf, 26)) {
+            result.pixelWidth_ = getULong(buf + 18, littleEndian);
+            // A negative height denotes a top-down bitmap
+            const int32_t height = getLong(buf + 22, littleEndian);
+            result.pixelHeight_ = height < 0 ? -static_cast<uint32_t>(height) : height;
+            // BITMAPV5HEADER with an embedded profile (LCS_PROFILE_EMBEDDED)
+            if (getULong(buf + 14, littleEndian) >= 124 && r.read(0, buf, 74) &&
+                getULong(buf + 70, littleEndian) == 0x4d424544) {
+                result.hasIccProfile_ = true;
+            }
+        } else if (result.imageType_ == ImageType::tga && r.read(0, buf, 16)) {
+            result.pixelWidth_ = getUShort(buf + 12, littleEndian);
+            result.pixelHeight_ = getUShort(buf + 14, littleEndian);
+        }
+    }
+
+}  // namespace
+
+// *****************************************************************************
+// free functions
+namespace Exiv2 {
+    namespace Internal {
+
+    void probeImage(BasicIo& io, const byte* prefix, long prefixSize, ImageProbe& result)
+    {
+        for (auto&& m : mimeTypes) {
+            if (m.imageType_ == result.imageType_)
+                result.mimeType_ = m.mimeType_;
+        }
+
+        ProbeReader r(io, prefix, prefixSize);
+        switch (result.imageType_) {
+            case ImageType::jpeg: probeJpeg(r, 2, result); break;
+            case ImageType::exv:  probeJpeg(r, 7, result); break;
+#ifdef EXV_HAVE_LIBZ
+            case ImageType::png:  probePng(r, result); break;
+#endif // EXV_HAVE_LIBZ
+            case ImageType::cr2:
+            case ImageType::tiff:
+            case ImageType::rw2:
+            case ImageType::orf:  probeTiff(r, result); break;
+            case ImageType::bmff: probeBmff(r, result); break;
+            case ImageType::jp2:  probeJp2(r, result); break;
+            case ImageType::webp: probeWebp(r, result); break;
+            case ImageType::psd:  probePsd(r, result); break;
+            case ImageType::gif:
+            case ImageType::bmp:
+            case ImageType::tga:  probeSimple(r, result); break;
+            case ImageType::xmp:  result.hasXmp_ = true; break;
+            default: break;
+        }
+        result.bytesRead_ = r.bytesRead();
+    }
+
+}}                                      // namespace Internal, Exiv2
@@ -0,0 +1,51 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2021 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef PROBE_INT_HPP_
+#define PROBE_INT_HPP_
+
+// *****************************************************************************
+// included header files
+#include "image.hpp"
+
+// *****************************************************************************
+// namespace extensions
+namespace Exiv2 {
+    namespace Internal {
+
+// *****************************************************************************
+// free functions
+
+    /*!
+      @brief Fill in the properties of an image of type \em result.imageType_
+             from its headers. Used by ImageFactory::probe().
+
+      Malformed or truncated headers are not an error, the properties found
+      until then are returned.
+
+      @param io         The image, opened.
+      @param prefix     The first bytes of the image, already read from \em io.
+      @param prefixSize Number of bytes in \em prefix.
+      @param result     The image type on input, the properties on return.
+     */
+    void probeImage(BasicIo& io, const byte* prefix, long prefixSize, ImageProbe& result);
+
+}}                                      // namespace Internal, Exiv2
+
+#endif                                  // #ifndef PROBE_INT_HPP_
@@ -22,8 +22,10 @@
 #include "config.h"
 
 #include "psdimage.hpp"
+#include "psdimage_int.hpp"
 #include "jpgimage.hpp"
 #include "image.hpp"
+#include "image_int.hpp"
 #include "basicio.hpp"
 #include "error.hpp"
 #include "futils.hpp"
@@ -37,6 +39,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cassert>
+#include <iterator>
 #include <memory>
 
 // Todo: Consolidate with existing code in struct Photoshop (jpgimage.hpp):
@@ -116,12 +119,55 @@ enum {
 // *****************************************************************************
 // class member definitions
 namespace Exiv2 {
+    using namespace Exiv2::Internal;
+
+    namespace {
+        /*!
+          @brief Skip the color mode data section of the Photoshop image \em io,
+                 which is positioned after the file header, and read the length
+                 of the image resources section which follows it.
+          @return An empty index of the image resources section; \em io is
+                  positioned at its first resource block.
+         */
+        std::unique_ptr<PsdResourceIndex> readSectionLengths(BasicIo& io)
+        {
+            byte buf[4];
+            // the first four bytes of the color mode data section specify the byte size of the whole section
+            if (io.read(buf, 4) != 4) throw Error(kerNotAnImage, "Photoshop");
+            const uint32_t colorDataLength = getULong(buf, bigEndian);
+            if (io.seek(colorDataLength, BasicIo::cur)) throw Error(kerNotAnImage, "Photoshop");
+
+            // after the color data section, comes a list of resource blocks, preceded by the total byte size
+            if (io.read(buf, 4) != 4) throw Error(kerNotAnImage, "Photoshop");
+            const uint32_t resourcesLength = getULong(buf, bigEndian);
+            enforce(resourcesLength < io.size(), Exiv2::kerCorruptedMetadata);
+            return std::make_unique<PsdResourceIndex>(io, io.tell(), resourcesLength);
+        }
+
+        //! Index all resource blocks of the Photoshop image \em io
+        std::unique_ptr<PsdResourceIndex> indexResources(BasicIo& io)
+        {
+            io.seek(0, BasicIo::beg);
+            // Ensure that this is the correct image type
+            if (!isPsdType(io, false)) {
+                if (io.error() || io.eof()) throw Error(kerInputDataReadFailed);
+                throw Error(kerNoImageInInputData);
+            }
+            byte psd_head[26];
+            if (io.read(psd_head, 26) != 26) throw Error(kerNotAnImage, "Photoshop");
+            auto index = readSectionLengths(io);
+            index->readAll(io);
+            return index;
+        }
+    }  // namespace
 
     PsdImage::PsdImage(BasicIo::UniquePtr io)
         : Image(ImageType::psd, mdExif | mdIptc | mdXmp, std::move(io))
     {
     } // PsdImage::PsdImage
 
+    PsdImage::~PsdImage() = default;
+
     std::string PsdImage::mimeType() const
     {
         return "image/x-photoshop";
@@ -150,6 +196,7 @@ namespace Exiv2 {
             throw Error(kerNotAnImage, "Photoshop");
         }
         clearMetadata();
+        resourceIndex_.reset();
 
         /*
           The Photoshop header goes as follows -- all numbers are in big-endian byte order:
@@ -173,71 +220,32 @@ namespace Exiv2 {
         pixelWidth_ = getLong(buf + 18, bigEndian);
         pixelHeight_ = getLong(buf + 14, bigEndian);
 
-        // immediately following the image header is the color mode data section,
-        // the first four bytes of which specify the byte size of the whole section
-        if (io_->read(buf, 4) != 4)
-        {
-            throw Error(kerNotAnImage, "Photoshop");
-        }
-
-        // skip it
-        uint32_t colorDataLength = getULong(buf, bigEndian);
-        if (io_->seek(colorDataLength, BasicIo::cur))
+        // Index the resource blocks as they are read, for writeMetadata()
+        auto index = readSectionLengths(*io_);
+        bool complete = true;
+        while (io_->tell() < index->end())
         {
-            throw Error(kerNotAnImage, "Photoshop");
-        }
-
-        // after the color data section, comes a list of resource blocks, preceded by the total byte size
-        if (io_->read(buf, 4) != 4)
-        {
-            throw Error(kerNotAnImage, "Photoshop");
-        }
-        uint32_t resourcesLength = getULong(buf, bigEndian);
-        enforce(resourcesLength < io_->size(), Exiv2::kerCorruptedMetadata);
-
-        while (resourcesLength > 0)
-        {
-            enforce(resourcesLength >= 8, Exiv2::kerCorruptedMetadata);
-            resourcesLength -= 8;
-            if (io_->read(buf, 8) != 8)
-            {
-                throw Error(kerNotAnImage, "Photoshop");
-            }
-
-            if (!Photoshop::isIrb(buf, 4))
+            const PsdResourceIndex::Entry* resource = index->readHeader(*io_);
+            if (resource == nullptr)
             {
+                complete = false;
                 break; // bad resource type
             }
-            uint16_t resourceId = getUShort(buf + 4, bigEndian);
-            uint32_t resourceNameLength = buf[6] & ~1;
-
-            // skip the resource name, plus any padding
-            enforce(resourceNameLength <= resourcesLength, Exiv2::kerCorruptedMetadata);
-            resourcesLength -= resourceNameLength;
-            io_->seek(resourceNameLength, BasicIo::cur);
-
-            // read resource size
-            enforce(resourcesLength >= 4, Exiv2::kerCorruptedMetadata);
-            resourcesLength -= 4;
-            if (io_->read(buf, 4) != 4)
-            {
-                throw Error(kerNotAnImage, "Photoshop");
-            }
-            uint32_t resourceSize = getULong(buf, bigEndian);
-            uint32_t curOffset = io_->tell();
+            const uint16_t resourceId = resource->id_;
+            const uint32_t resourceSize = resource->length_;
+            const long next = resource->offset_ + resource->size();
 
 #ifdef EXIV2_DEBUG_MESSAGES
         std::cerr << std::hex << "resourceId: " << resourceId << std::dec << " length: " << resourceSize << std::hex << "\n";
 #endif
 
-            enforce(resourceSize <= resourcesLength, Exiv2::kerCorruptedMetadata);
             readResourceBlock(resourceId, resourceSize);
-            resourceSize = (resourceSize + 1) & ~1;        // pad to even
-            enforce(resourceSize <= resourcesLength, Exiv2::kerCorruptedMetadata);
-            resourcesLength -= resourceSize;
-            io_->seek(curOffset + resourceSize, BasicIo::beg);
+            io_->seek(next, BasicIo::beg);
         }
 
+        // Keep a complete index, it spares writeMetadata() another pass over the resource blocks
+        if (complete) resourceIndex_ = std::move(index);
+        setMetadataClean();
     } // PsdImage::readMetadata
 
     void PsdImage::readResourceBlock(uint16_t resourceId, uint32_t resourceSize)
@@ -345,20 +353,32 @@ namespace Exiv2 {
 
     void PsdImage::writeMetadata()
     {
+        const int changed = changedMetadata() & (mdExif | mdIptc | mdXmp);
+        if (changed == mdNone) {
+            setWrittenMetadata(mdNone);
+            return;
+        }
         if (io_->open() != 0)
         {
             throw Error(kerDataSourceOpenFailed, io_->path(), strError());
         }
         IoCloser closer(*io_);
-        auto tempIo = std::make_unique<MemIo>();
 
-        doWriteMetadata(*tempIo); // may throw
+        auto index = std::move(resourceIndex_);
+        if (!index || !index->isCurrent(*io_)) {
+            index = indexResources(*io_);
+        }
+
+        auto tempIo = std::make_unique<TempIo>(*io_);
+        doWriteMetadata(*index, changed, *tempIo); // may throw
         io_->close();
         io_->transfer(*tempIo); // may throw
+        setWrittenMetadata(changed);
+        setMetadataClean();
 
     } // PsdImage::writeMetadata
 
-    void PsdImage::doWriteMetadata(BasicIo& outIo)
+    void PsdImage::doWriteMetadata(const PsdResourceIndex& index, int changed, BasicIo& outIo)
     {
         if (!io_->isopen()) throw Error(kerInputDataReadFailed);
         if (!outIo.isopen()) throw Error(kerImageWriteFailed);
@@ -368,188 +388,75 @@ namespace Exiv2 {
         std::cout << "Exiv2::PsdImage::doWriteMetadata: tmp file created " << outIo.path() << "\n";
 #endif
 
-        // Ensure that this is the correct image type
-        if (!isPsdType(*io_, true)) {
-            if (io_->error() || io_->eof()) throw Error(kerInputDataReadFailed);
-            throw Error(kerNoImageInInputData);
-        }
-
-        io_->seek(0, BasicIo::beg);    // rewind
-
-        DataBuf lbuf(4096);
-        byte buf[8];
-
-        // Get Photoshop header from original file
-        byte psd_head[26];
-        if (io_->read(psd_head, 26) != 26) throw Error(kerNotAnImage, "Photoshop");
-
-        // Write Photoshop header data out to new PSD file
-        if (outIo.write(psd_head, 26) != 26) throw Error(kerImageWriteFailed);
-
-        // Read colorDataLength from original PSD
-        if (io_->read(buf, 4) != 4) throw Error(kerNotAnImage, "Photoshop");
+        // Copy the Photoshop header and the color mode data section
+        const long resLenOffset = index.start() - 4;  // remember for later update
+        copyData(*io_, 0, resLenOffset, outIo);
 
-        uint32_t colorDataLength = getULong(buf, bigEndian);
-
-        // Write colorDataLength
-        ul2Data(buf, colorDataLength, bigEndian);
+        // Write the old length of all resource blocks (will be updated later)
+        byte buf[4];
+        ul2Data(buf, static_cast<uint32_t>(index.end() - index.start()), bigEndian);
         if (outIo.write(buf, 4) != 4) throw Error(kerImageWriteFailed);
-#ifdef EXIV2_DEBUG_MESSAGES
-        std::cerr << std::dec << "colorDataLength: " << colorDataLength << "\n";
-#endif
-        // Copy colorData
-        uint32_t readTotal = 0;
-        long toRead = 0;
-        while (readTotal < colorDataLength) {
-            toRead =   static_cast<long>(colorDataLength - readTotal) < lbuf.size()
-                     ? static_cast<long>(colorDataLength - readTotal) : lbuf.size();
-            if (io_->read(lbuf.data(), toRead) != toRead) throw Error(kerNotAnImage, "Photoshop");
-            readTotal += toRead;
-            if (outIo.write(lbuf.c_data(), toRead) != toRead) throw Error(kerImageWriteFailed);
-        }
-        if (outIo.error()) throw Error(kerImageWriteFailed);
-
-        uint32_t resLenOffset = io_->tell();  // remember for later update
-
-        // Read length of all resource blocks from original PSD
-        if (io_->read(buf, 4) != 4) throw Error(kerNotAnImage, "Photoshop");
-
-        uint32_t oldResLength = getULong(buf, bigEndian);
         uint32_t newResLength = 0;
 
-        // Write oldResLength (will be updated later)
-        ul2Data(buf, oldResLength, bigEndian);
-        if (outIo.write(buf, 4) != 4) throw Error(kerImageWriteFailed);
-
-#ifdef EXIV2_DEBUG_MESSAGES
-        std::cerr << std::dec << "oldResLength: " << oldResLength << "\n";
-#endif
-
-        // Iterate over original resource blocks.
-        // Replace or insert IPTC, EXIF and XMP
+        // Replace or insert IPTC, EXIF and XMP of the changed metadata, copy
+        // all other resource blocks in runs of adjacent blocks.
         // Original resource blocks assumed to be sorted ASC
-
-        bool iptcDone = false;
-        bool exifDone = false;
-        bool xmpDone = false;
-        while (oldResLength > 0) {
-            if (io_->read(buf, 8) != 8) throw Error(kerNotAnImage, "Photoshop");
-
-            // read resource type and ID
-            uint32_t resourceType = getULong(buf, bigEndian);
-
-            if (!Photoshop::isIrb(buf, 4))
-            {
-                throw Error(kerNotAnImage, "Photoshop"); // bad resource type
+        const struct {
+            uint16_t resourceId_;
+            MetadataId metadataId_;
+        } metadata[] = {
+            { kPhotoshopResourceID_IPTC_NAA,  mdIptc },
+            { kPhotoshopResourceID_ExifInfo,  mdExif },
+            { kPhotoshopResourceID_XMPPacket, mdXmp  },
+        };
+        auto isRewritten = [&](uint16_t resourceId) {
+            for (auto&& md : metadata) {
+                if (md.resourceId_ == resourceId) return (changed & md.metadataId_) != 0;
             }
-            uint16_t resourceId = getUShort(buf + 4, bigEndian);
-            uint32_t resourceNameLength = buf[6];
-            uint32_t adjResourceNameLen = resourceNameLength & ~1;
-            unsigned char resourceNameFirstChar = buf[7];
-
-            // read rest of resource name, plus any padding
-            DataBuf resName(256);
-            if (   io_->read(resName.data(), adjResourceNameLen)
-                != static_cast<long>(adjResourceNameLen)) throw Error(kerNotAnImage, "Photoshop");
-
-            // read resource size (actual length w/o padding!)
-            if (io_->read(buf, 4) != 4) throw Error(kerNotAnImage, "Photoshop");
-
-            uint32_t resourceSize = getULong(buf, bigEndian);
-            uint32_t pResourceSize = (resourceSize + 1) & ~1;    // padded resource size
-            uint32_t curOffset = io_->tell();
-
-            // Write IPTC_NAA resource block
-            if ((resourceId == kPhotoshopResourceID_IPTC_NAA || resourceId > kPhotoshopResourceID_IPTC_NAA) &&
-                !iptcDone) {
-                newResLength += writeIptcData(iptcData_, outIo);
-                iptcDone = true;
+            return false;
+        };
+        size_t next = 0;  // next metadata resource to write
+        auto writeResources = [&](uint32_t upToId) {
+            for (; next < std::size(metadata) && metadata[next].resourceId_ <= upToId; ++next) {
+                if (changed & metadata[next].metadataId_) {
+                    newResLength += writeResource(metadata[next].resourceId_, outIo);
+                }
             }
-
-            // Write ExifInfo resource block
-            else if ((resourceId == kPhotoshopResourceID_ExifInfo || resourceId > kPhotoshopResourceID_ExifInfo) &&
-                     !exifDone) {
-                newResLength += writeExifData(exifData_, outIo);
-                exifDone = true;
+        };
+
+        long runOffset = index.start();
+        long runSize = 0;
+        for (auto&& resource : index.resources()) {
+            if (next < std::size(metadata) && metadata[next].resourceId_ <= resource.id_) {
+                copyData(*io_, runOffset, runSize, outIo);
+                runSize = 0;
+                writeResources(resource.id_);
             }
-
-            // Write XMPpacket resource block
-            else if ((resourceId == kPhotoshopResourceID_XMPPacket || resourceId > kPhotoshopResourceID_XMPPacket) &&
-                     !xmpDone) {
-                newResLength += writeXmpData(xmpData_, outIo);
-                xmpDone = true;
+            if (isRewritten(resource.id_)) {
+                copyData(*io_, runOffset, runSize, outIo);
+                runSize = 0;
+                continue;
             }
-
-            // Copy all other resource blocks
-            if (   resourceId != kPhotoshopResourceID_IPTC_NAA
-                && resourceId != kPhotoshopResourceID_ExifInfo
-                && resourceId != kPhotoshopResourceID_XMPPacket) {
 #ifdef EXIV2_DEBUG_MESSAGES
-                std::cerr << std::hex << "copy : resourceType: " << resourceType << "\n";
-                std::cerr << std::hex << "copy : resourceId: " << resourceId << "\n";
-                std::cerr << std::dec;
+            std::cerr << std::hex << "copy : resourceId: " << resource.id_ << std::dec << "\n";
 #endif
-                // Copy resource block to new PSD file
-                ul2Data(buf, resourceType, bigEndian);
-                if (outIo.write(buf, 4) != 4) throw Error(kerImageWriteFailed);
-                us2Data(buf, resourceId, bigEndian);
-                if (outIo.write(buf, 2) != 2) throw Error(kerImageWriteFailed);
-                // Write resource name as Pascal string
-                buf[0] = resourceNameLength & 0x00ff;
-                if (outIo.write(buf, 1) != 1) throw Error(kerImageWriteFailed);
-                buf[0] = resourceNameFirstChar;
-                if (outIo.write(buf, 1) != 1) throw Error(kerImageWriteFailed);
-                if (   outIo.write(resName.c_data(), adjResourceNameLen)
-                    != static_cast<long>(adjResourceNameLen)) throw Error(kerImageWriteFailed);
-                ul2Data(buf, resourceSize, bigEndian);
-                if (outIo.write(buf, 4) != 4) throw Error(kerImageWriteFailed);
-
-                readTotal = 0;
-                toRead = 0;
-                while (readTotal < pResourceSize) {
-                    toRead =   static_cast<long>(pResourceSize - readTotal) < lbuf.size()
-                             ? static_cast<long>(pResourceSize - readTotal) : lbuf.size();
-                    if (io_->read(lbuf.data(), toRead) != toRead) {
-                        throw Error(kerNotAnImage, "Photoshop");
-                    }
-                    readTotal += toRead;
-                    if (outIo.write(lbuf.c_data(), toRead) != toRead) throw Error(kerImageWriteFailed);
-                }
-                if (outIo.error()) throw Error(kerImageWriteFailed);
-                newResLength += pResourceSize + adjResourceNameLen + 12;
-            }
-
-            io_->seek(curOffset + pResourceSize, BasicIo::beg);
-            oldResLength -= (12 + adjResourceNameLen + pResourceSize);
+            if (runSize == 0) runOffset = resource.offset_;
+            runSize += resource.size();
+            newResLength += static_cast<uint32_t>(resource.size());
         }
+        copyData(*io_, runOffset, runSize, outIo);
 
-        // Append IPTC_NAA resource block, if not yet written
-        if (!iptcDone) {
-            newResLength += writeIptcData(iptcData_, outIo);
-            iptcDone = true;
-        }
-
-        // Append ExifInfo resource block, if not yet written
-        if (!exifDone) {
-            newResLength += writeExifData(exifData_, outIo);
-            exifDone = true;
-        }
-
-        // Append XmpPacket resource block, if not yet written
-        if (!xmpDone) {
-            newResLength += writeXmpData(xmpData_, outIo);
-            xmpDone = true;
-        }
+        // Append the metadata resource blocks not yet written
+        writeResources(0xffff);
 
         // Populate the fake data, only make sense for remoteio, httpio and sshio.
         // it avoids allocating memory for parts of the file that contain image-date.
         io_->populateFakeData();
 
-        // Copy remaining data
-        long readSize = 0;
-        while ((readSize=io_->read(lbuf.data(), lbuf.size()))) {
-            if (outIo.write(lbuf.c_data(), readSize) != readSize) throw Error(kerImageWriteFailed);
-        }
+        // Copy the layer and mask information and the image data
+        if (io_->seek(index.end(), BasicIo::beg) != 0) throw Error(kerNotAnImage, "Photoshop");
+        const long rest = static_cast<long>(io_->size()) - index.end();
+        if (outIo.write(*io_) != rest) throw Error(kerImageWriteFailed);
         if (outIo.error()) throw Error(kerImageWriteFailed);
 
         // Update length of resources
@@ -562,6 +469,16 @@ namespace Exiv2 {
 
     } // PsdImage::doWriteMetadata
 
+    uint32_t PsdImage::writeResource(uint16_t resourceId, BasicIo& out)
+    {
+        switch (resourceId) {
+            case kPhotoshopResourceID_IPTC_NAA:  return writeIptcData(iptcData_, out);
+            case kPhotoshopResourceID_ExifInfo:  return writeExifData(exifData_, out);
+            case kPhotoshopResourceID_XMPPacket: return writeXmpData(xmpData_, out);
+            default:                             return 0;
+        }
+    } // PsdImage::writeResource
+
     uint32_t PsdImage::writeIptcData(const IptcData& iptcData, BasicIo& out)
     {
         uint32_t resLength = 0;
@@ -0,0 +1,80 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+// *****************************************************************************
+// included header files
+#include "config.h"
+
+#include "psdimage_int.hpp"
+#include "basicio.hpp"
+#include "enforce.hpp"
+#include "error.hpp"
+#include "image_int.hpp"
+#include "jpgimage.hpp"
+
+// *****************************************************************************
+// class member definitions
+namespace Exiv2 {
+    namespace Internal {
+
+    PsdResourceIndex::PsdResourceIndex(const BasicIo& io, long start, uint32_t length)
+        : BlockIndex(io, start + static_cast<long>(length)), start_(start)
+    {
+    }
+
+    const PsdResourceIndex::Entry* PsdResourceIndex::readHeader(BasicIo& io)
+    {
+        const long offset = io.tell();
+        enforce(offset <= end(), kerCorruptedMetadata);
+        uint32_t remaining = static_cast<uint32_t>(end() - offset);
+
+        // Block header: 4 bytes (signature) + 2 bytes (ID) + 2 bytes (start of the name)
+        byte buf[8];
+        enforce(remaining >= 8, kerCorruptedMetadata);
+        remaining -= 8;
+        if (io.read(buf, 8) != 8) throw Error(kerNotAnImage, "Photoshop");
+        if (!Photoshop::isIrb(buf, 4)) return nullptr;
+        const uint16_t id = getUShort(buf + 4, bigEndian);
+
+        // Skip the rest of the resource name, a Pascal string padded to an even size
+        const uint32_t nameLength = buf[6] & ~1;
+        enforce(nameLength <= remaining, kerCorruptedMetadata);
+        remaining -= nameLength;
+        io.seek(nameLength, BasicIo::cur);
+
+        // Resource size, without padding
+        enforce(remaining >= 4, kerCorruptedMetadata);
+        remaining -= 4;
+        if (io.read(buf, 4) != 4) throw Error(kerNotAnImage, "Photoshop");
+        const uint32_t length = getULong(buf, bigEndian);
+        enforce(length <= remaining, kerCorruptedMetadata);
+        enforce(length + (length & 1) <= remaining, kerCorruptedMetadata);
+
+        resources_.push_back({id, offset, nameLength, length});
+        return &resources_.back();
+    }
+
+    long PsdResourceIndex::nextBlock(BasicIo& io)
+    {
+        const Entry* resource = readHeader(io);
+        if (resource == nullptr) throw Error(kerNotAnImage, "Photoshop"); // bad resource type
+        return resource->offset_ + resource->size();
+    }
+
+}}                                      // namespace Internal, Exiv2
@@ -0,0 +1,113 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef PSDIMAGE_INT_HPP_
+#define PSDIMAGE_INT_HPP_
+
+// *****************************************************************************
+// included header files
+#include "types.hpp"
+#include "image_int.hpp"
+
+// + standard includes
+#include <vector>
+
+// *****************************************************************************
+// namespace extensions
+namespace Exiv2 {
+
+// *****************************************************************************
+// class declarations
+    class BasicIo;
+
+    namespace Internal {
+
+// *****************************************************************************
+// class definitions
+
+    /*!
+      @brief Index of the image resource blocks of a Photoshop image. It is
+             built in one pass over the block headers, either while the
+             blocks are read (readHeader()) or seeking over the block data
+             (readAll()).
+     */
+    class PsdResourceIndex : public BlockIndex {
+    public:
+        //! Position of an image resource block in the image
+        struct Entry {
+            uint16_t id_;          //!< Resource ID
+            long offset_;          //!< Offset of the block, i.e., of its signature
+            uint32_t nameLength_;  //!< Length of the resource name after its first two bytes
+            uint32_t length_;      //!< Length of the resource data, without padding
+
+            //! Return the offset of the resource data
+            long data() const { return offset_ + 12 + static_cast<long>(nameLength_); }
+            //! Return the size of the whole block: header, name, data and padding
+            long size() const
+            {
+                return 12 + static_cast<long>(nameLength_) + static_cast<long>(length_) +
+                       static_cast<long>(length_ & 1);
+            }
+        };
+
+        //! @name Creators
+        //@{
+        /*!
+          @brief Constructor for an empty index of the image resources section
+                 of \em io, which starts at \em start, after the section length,
+                 and is \em length bytes long.
+         */
+        PsdResourceIndex(const BasicIo& io, long start, uint32_t length);
+        //@}
+
+        //! @name Manipulators
+        //@{
+        /*!
+          @brief Read the header of the resource block at the current position
+                 of \em io and add the block to the index. On return, \em io is
+                 positioned at the resource data.
+          @return The new entry, which is valid until the next block is added;
+                  nullptr if there is no resource block signature, the index is
+                  not changed then.
+          @throw Error if the header can't be read or the block exceeds the section.
+         */
+        const Entry* readHeader(BasicIo& io);
+        //@}
+
+        //! @name Accessors
+        //@{
+        //! Return the resource blocks, in the order of the image.
+        const std::vector<Entry>& resources() const { return resources_; }
+        //! Return the start of the image resources section, after its length
+        long start() const { return start_; }
+        //@}
+
+    protected:
+        //! Add the block at the current position of \em io, fail if it has no resource block signature.
+        long nextBlock(BasicIo& io) override;
+
+    private:
+        // DATA
+        std::vector<Entry> resources_;  //!< The resource blocks
+        long start_;                    //!< Start of the image resources section
+    }; // class PsdResourceIndex
+
+}}                                      // namespace Internal, Exiv2
+
+#endif                                  // #ifndef PSDIMAGE_INT_HPP_
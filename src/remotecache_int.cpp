@@ -0,0 +1,266 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2021 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+// *****************************************************************************
+// included header files
+#include "remotecache_int.hpp"
+
+// + standard includes
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// *****************************************************************************
+namespace {
+    //! File name prefix and extension of the data files
+    constexpr const char* cachePrefix = "exiv2-";
+    constexpr const char* cacheExt = ".blk";
+    //! File name and first line of the manifest
+    constexpr const char* manifestName = "exiv2-cache.idx";
+    constexpr const char* manifestHeader = "exiv2-remote-cache 1";
+    //! Size of the hash in front of each block in a data file
+    constexpr size_t hashSize = 8;
+
+    //! 64 bit FNV-1a hash of \em size bytes at \em data
+    uint64_t fnv1a(const void* data, size_t size)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        auto p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    //! Hash of a block, never 0, which marks an empty slot
+    uint64_t blockHash(const Exiv2::byte* data, size_t size)
+    {
+        return fnv1a(data, size) | 1;
+    }
+
+    //! Seek to \em offset of \em fp, which may be beyond 2 GB
+    int seekFile(std::FILE* fp, uint64_t offset)
+    {
+#ifdef _WIN64
+        return _fseeki64(fp, static_cast<int64_t>(offset), SEEK_SET);
+#else
+        return std::fseek(fp, static_cast<long>(offset), SEEK_SET);
+#endif
+    }
+}  // namespace
+
+// *****************************************************************************
+// class member definitions
+namespace Exiv2 {
+    namespace Internal {
+
+    RemoteBlockCache::RemoteBlockCache(std::string dir, size_t maxBytes)
+        : dir_(std::move(dir)), maxBytes_(maxBytes)
+    {
+        std::error_code ec;
+        fs::create_directories(dir_, ec);
+        readManifest(resources_);
+        for (auto&& resource : resources_) {
+            clock_ = std::max(clock_, resource.second.lastUse_);
+        }
+    }
+
+    RemoteBlockCache::~RemoteBlockCache()
+    {
+        if (fp_ != nullptr) std::fclose(fp_);
+        if (dirty_) evict();
+    }
+
+    void RemoteBlockCache::setKey(const std::string& key, size_t blockSize)
+    {
+        if (fp_ != nullptr) {
+            std::fclose(fp_);
+            fp_ = nullptr;
+        }
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(fnv1a(key.data(), key.size())));
+        name_ = cachePrefix + std::string(buf) + cacheExt;
+        blockSize_ = blockSize;
+
+        // Mark the resource as recently used
+        auto resource = resources_.find(name_);
+        if (resource != resources_.end()) {
+            resource->second.lastUse_ = ++clock_;
+            dirty_ = true;
+        }
+    }
+
+    std::string RemoteBlockCache::dataPath() const
+    {
+        return (fs::path(dir_) / name_).string();
+    }
+
+    std::string RemoteBlockCache::manifestPath() const
+    {
+        return (fs::path(dir_) / manifestName).string();
+    }
+
+    std::FILE* RemoteBlockCache::file(bool create)
+    {
+        if (fp_ == nullptr && !name_.empty()) {
+            fp_ = std::fopen(dataPath().c_str(), "r+b");
+            if (fp_ == nullptr && create) {
+                fp_ = std::fopen(dataPath().c_str(), "w+b");
+            }
+        }
+        return fp_;
+    }
+
+    DataBuf RemoteBlockCache::load(size_t block, size_t size)
+    {
+        std::FILE* fp = size == 0 || size > blockSize_ ? nullptr : file(false);
+        if (fp == nullptr || seekFile(fp, block * (hashSize + blockSize_)) != 0) {
+            misses_++;
+            return DataBuf();
+        }
+        uint64_t hash = 0;
+        DataBuf buf(static_cast<long>(size));
+        if (   std::fread(&hash, 1, hashSize, fp) != hashSize
+            || std::fread(buf.data(), 1, size, fp) != size
+            || hash != blockHash(buf.c_data(), size)) {
+            misses_++;
+            return DataBuf();
+        }
+        hits_++;
+        return buf;
+    }
+
+    void RemoteBlockCache::store(size_t block, const byte* data, size_t size)
+    {
+        if (size == 0 || size > blockSize_) return;
+        Resource& resource = resources_.insert({name_, {0, 0}}).first->second;
+        std::FILE* fp = file(true);
+        if (fp == nullptr || seekFile(fp, block * (hashSize + blockSize_)) != 0) return;
+        // A block which was stored before, e.g. fetched again after a hash mismatch, is counted already
+        uint64_t stored = 0;
+        const bool counted = std::fread(&stored, 1, hashSize, fp) == hashSize && stored != 0;
+        // A single resource never takes more than the whole cache
+        if (!counted && resource.bytes_ + hashSize + size > maxBytes_) return;
+        if (seekFile(fp, block * (hashSize + blockSize_)) != 0) return;
+        // The hash is written last, a partially written block is never served
+        const uint64_t hash = blockHash(data, size);
+        const uint64_t none = 0;
+        if (   std::fwrite(&none, 1, hashSize, fp) != hashSize
+            || std::fwrite(data, 1, size, fp) != size
+            || seekFile(fp, block * (hashSize + blockSize_)) != 0
+            || std::fwrite(&hash, 1, hashSize, fp) != hashSize
+            || std::fflush(fp) != 0) {
+            return;
+        }
+        if (!counted) resource.bytes_ += hashSize + size;
+        resource.lastUse_ = ++clock_;
+        dirty_ = true;
+    }
+
+    void RemoteBlockCache::evict()
+    {
+        mergeManifest();
+        uint64_t total = 0;
+        for (auto&& resource : resources_) {
+            total += resource.second.bytes_;
+        }
+        while (total > maxBytes_) {
+            auto lru = resources_.end();
+            for (auto it = resources_.begin(); it != resources_.end(); ++it) {
+                if (it->first == name_) continue;
+                if (lru == resources_.end() || it->second.lastUse_ < lru->second.lastUse_) lru = it;
+            }
+            if (lru == resources_.end()) break;
+            std::error_code ec;
+            fs::remove(fs::path(dir_) / lru->first, ec);
+            total -= lru->second.bytes_;
+            evicted_.insert(lru->first);
+            resources_.erase(lru);
+            dirty_ = true;
+        }
+        if (dirty_) writeManifest();
+    }
+
+    void RemoteBlockCache::readManifest(Resources& resources) const
+    {
+        std::ifstream is(manifestPath());
+        std::string line;
+        if (!std::getline(is, line) || line != manifestHeader) return;
+        while (std::getline(is, line)) {
+            std::istringstream fields(line);
+            std::string name;
+            Resource resource{0, 0};
+            if (   fields >> name >> resource.bytes_ >> resource.lastUse_
+                && name.compare(0, std::strlen(cachePrefix), cachePrefix) == 0
+                && name.find_first_of("/\\") == std::string::npos) {
+                resources[name] = resource;
+            }
+        }
+    }
+
+    void RemoteBlockCache::mergeManifest()
+    {
+        Resources current;
+        readManifest(current);
+        for (auto&& resource : current) {
+            if (evicted_.count(resource.first)) continue;
+            auto it = resources_.find(resource.first);
+            if (it == resources_.end()) {
+                resources_.insert(resource);
+            } else {
+                it->second.bytes_ = std::max(it->second.bytes_, resource.second.bytes_);
+                it->second.lastUse_ = std::max(it->second.lastUse_, resource.second.lastUse_);
+            }
+            clock_ = std::max(clock_, resource.second.lastUse_);
+        }
+    }
+
+    void RemoteBlockCache::writeManifest()
+    {
+        // Write to a temporary name first so that readers never see a partial manifest
+        const std::string path = manifestPath();
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream os(tmp, std::ios::trunc);
+            os << manifestHeader << '\n';
+            for (auto&& resource : resources_) {
+                os << resource.first << ' ' << resource.second.bytes_ << ' ' << resource.second.lastUse_ << '\n';
+            }
+            if (!os) {
+                os.close();
+                std::remove(tmp.c_str());
+                return;
+            }
+        }
+        std::error_code ec;
+        fs::rename(tmp, path, ec);
+        if (ec) {
+            fs::remove(tmp, ec);
+            return;
+        }
+        dirty_ = false;
+    }
+
+}}                                      // namespace Internal, Exiv2
@@ -0,0 +1,149 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2021 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef REMOTECACHE_INT_HPP_
+#define REMOTECACHE_INT_HPP_
+
+// *****************************************************************************
+// included header files
+#include "types.hpp"
+
+// + standard includes
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+
+// *****************************************************************************
+// namespace extensions
+namespace Exiv2 {
+    namespace Internal {
+
+// *****************************************************************************
+// class definitions
+
+    /*!
+      @brief Persistent, size-bounded on-disk store for the blocks of a RemoteIo.
+
+      All blocks of a resource are packed into one data file in the cache
+      directory, each in a slot at a fixed offset together with a hash of its
+      data. The file name is derived from a hash of the resource key (URL,
+      validator, size and block size), so a changed remote file never hits
+      stale blocks. A block is only served if its hash matches.
+
+      A manifest in the cache directory records the size and the last use of
+      every resource. When the total size exceeds the limit, the least
+      recently used resources are removed. Instances in other processes merge
+      their changes into the manifest when they update it.
+
+      Failures to read or write the cache are never fatal, the cache simply
+      reports a miss and the caller falls back to the server.
+     */
+    class RemoteBlockCache {
+    public:
+        //! @name Creators
+        //@{
+        /*!
+          @brief Constructor.
+          @param dir      Directory for the cache files. It is created if needed.
+          @param maxBytes Upper bound for the total size of all cached blocks.
+         */
+        RemoteBlockCache(std::string dir, size_t maxBytes);
+        //! Destructor, updates the manifest.
+        ~RemoteBlockCache();
+        //! Copy constructor
+        RemoteBlockCache(const RemoteBlockCache&) = delete;
+        //! Assignment operator
+        RemoteBlockCache& operator=(const RemoteBlockCache&) = delete;
+        //@}
+
+        //! @name Manipulators
+        //@{
+        /*!
+          @brief Bind the cache to a resource with blocks of \em blockSize bytes.
+                 Must be called before load() and store().
+         */
+        void setKey(const std::string& key, size_t blockSize);
+        /*!
+          @brief Read block \em block of the current resource from the cache.
+          @param block Index of the block.
+          @param size  Expected size of the block. Cached blocks of any other size are ignored.
+          @return The block data, or an empty buffer if the block is not cached.
+         */
+        DataBuf load(size_t block, size_t size);
+        //! Write block \em block of the current resource to the cache.
+        void store(size_t block, const byte* data, size_t size);
+        /*!
+          @brief Remove least recently used resources, except the current one,
+                 until the cache fits into its size limit, and write the manifest.
+         */
+        void evict();
+        //@}
+
+        //! @name Accessors
+        //@{
+        //! Number of blocks served from the cache.
+        size_t hits() const { return hits_; }
+        //! Number of blocks looked up but not found in the cache.
+        size_t misses() const { return misses_; }
+        //! Path of the data file of the current resource.
+        std::string dataPath() const;
+        //! Path of the manifest of the cache directory.
+        std::string manifestPath() const;
+        //@}
+
+    private:
+        //! Size and last use of a resource
+        struct Resource {
+            uint64_t bytes_;    //!< Size of the blocks stored
+            uint64_t lastUse_;  //!< Value of the use counter when the resource was last used
+        };
+        //! Map of the resources by the name of their data file
+        using Resources = std::map<std::string, Resource>;
+
+        //! @name Manipulators
+        //@{
+        //! Return the data file of the current resource, open it or, if \em create is true, create it if needed.
+        std::FILE* file(bool create);
+        //! Merge the manifest written by other instances into resources_.
+        void mergeManifest();
+        //! Write resources_ to the manifest.
+        void writeManifest();
+        //@}
+
+        //! Read the manifest into \em resources.
+        void readManifest(Resources& resources) const;
+
+        // DATA
+        std::string dir_;              //!< Cache directory
+        size_t maxBytes_;              //!< Size limit of the cache
+        std::string name_;             //!< Name of the data file of the current resource
+        size_t blockSize_{0};          //!< Block size of the current resource
+        std::FILE* fp_{nullptr};       //!< Data file of the current resource, if open
+        Resources resources_;          //!< Resources of the cache
+        std::set<std::string> evicted_; //!< Resources removed by this instance
+        uint64_t clock_{0};            //!< Use counter, orders the resources by their last use
+        bool dirty_{false};            //!< True if resources_ has changes not in the manifest
+        size_t hits_{0};               //!< Number of cache hits
+        size_t misses_{0};             //!< Number of cache misses
+    }; // class RemoteBlockCache
+
+}}                                      // namespace Internal, Exiv2
+
+#endif                                  // #ifndef REMOTECACHE_INT_HPP_
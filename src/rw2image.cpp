@@ -119,8 +119,9 @@ namespace Exiv2 {
             throw Error(kerNotAnImage, "RW2");
         }
         clearMetadata();
-        ByteOrder bo =
-            Rw2Parser::decode(exifData_, iptcData_, xmpData_, io_->mmap(), static_cast<uint32_t>(io_->size()));
+        Rw2Header rw2Header;
+        ByteOrder bo = TiffParserWorker::decode(exifData_, iptcData_, xmpData_, *io_, Tag::pana,
+                                                TiffMapping::findDecoder, &rw2Header);
         setByteOrder(bo);
 
         // A lot more metadata is hidden in the embedded preview image
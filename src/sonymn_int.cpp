@@ -856,7 +856,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             return os << "(" << value << ")";
 
-        auto pos = metadata->findKey(ExifKey("Exif.Sony2Fp.0x0002"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.Sony2Fp.0x0002");
         if (pos != metadata->end() && pos-> count() == 1 && pos->toLong() == 255)
             return os << value << " °C";
 
@@ -898,7 +898,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             os << "(" << value << ")";
         else {
-            auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+            auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
             if (pos == metadata->end())
                 return os << "(" << value << ")";
 
@@ -943,7 +943,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             return os << "(" << value << ")";
 
-        auto pos = metadata->findKey(ExifKey("Exif.SonyMisc1.0x0004"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.SonyMisc1.0x0004");
         if (pos != metadata->end() && pos->count() == 1 && pos->toLong() != 0 && pos->toLong() < 100)
             return os << value << " °C";
 
@@ -1017,7 +1017,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             return os << "(" << value << ")";
 
-        auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
         if (pos == metadata->end())
             return os << "(" << value << ")";
 
@@ -1038,7 +1038,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             return os << "(" << value << ")";
 
-        auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
         if (pos == metadata->end())
             return os << "(" << value << ")";
 
@@ -1140,7 +1140,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             return os << "(" << value << ")";
 
-        auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
         if (pos == metadata->end())
             return os << "(" << value << ")";
 
@@ -1172,7 +1172,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             return os << "(" << value << ")";
 
-        auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
         if (pos == metadata->end())
             return os << "(" << value << ")";
 
@@ -1219,7 +1219,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             return os << "(" << value << ")";
 
-        auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
         if (pos == metadata->end())
             return os << "(" << value << ")";
 
@@ -1240,7 +1240,7 @@ namespace Exiv2 {
         if (value.count() != 1)
             return os << "(" << value << ")";
 
-        auto pos = metadata->findKey(ExifKey("Exif.Image.Model"));
+        auto pos = ExifPrintContext::findKey(*metadata, "Exif.Image.Model");
         if (pos == metadata->end())
             return os << "(" << value << ")";
 
@@ -1368,11 +1368,13 @@ namespace Exiv2 {
         return b;
     }
 
-    DataBuf sonyTagDecipher(uint16_t tag, const byte* bytes, uint32_t size, TiffComponent* const object)
+    DataBuf sonyTagDecipher(uint16_t tag, const byte* bytes, uint32_t size, TiffComponent* const object,
+                            const TiffCameraInfo& /*camera*/)
     {
         return sonyTagCipher(tag,bytes,size,object,true);
     }
-    DataBuf sonyTagEncipher(uint16_t tag, const byte* bytes, uint32_t size, TiffComponent* const object)
+    DataBuf sonyTagEncipher(uint16_t tag, const byte* bytes, uint32_t size, TiffComponent* const object,
+                            const TiffCameraInfo& /*camera*/)
     {
         return sonyTagCipher(tag,bytes,size,object,false);
     }
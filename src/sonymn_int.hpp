@@ -103,8 +103,8 @@ namespace Exiv2 {
 
     }; // class SonyMakerNote
 
-    DataBuf sonyTagDecipher(uint16_t, const byte*, uint32_t, TiffComponent* const);
-    DataBuf sonyTagEncipher(uint16_t, const byte*, uint32_t, TiffComponent* const);
+    DataBuf sonyTagDecipher(uint16_t, const byte*, uint32_t, TiffComponent* const, const TiffCameraInfo&);
+    DataBuf sonyTagEncipher(uint16_t, const byte*, uint32_t, TiffComponent* const, const TiffCameraInfo&);
 
 }}                                      // namespace Internal, Exiv2
 
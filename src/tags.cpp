@@ -222,6 +222,10 @@ namespace Exiv2 {
         //@{
         //! Return the name of the tag
         std::string tagName() const;
+        //! Return the group name
+        std::string groupName() const;
+        //! Return the key, made from the tag and group if it was not set
+        std::string key() const;
         //@}
 
         // DATA
@@ -231,8 +235,8 @@ namespace Exiv2 {
         uint16_t tag_{0};               //!< Tag value
         IfdId ifdId_{ifdIdNotSet};      //!< The IFD associated with this tag
         int idx_{0};                    //!< Unique id of the Exif key in the image
-        std::string groupName_;         //!< The group name
-        std::string key_;               //!< %Key
+        std::string groupName_;         //!< The group name, empty if not set
+        std::string key_;               //!< %Key, empty if not set
     };
 
     std::string ExifKey::Impl::tagName() const
@@ -246,6 +250,23 @@ namespace Exiv2 {
         return os.str();
     }
 
+    std::string ExifKey::Impl::groupName() const
+    {
+        if (groupName_.empty()) {
+            return Internal::groupName(ifdId_);
+        }
+        return groupName_;
+    }
+
+    std::string ExifKey::Impl::key() const
+    {
+        // Not cached: a const key must be safe to read from several threads
+        if (key_.empty()) {
+            return std::string(familyName_) + "." + groupName() + "." + tagName();
+        }
+        return key_;
+    }
+
     void ExifKey::Impl::decomposeKey(const std::string& key)
     {
         // Get the family name, IFD name and tag name parts of the key
@@ -272,7 +293,7 @@ namespace Exiv2 {
         // Convert tag
         uint16_t tag = tagNumber(tn, ifdId);
         // Get tag info
-        tagInfo_ = tagInfo(tag, ifdId);
+        tagInfo_ = Internal::tagInfo(tag, ifdId);
         if (tagInfo_ == nullptr)
             throw Error(kerInvalidKey, key);
 
@@ -301,7 +322,7 @@ namespace Exiv2 {
         if (!Internal::isExifIfd(ifdId) && !Internal::isMakerIfd(ifdId)) {
             throw Error(kerInvalidIfdId, ifdId);
         }
-        const TagInfo* ti = tagInfo(tag, ifdId);
+        const TagInfo* ti = Internal::tagInfo(tag, ifdId);
         if (ti == nullptr) {
             throw Error(kerInvalidIfdId, ifdId);
         }
@@ -320,6 +341,24 @@ namespace Exiv2 {
         p_->makeKey(ti.tag_, ifdId, &ti);
     }
 
+    ExifKey::ExifKey(uint16_t tag, int ifdId, const TagInfo* tagInfo)
+        : p_(new Impl)
+    {
+        auto id = static_cast<IfdId>(ifdId);
+        if (!Internal::isExifIfd(id) && !Internal::isMakerIfd(id)) {
+            throw Error(kerInvalidIfdId, id);
+        }
+        if (tagInfo == nullptr) {
+            tagInfo = Internal::tagInfo(tag, id);
+            if (tagInfo == nullptr) {
+                throw Error(kerInvalidIfdId, id);
+            }
+        }
+        p_->tagInfo_ = tagInfo;
+        p_->tag_ = tag;
+        p_->ifdId_ = id;
+    }
+
     ExifKey::ExifKey(const std::string& key)
         : p_(new Impl)
     {
@@ -348,7 +387,7 @@ namespace Exiv2 {
 
     std::string ExifKey::key() const
     {
-        return p_->key_;
+        return p_->key();
     }
 
     const char* ExifKey::familyName() const
@@ -358,7 +397,7 @@ namespace Exiv2 {
 
     std::string ExifKey::groupName() const
     {
-        return p_->groupName_;
+        return p_->groupName();
     }
 
     std::string ExifKey::tagName() const
@@ -392,6 +431,11 @@ namespace Exiv2 {
         return p_->tag_;
     }
 
+    const TagInfo* ExifKey::tagInfo() const
+    {
+        return p_->tagInfo_;
+    }
+
     ExifKey::UniquePtr ExifKey::clone() const
     {
         return UniquePtr(clone_());
@@ -27,9 +27,11 @@
 #include "value.hpp"
 
 // + standard includes
+#include <array>
 #include <string>
 #include <iostream>
 #include <memory>
+#include <utility>
 
 // *****************************************************************************
 // namespace extensions
@@ -262,6 +264,93 @@ namespace Exiv2 {
         bool operator==(const std::string& key) const;
     }; // struct TagDetails
 
+    /*!
+      @brief Return the positions of the entries of \em array, sorted by value.
+             Entries with the same value keep their order in the table. This is
+             a stable merge sort, to be evaluated at compile time.
+     */
+    template <int N>
+    constexpr std::array<uint16_t, N> sortTagDetails(const TagDetails (&array)[N])
+    {
+        static_assert(N <= 0xffff, "TagDetails table too large to index");
+        std::array<uint16_t, N> index{};
+        std::array<uint16_t, N> merged{};
+        for (int i = 0; i < N; ++i) {
+            index[i] = static_cast<uint16_t>(i);
+        }
+        for (int width = 1; width < N; width *= 2) {
+            for (int lo = 0; lo < N; lo += 2 * width) {
+                const int mid = lo + width < N ? lo + width : N;
+                const int hi = lo + 2 * width < N ? lo + 2 * width : N;
+                int l = lo;
+                int r = mid;
+                for (int k = lo; k < hi; ++k) {
+                    if (l < mid && (r == hi || array[index[r]].val_ >= array[index[l]].val_)) {
+                        merged[k] = index[l++];
+                    }
+                    else {
+                        merged[k] = index[r++];
+                    }
+                }
+            }
+            for (int i = 0; i < N; ++i) {
+                index[i] = merged[i];
+            }
+        }
+        return index;
+    }
+
+    /*!
+      @brief Lookup of the entries of a TagDetails table by value, with a
+             binary search over an index sorted at compile time. The tables
+             themselves stay in their documented order.
+     */
+    template <int N, const TagDetails (&array)[N]>
+    struct TagDetailsIndex {
+        //! Positions of the table entries, sorted by value
+        static constexpr std::array<uint16_t, N> index_ = sortTagDetails(array);
+
+        //! Return the position in index_ of the first entry with a value not less than \em value
+        static int lowerBound(int64_t value)
+        {
+            int lo = 0;
+            int hi = N;
+            while (lo < hi) {
+                const int mid = lo + (hi - lo) / 2;
+                if (array[index_[mid]].val_ < value) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+
+        //! Return the first entry of the table with value \em value, like find(), or 0
+        static const TagDetails* find(int64_t value)
+        {
+            const int pos = lowerBound(value);
+            if (pos == N || array[index_[pos]].val_ != value) return nullptr;
+            return &array[index_[pos]];
+        }
+
+        /*!
+          @brief Return the range of positions in the table of the entries with
+                 value \em value, in the order of the table
+         */
+        static std::pair<const uint16_t*, const uint16_t*> equalRange(int64_t value)
+        {
+            int last = lowerBound(value);
+            const int first = last;
+            while (last < N && array[index_[last]].val_ == value) ++last;
+            return {index_.data() + first, index_.data() + last};
+        }
+    };
+
+//! Shortcut for the TagDetailsIndex template which requires typing the array name only once.
+#define EXV_TAG_DETAILS_INDEX(array) TagDetailsIndex<EXV_COUNTOF(array), array>
+
     /*!
       @brief Generic pretty-print function to translate a long value to a description
              by looking up a reference table.
@@ -269,7 +358,7 @@ namespace Exiv2 {
     template <int N, const TagDetails (&array)[N]>
     std::ostream& printTag(std::ostream& os, const long& value, const ExifData*)
     {
-        const TagDetails* td = find(array, value);
+        const TagDetails* td = TagDetailsIndex<N, array>::find(value);
         if (td) {
             os << exvGettext(td->label_);
         }
@@ -27,6 +27,7 @@
 #include "makernote_int.hpp"
 #include "sonymn_int.hpp"
 #include "value.hpp"
+#include "basicio.hpp"
 #include "error.hpp"
 #include "enforce.hpp"
 
@@ -36,6 +37,7 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <limits>
 
 // *****************************************************************************
 namespace {
@@ -48,6 +50,89 @@ namespace {
 namespace Exiv2 {
     namespace Internal {
 
+    TiffSource::TiffSource(const byte* pData, uint32_t size)
+        : pData_(pData), size_(size), io_(nullptr)
+    {
+    }
+
+    TiffSource::TiffSource(BasicIo& io)
+        : pData_(nullptr),
+          size_(static_cast<uint32_t>(std::min<size_t>(io.size(), std::numeric_limits<uint32_t>::max()))),
+          io_(&io)
+    {
+        // Data in memory doesn't need to be copied, use it directly
+        if (dynamic_cast<MemIo*>(&io) != nullptr) {
+            pData_ = io.mmap();
+            io_ = nullptr;
+        }
+    }
+
+    const byte* TiffSource::data(uint32_t offset, uint32_t count)
+    {
+        if (offset > size_ || count > size_ - offset) return nullptr;
+        if (io_ == nullptr) return pData_ == nullptr ? nullptr : pData_ + offset;
+        if (size_ == 0) return nullptr;
+
+        // The end of the data is addressed through the last window
+        const uint32_t first = (offset < size_ ? offset : offset - 1) / windowSize_;
+        const uint32_t last = count == 0 ? first : (offset + count - 1) / windowSize_;
+        if (first != last) {
+            // The range spans windows, read it into a buffer of its own
+            return read(offset, count);
+        }
+        auto pos = windows_.find(first);
+        if (pos == windows_.end()) {
+            const uint32_t start = first * windowSize_;
+            pos = windows_.emplace(first, read(start, std::min(windowSize_, size_ - start))).first;
+        }
+        return pos->second + (offset - first * windowSize_);
+    }
+
+    const byte* TiffSource::read(uint32_t offset, uint32_t count)
+    {
+        Chunk chunk{offset, DataBuf(static_cast<long>(count))};
+        if (io_->readAt(offset, chunk.buf_.data(), static_cast<long>(count)) != static_cast<long>(count)) {
+            throw Error(kerFailedToReadImageData);
+        }
+        const byte* p = chunk.buf_.c_data();
+        chunks_.emplace(p, std::move(chunk));
+        return p;
+    }
+
+    const TiffSource::Chunk* TiffSource::chunk(const byte* p) const
+    {
+        auto pos = chunks_.upper_bound(p);
+        if (pos == chunks_.begin()) return nullptr;
+        --pos;
+        const auto distance = reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(pos->first);
+        if (distance > static_cast<uintptr_t>(pos->second.buf_.size())) return nullptr;
+        return &pos->second;
+    }
+
+    bool TiffSource::offset(const byte* p, uint32_t& offset) const
+    {
+        if (pData_ != nullptr) {
+            if (p < pData_ || p > pData_ + size_) return false;
+            offset = static_cast<uint32_t>(p - pData_);
+            return true;
+        }
+        const Chunk* c = chunk(p);
+        if (c == nullptr) return false;
+        offset = c->offset_ + static_cast<uint32_t>(p - c->buf_.c_data());
+        return true;
+    }
+
+    uint32_t TiffSource::available(const byte* p) const
+    {
+        if (pData_ != nullptr) {
+            if (p < pData_ || p > pData_ + size_) return 0;
+            return static_cast<uint32_t>(pData_ + size_ - p);
+        }
+        const Chunk* c = chunk(p);
+        if (c == nullptr) return 0;
+        return static_cast<uint32_t>(c->buf_.c_data() + c->buf_.size() - p);
+    }
+
     bool TiffMappingInfo::operator==(const TiffMappingInfo::Key& key) const
     {
         return    (   0 == strcmp("*", make_)
@@ -356,8 +441,7 @@ namespace Exiv2 {
     } // TiffEntryBase::setValue
 
     void TiffDataEntry::setStrips(const Value* pSize,
-                                  const byte*  pData,
-                                  uint32_t     sizeData,
+                                  TiffSource&  source,
                                   uint32_t     baseOffset)
     {
         if (!pValue() || !pSize) {
@@ -406,6 +490,7 @@ namespace Exiv2 {
 #endif
             return;
         }
+        const uint32_t sizeData = source.size();
         if (   offset > sizeData
             || size > sizeData
             || baseOffset + offset > sizeData - size) {
@@ -417,14 +502,13 @@ namespace Exiv2 {
 #endif
             return;
         }
-        pDataArea_ = const_cast<byte*>(pData) + baseOffset + offset;
+        pDataArea_ = const_cast<byte*>(source.data(baseOffset + offset, size));
         sizeDataArea_ = size;
         const_cast<Value*>(pValue())->setDataArea(pDataArea_, sizeDataArea_);
     } // TiffDataEntry::setStrips
 
     void TiffImageEntry::setStrips(const Value* pSize,
-                                   const byte*  pData,
-                                   uint32_t     sizeData,
+                                   TiffSource&  source,
                                    uint32_t     baseOffset)
     {
         if (!pValue() || !pSize) {
@@ -446,9 +530,12 @@ namespace Exiv2 {
 #endif
             return;
         }
+        // The strips are only needed to write the image. They are not read from
+        // a windowed source, which is only used to decode the metadata.
+        const byte* pData = source.buffer();
+        const uint32_t sizeData = source.size();
         for (long i = 0; i < pValue()->count(); ++i) {
             const auto offset = static_cast<uint32_t>(pValue()->toLong(i));
-            const byte* pStrip = pData + baseOffset + offset;
             const auto size = static_cast<uint32_t>(pSize->toLong(i));
 
             if (   offset > sizeData
@@ -462,8 +549,8 @@ namespace Exiv2 {
                             << " is outside of the data area; ignored.\n";
 #endif
             }
-            else if (size != 0) {
-                strips_.emplace_back(pStrip, size);
+            else if (size != 0 && pData != nullptr) {
+                strips_.emplace_back(pData + baseOffset + offset, size);
             }
         }
     } // TiffImageEntry::setStrips
@@ -541,12 +628,12 @@ namespace Exiv2 {
         return false;
     }
 
-    bool TiffBinaryArray::initialize(TiffComponent* const pRoot)
+    bool TiffBinaryArray::initialize(TiffComponent* const pRoot, const TiffCameraInfo& camera)
     {
         if (cfgSelFct_ == nullptr)
             return true;  // Not a complex array
 
-        int idx = cfgSelFct_(tag(), pData(), TiffEntryBase::doSize(), pRoot);
+        int idx = cfgSelFct_(tag(), pData(), TiffEntryBase::doSize(), pRoot, camera);
         if (idx > -1) {
             arrayCfg_ = &arraySet_[idx].cfg_;
             arrayDef_ = arraySet_[idx].def_;
@@ -1407,7 +1494,7 @@ namespace Exiv2 {
             if ( cryptFct == sonyTagDecipher ) {
                  cryptFct  = sonyTagEncipher;
             }
-            DataBuf buf = cryptFct(tag(), mio.mmap(), static_cast<uint32_t>(mio.size()), pRoot_);
+            DataBuf buf = cryptFct(tag(), mio.mmap(), static_cast<uint32_t>(mio.size()), pRoot_, findCameraInfo(pRoot_));
             if (    buf.size()) {
                 mio.seek(0,Exiv2::FileIo::beg);
                 mio.write(buf.c_data(), buf.size());
@@ -28,6 +28,7 @@
 
 // + standard includes
 #include <iosfwd>
+#include <map>
 #include <memory>
 #include <vector>
 #include <string>
@@ -81,6 +82,80 @@ namespace Exiv2 {
         const uint32_t cmt4      = 0x130000; //!< Special tag: root IFD of CR3 images
     }
 
+    /*!
+      @brief The data TiffReader reads a TIFF structure from. Either a buffer
+             with all the data, or a BasicIo which is read in windows, as the
+             IFDs and values are visited.
+
+      Offsets are relative to the start of the data, i.e., to the TIFF header.
+      All pointers returned by the source remain valid as long as the source
+      exists. Windowed reads do not keep the buffers of different windows
+      adjacent, so a pointer must not be used beyond the bytes that were
+      requested with it, see available().
+     */
+    class TiffSource {
+    public:
+        //! @name Creators
+        //@{
+        //! Constructor for the data in the buffer \em pData of \em size bytes.
+        TiffSource(const byte* pData, uint32_t size);
+        /*!
+          @brief Constructor for the data of \em io, which must be open. Data
+                 held in memory (MemIo) is accessed directly, otherwise windows
+                 of the data are read from \em io as they are needed.
+         */
+        explicit TiffSource(BasicIo& io);
+        //@}
+
+        //! @name Manipulators
+        //@{
+        /*!
+          @brief Return a pointer to \em count contiguous bytes at \em offset.
+                 A \em count of 0 is allowed and returns a pointer to the
+                 position, which may be the end of the data.
+          @return Pointer to the data, 0 if the range lies outside of the data.
+          @throw Error if reading the data fails.
+         */
+        const byte* data(uint32_t offset, uint32_t count);
+        //@}
+
+        //! @name Accessors
+        //@{
+        //! Return the size of the data.
+        uint32_t size() const { return size_; }
+        //! Return the buffer with all the data, 0 if the data is read in windows.
+        const byte* buffer() const { return pData_; }
+        /*!
+          @brief Determine the \em offset of \em p, a pointer obtained from
+                 this source.
+          @return true if \em p points into the data, else false.
+         */
+        bool offset(const byte* p, uint32_t& offset) const;
+        //! Return the number of contiguous bytes from \em p on, 0 if \em p is not from this source.
+        uint32_t available(const byte* p) const;
+        //@}
+
+    private:
+        //! A buffer with data read from the BasicIo
+        struct Chunk {
+            uint32_t offset_;  //!< Offset of the data
+            DataBuf buf_;      //!< The data
+        };
+        //! Return the chunk \em p points into, including the end of the chunk, 0 if none.
+        const Chunk* chunk(const byte* p) const;
+        //! Read \em count bytes at \em offset into a new chunk and return its data
+        const byte* read(uint32_t offset, uint32_t count);
+
+        // DATA
+        static constexpr uint32_t windowSize_ = 64 * 1024; //!< Size of the windows read from the BasicIo
+
+        const byte* pData_;                        //!< All the data, if it is in memory
+        uint32_t size_;                            //!< Size of the data
+        BasicIo* io_;                              //!< BasicIo the data is read from otherwise
+        std::map<uint32_t, const byte*> windows_;  //!< Windows read, by their index
+        std::map<const byte*, Chunk> chunks_;      //!< All buffers read, by the start of their data
+    }; // class TiffSource
+
     /*!
       @brief A tupel consisting of extended Tag and group used as an item in
              TIFF paths.
@@ -414,6 +489,7 @@ namespace Exiv2 {
     class TiffEntryBase : public TiffComponent {
         friend class TiffReader;
         friend class TiffEncoder;
+        friend class TiffRebaser;
         friend int selectNikonLd(TiffBinaryArray* const, TiffComponent* const);
     public:
         //! @name Creators
@@ -638,13 +714,11 @@ namespace Exiv2 {
 
           @param pSize Pointer to the Value holding the sizes corresponding
                        to this data entry.
-          @param pData Pointer to the data area.
-          @param sizeData Size of the data area.
-          @param baseOffset Base offset into the data area.
+          @param source The data the TIFF structure is read from.
+          @param baseOffset Base offset into the data.
          */
         virtual void setStrips(const Value* pSize,
-                               const byte*  pData,
-                               uint32_t     sizeData,
+                               TiffSource&  source,
                                uint32_t     baseOffset) =0;
         //@}
 
@@ -676,6 +750,7 @@ namespace Exiv2 {
      */
     class TiffDataEntry : public TiffDataEntryBase {
         friend class TiffEncoder;
+        friend class TiffRebaser;
     public:
         //! @name Creators
         //@{
@@ -689,7 +764,7 @@ namespace Exiv2 {
 
         //! @name Manipulators
         //@{
-        void setStrips(const Value* pSize, const byte* pData, uint32_t sizeData, uint32_t baseOffset) override;
+        void setStrips(const Value* pSize, TiffSource& source, uint32_t baseOffset) override;
         //@}
 
     protected:
@@ -749,6 +824,7 @@ namespace Exiv2 {
      */
     class TiffImageEntry : public TiffDataEntryBase {
         friend class TiffEncoder;
+        friend class TiffRebaser;
     public:
         //! @name Creators
         //@{
@@ -761,7 +837,7 @@ namespace Exiv2 {
 
         //! @name Manipulators
         //@{
-        void setStrips(const Value* pSize, const byte* pData, uint32_t sizeData, uint32_t baseOffset) override;
+        void setStrips(const Value* pSize, TiffSource& source, uint32_t baseOffset) override;
         //@}
 
     protected:
@@ -1266,14 +1342,27 @@ namespace Exiv2 {
 
     }; // class TiffIfdMakernote
 
+    /*!
+      @brief Camera model and Nikon encryption key of the image. They are
+             looked up once per read or write of the TIFF tree and passed to
+             the functions which select the cfg + def of complex binary arrays
+             and to the crypt functions.
+     */
+    struct TiffCameraInfo {
+        std::string model_;           //!< Value of tag 0x0110 in IFD0, empty if not found
+        bool        nikonKey_{false}; //!< True if both Nikon3 tags below were found
+        uint32_t    shutterCount_{0}; //!< Value of Exif.Nikon3.ShutterCount
+        std::string serialNumber_;    //!< Value of Exif.Nikon3.SerialNumber
+    };
+
     /*!
       @brief Function pointer type for a function to determine which cfg + def
              of a corresponding array set to use.
      */
-    using CfgSelFct = int (*)(uint16_t, const byte*, uint32_t, TiffComponent* const);
+    using CfgSelFct = int (*)(uint16_t, const byte*, uint32_t, TiffComponent* const, const TiffCameraInfo&);
 
     //! Function pointer type for a crypt function used for binary arrays.
-    using CryptFct = DataBuf (*)(uint16_t, const byte*, uint32_t, TiffComponent* const);
+    using CryptFct = DataBuf (*)(uint16_t, const byte*, uint32_t, TiffComponent* const, const TiffCameraInfo&);
 
     //! Defines one tag in a binary array
     struct ArrayDef {
@@ -1318,6 +1407,7 @@ namespace Exiv2 {
              component are of type TiffBinaryElement.
      */
     class TiffBinaryArray : public TiffEntryBase {
+        friend class TiffRebaser;
     public:
         //! @name Creators
         //@{
@@ -1361,9 +1451,10 @@ namespace Exiv2 {
           calls cfgSelFct_ to determine the correct settings.
 
           @param pRoot Pointer to the root component of the TIFF tree.
+          @param camera Camera model of the TIFF tree.
           @return true if the initialization succeeded, else false.
          */
-        bool initialize(TiffComponent* const pRoot);
+        bool initialize(TiffComponent* const pRoot, const TiffCameraInfo& camera);
         //! Initialize the original data buffer and its size from the base entry.
         void iniOrigDataBuf();
         //! Update the original data buffer and its size, return true if successful.
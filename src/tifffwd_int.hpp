@@ -58,9 +58,11 @@ namespace Exiv2 {
     class TiffDecoder;
     class TiffEncoder;
     class TiffReader;
+    class TiffSource;
 
     class TiffRwState;
     class TiffPathItem;
+    struct TiffCameraInfo;
     struct TiffMappingInfo;
 
     class IoWrapper;
@@ -37,11 +37,15 @@
 #include "i18n.h"                // NLS support.
 
 // + standard includes
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <iomanip>
 #include <cassert>
 #include <cstdarg>
+#include <filesystem>
+
+namespace fs = std::filesystem;
 
 /* --------------------------------------------------------------------------
 
@@ -61,6 +65,49 @@
 
    -------------------------------------------------------------------------- */
 
+// *****************************************************************************
+namespace {
+    using namespace Exiv2;
+    using namespace Exiv2::Internal;
+
+    //! Implementation of TiffParser::encode(), reusing \em parsedTree if provided
+    WriteMethod encodeTiff(
+              BasicIo&  io,
+        const byte*     pData,
+              uint32_t  size,
+              ByteOrder byteOrder,
+        const ExifData& exifData,
+        const IptcData& iptcData,
+        const XmpData&  xmpData,
+              TiffComponent::UniquePtr parsedTree
+    )
+    {
+        // Delete IFDs which do not occur in TIFF images. Copy the Exif data
+        // to be able to modify it, but only if there is anything to delete.
+        static const IfdId filteredIfds[] = {
+            panaRawId
+        };
+        ExifData filtered;
+        const ExifData* ed = &exifData;
+        for (auto&& filteredIfd : filteredIfds) {
+            if (std::none_of(ed->begin(), ed->end(), FindExifdatum(filteredIfd))) continue;
+#ifdef EXIV2_DEBUG_MESSAGES
+            std::cerr << "Warning: Exif IFD " << filteredIfd << " not encoded\n";
+#endif
+            if (ed != &filtered) {
+                filtered = exifData;
+                ed = &filtered;
+            }
+            filtered.erase(std::remove_if(filtered.begin(), filtered.end(), FindExifdatum(filteredIfd)),
+                           filtered.end());
+        }
+
+        std::unique_ptr<TiffHeaderBase> header(new TiffHeader(byteOrder));
+        return TiffParserWorker::encode(io, pData, size, *ed, iptcData, xmpData, Tag::root, TiffMapping::findEncoder,
+                                        header.get(), nullptr, std::move(parsedTree));
+    }
+}  // namespace
+
 // *****************************************************************************
 // class member definitions
 namespace Exiv2 {
@@ -71,9 +118,18 @@ namespace Exiv2 {
         : Image(ImageType::tiff, mdExif | mdIptc | mdXmp, std::move(io))
         , pixelWidthPrimary_(0)
         , pixelHeightPrimary_(0)
+        , retainParsedTree_(false)
     {
     }  // TiffImage::TiffImage
 
+    TiffImage::~TiffImage() = default;
+
+    void TiffImage::retainParsedTree(bool retain)
+    {
+        retainParsedTree_ = retain;
+        if (!retain) parsedTree_.reset();
+    }
+
     //! Structure for TIFF compression to MIME type mappings
     struct MimeTypeList {
         //! Comparison operator for compression
@@ -185,9 +241,26 @@ namespace Exiv2 {
             throw Error(kerNotAnImage, "TIFF");
         }
         clearMetadata();
-
-        ByteOrder bo =
-            TiffParser::decode(exifData_, iptcData_, xmpData_, io_->mmap(), static_cast<uint32_t>(io_->size()));
+        parsedTree_.reset();
+
+        ByteOrder bo = invalidByteOrder;
+        fs::file_time_type mtime;
+        if (retainParsedTree_ && lastWriteTime(*io_, mtime)) {
+            // The retained tree points into the data, so all of it is mapped
+            const byte* pData = io_->mmap();
+            const auto size = static_cast<uint32_t>(io_->size());
+            // The metadata was cleared above, so the root is always Tag::root
+            TiffComponent::UniquePtr rootDir;
+            bo = TiffParserWorker::decode(exifData_, iptcData_, xmpData_, pData, size, Tag::root,
+                                          TiffMapping::findDecoder, nullptr, &rootDir);
+            if (rootDir) {
+                parsedTree_ = std::make_unique<TiffParsedTree>(std::move(rootDir), pData, size, mtime);
+            }
+        }
+        else {
+            // The metadata was cleared above, so the root is always Tag::root
+            bo = TiffParserWorker::decode(exifData_, iptcData_, xmpData_, *io_, Tag::root, TiffMapping::findDecoder);
+        }
         setByteOrder(bo);
 
         // read profile from the metadata
@@ -201,7 +274,7 @@ namespace Exiv2 {
             iccProfile_.alloc(size);
             pos->copy(iccProfile_.data(),bo);
         }
-
+        setMetadataClean();
     }
 
     void TiffImage::writeMetadata()
@@ -209,15 +282,29 @@ namespace Exiv2 {
 #ifdef EXIV2_DEBUG_MESSAGES
         std::cerr << "Writing TIFF file " << io_->path() << "\n";
 #endif
+        // Nothing to do if the metadata did not change, the tree kept by readMetadata() stays valid
+        const int changed = changedMetadata();
+        if (changed == mdNone) {
+            setWrittenMetadata(mdNone);
+            return;
+        }
         ByteOrder bo = byteOrder();
         byte* pData = nullptr;
         long size = 0;
+        // The tree kept by readMetadata() can only be used once
+        auto kept = std::move(parsedTree_);
+        TiffComponent::UniquePtr parsedTree;
+        fs::file_time_type mtime;
+        const bool haveMtime = kept && lastWriteTime(*io_, mtime);
         IoCloser closer(*io_);
         if (io_->open() == 0) {
             // Ensure that this is the correct image type
             if (isTiffType(*io_, false)) {
                 pData = io_->mmap(true);
                 size = static_cast<long>(io_->size());
+                if (haveMtime) {
+                    parsedTree = kept->take(pData, static_cast<uint32_t>(size), mtime);
+                }
                 TiffHeader tiffHeader;
                 if (0 == tiffHeader.read(pData, 8)) {
                     bo = tiffHeader.byteOrder();
@@ -242,9 +329,11 @@ namespace Exiv2 {
         }
 
         // set usePacket to influence TiffEncoder::encodeXmp() called by TiffVisitor.encode()
-        xmpData().usePacket(writeXmpFromPacket());
+        xmpData_.usePacket(writeXmpFromPacket());
 
-        TiffParser::encode(*io_, pData, size, bo, exifData_, iptcData_, xmpData_); // may throw
+        encodeTiff(*io_, pData, size, bo, exifData_, iptcData_, xmpData_, std::move(parsedTree)); // may throw
+        setWrittenMetadata(changed);
+        setMetadataClean();
     } // TiffImage::writeMetadata
 
     ByteOrder TiffParser::decode(
@@ -284,23 +373,7 @@ namespace Exiv2 {
         const XmpData&  xmpData
     )
     {
-        // Copy to be able to modify the Exif data
-        ExifData ed = exifData;
-
-        // Delete IFDs which do not occur in TIFF images
-        static const IfdId filteredIfds[] = {
-            panaRawId
-        };
-        for (auto&& filteredIfd : filteredIfds) {
-#ifdef EXIV2_DEBUG_MESSAGES
-            std::cerr << "Warning: Exif IFD " << filteredIfd << " not encoded\n";
-#endif
-            ed.erase(std::remove_if(ed.begin(), ed.end(), FindExifdatum(filteredIfd)), ed.end());
-        }
-
-        std::unique_ptr<TiffHeaderBase> header(new TiffHeader(byteOrder));
-        return TiffParserWorker::encode(io, pData, size, ed, iptcData, xmpData, Tag::root, TiffMapping::findEncoder,
-                                        header.get(), nullptr);
+        return encodeTiff(io, pData, size, byteOrder, exifData, iptcData, xmpData, nullptr);
     } // TiffParser::encode
 
     // *************************************************************************
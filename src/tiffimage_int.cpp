@@ -1884,8 +1884,41 @@ namespace Exiv2 {
               uint32_t           size,
               uint32_t           root,
               FindDecoderFct     findDecoderFct,
+              TiffHeaderBase*    pHeader,
+              TiffComponent::UniquePtr* pParsedTree
+    )
+    {
+        TiffSource source(pData, size);
+        return decode(exifData, iptcData, xmpData, source, root, findDecoderFct, pHeader, pParsedTree);
+
+    } // TiffParserWorker::decode
+
+    ByteOrder TiffParserWorker::decode(
+              ExifData&          exifData,
+              IptcData&          iptcData,
+              XmpData&           xmpData,
+              BasicIo&           io,
+              uint32_t           root,
+              FindDecoderFct     findDecoderFct,
               TiffHeaderBase*    pHeader
     )
+    {
+        // The tree points into the windows read by the source, it can't outlive it
+        TiffSource source(io);
+        return decode(exifData, iptcData, xmpData, source, root, findDecoderFct, pHeader, nullptr);
+
+    } // TiffParserWorker::decode
+
+    ByteOrder TiffParserWorker::decode(
+              ExifData&          exifData,
+              IptcData&          iptcData,
+              XmpData&           xmpData,
+              TiffSource&        source,
+              uint32_t           root,
+              FindDecoderFct     findDecoderFct,
+              TiffHeaderBase*    pHeader,
+              TiffComponent::UniquePtr* pParsedTree
+    )
     {
         // Create standard TIFF header if necessary
         std::unique_ptr<TiffHeaderBase> ph;
@@ -1894,7 +1927,7 @@ namespace Exiv2 {
             pHeader = ph.get();
         }
 
-        auto rootDir = parse(pData, size, root, pHeader);
+        auto rootDir = parse(source, root, pHeader);
         if (nullptr != rootDir.get()) {
             TiffDecoder decoder(exifData,
                                 iptcData,
@@ -1903,6 +1936,7 @@ namespace Exiv2 {
                                 findDecoderFct);
             rootDir->accept(decoder);
         }
+        if (pParsedTree) *pParsedTree = std::move(rootDir);
         return pHeader->byteOrder();
 
     } // TiffParserWorker::decode
@@ -1917,7 +1951,8 @@ namespace Exiv2 {
               uint32_t           root,
               FindEncoderFct     findEncoderFct,
               TiffHeaderBase*    pHeader,
-              OffsetWriter*      pOffsetWriter
+              OffsetWriter*      pOffsetWriter,
+              TiffComponent::UniquePtr parsedTree
     )
     {
         /*
@@ -1930,7 +1965,15 @@ namespace Exiv2 {
         assert(pHeader);
         assert(pHeader->byteOrder() != invalidByteOrder);
         WriteMethod writeMethod = wmIntrusive;
-        auto parsedTree = parse(pData, size, root, pHeader);
+        if (parsedTree) {
+            // The tree is already there, only the header needs to be read
+            if (!pHeader->read(pData, size) || pHeader->offset() >= size) {
+                throw Error(kerNotAnImage, "TIFF");
+            }
+        }
+        else {
+            parsedTree = parse(pData, size, root, pHeader);
+        }
         PrimaryGroups primaryGroups;
         findPrimaryGroups(primaryGroups, parsedTree.get());
         if (nullptr != parsedTree.get()) {
@@ -1959,7 +2002,7 @@ namespace Exiv2 {
             encoder.add(createdTree.get(), parsedTree.get(), root);
             // Write binary representation from the composite tree
             DataBuf header = pHeader->write();
-            auto tempIo = std::make_unique<MemIo>();
+            auto tempIo = std::make_unique<TempIo>(io);
             assert(tempIo.get() != 0);
             IoWrapper ioWrapper(*tempIo, header.c_data(), header.size(), pOffsetWriter);
             auto imageIdx(uint32_t(-1));
@@ -1990,16 +2033,30 @@ namespace Exiv2 {
               TiffHeaderBase*    pHeader
     )
     {
+        TiffSource source(pData, size);
+        return parse(source, root, pHeader);
+
+    } // TiffParserWorker::parse
+
+    TiffComponent::UniquePtr TiffParserWorker::parse(
+              TiffSource&        source,
+              uint32_t           root,
+              TiffHeaderBase*    pHeader
+    )
+    {
+        const byte* pData = source.data(0, 0);
+        const uint32_t size = source.size();
         if (pData == nullptr || size == 0)
             return nullptr;
-        if (!pHeader->read(pData, size) || pHeader->offset() >= size) {
+        // All the data if it is in memory, else at least the first window
+        if (!pHeader->read(pData, source.available(pData)) || pHeader->offset() >= size) {
             throw Error(kerNotAnImage, "TIFF");
         }
         auto rootDir = TiffCreator::create(root, ifdIdNotSet);
         if (rootDir) {
-            rootDir->setStart(pData + pHeader->offset());
+            rootDir->setStart(source.data(pHeader->offset(), 0));
             TiffRwState state(pHeader->byteOrder(), 0);
-            TiffReader reader(pData, size, rootDir.get(), state);
+            TiffReader reader(source, rootDir.get(), state);
             rootDir->accept(reader);
             reader.postProcess();
         }
@@ -2007,6 +2064,24 @@ namespace Exiv2 {
 
     } // TiffParserWorker::parse
 
+    TiffParsedTree::TiffParsedTree(TiffComponent::UniquePtr rootDir,
+                                   const byte* pData,
+                                   uint32_t size,
+                                   std::filesystem::file_time_type mtime)
+        : rootDir_(std::move(rootDir)), pData_(pData), size_(size), mtime_(mtime)
+    {
+    }
+
+    TiffComponent::UniquePtr TiffParsedTree::take(byte* pData, uint32_t size, std::filesystem::file_time_type mtime)
+    {
+        if (!rootDir_ || pData == nullptr || size != size_ || mtime != mtime_) return nullptr;
+        if (pData != pData_) {
+            TiffRebaser rebaser(pData_, size_, pData);
+            rootDir_->accept(rebaser);
+        }
+        return std::move(rootDir_);
+    }
+
     void TiffParserWorker::findPrimaryGroups(PrimaryGroups& primaryGroups, TiffComponent* pSourceDir)
     {
         if (nullptr == pSourceDir)
@@ -29,6 +29,7 @@
 #include "types.hpp"
 
 // + standard includes
+#include <filesystem>
 #include <map>
 #include <utility>
 
@@ -289,6 +290,9 @@ namespace Exiv2 {
           @param findDecoderFct Function to access special decoding info.
           @param pHeader   Optional pointer to a TIFF header. If not provided,
                            a standard TIFF header is used.
+          @param pParsedTree Optional pointer which receives the parsed TIFF
+                           tree. The tree points into \em pData. If not
+                           provided, the tree is discarded.
 
           @return Byte order in which the data is encoded, invalidByteOrder if
                   decoding failed.
@@ -301,6 +305,26 @@ namespace Exiv2 {
                   uint32_t           size,
                   uint32_t           root,
                   FindDecoderFct     findDecoderFct,
+                  TiffHeaderBase*    pHeader =0,
+                  TiffComponent::UniquePtr* pParsedTree =0
+        );
+        /*!
+          @brief Decode TIFF metadata from the data of \em io, which must be
+                 open and start with the TIFF header, into the provided
+                 metadata containers.
+
+          Unlike the decode() function for a data buffer, this reads only the
+          IFDs and values from \em io, as they are visited, instead of the
+          whole data. The parsed TIFF tree is therefore not available.
+          See the other decode() function for the parameters.
+         */
+        static ByteOrder decode(
+                  ExifData&          exifData,
+                  IptcData&          iptcData,
+                  XmpData&           xmpData,
+                  BasicIo&           io,
+                  uint32_t           root,
+                  FindDecoderFct     findDecoderFct,
                   TiffHeaderBase*    pHeader =0
         );
         /*!
@@ -312,6 +336,9 @@ namespace Exiv2 {
           3) else, create a new tree and write a new TIFF structure ("intrusive
              writing"). If there is a parsed tree, it is only used to access the
              image data in this case.
+
+          If \em parsedTree is provided, it must have been parsed from
+          \em pData with the same \em root and step 1) is skipped.
          */
         static WriteMethod encode(
                   BasicIo&           io,
@@ -323,10 +350,22 @@ namespace Exiv2 {
                   uint32_t           root,
                   FindEncoderFct     findEncoderFct,
                   TiffHeaderBase*    pHeader,
-                  OffsetWriter*      pOffsetWriter
+                  OffsetWriter*      pOffsetWriter,
+                  TiffComponent::UniquePtr parsedTree =nullptr
         );
 
     private:
+        //! Decode TIFF metadata from \em source, see the public decode() functions.
+        static ByteOrder decode(
+                  ExifData&          exifData,
+                  IptcData&          iptcData,
+                  XmpData&           xmpData,
+                  TiffSource&        source,
+                  uint32_t           root,
+                  FindDecoderFct     findDecoderFct,
+                  TiffHeaderBase*    pHeader,
+                  TiffComponent::UniquePtr* pParsedTree
+        );
         /*!
           @brief Parse TIFF metadata from a data buffer \em pData of length
                  \em size into a TIFF composite structure.
@@ -346,6 +385,15 @@ namespace Exiv2 {
                   uint32_t           root,
                   TiffHeaderBase*    pHeader
         );
+        /*!
+          @brief Parse TIFF metadata from \em source into a TIFF composite
+                 structure, which points into the data of \em source.
+         */
+        static std::unique_ptr<TiffComponent> parse(
+                  TiffSource&        source,
+                  uint32_t           root,
+                  TiffHeaderBase*    pHeader
+        );
         /*!
           @brief Find primary groups in the source tree provided and populate
                  the list of primary groups.
@@ -360,6 +408,49 @@ namespace Exiv2 {
 
     }; // class TiffParserWorker
 
+    /*!
+      @brief A TIFF tree kept after decoding an image file, to be reused when
+             the metadata of the same, unchanged file is written. The tree
+             points into the buffer it was parsed from, which is usually
+             unmapped by then; take() moves it to the new buffer.
+     */
+    class TiffParsedTree {
+    public:
+        //! @name Creators
+        //@{
+        /*!
+          @brief Constructor
+
+          @param rootDir Root of the parsed tree.
+          @param pData   Buffer the tree was parsed from.
+          @param size    Size of the buffer.
+          @param mtime   Modification time of the file at the time of parsing.
+         */
+        TiffParsedTree(TiffComponent::UniquePtr rootDir,
+                       const byte* pData,
+                       uint32_t size,
+                       std::filesystem::file_time_type mtime);
+        //@}
+
+        //! @name Manipulators
+        //@{
+        /*!
+          @brief Return the tree, moved to buffer \em pData, which holds
+                 the current content of the file. Returns 0 if \em size or
+                 \em mtime show that the file changed since it was parsed or
+                 if the tree was already taken.
+         */
+        TiffComponent::UniquePtr take(byte* pData, uint32_t size, std::filesystem::file_time_type mtime);
+        //@}
+
+    private:
+        // DATA
+        TiffComponent::UniquePtr rootDir_; //!< Root of the parsed tree
+        const byte* pData_;                //!< Buffer the tree was parsed from (not owned)
+        uint32_t size_;                    //!< Size of the buffer
+        std::filesystem::file_time_type mtime_; //!< Modification time of the file
+    }; // class TiffParsedTree
+
     /*!
       @brief Table of TIFF decoding and encoding functions and find functions.
              This class is separated from the metadata decoder and encoder
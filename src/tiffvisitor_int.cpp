@@ -40,29 +40,15 @@
 #include <iostream>
 #include <iomanip>
 #include <cassert>
+#include <algorithm>
+#include <iterator>
 #include <limits>
+#include <numeric>
 #include <ostream>
+#include <tuple>
 
 // *****************************************************************************
 namespace {
-    //! Unary predicate that matches an Exifdatum with a given group and index.
-    class FindExifdatum2 {
-    public:
-        //! Constructor, initializes the object with the group and index to look for.
-        FindExifdatum2(Exiv2::Internal::IfdId group, int idx)
-            : groupName_(Exiv2::Internal::groupName(group)), idx_(idx) {}
-        //! Returns true if group and index match.
-        bool operator()(const Exiv2::Exifdatum& md) const
-        {
-            return idx_ == md.idx() && 0 == strcmp(md.groupName().c_str(), groupName_);
-        }
-
-    private:
-        const char* groupName_;
-        int idx_;
-
-    }; // class FindExifdatum2
-
     Exiv2::ByteOrder stringToByteOrder(const std::string& val)
     {
         Exiv2::ByteOrder bo = Exiv2::invalidByteOrder;
@@ -177,6 +163,65 @@ namespace Exiv2 {
         findObject(object);
     }
 
+    namespace {
+        //! Find the entries of a TiffCameraInfo in one traversal of a composite
+        class TiffCameraInfoFinder : public TiffVisitor {
+        public:
+            void visitEntry(TiffEntry* object) override { findObject(object); }
+            void visitDataEntry(TiffDataEntry* object) override { findObject(object); }
+            void visitImageEntry(TiffImageEntry* object) override { findObject(object); }
+            void visitSizeEntry(TiffSizeEntry* object) override { findObject(object); }
+            void visitDirectory(TiffDirectory* /*object*/) override {}
+            void visitSubIfd(TiffSubIfd* /*object*/) override {}
+            void visitMnEntry(TiffMnEntry* /*object*/) override {}
+            void visitIfdMakernote(TiffIfdMakernote* /*object*/) override {}
+            void visitBinaryArray(TiffBinaryArray* /*object*/) override {}
+            void visitBinaryElement(TiffBinaryElement* /*object*/) override {}
+
+            //! Return the value of the entry if it has one
+            static const Value* value(TiffEntryBase* object)
+            {
+                return object && object->pValue() && object->pValue()->count() > 0 ? object->pValue() : nullptr;
+            }
+
+            //! Keep the first entry found for each tag, stop when all were found
+            void findObject(TiffEntryBase* object)
+            {
+                if (object->tag() == 0x0110 && object->group() == ifd0Id && !model_) {
+                    model_ = object;
+                } else if (object->tag() == 0x00a7 && object->group() == nikon3Id && !shutterCount_) {
+                    shutterCount_ = object;
+                } else if (object->tag() == 0x001d && object->group() == nikon3Id && !serialNumber_) {
+                    serialNumber_ = object;
+                }
+                if (model_ && shutterCount_ && serialNumber_) setGo(geTraverse, false);
+            }
+
+            TiffEntryBase* model_{nullptr};
+            TiffEntryBase* shutterCount_{nullptr};
+            TiffEntryBase* serialNumber_{nullptr};
+        };
+    }  // namespace
+
+    TiffCameraInfo findCameraInfo(TiffComponent* pRoot)
+    {
+        TiffCameraInfo camera;
+        if (!pRoot) return camera;
+        TiffCameraInfoFinder finder;
+        pRoot->accept(finder);
+        if (auto model = TiffCameraInfoFinder::value(finder.model_)) {
+            camera.model_ = model->toString();
+        }
+        auto shutterCount = TiffCameraInfoFinder::value(finder.shutterCount_);
+        auto serialNumber = TiffCameraInfoFinder::value(finder.serialNumber_);
+        if (shutterCount && serialNumber) {
+            camera.nikonKey_ = true;
+            camera.shutterCount_ = static_cast<uint32_t>(shutterCount->toLong());
+            camera.serialNumber_ = serialNumber->toString();
+        }
+        return camera;
+    }
+
     TiffCopier::TiffCopier(      TiffComponent*  pRoot,
                                  uint32_t        root,
                            const TiffHeaderBase* pHeader,
@@ -202,7 +247,7 @@ namespace Exiv2 {
             TiffCreator::getPath(tiffPath, object->tag(), object->group(), root_);
             pRoot_->addPath(object->tag(), tiffPath, pRoot_, std::move(clone));
 #ifdef EXIV2_DEBUG_MESSAGES
-            ExifKey key(object->tag(), groupName(object->group()));
+            ExifKey key(object->tag(), object->group(), nullptr);
             std::cerr << "Copied " << key << "\n";
 #endif
         }
@@ -258,6 +303,85 @@ namespace Exiv2 {
         copyObject(object);
     }
 
+    TiffRebaser::TiffRebaser(const byte* pOldData, uint32_t size, byte* pNewData)
+        : oldData_(reinterpret_cast<uintptr_t>(pOldData)), size_(size), pNewData_(pNewData)
+    {
+        assert(pNewData_ != 0);
+    }
+
+    byte* TiffRebaser::rebase(const byte* p) const
+    {
+        // Compare addresses as integers, the old buffer may no longer exist.
+        // Buffers owned by the components were allocated while the old buffer
+        // was alive, so they can not overlap with it.
+        const auto addr = reinterpret_cast<uintptr_t>(p);
+        if (p != nullptr && addr >= oldData_ && addr - oldData_ < size_) {
+            return pNewData_ + (addr - oldData_);
+        }
+        return const_cast<byte*>(p);
+    }
+
+    void TiffRebaser::rebaseEntry(TiffEntryBase* object) const
+    {
+        object->setStart(rebase(object->start()));
+        object->pData_ = rebase(object->pData_);
+    }
+
+    void TiffRebaser::visitEntry(TiffEntry* object)
+    {
+        rebaseEntry(object);
+    }
+
+    void TiffRebaser::visitDataEntry(TiffDataEntry* object)
+    {
+        rebaseEntry(object);
+        object->pDataArea_ = rebase(object->pDataArea_);
+    }
+
+    void TiffRebaser::visitImageEntry(TiffImageEntry* object)
+    {
+        rebaseEntry(object);
+        for (auto&& strip : object->strips_) {
+            strip.first = rebase(strip.first);
+        }
+    }
+
+    void TiffRebaser::visitSizeEntry(TiffSizeEntry* object)
+    {
+        rebaseEntry(object);
+    }
+
+    void TiffRebaser::visitDirectory(TiffDirectory* object)
+    {
+        object->setStart(rebase(object->start()));
+    }
+
+    void TiffRebaser::visitSubIfd(TiffSubIfd* object)
+    {
+        rebaseEntry(object);
+    }
+
+    void TiffRebaser::visitMnEntry(TiffMnEntry* object)
+    {
+        rebaseEntry(object);
+    }
+
+    void TiffRebaser::visitIfdMakernote(TiffIfdMakernote* object)
+    {
+        object->setStart(rebase(object->start()));
+    }
+
+    void TiffRebaser::visitBinaryArray(TiffBinaryArray* object)
+    {
+        rebaseEntry(object);
+        object->origData_ = rebase(object->origData_);
+    }
+
+    void TiffRebaser::visitBinaryElement(TiffBinaryElement* object)
+    {
+        rebaseEntry(object);
+    }
+
     TiffDecoder::TiffDecoder(
         ExifData&            exifData,
         IptcData&            iptcData,
@@ -537,7 +661,7 @@ namespace Exiv2 {
     void TiffDecoder::decodeStdTiffEntry(const TiffEntryBase* object)
     {
         assert(object != 0);
-        ExifKey key(object->tag(), groupName(object->group()));
+        ExifKey key(object->tag(), object->group(), nullptr);
         key.setIdx(object->idx());
         exifData_.add(key, object->pValue());
 
@@ -555,10 +679,10 @@ namespace Exiv2 {
         decodeTiffEntry(object);
     }
 
-    TiffEncoder::TiffEncoder(ExifData exifData, const IptcData& iptcData, const XmpData& xmpData, TiffComponent* pRoot,
-                             const bool isNewImage, const PrimaryGroups* pPrimaryGroups, const TiffHeaderBase* pHeader,
-                             FindEncoderFct findEncoderFct)
-        : exifData_(std::move(exifData)),
+    TiffEncoder::TiffEncoder(const ExifData& exifData, const IptcData& iptcData, const XmpData& xmpData,
+                             TiffComponent* pRoot, const bool isNewImage, const PrimaryGroups* pPrimaryGroups,
+                             const TiffHeaderBase* pHeader, FindEncoderFct findEncoderFct)
+        : remaining_(0),
           iptcData_(iptcData),
           xmpData_(xmpData),
           del_(true),
@@ -568,6 +692,7 @@ namespace Exiv2 {
           pPrimaryGroups_(pPrimaryGroups),
           pSourceTree_(nullptr),
           findEncoderFct_(findEncoderFct),
+          cameraFound_(false),
           dirty_(false),
           writeMethod_(wmNonIntrusive)
     {
@@ -578,14 +703,27 @@ namespace Exiv2 {
         byteOrder_ = pHeader->byteOrder();
         origByteOrder_ = byteOrder_;
 
+        entries_.reserve(exifData.count());
+        for (auto&& datum : exifData) {
+            entries_.push_back(&datum);
+        }
+        encoded_.assign(entries_.size(), false);
+        remaining_ = entries_.size();
+        index_.resize(entries_.size());
+        std::iota(index_.begin(), index_.end(), 0);
+        std::sort(index_.begin(), index_.end(), [this](size_t lhs, size_t rhs) {
+            const Exifdatum* l = entries_[lhs];
+            const Exifdatum* r = entries_[rhs];
+            return std::make_tuple(l->ifdId(), l->tag(), lhs) < std::make_tuple(r->ifdId(), r->tag(), rhs);
+        });
+
         encodeIptc();
         encodeXmp();
 
         // Find camera make
-        ExifKey key("Exif.Image.Make");
-        auto pos = exifData_.findKey(key);
-        if (pos != exifData_.end()) {
-            make_ = pos->toString();
+        auto pos = findDatum(0x010f, ifd0Id);
+        if (pos != npos) {
+            make_ = entries_[pos]->toString();
         }
         if (make_.empty() && pRoot_) {
             TiffFinder finder(0x010f, ifd0Id);
@@ -605,19 +743,19 @@ namespace Exiv2 {
         // not exist, create a new IPTCNAA Exif tag.
         bool del = false;
         ExifKey iptcNaaKey("Exif.Image.IPTCNAA");
-        auto pos = exifData_.findKey(iptcNaaKey);
-        if (pos != exifData_.end()) {
-            iptcNaaKey.setIdx(pos->idx());
-            exifData_.erase(pos);
+        auto pos = findDatum(iptcNaaKey);
+        if (pos != npos) {
+            iptcNaaKey.setIdx(entries_[pos]->idx());
+            setEncoded(pos);
             del = true;
         }
         DataBuf rawIptc = IptcParser::encode(iptcData_);
         ExifKey irbKey("Exif.Image.ImageResources");
-        pos = exifData_.findKey(irbKey);
-        if (pos != exifData_.end()) {
-            irbKey.setIdx(pos->idx());
+        pos = findDatum(irbKey);
+        if (pos != npos) {
+            irbKey.setIdx(entries_[pos]->idx());
         }
-        if (rawIptc.size() != 0 && (del || pos == exifData_.end())) {
+        if (rawIptc.size() != 0 && (del || pos == npos)) {
             auto value = Value::create(unsignedLong);
             DataBuf buf;
             if (rawIptc.size() % 4 != 0) {
@@ -630,22 +768,20 @@ namespace Exiv2 {
                 buf = std::move(rawIptc); // Note: This resets rawIptc
             }
             value->read(buf.data(), buf.size(), byteOrder_);
-            Exifdatum iptcDatum(iptcNaaKey, value.get());
-            exifData_.add(iptcDatum);
-            pos = exifData_.findKey(irbKey); // needed after add()
+            addDatum(Exifdatum(iptcNaaKey, value.get()));
         }
         // Also update IPTC IRB in Exif.Image.ImageResources if it exists,
         // but don't create it if not.
-        if (pos != exifData_.end()) {
-            DataBuf irbBuf(pos->value().size());
-            pos->value().copy(irbBuf.data(), invalidByteOrder);
+        if (pos != npos) {
+            const Value& irb = entries_[pos]->value();
+            DataBuf irbBuf(irb.size());
+            irb.copy(irbBuf.data(), invalidByteOrder);
             irbBuf = Photoshop::setIptcIrb(irbBuf.c_data(), irbBuf.size(), iptcData_);
-            exifData_.erase(pos);
+            setEncoded(pos);
             if (irbBuf.size() != 0) {
                 auto value = Value::create(unsignedByte);
                 value->read(irbBuf.data(), irbBuf.size(), invalidByteOrder);
-                Exifdatum iptcDatum(irbKey, value.get());
-                exifData_.add(iptcDatum);
+                addDatum(Exifdatum(irbKey, value.get()));
             }
         }
     } // TiffEncoder::encodeIptc
@@ -655,10 +791,10 @@ namespace Exiv2 {
 #ifdef EXV_HAVE_XMP_TOOLKIT
         ExifKey xmpKey("Exif.Image.XMLPacket");
         // Remove any existing XMP Exif tag
-        auto pos = exifData_.findKey(xmpKey);
-        if (pos != exifData_.end()) {
-            xmpKey.setIdx(pos->idx());
-            exifData_.erase(pos);
+        auto pos = findDatum(xmpKey);
+        if (pos != npos) {
+            xmpKey.setIdx(entries_[pos]->idx());
+            setEncoded(pos);
         }
         std::string xmpPacket;
         if ( xmpData_.usePacket() ) {
@@ -676,12 +812,67 @@ namespace Exiv2 {
             value->read(reinterpret_cast<const byte*>(&xmpPacket[0]),
                         static_cast<long>(xmpPacket.size()),
                         invalidByteOrder);
-            Exifdatum xmpDatum(xmpKey, value.get());
-            exifData_.add(xmpDatum);
+            addDatum(Exifdatum(xmpKey, value.get()));
         }
 #endif
     } // TiffEncoder::encodeXmp
 
+    void TiffEncoder::addDatum(Exifdatum&& datum)
+    {
+        added_.add(std::move(datum));
+        const size_t pos = entries_.size();
+        entries_.push_back(&*std::prev(added_.end()));
+        encoded_.push_back(false);
+        ++remaining_;
+        // The new entry has the highest position, it goes last among those with the same key
+        const Exifdatum& ed = *entries_.back();
+        index_.insert(equalRange(ed.tag(), static_cast<IfdId>(ed.ifdId())).second, pos);
+    }
+
+    void TiffEncoder::setEncoded(size_t pos)
+    {
+        if (!encoded_[pos]) {
+            encoded_[pos] = true;
+            --remaining_;
+        }
+    }
+
+    std::pair<std::vector<size_t>::const_iterator, std::vector<size_t>::const_iterator> TiffEncoder::equalRange(
+        uint16_t tag, IfdId group) const
+    {
+        const auto key = std::make_pair(static_cast<int>(group), tag);
+        const auto lower = std::lower_bound(index_.begin(), index_.end(), key, [this](size_t pos, const auto& k) {
+            return std::make_pair(entries_[pos]->ifdId(), entries_[pos]->tag()) < k;
+        });
+        const auto upper = std::upper_bound(lower, index_.end(), key, [this](const auto& k, size_t pos) {
+            return k < std::make_pair(entries_[pos]->ifdId(), entries_[pos]->tag());
+        });
+        return {lower, upper};
+    }
+
+    size_t TiffEncoder::findDatum(uint16_t tag, IfdId group) const
+    {
+        const auto range = equalRange(tag, group);
+        for (auto i = range.first; i != range.second; ++i) {
+            if (!encoded_[*i]) return *i;
+        }
+        return npos;
+    }
+
+    size_t TiffEncoder::findDatum(uint16_t tag, IfdId group, int idx) const
+    {
+        const auto range = equalRange(tag, group);
+        for (auto i = range.first; i != range.second; ++i) {
+            if (!encoded_[*i] && entries_[*i]->idx() == idx) return *i;
+        }
+        return npos;
+    }
+
+    size_t TiffEncoder::findDatum(const ExifKey& key) const
+    {
+        return findDatum(key.tag(), static_cast<IfdId>(key.ifdId()));
+    }
+
     void TiffEncoder::setDirty(bool flag)
     {
         dirty_ = flag;
@@ -690,7 +881,7 @@ namespace Exiv2 {
 
     bool TiffEncoder::dirty() const
     {
-        return dirty_ || exifData_.count() > 0;
+        return dirty_ || remaining_ > 0;
     }
 
     void TiffEncoder::visitEntry(TiffEntry* object)
@@ -765,9 +956,8 @@ namespace Exiv2 {
         }
         else if (del_) {
             // The makernote is made up of decoded tags, delete binary tag
-            ExifKey key(object->tag(), groupName(object->group()));
-            auto pos = exifData_.findKey(key);
-            if (pos != exifData_.end()) exifData_.erase(pos);
+            auto pos = findDatum(object->tag(), object->group());
+            if (pos != npos) setEncoded(pos);
         }
     }
 
@@ -775,15 +965,15 @@ namespace Exiv2 {
     {
         assert(object != 0);
 
-        auto pos = exifData_.findKey(ExifKey("Exif.MakerNote.ByteOrder"));
-        if (pos != exifData_.end()) {
+        auto pos = findDatum(ExifKey("Exif.MakerNote.ByteOrder"));
+        if (pos != npos) {
             // Set Makernote byte order
-            ByteOrder bo = stringToByteOrder(pos->toString());
+            ByteOrder bo = stringToByteOrder(entries_[pos]->toString());
             if (bo != invalidByteOrder && bo != object->byteOrder()) {
                 object->setByteOrder(bo);
                 setDirty();
             }
-            if (del_) exifData_.erase(pos);
+            if (del_) setEncoded(pos);
         }
         if (del_) {
             // Remove remaining synthesized tags
@@ -791,8 +981,8 @@ namespace Exiv2 {
                 "Exif.MakerNote.Offset",
             };
             for (auto&& synthesizedTag : synthesizedTags) {
-                pos = exifData_.findKey(ExifKey(synthesizedTag));
-                if (pos != exifData_.end()) exifData_.erase(pos);
+                pos = findDatum(ExifKey(synthesizedTag));
+                if (pos != npos) setEncoded(pos);
             }
         }
         // Modify encoder for Makernote peculiarities, byte order
@@ -822,7 +1012,11 @@ namespace Exiv2 {
             return;
         int32_t size = object->TiffEntryBase::doSize();
         if (size == 0) return;
-        if (!object->initialize(pRoot_)) return;
+        if (!cameraFound_) {
+            camera_ = findCameraInfo(pRoot_);
+            cameraFound_ = true;
+        }
+        if (!object->initialize(pRoot_, camera_)) return;
 
         // Re-encrypt buffer if necessary
         CryptFct cryptFct = object->cfg()->cryptFct_;
@@ -831,7 +1025,7 @@ namespace Exiv2 {
         }
         if (cryptFct != nullptr) {
             const byte* pData = object->pData();
-            DataBuf buf = cryptFct(object->tag(), pData, size, pRoot_);
+            DataBuf buf = cryptFct(object->tag(), pData, size, pRoot_, camera_);
             if (buf.size() > 0) {
                 pData = buf.c_data();
                 size = buf.size();
@@ -863,28 +1057,25 @@ namespace Exiv2 {
     {
         assert(object != 0);
 
-        auto pos = exifData_.end();
+        size_t pos = npos;
         const Exifdatum* ed = datum;
         if (ed == nullptr) {
             // Non-intrusive writing: find matching tag
-            ExifKey key(object->tag(), groupName(object->group()));
-            pos = exifData_.findKey(key);
-            if (pos != exifData_.end()) {
-                ed = &(*pos);
-                if (object->idx() != pos->idx()) {
+            pos = findDatum(object->tag(), object->group());
+            if (pos != npos) {
+                if (object->idx() != entries_[pos]->idx()) {
                     // Try to find exact match (in case of duplicate tags)
-                    auto pos2 =
-                        std::find_if(exifData_.begin(), exifData_.end(),
-                                     FindExifdatum2(object->group(), object->idx()));
-                    if (pos2 != exifData_.end() && pos2->key() == key.key()) {
-                        ed = &(*pos2);
-                        pos = pos2; // make sure we delete the correct tag below
+                    const size_t pos2 = findDatum(object->tag(), object->group(), object->idx());
+                    if (pos2 != npos) {
+                        pos = pos2; // make sure we mark the correct tag below
                     }
                 }
+                ed = entries_[pos];
             }
             else {
                 setDirty();
 #ifdef EXIV2_DEBUG_MESSAGES
+                ExifKey key(object->tag(), object->group(), nullptr);
                 std::cerr << "DELETING          " << key << ", idx = " << object->idx() << "\n";
 #endif
             }
@@ -907,8 +1098,8 @@ namespace Exiv2 {
                 object->encode(*this, ed);
             }
         }
-        if (del_ && pos != exifData_.end()) {
-            exifData_.erase(pos);
+        if (del_ && pos != npos) {
+            setEncoded(pos);
         }
 #ifdef EXIV2_DEBUG_MESSAGES
         std::cerr << "\n";
@@ -935,7 +1126,7 @@ namespace Exiv2 {
             if (  object->sizeDataArea_
                 < static_cast<uint32_t>(object->pValue()->sizeDataArea())) {
 #ifdef EXIV2_DEBUG_MESSAGES
-                ExifKey key(object->tag(), groupName(object->group()));
+                ExifKey key(object->tag(), object->group(), nullptr);
                 std::cerr << "DATAAREA GREW     " << key << "\n";
 #endif
                 setDirty();
@@ -943,7 +1134,7 @@ namespace Exiv2 {
             else {
                 // Write the new dataarea, fill with 0x0
 #ifdef EXIV2_DEBUG_MESSAGES
-                ExifKey key(object->tag(), groupName(object->group()));
+                ExifKey key(object->tag(), object->group(), nullptr);
                 std::cerr << "Writing data area for " << key << "\n";
 #endif
                 DataBuf buf = object->pValue()->dataArea();
@@ -982,10 +1173,10 @@ namespace Exiv2 {
             std::cerr << "\t DATAAREA IS SET (INTRUSIVE WRITING)";
 #endif
             // Set pseudo strips (without a data pointer) from the size tag
-            ExifKey key(object->szTag(), groupName(object->szGroup()));
-            auto pos = exifData_.findKey(key);
+            ExifKey key(object->szTag(), object->szGroup(), nullptr);
+            auto pos = findDatum(key);
             const byte* zero = nullptr;
-            if (pos == exifData_.end()) {
+            if (pos == npos) {
 #ifndef SUPPRESS_WARNINGS
                 EXV_ERROR << "Size tag " << key
                           << " not found. Writing only one strip.\n";
@@ -996,14 +1187,15 @@ namespace Exiv2 {
             else {
                 uint32_t sizeTotal = 0;
                 object->strips_.clear();
-                for (long i = 0; i < pos->count(); ++i) {
-                    uint32_t len = pos->toLong(i);
+                const Exifdatum& sizes = *entries_[pos];
+                for (long i = 0; i < sizes.count(); ++i) {
+                    uint32_t len = sizes.toLong(i);
                     object->strips_.emplace_back(zero, len);
                     sizeTotal += len;
                 }
                 if (sizeTotal != sizeDataArea) {
 #ifndef SUPPRESS_WARNINGS
-                    ExifKey key2(object->tag(), groupName(object->group()));
+                    ExifKey key2(object->tag(), object->group(), nullptr);
                     EXV_ERROR << "Sum of all sizes of " << key
                               << " != data size of " << key2 << ". "
                               << "This results in an invalid image.\n";
@@ -1028,7 +1220,7 @@ namespace Exiv2 {
             }
 #ifndef SUPPRESS_WARNINGS
             else {
-                ExifKey key2(object->tag(), groupName(object->group()));
+                ExifKey key2(object->tag(), object->group(), nullptr);
                 EXV_WARNING << "No image data to encode " << key2 << ".\n";
             }
 #endif
@@ -1069,7 +1261,7 @@ namespace Exiv2 {
         }
         object->updateValue(datum->getValue(), byteOrder()); // clones the value
 #ifdef EXIV2_DEBUG_MESSAGES
-        ExifKey key(object->tag(), groupName(object->group()));
+        ExifKey key(object->tag(), object->group(), nullptr);
         std::cerr << "UPDATING DATA     " << key;
         if (tooLarge) {
             std::cerr << "\t\t\t ALLOCATED " << std::dec << object->size_ << " BYTES";
@@ -1087,7 +1279,7 @@ namespace Exiv2 {
             setDirty();
             object->updateValue(datum->getValue(), byteOrder()); // clones the value
 #ifdef EXIV2_DEBUG_MESSAGES
-            ExifKey key(object->tag(), groupName(object->group()));
+            ExifKey key(object->tag(), object->group(), nullptr);
             std::cerr << "UPDATING DATA     " << key;
             std::cerr << "\t\t\t ALLOCATED " << object->size() << " BYTES";
 #endif
@@ -1095,7 +1287,7 @@ namespace Exiv2 {
         else {
             object->setValue(datum->getValue()); // clones the value
 #ifdef EXIV2_DEBUG_MESSAGES
-            ExifKey key(object->tag(), groupName(object->group()));
+            ExifKey key(object->tag(), object->group(), nullptr);
             std::cerr << "NOT UPDATING      " << key;
             std::cerr << "\t\t\t PRESERVE VALUE DATA";
 #endif
@@ -1114,15 +1306,16 @@ namespace Exiv2 {
         writeMethod_ = wmIntrusive;
         pSourceTree_ = pSourceDir;
 
-        // Ensure that the exifData_ entries are not deleted, to be able to
+        // Ensure that the entries are not marked as encoded, to be able to
         // iterate over all remaining entries.
         del_ = false;
 
-        auto posBo = exifData_.end();
-        for (auto i = exifData_.begin();
-             i != exifData_.end(); ++i) {
+        const Exifdatum* posBo = nullptr;
+        for (size_t pos = 0; pos < entries_.size(); ++pos) {
+            if (encoded_[pos]) continue;
+            const Exifdatum* i = entries_[pos];
 
-            IfdId group = groupId(i->groupName());
+            auto group = static_cast<IfdId>(i->ifdId());
             // Skip synthesized info tags
             if (group == mnId) {
                 if (i->tag() == 0x0002) {
@@ -1149,7 +1342,7 @@ namespace Exiv2 {
             }
 #endif
             if (object != nullptr) {
-                encodeTiffComponent(object, &(*i));
+                encodeTiffComponent(object, i);
             }
         }
 
@@ -1160,7 +1353,7 @@ namespace Exiv2 {
           visit/encodeIfdMakernote is not called in this case and there
           can't be an Exif tag which corresponds to this component.
          */
-        if (posBo == exifData_.end()) return;
+        if (posBo == nullptr) return;
 
         TiffFinder finder(0x927c, exifId);
         pRootDir->accept(finder);
@@ -1176,21 +1369,17 @@ namespace Exiv2 {
 
     } // TiffEncoder::add
 
-    TiffReader::TiffReader(const byte*    pData,
-                           uint32_t       size,
+    TiffReader::TiffReader(TiffSource&    source,
                            TiffComponent* pRoot,
                            TiffRwState    state)
-        : pData_(pData),
-          size_(size),
-          pLast_(pData + size),
+        : source_(source),
           pRoot_(pRoot),
           origState_(state),
           mnState_(state),
           postProc_(false)
     {
         pState_ = &origState_;
-        assert(pData_);
-        assert(size_ > 0);
+        assert(source_.size() > 0);
 
     } // TiffReader::TiffReader
 
@@ -1234,7 +1423,7 @@ namespace Exiv2 {
         pRoot_->accept(finder);
         auto te = dynamic_cast<TiffEntryBase*>(finder.result());
         if (te && te->pValue()) {
-            object->setStrips(te->pValue(), pData_, size_, baseOffset());
+            object->setStrips(te->pValue(), source_, baseOffset());
         }
     }
 
@@ -1262,11 +1451,11 @@ namespace Exiv2 {
         pRoot_->accept(finder);
         auto te = dynamic_cast<TiffDataEntryBase*>(finder.result());
         if (te && te->pValue()) {
-            te->setStrips(object->pValue(), pData_, size_, baseOffset());
+            te->setStrips(object->pValue(), source_, baseOffset());
         }
     }
 
-    bool TiffReader::circularReference(const byte* start, IfdId group)
+    bool TiffReader::circularReference(uint32_t start, IfdId group)
     {
         auto pos = dirList_.find(start);
         if (pos != dirList_.end()) {
@@ -1280,6 +1469,13 @@ namespace Exiv2 {
         return false;
     }
 
+    const byte* TiffReader::position(uint32_t offset)
+    {
+        const uint64_t start = static_cast<uint64_t>(baseOffset()) + offset;
+        if (start > source_.size()) return nullptr;
+        return source_.data(static_cast<uint32_t>(start), 0);
+    }
+
     int TiffReader::nextIdx(IfdId group)
     {
         return ++idxSeq_[group];
@@ -1289,6 +1485,7 @@ namespace Exiv2 {
     {
         setMnState(); // All components to be post-processed must be from the Makernote
         postProc_ = true;
+        if (!postList_.empty()) camera_ = findCameraInfo(pRoot_);
         for (auto&& pos : postList_) {
             pos->accept(*this);
         }
@@ -1300,20 +1497,20 @@ namespace Exiv2 {
     {
         assert(object != 0);
 
-        const byte* p = object->start();
-        assert(p >= pData_);
+        uint32_t start = 0;
+        const bool found = source_.offset(object->start(), start);
 
-        if (circularReference(object->start(), object->group())) return;
+        if (found && circularReference(start, object->group())) return;
 
-        if (p + 2 > pLast_) {
+        if (!found || source_.size() - start < 2) {
 #ifndef SUPPRESS_WARNINGS
             EXV_ERROR << "Directory " << groupName(object->group())
                       << ": IFD exceeds data buffer, cannot read entry count.\n";
 #endif
             return;
         }
-        const uint16_t n = getUShort(p, byteOrder());
-        p += 2;
+        const uint16_t n = getUShort(source_.data(start, 2), byteOrder());
+        uint32_t offset = start + 2;
         // Sanity check with an "unreasonably" large number
         if (n > 256) {
 #ifndef SUPPRESS_WARNINGS
@@ -1323,7 +1520,7 @@ namespace Exiv2 {
             return;
         }
         for (uint16_t i = 0; i < n; ++i) {
-            if (p + 12 > pLast_) {
+            if (source_.size() - offset < 12) {
 #ifndef SUPPRESS_WARNINGS
                 EXV_ERROR << "Directory " << groupName(object->group())
                           << ": IFD entry " << i
@@ -1331,6 +1528,7 @@ namespace Exiv2 {
 #endif
                 return;
             }
+            const byte* p = source_.data(offset, 12);
             uint16_t tag = getUShort(p, byteOrder());
             auto tc = TiffCreator::create(tag, object->group());
             if (tc) {
@@ -1341,11 +1539,11 @@ namespace Exiv2 {
                EXV_WARNING << "Unable to handle tag " << tag << ".\n";
 #endif
             }
-            p += 12;
+            offset += 12;
         }
 
         if (object->hasNext()) {
-            if (p + 4 > pLast_) {
+            if (source_.size() - offset < 4) {
 #ifndef SUPPRESS_WARNINGS
                 EXV_ERROR << "Directory " << groupName(object->group())
                           << ": IFD exceeds data buffer, cannot read next pointer.\n";
@@ -1353,7 +1551,7 @@ namespace Exiv2 {
                 return;
             }
             TiffComponent::UniquePtr tc;
-            uint32_t next = getLong(p, byteOrder());
+            uint32_t next = getLong(source_.data(offset, 4), byteOrder());
             if (next) {
                 tc = TiffCreator::create(Tag::next, object->group());
 #ifndef SUPPRESS_WARNINGS
@@ -1364,14 +1562,14 @@ namespace Exiv2 {
 #endif
             }
             if (tc.get()) {
-                if (baseOffset() + next > size_) {
+                if (baseOffset() + next > source_.size()) {
 #ifndef SUPPRESS_WARNINGS
                     EXV_ERROR << "Directory " << groupName(object->group())
                               << ": Next pointer is out of bounds; ignored.\n";
 #endif
                     return;
                 }
-                tc->setStart(pData_ + baseOffset() + next);
+                tc->setStart(position(next));
                 object->addNext(std::move(tc));
             }
         } // object->hasNext()
@@ -1391,7 +1589,7 @@ namespace Exiv2 {
             if (object->group() == ifd1Id) maxi = 1;
             for (uint32_t i = 0; i < object->count(); ++i) {
                 uint32_t offset = getLong(object->pData() + 4*i, byteOrder());
-                if (   baseOffset() + offset > size_ ) {
+                if (   baseOffset() + offset > source_.size() ) {
 #ifndef SUPPRESS_WARNINGS
                     EXV_ERROR << "Directory " << groupName(object->group())
                               << ", entry 0x" << std::setw(4)
@@ -1413,7 +1611,7 @@ namespace Exiv2 {
                 // If there are multiple dirs, group is incremented for each
                 auto td = std::make_unique<TiffDirectory>(object->tag(),
                                                             static_cast<IfdId>(object->newGroup_ + i));
-                td->setStart(pData_ + baseOffset() + offset);
+                td->setStart(position(offset));
                 object->addChild(std::move(td));
             }
         }
@@ -1459,14 +1657,14 @@ namespace Exiv2 {
         object->setImageByteOrder(byteOrder()); // set the byte order for the image
 
         if (!object->readHeader(object->start(),
-                                static_cast<uint32_t>(pLast_ - object->start()),
+                                source_.available(object->start()),
                                 byteOrder())) {
 #ifndef SUPPRESS_WARNINGS
             EXV_ERROR << "Failed to read "
                       << groupName(object->ifd_.group())
                       << " IFD Makernote header.\n";
 #ifdef EXIV2_DEBUG_MESSAGES
-            if (static_cast<uint32_t>(pLast_ - object->start()) >= 16) {
+            if (source_.available(object->start()) >= 16) {
                 hexdump(std::cerr, object->start(), 16);
             }
 #endif // EXIV2_DEBUG_MESSAGES
@@ -1475,10 +1673,14 @@ namespace Exiv2 {
             return;
         }
 
-        object->ifd_.setStart(object->start() + object->ifdOffset());
+        uint32_t mnOffset = 0;
+        const bool found = source_.offset(object->start(), mnOffset);
+        const uint64_t ifdStart = static_cast<uint64_t>(mnOffset) + object->ifdOffset();
+        object->ifd_.setStart(found && ifdStart <= source_.size()
+                              ? source_.data(static_cast<uint32_t>(ifdStart), 0) : nullptr);
 
         // Modify reader for Makernote peculiarities, byte order and offset
-        object->mnOffset_ = static_cast<uint32_t>(object->start() - pData_);
+        object->mnOffset_ = mnOffset;
         TiffRwState state(object->byteOrder(), object->baseOffset());
         setMnState(&state);
 
@@ -1495,9 +1697,8 @@ namespace Exiv2 {
         assert(object != 0);
 
         byte* p = object->start();
-        assert(p >= pData_);
 
-        if (p + 12 > pLast_) {
+        if (source_.available(p) < 12) {
 #ifndef SUPPRESS_WARNINGS
             EXV_ERROR << "Entry in directory " << groupName(object->group())
                       << "requests access to memory beyond the data buffer. "
@@ -1542,7 +1743,7 @@ namespace Exiv2 {
         uint32_t offset = getLong(p, byteOrder());
         byte* pData = p;
         if (   size > 4
-            && (   baseOffset() + offset >= size_
+            && (   baseOffset() + offset >= source_.size()
                 || static_cast<int32_t>(baseOffset()) + offset <= 0)) {
                 // #1143
                 if ( object->tag() == 0x2001 && std::string(groupName(object->group())) == "Sony1" ) {
@@ -1573,20 +1774,14 @@ namespace Exiv2 {
                 size = 0;
         }
         if (size > 4) {
-            // setting pData to pData_ + baseOffset() + offset can result in pData pointing to invalid memory,
-            // as offset can be arbitrarily large
-            if ((static_cast<uintptr_t>(baseOffset()) > std::numeric_limits<uintptr_t>::max() - static_cast<uintptr_t>(offset))
-             || (static_cast<uintptr_t>(baseOffset() + offset) > std::numeric_limits<uintptr_t>::max() - reinterpret_cast<uintptr_t>(pData_)))
-            {
+            // offset can be arbitrarily large
+            const uint64_t dataOffset = static_cast<uint64_t>(baseOffset()) + offset;
+            if (dataOffset > source_.size()) {
                 throw Error(kerCorruptedMetadata); // #562 don't throw kerArithmeticOverflow
             }
-            if (pData_ + static_cast<uintptr_t>(baseOffset()) + static_cast<uintptr_t>(offset) > pLast_) {
-                throw Error(kerCorruptedMetadata);
-            }
-            pData = const_cast<byte*>(pData_) + baseOffset() + offset;
 
         // check for size being invalid
-            if (size > static_cast<uint32_t>(pLast_ - pData)) {
+            if (size > source_.size() - dataOffset) {
 #ifndef SUPPRESS_WARNINGS
                 EXV_ERROR << "Upper boundary of data for "
                           << "directory " << groupName(object->group())
@@ -1598,11 +1793,12 @@ namespace Exiv2 {
                           << ", size = " << std::dec << size
                           << ", exceeds buffer size by "
                           // cast to make MSVC happy
-                          << static_cast<uint32_t>(pData + size - pLast_)
+                          << static_cast<uint32_t>(dataOffset + size - source_.size())
                           << " Bytes; truncating the entry\n";
 #endif
                 size = 0;
             }
+            pData = const_cast<byte*>(source_.data(static_cast<uint32_t>(dataOffset), size));
         }
         auto v = Value::create(typeId);
         enforce(v.get() != nullptr, kerCorruptedMetadata);
@@ -1644,7 +1840,7 @@ namespace Exiv2 {
         }
 
         if (object->TiffEntryBase::doSize() == 0) return;
-        if (!object->initialize(pRoot_)) return;
+        if (!object->initialize(pRoot_, camera_)) return;
         const ArrayCfg* cfg = object->cfg();
         if (cfg == nullptr)
             return;
@@ -1654,7 +1850,7 @@ namespace Exiv2 {
             const byte* pData = object->pData();
             int32_t size = object->TiffEntryBase::doSize();
             std::shared_ptr<DataBuf> buf = std::make_shared<DataBuf>(
-              cryptFct(object->tag(), pData, size, pRoot_)
+              cryptFct(object->tag(), pData, size, pRoot_, camera_)
             );
             if (buf->size() > 0) object->setData(buf);
         }
@@ -209,6 +209,13 @@ namespace Exiv2 {
         TiffComponent* tiffComponent_;
     }; // class TiffFinder
 
+    /*!
+      @brief Return the camera model from tag 0x0110 of IFD0 and the Nikon
+             encryption key from the Nikon3 makernote in the composite
+             \em pRoot, looked up in one traversal.
+     */
+    TiffCameraInfo findCameraInfo(TiffComponent* pRoot);
+
     /*!
       @brief Copy all image tags from the source tree (the tree that is traversed) to a
              target tree, which is empty except for the root element provided in the
@@ -268,6 +275,68 @@ namespace Exiv2 {
         const PrimaryGroups*  pPrimaryGroups_;
     }; // class TiffCopier
 
+    /*!
+      @brief Move a parsed TIFF tree from the buffer it was parsed from to
+             another buffer with the same content, e.g., a new mapping of the
+             same file. Pointers into the old buffer are replaced with pointers
+             to the same offset in the new buffer, pointers to data owned by
+             the components are left alone. The old buffer is not accessed.
+    */
+    class TiffRebaser : public TiffVisitor {
+    public:
+        //! @name Creators
+        //@{
+        /*!
+          @brief Constructor
+
+          @param pOldData Start of the buffer the tree was parsed from.
+          @param size     Size of both buffers.
+          @param pNewData Start of the buffer to move the tree to.
+         */
+        TiffRebaser(const byte* pOldData, uint32_t size, byte* pNewData);
+        //! Virtual destructor
+        ~TiffRebaser() override = default;
+        //@}
+
+        //! @name Manipulators
+        //@{
+        //! Rebase a TIFF entry
+        void visitEntry(TiffEntry* object) override;
+        //! Rebase a TIFF data entry and its data area
+        void visitDataEntry(TiffDataEntry* object) override;
+        //! Rebase a TIFF image entry and its strips
+        void visitImageEntry(TiffImageEntry* object) override;
+        //! Rebase a TIFF size entry
+        void visitSizeEntry(TiffSizeEntry* object) override;
+        //! Rebase a TIFF directory
+        void visitDirectory(TiffDirectory* object) override;
+        //! Rebase a TIFF sub-IFD
+        void visitSubIfd(TiffSubIfd* object) override;
+        //! Rebase a TIFF makernote
+        void visitMnEntry(TiffMnEntry* object) override;
+        //! Rebase an IFD makernote
+        void visitIfdMakernote(TiffIfdMakernote* object) override;
+        //! Rebase a binary array and its original data
+        void visitBinaryArray(TiffBinaryArray* object) override;
+        //! Rebase an element of a binary array
+        void visitBinaryElement(TiffBinaryElement* object) override;
+        //@}
+
+    private:
+        //! Rebase start and data pointers of a TIFF entry
+        void rebaseEntry(TiffEntryBase* object) const;
+        /*!
+          @brief Return the pointer in the new buffer for \em p if it points
+                 into the old buffer, else \em p.
+         */
+        byte* rebase(const byte* p) const;
+
+        // DATA
+        uintptr_t oldData_; //!< Start of the old buffer
+        uint32_t  size_;    //!< Size of the buffers
+        byte*     pNewData_; //!< Start of the new buffer
+    }; // class TiffRebaser
+
     /*!
       @brief TIFF composite visitor to decode metadata from the TIFF tree and
              add it to an Image, which is supplied in the constructor (Visitor
@@ -383,7 +452,7 @@ namespace Exiv2 {
                  to, the image with the metadata to encode and a function to
                  find special encoders.
          */
-        TiffEncoder(ExifData exifData, const IptcData& iptcData, const XmpData& xmpData, TiffComponent* pRoot,
+        TiffEncoder(const ExifData& exifData, const IptcData& iptcData, const XmpData& xmpData, TiffComponent* pRoot,
                     const bool isNewImage, const PrimaryGroups* pPrimaryGroups, const TiffHeaderBase* pHeader,
                     FindEncoderFct findEncoderFct);
         //! Virtual destructor
@@ -521,10 +590,30 @@ namespace Exiv2 {
           This method is called from the constructor.
          */
         void encodeXmp();
+        /*!
+          @brief Add an Exif datum to the entries to encode. Used for tags which
+                 the encoder synthesizes from other metadata.
+         */
+        void addDatum(Exifdatum&& datum);
+        //! Mark the entry at position \em pos as encoded (or removed).
+        void setEncoded(size_t pos);
         //@}
 
         //! @name Accessors
         //@{
+        /*!
+          @brief Return the position in entries_ of the first Exif datum with
+                 \em tag and \em group which is not yet encoded, npos if
+                 there is none.
+         */
+        size_t findDatum(uint16_t tag, IfdId group) const;
+        //! Same as findDatum(tag, group), but the datum must also have index \em idx.
+        size_t findDatum(uint16_t tag, IfdId group, int idx) const;
+        //! Same as findDatum(tag, group) for \em key.
+        size_t findDatum(const ExifKey& key) const;
+        //! Return the range of index_ with the entries with \em tag and \em group
+        std::pair<std::vector<size_t>::const_iterator, std::vector<size_t>::const_iterator> equalRange(
+            uint16_t tag, IfdId group) const;
         /*!
           @brief Update a directory entry. This is called after all directory
                  entries are encoded. It takes care of type and count changes
@@ -544,11 +633,24 @@ namespace Exiv2 {
         //@}
 
     private:
+        //! Position returned by findDatum() if there is no match
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
         // DATA
-        ExifData exifData_;          //!< Copy of the Exif data to encode
+        /*!
+          @brief The Exif data to encode: the entries of the Exif data provided
+                 in the constructor, followed by those in added_. The Exif data
+                 is not copied; instead of erasing entries as they are encoded,
+                 they are marked in encoded_.
+         */
+        std::vector<const Exifdatum*> entries_;
+        std::vector<bool> encoded_;  //!< Flags for the entries which are encoded or removed
+        size_t remaining_;           //!< Number of entries which are not yet encoded
+        std::vector<size_t> index_;  //!< Positions in entries_, sorted by group, tag and position
+        ExifData added_;             //!< Exif data synthesized by the encoder, from IPTC and XMP data
         const IptcData& iptcData_;   //!< IPTC data to encode, just a reference
         const XmpData&  xmpData_;    //!< XMP data to encode, just a reference
-        bool del_;                   //!< Indicates if Exif data entries should be deleted after encoding
+        bool del_;                   //!< Indicates if Exif data entries should be marked as encoded
         const TiffHeaderBase* pHeader_; //!< TIFF image header
         TiffComponent* pRoot_;       //!< Root element of the composite
         const bool isNewImage_;      //!< True if the TIFF image is created from scratch
@@ -558,6 +660,8 @@ namespace Exiv2 {
         ByteOrder origByteOrder_;    //!< Byteorder as set in the c'tor
         const FindEncoderFct findEncoderFct_; //!< Ptr to the function to find special encoding functions
         std::string make_;           //!< Camera make, determined from the tags to encode
+        TiffCameraInfo camera_;      //!< Camera info of the composite, for array selectors and crypt functions
+        bool cameraFound_;           //!< True once camera_ is looked up
         bool dirty_;                 //!< Signals if any tag is deleted or allocated
         WriteMethod writeMethod_;    //!< Write method used.
 
@@ -607,25 +711,25 @@ namespace Exiv2 {
     }; // TiffRwState
 
     /*!
-      @brief TIFF composite visitor to read the TIFF structure from a block of
-             memory and build the composite from it (Visitor pattern). Used by
-             TiffParser to read the TIFF data from a block of memory.
+      @brief TIFF composite visitor to read the TIFF structure from a TiffSource
+             and build the composite from it (Visitor pattern). Used by
+             TiffParser to read the TIFF data from a block of memory or, in
+             windows, from a BasicIo.
      */
     class TiffReader : public TiffVisitor {
     public:
         //! @name Creators
         //@{
         /*!
-          @brief Constructor. The data buffer and table describing the TIFF
+          @brief Constructor. The data source and table describing the TIFF
                            structure of the data are set in the constructor.
-          @param pData     Pointer to the data buffer, starting with a TIFF header.
-          @param size      Number of bytes in the data buffer.
+          @param source    The data, starting with a TIFF header. It must
+                           outlive the composite, which points into its data.
           @param pRoot     Root element of the TIFF composite.
           @param state     State object for creation function, byte order and
                            base offset.
          */
-        TiffReader(const byte*          pData,
-                   uint32_t             size,
+        TiffReader(TiffSource&          source,
                    TiffComponent*       pRoot,
                    TiffRwState          state);
 
@@ -671,8 +775,10 @@ namespace Exiv2 {
         void setMnState(const TiffRwState* state =0);
         //! Set the state to the original state as set in the constructor.
         void setOrigState();
-        //! Check IFD directory pointer \em start for circular reference
-        bool circularReference(const byte* start, IfdId group);
+        //! Check IFD directory offset \em start for circular reference
+        bool circularReference(uint32_t start, IfdId group);
+        //! Return a pointer to the position \em offset from the base offset, 0 if it is beyond the data
+        const byte* position(uint32_t offset);
         //! Return the next idx sequence number for \em group
         int nextIdx(IfdId group);
 
@@ -697,22 +803,21 @@ namespace Exiv2 {
         //@}
 
     private:
-        using DirList = std::map<const byte*, IfdId>;
+        using DirList = std::map<uint32_t, IfdId>;
         using IdxSeq = std::map<uint16_t, int>;
         using PostList = std::vector<TiffComponent*>;
 
         // DATA
-        const byte*          pData_;      //!< Pointer to the memory buffer
-        const uint32_t       size_;       //!< Size of the buffer
-        const byte*          pLast_;      //!< Pointer to the last byte
+        TiffSource&          source_;     //!< The data read
         TiffComponent* const pRoot_;      //!< Root element of the composite
         TiffRwState*         pState_;     //!< Pointer to the state in effect (origState_ or mnState_)
         TiffRwState          origState_;  //!< State class as set in the c'tor
         TiffRwState          mnState_;    //!< State class as set in the c'tor or by setMnState()
-        DirList              dirList_;    //!< List of IFD pointers and their groups
+        DirList              dirList_;    //!< List of IFD offsets and their groups
         IdxSeq               idxSeq_;     //!< Sequences for group, used for the entry's idx
         PostList             postList_;   //!< List of components with deferred reading
         bool                 postProc_;   //!< True in postProcessList()
+        TiffCameraInfo       camera_;     //!< Camera info, looked up for postProcess()
     }; // class TiffReader
 
 }}                                      // namespace Internal, Exiv2
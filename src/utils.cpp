@@ -119,7 +119,7 @@ namespace Util {
         }
     }
 
-    bool startsWith(const std::string& s, const std::string& start)
+    bool startsWith(std::string_view s, std::string_view start)
     {
         return s.size() >= start.size() && std::memcmp(s.data(), start.data(), start.size()) == 0;
     }
@@ -25,6 +25,7 @@
 
 // + standard includes
 #include <string>
+#include <string_view>
 
 // *********************************************************************
 // namespace extensions
@@ -85,7 +86,7 @@ namespace Util {
              When Exiv2 uses C++20, this will be replaced with
              std::basic_string<CharT,Traits,Allocator>::starts_with().
      */
-    bool startsWith(const std::string& s, const std::string& start);
+    bool startsWith(std::string_view s, std::string_view start);
 }                                       // namespace Util
 
 #endif                                  // #ifndef UTILS_HPP_
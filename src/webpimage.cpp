@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include "webpimage.hpp"
+#include "webpimage_int.hpp"
 #include "image_int.hpp"
 #include "enforce.hpp"
 #include "futils.hpp"
@@ -39,6 +40,7 @@
 #include "convert.hpp"
 #include "safe_op.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <string>
@@ -47,6 +49,7 @@
 #include <sstream>
 #include <cassert>
 #include <cstdio>
+#include <limits>
 
 #define CHECK_BIT(var,pos) ((var) & (1<<(pos)))
 
@@ -55,11 +58,52 @@
 namespace Exiv2 {
     using namespace Exiv2::Internal;
 
+    namespace {
+        /*!
+          @brief Read the RIFF header at the current position of \em io.
+          @return The end of the RIFF container.
+          @throw Error if the header can't be read or the container exceeds the data.
+         */
+        long readRiffHeader(BasicIo& io)
+        {
+            byte data[12];
+            io.readOrThrow(data, sizeof(data), Exiv2::kerCorruptedMetadata);
+
+            const uint32_t filesize_u32 = Safe::add(Exiv2::getULong(data + 4, littleEndian), 8U);
+            enforce(filesize_u32 <= io.size(), Exiv2::kerCorruptedMetadata);
+
+            // Check that `filesize_u32` is safe to cast to `long`.
+            enforce(filesize_u32 <= static_cast<size_t>(std::numeric_limits<unsigned int>::max()),
+                    Exiv2::kerCorruptedMetadata);
+            return static_cast<long>(filesize_u32);
+        }
+
+        //! Read the first \em count bytes of the data of \em chunk, at most the whole data
+        DataBuf readPayload(BasicIo& io, const WebPChunkIndex::Entry& chunk, long count)
+        {
+            DataBuf payload(std::min(count, static_cast<long>(chunk.length_)));
+            if (io.seek(chunk.payload(), BasicIo::beg) != 0) throw Error(kerCorruptedMetadata);
+            io.readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
+            return payload;
+        }
+
+        //! Append the header of a chunk of \em type with \em length bytes of data to \em blob
+        void appendChunkHeader(Blob& blob, const char* type, uint32_t length)
+        {
+            byte size[4];
+            ul2Data(size, length, littleEndian);
+            blob.insert(blob.end(), type, type + 4);
+            blob.insert(blob.end(), size, size + 4);
+        }
+    }  // namespace
+
     WebPImage::WebPImage(BasicIo::UniquePtr io)
-    : Image(ImageType::webp, mdNone, std::move(io))
+    : Image(ImageType::webp, mdExif | mdXmp | mdIccProfile, std::move(io))
     {
     } // WebPImage::WebPImage
 
+    WebPImage::~WebPImage() = default;
+
     std::string WebPImage::mimeType() const
     {
         return "image/webp";
@@ -86,6 +130,7 @@ namespace Exiv2 {
     constexpr const char* WebPImage::WEBP_CHUNK_HEADER_ICCP = "ICCP";
     constexpr const char* WebPImage::WEBP_CHUNK_HEADER_EXIF = "EXIF";
     constexpr const char* WebPImage::WEBP_CHUNK_HEADER_XMP = "XMP ";
+    constexpr const char* WebPImage::WEBP_CHUNK_HEADER_JUNK = "JUNK";
 
     /* =========================================== */
 
@@ -106,94 +151,60 @@ namespace Exiv2 {
 
     void WebPImage::writeMetadata()
     {
+        // IPTC data and comments are not written
+        const int changed = changedMetadata() & (mdExif | mdXmp | mdIccProfile);
+        if (changed == mdNone) {
+            setWrittenMetadata(mdNone);
+            return;
+        }
         if (io_->open() != 0) {
             throw Error(kerDataSourceOpenFailed, io_->path(), strError());
         }
         IoCloser closer(*io_);
-        auto tempIo = std::make_unique<MemIo>();
 
-        doWriteMetadata(*tempIo); // may throw
-        io_->close();
-        io_->transfer(*tempIo); // may throw
-    } // WebPImage::writeMetadata
-
-
-    void WebPImage::doWriteMetadata(BasicIo& outIo)
-    {
-        if (!io_->isopen()) throw Error(kerInputDataReadFailed);
-        if (!outIo.isopen()) throw Error(kerImageWriteFailed);
-
-#ifdef EXIV2_DEBUG_MESSAGES
-        std::cout << "Writing metadata" << std::endl;
-#endif
-
-        byte    data   [WEBP_TAG_SIZE*3];
-        DataBuf chunkId(WEBP_TAG_SIZE+1);
-        chunkId.write_uint8(WEBP_TAG_SIZE, '\0');
-
-        io_->readOrThrow(data, WEBP_TAG_SIZE * 3, Exiv2::kerCorruptedMetadata);
-        uint64_t filesize = Exiv2::getULong(data + WEBP_TAG_SIZE, littleEndian);
-
-        /* Set up header */
-        if (outIo.write(data, WEBP_TAG_SIZE * 3) != WEBP_TAG_SIZE * 3)
-            throw Error(kerImageWriteFailed);
-
-        /* Parse Chunks */
-        bool has_size  = false;
-        bool has_xmp   = false;
-        bool has_exif  = false;
-        bool has_vp8x  = false;
-        bool has_alpha = false;
-        bool has_icc   = iccProfileDefined();
-
-        int width      = 0;
-        int height     = 0;
-
-        byte       size_buff[WEBP_TAG_SIZE];
-        Blob       blob;
+        auto index = std::move(chunkIndex_);
+        if (!index || !index->isCurrent(*io_)) {
+            index = std::make_unique<WebPChunkIndex>(*io_, readRiffHeader(*io_));
+            index->readAll(*io_);
+        }
 
+        Blob exif;
         if (exifData_.count() > 0) {
-            ExifParser::encode(blob, littleEndian, exifData_);
-            if (!blob.empty()) {
-                has_exif = true;
-            }
+            ExifParser::encode(exif, littleEndian, exifData_);
         }
-
         if (xmpData_.count() > 0 && !writeXmpFromPacket()) {
             XmpParser::encode(xmpPacket_, xmpData_,
                               XmpParser::useCompactFormat |
                               XmpParser::omitAllFormatting);
         }
-        has_xmp = !xmpPacket_.empty();
-        std::string xmp(xmpPacket_);
 
-        /* Verify for a VP8X Chunk First before writing in
-         case we have any exif or xmp data, also check
-         for any chunks with alpha frame/layer set */
-        while (!io_->eof() && static_cast<uint64_t>(io_->tell()) < filesize) {
-            io_->readOrThrow(chunkId.data(), WEBP_TAG_SIZE, Exiv2::kerCorruptedMetadata);
-            io_->readOrThrow(size_buff, WEBP_TAG_SIZE, Exiv2::kerCorruptedMetadata);
-            const uint32_t size_u32 = Exiv2::getULong(size_buff, littleEndian);
+        if (!writeInPlace(*index, changed, exif, xmpPacket_)) {
+            auto tempIo = std::make_unique<TempIo>(*io_);
+            doWriteMetadata(*index, *tempIo, exif, xmpPacket_); // may throw
+            io_->close();
+            io_->transfer(*tempIo); // may throw
+        }
+        setWrittenMetadata(changed);
+        setMetadataClean();
+    } // WebPImage::writeMetadata
 
-            // Check that `size_u32` is safe to cast to `long`.
-            enforce(size_u32 <= static_cast<size_t>(std::numeric_limits<unsigned int>::max()),
-                    Exiv2::kerCorruptedMetadata);
-            const long size = static_cast<long>(size_u32);
-            DataBuf payload(size);
-            io_->readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
-            if ( payload.size() % 2 ) {
-              byte c = 0;
-              io_->readOrThrow(&c, 1, Exiv2::kerCorruptedMetadata);
-            }
+    void WebPImage::inspectChunks(const WebPChunkIndex& index, bool& has_vp8x,
+                                  bool& has_alpha, int& width, int& height)
+    {
+        bool has_size = false;
+
+        for (auto&& chunk : index.chunks()) {
+            const long size = static_cast<long>(chunk.length_);
 
             /* Chunk with information about features
              used in the file. */
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8X) && !has_vp8x) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_VP8X) && !has_vp8x) {
                 has_vp8x = true;
             }
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8X) && !has_size) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_VP8X) && !has_size) {
                 enforce(size >= 10, Exiv2::kerCorruptedMetadata);
                 has_size = true;
+                const DataBuf payload = readPayload(*io_, chunk, 10);
                 byte size_buf[WEBP_TAG_SIZE];
 
                 // Fetch width - stored in 24bits
@@ -209,20 +220,21 @@ namespace Exiv2 {
 
             /* Chunk with animation control data. */
 #ifdef __CHECK_FOR_ALPHA__  // Maybe in the future
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_ANIM) && !has_alpha) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_ANIM) && !has_alpha) {
                 has_alpha = true;
             }
 #endif
 
             /* Chunk with lossy image data. */
 #ifdef __CHECK_FOR_ALPHA__ // Maybe in the future
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8) && !has_alpha) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_VP8) && !has_alpha) {
                 has_alpha = true;
             }
 #endif
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8) && !has_size) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_VP8) && !has_size) {
                 enforce(size >= 10, Exiv2::kerCorruptedMetadata);
                 has_size = true;
+                const DataBuf payload = readPayload(*io_, chunk, 10);
                 byte size_buf[2];
 
                 /* Refer to this https://tools.ietf.org/html/rfc6386
@@ -238,15 +250,17 @@ namespace Exiv2 {
             }
 
             /* Chunk with lossless image data. */
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8L) && !has_alpha) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_VP8L) && !has_alpha) {
                 enforce(size >= 5, Exiv2::kerCorruptedMetadata);
+                const DataBuf payload = readPayload(*io_, chunk, 5);
                 if ((payload.read_uint8(4) & WEBP_VP8X_ALPHA_BIT) == WEBP_VP8X_ALPHA_BIT) {
                     has_alpha = true;
                 }
             }
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8L) && !has_size) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_VP8L) && !has_size) {
                 enforce(size >= 5, Exiv2::kerCorruptedMetadata);
                 has_size = true;
+                const DataBuf payload = readPayload(*io_, chunk, 5);
                 byte size_buf_w[2];
                 byte size_buf_h[3];
 
@@ -272,15 +286,17 @@ namespace Exiv2 {
             }
 
             /* Chunk with animation frame. */
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_ANMF) && !has_alpha) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_ANMF) && !has_alpha) {
                 enforce(size >= 6, Exiv2::kerCorruptedMetadata);
+                const DataBuf payload = readPayload(*io_, chunk, 6);
                 if ((payload.read_uint8(5) & 0x2) == 0x2) {
                     has_alpha = true;
                 }
             }
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_ANMF) && !has_size) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_ANMF) && !has_size) {
                 enforce(size >= 12, Exiv2::kerCorruptedMetadata);
                 has_size = true;
+                const DataBuf payload = readPayload(*io_, chunk, 12);
                 byte size_buf[WEBP_TAG_SIZE];
 
                 // Fetch width - stored in 24bits
@@ -295,35 +311,195 @@ namespace Exiv2 {
             }
 
             /* Chunk with alpha data. */
-            if (equalsWebPTag(chunkId, "ALPH") && !has_alpha) {
+            if (equalsWebPTag(chunk.type_, "ALPH") && !has_alpha) {
                 has_alpha = true;
             }
         }
+    } // WebPImage::inspectChunks
 
-        /* Inject a VP8X chunk if one isn't available. */
-        if (!has_vp8x) {
-            inject_VP8X(outIo, has_xmp, has_exif, has_alpha,
-                        has_icc, width, height);
+    bool WebPImage::writeInPlace(const WebPChunkIndex& index, int changed,
+                                 const Blob& exif, const std::string& xmp)
+    {
+        // The ICCP chunk must follow the VP8X chunk, it is only written with the whole image
+        if (changed & mdIccProfile) return false;
+        auto file = dynamic_cast<FileIo*>(io_.get());
+        if (!file && !dynamic_cast<MemIo*>(io_.get())) return false;
+
+        bool has_vp8x  = false;
+        bool has_alpha = false;
+        int width      = 0;
+        int height     = 0;
+        inspectChunks(index, has_vp8x, has_alpha, width, height);
+
+        const auto& chunks = index.chunks();
+        auto chunkOf = [&](const char* type) {
+            return std::find_if(chunks.begin(), chunks.end(),
+                                [type](const WebPChunkIndex::Entry& chunk) { return equalsWebPTag(chunk.type_, type); });
+        };
+        const auto vp8x = chunkOf(WEBP_CHUNK_HEADER_VP8X);
+        if (vp8x == chunks.end()) return false;
+
+        // The data to write and where
+        std::vector<std::pair<long, Blob>> writes;
+        long end = index.end();
+        const bool atEnd = static_cast<size_t>(end) == io_->size();
+
+        /*
+          Replace the chunk of type with a chunk with data, or remove it if
+          data is empty. The new chunk takes the place of the old one and of
+          JUNK chunks which follow it, space left over becomes a JUNK chunk.
+          At the end of the image, the chunk may grow. A missing chunk is
+          added at the end, if append is true.
+         */
+        auto place = [&](const char* type, const byte* data, size_t size, bool append) {
+            auto chunk = chunkOf(type);
+            long start = end;
+            long stop = end;
+            if (chunk != chunks.end()) {
+                if (std::find_if(chunk + 1, chunks.end(), [type](const WebPChunkIndex::Entry& c) {
+                        return equalsWebPTag(c.type_, type);
+                    }) != chunks.end()) {
+                    return false;  // Duplicate chunks are removed by a rewrite
+                }
+                start = chunk->offset_;
+                stop = std::min(chunk->offset_ + chunk->size(), index.end());
+                while (++chunk != chunks.end() && equalsWebPTag(chunk->type_, WEBP_CHUNK_HEADER_JUNK) &&
+                       chunk->offset_ == stop) {
+                    stop = std::min(chunk->offset_ + chunk->size(), index.end());
+                }
+            } else if (size == 0) {
+                return true;
+            } else if (!append) {
+                return false;
+            }
+            const bool growable = atEnd && stop == end;
+
+            Blob blob;
+            if (size > 0) {
+                enforce(size <= std::numeric_limits<uint32_t>::max() - 1, kerImageWriteFailed);
+                appendChunkHeader(blob, type, static_cast<uint32_t>(size));
+                blob.insert(blob.end(), data, data + size);
+                if (size % 2) blob.push_back(WEBP_PAD_ODD);
+            }
+            const long rest = stop - start - static_cast<long>(blob.size());
+            if (rest > 0 && rest < 8) return false;
+            if (rest >= 8) {
+                appendChunkHeader(blob, WEBP_CHUNK_HEADER_JUNK, static_cast<uint32_t>(rest - 8));
+                blob.resize(blob.size() + rest - 8 + rest % 2, 0);
+            }
+            if (start + static_cast<long>(blob.size()) > stop) {
+                if (!growable) return false;
+                end = start + static_cast<long>(blob.size());
+            }
+            writes.emplace_back(start, std::move(blob));
+            return true;
+        };
+
+        byte flags = readPayload(*io_, *vp8x, 1).read_uint8(0);
+        const byte oldFlags = flags;
+        if (changed & mdExif) {
+            // EXIF is added before XMP
+            if (!place(WEBP_CHUNK_HEADER_EXIF, exif.data(), exif.size(), chunkOf(WEBP_CHUNK_HEADER_XMP) == chunks.end())) {
+                return false;
+            }
+            flags = exif.empty() ? flags & ~WEBP_VP8X_EXIF_BIT : flags | WEBP_VP8X_EXIF_BIT;
+        }
+        if (changed & mdXmp) {
+            if (!place(WEBP_CHUNK_HEADER_XMP, reinterpret_cast<const byte*>(xmp.data()), xmp.size(), true)) {
+                return false;
+            }
+            flags = xmp.empty() ? flags & ~WEBP_VP8X_XMP_BIT : flags | WEBP_VP8X_XMP_BIT;
+        }
+        if (flags != oldFlags) {
+            writes.emplace_back(vp8x->payload(), Blob{flags});
+        }
+        if (end != index.end()) {
+            // Fix File Size Payload Data
+            Blob size(WEBP_TAG_SIZE);
+            ul2Data(size.data(), static_cast<uint32_t>(end - 8), littleEndian);
+            writes.emplace_back(4, std::move(size));
+        }
+
+        if (file) {
+            io_->close();
+            if (file->open("r+b") != 0) {
+                throw Error(kerFileOpenFailed, io_->path(), "r+b", strError());
+            }
+        }
+        for (auto&& write : writes) {
+            if (io_->seek(write.first, BasicIo::beg) != 0 ||
+                io_->write(write.second.data(), static_cast<long>(write.second.size())) !=
+                    static_cast<long>(write.second.size())) {
+                throw Error(kerImageWriteFailed);
+            }
         }
+        return true;
+    } // WebPImage::writeInPlace
 
-        io_->seek(12, BasicIo::beg);
-        while (!io_->eof() && static_cast<uint64_t>(io_->tell()) < filesize) {
-            io_->readOrThrow(chunkId.data(), 4, Exiv2::kerCorruptedMetadata);
-            io_->readOrThrow(size_buff, 4, Exiv2::kerCorruptedMetadata);
+    void WebPImage::doWriteMetadata(const WebPChunkIndex& index, BasicIo& outIo,
+                                    const Blob& exif, const std::string& xmp)
+    {
+        if (!io_->isopen()) throw Error(kerInputDataReadFailed);
+        if (!outIo.isopen()) throw Error(kerImageWriteFailed);
 
-            const uint32_t size_u32 = Exiv2::getULong(size_buff, littleEndian);
+#ifdef EXIV2_DEBUG_MESSAGES
+        std::cout << "Writing metadata" << std::endl;
+#endif
 
-            // Check that `size_u32` is safe to cast to `long`.
-            enforce(size_u32 <= static_cast<size_t>(std::numeric_limits<unsigned int>::max()),
-                    Exiv2::kerCorruptedMetadata);
-            const long size = static_cast<long>(size_u32);
+        byte    data   [WEBP_TAG_SIZE*3];
 
-            DataBuf payload(size);
-            io_->readOrThrow(payload.data(), size, Exiv2::kerCorruptedMetadata);
-            if ( io_->tell() % 2 ) io_->seek(+1,BasicIo::cur); // skip pad
+        /* Set up header */
+        io_->seek(0, BasicIo::beg);
+        io_->readOrThrow(data, WEBP_TAG_SIZE * 3, Exiv2::kerCorruptedMetadata);
+        if (outIo.write(data, WEBP_TAG_SIZE * 3) != WEBP_TAG_SIZE * 3)
+            throw Error(kerImageWriteFailed);
 
-            if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8X)) {
-                enforce(size >= 1, Exiv2::kerCorruptedMetadata);
+        /* Parse Chunks */
+        bool has_xmp   = !xmp.empty();
+        bool has_exif  = !exif.empty();
+        bool has_vp8x  = false;
+        bool has_alpha = false;
+        bool has_icc   = iccProfileDefined();
+
+        int width      = 0;
+        int height     = 0;
+
+        /* Verify for a VP8X Chunk First before writing in
+         case we have any exif or xmp data, also check
+         for any chunks with alpha frame/layer set */
+        inspectChunks(index, has_vp8x, has_alpha, width, height);
+
+        /* Inject a VP8X chunk if one isn't available. */
+        if (!has_vp8x) {
+            inject_VP8X(outIo, has_xmp, has_exif, has_alpha,
+                        has_icc, width, height);
+        }
+
+        // Chunks which are written unchanged are collected into runs of adjacent
+        // chunks and each run, with the image data, is streamed to the output in one go
+        long runOffset = 0;
+        long runSize = 0;
+        auto copyRun = [&]() {
+            if (runSize == 0) return;
+            Internal::copyData(*io_, runOffset, runSize, outIo);
+            runSize = 0;
+            // Encoder required to pad odd sized data with a null byte
+            if (outIo.tell() % 2) {
+                if (outIo.write(&WEBP_PAD_ODD, 1) != 1) throw Error(kerImageWriteFailed);
+            }
+        };
+        auto addToRun = [&](const WebPChunkIndex::Entry& chunk) {
+            const long runEnd = runOffset + runSize;
+            if (runSize > 0 && runEnd + runEnd % 2 != chunk.offset_) copyRun();
+            if (runSize == 0) runOffset = chunk.offset_;
+            runSize = chunk.payload() + static_cast<long>(chunk.length_) - runOffset;
+        };
+
+        for (auto&& chunk : index.chunks()) {
+            if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_VP8X)) {
+                copyRun();
+                enforce(chunk.length_ >= 1, Exiv2::kerCorruptedMetadata);
+                DataBuf payload = readPayload(*io_, chunk, static_cast<long>(chunk.length_));
                 if (has_icc){
                     const uint8_t x = payload.read_uint8(0);
                     payload.write_uint8(0, x | WEBP_VP8X_ICC_BIT);
@@ -348,9 +524,10 @@ namespace Exiv2 {
                     payload.write_uint8(0, x & ~WEBP_VP8X_EXIF_BIT);
                 }
 
-                if (outIo.write(chunkId.c_data(), WEBP_TAG_SIZE) != WEBP_TAG_SIZE)
+                ul2Data(data, chunk.length_, littleEndian);
+                if (outIo.write(reinterpret_cast<const byte*>(chunk.type_.data()), WEBP_TAG_SIZE) != WEBP_TAG_SIZE)
                     throw Error(kerImageWriteFailed);
-                if (outIo.write(size_buff, WEBP_TAG_SIZE) != WEBP_TAG_SIZE)
+                if (outIo.write(data, WEBP_TAG_SIZE) != WEBP_TAG_SIZE)
                     throw Error(kerImageWriteFailed);
                 if (outIo.write(payload.c_data(), payload.size()) != payload.size())
                     throw Error(kerImageWriteFailed);
@@ -367,36 +544,31 @@ namespace Exiv2 {
                     if (outIo.write(iccProfile_.c_data(), iccProfile_.size()) != iccProfile_.size()) {
                         throw Error(kerImageWriteFailed);
                     }
+                    if (outIo.tell() % 2) {
+                        if (outIo.write(&WEBP_PAD_ODD, 1) != 1) throw Error(kerImageWriteFailed);
+                    }
                     has_icc = false;
                 }
-            } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_ICCP)) {
+            } else if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_ICCP)) {
                 // Skip it altogether handle it prior to here :)
-            } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_EXIF)) {
+            } else if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_EXIF)) {
                 // Skip and add new data afterwards
-            } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_XMP)) {
+            } else if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_XMP)) {
                 // Skip and add new data afterwards
+            } else if (equalsWebPTag(chunk.type_, WEBP_CHUNK_HEADER_JUNK)) {
+                // Padding, e.g., left by writeInPlace(), is dropped
             } else {
-                if (outIo.write(chunkId.c_data(), WEBP_TAG_SIZE) != WEBP_TAG_SIZE)
-                    throw Error(kerImageWriteFailed);
-                if (outIo.write(size_buff, WEBP_TAG_SIZE) != WEBP_TAG_SIZE)
-                    throw Error(kerImageWriteFailed);
-                if (outIo.write(payload.c_data(), payload.size()) != payload.size())
-                    throw Error(kerImageWriteFailed);
-            }
-
-            // Encoder required to pad odd sized data with a null byte
-            if (outIo.tell() % 2) {
-                if (outIo.write(&WEBP_PAD_ODD, 1) != 1) throw Error(kerImageWriteFailed);
+                addToRun(chunk);
             }
         }
+        copyRun();
 
         if (has_exif) {
             if (outIo.write(reinterpret_cast<const byte*>(WEBP_CHUNK_HEADER_EXIF), WEBP_TAG_SIZE) != WEBP_TAG_SIZE)
                 throw Error(kerImageWriteFailed);
-            us2Data(data, static_cast<uint16_t>(blob.size()) + 8, bigEndian);
-            ul2Data(data, static_cast<uint32_t>(blob.size()), littleEndian);
+            ul2Data(data, static_cast<uint32_t>(exif.size()), littleEndian);
             if (outIo.write(data, WEBP_TAG_SIZE) != WEBP_TAG_SIZE) throw Error(kerImageWriteFailed);
-            if (outIo.write(&blob[0], static_cast<long>(blob.size())) != static_cast<long>(blob.size())) {
+            if (outIo.write(exif.data(), static_cast<long>(exif.size())) != static_cast<long>(exif.size())) {
                 throw Error(kerImageWriteFailed);
             }
             if (outIo.tell() % 2) {
@@ -407,7 +579,7 @@ namespace Exiv2 {
         if (has_xmp) {
             if (outIo.write(reinterpret_cast<const byte*>(WEBP_CHUNK_HEADER_XMP), WEBP_TAG_SIZE) != WEBP_TAG_SIZE)
                 throw Error(kerImageWriteFailed);
-            ul2Data(data, static_cast<uint32_t>(xmpPacket().size()), littleEndian);
+            ul2Data(data, static_cast<uint32_t>(xmp.size()), littleEndian);
             if (outIo.write(data, WEBP_TAG_SIZE) != WEBP_TAG_SIZE) throw Error(kerImageWriteFailed);
             if (outIo.write(reinterpret_cast<const byte*>(xmp.data()), static_cast<long>(xmp.size())) !=
                 static_cast<long>(xmp.size())) {
@@ -419,13 +591,12 @@ namespace Exiv2 {
         }
 
         // Fix File Size Payload Data
-        outIo.seek(0, BasicIo::beg);
-        filesize = outIo.size() - 8;
+        const long filesize = static_cast<long>(outIo.size()) - 8;
         outIo.seek(4, BasicIo::beg);
         ul2Data(data, static_cast<uint32_t>(filesize), littleEndian);
         if (outIo.write(data, WEBP_TAG_SIZE) != WEBP_TAG_SIZE) throw Error(kerImageWriteFailed);
 
-    } // WebPImage::writeMetadata
+    } // WebPImage::doWriteMetadata
 
     /* =========================================== */
 
@@ -506,52 +677,32 @@ namespace Exiv2 {
             throw Error(kerNotAJpeg);
         }
         clearMetadata();
+        chunkIndex_.reset();
 
-        byte data[12];
-        DataBuf chunkId(5);
-        chunkId.write_uint8(4, '\0');
-
-        io_->readOrThrow(data, WEBP_TAG_SIZE * 3, Exiv2::kerCorruptedMetadata);
-
-        const uint32_t filesize_u32 =
-            Safe::add(Exiv2::getULong(data + WEBP_TAG_SIZE, littleEndian), 8U);
-        enforce(filesize_u32 <= io_->size(), Exiv2::kerCorruptedMetadata);
-
-        // Check that `filesize_u32` is safe to cast to `long`.
-        enforce(filesize_u32 <= static_cast<size_t>(std::numeric_limits<unsigned int>::max()),
-                Exiv2::kerCorruptedMetadata);
-
-        WebPImage::decodeChunks(static_cast<long>(filesize_u32));
+        // Index the chunks as they are read, for writeMetadata()
+        auto index = std::make_unique<WebPChunkIndex>(*io_, readRiffHeader(*io_));
+        WebPImage::decodeChunks(*index);
 
+        // Keep the index, it spares writeMetadata() another pass over the chunks
+        chunkIndex_ = std::move(index);
+        setMetadataClean();
     } // WebPImage::readMetadata
 
-    void WebPImage::decodeChunks(long filesize)
+    void WebPImage::decodeChunks(WebPChunkIndex& index)
     {
-        DataBuf   chunkId(5);
-        byte      size_buff[WEBP_TAG_SIZE];
         bool      has_canvas_data = false;
 
 #ifdef EXIV2_DEBUG_MESSAGES
         std::cout << "Reading metadata" << std::endl;
 #endif
 
-        chunkId.write_uint8(4, '\0');
-        while (!io_->eof() && io_->tell() < filesize) {
-            io_->readOrThrow(chunkId.data(), WEBP_TAG_SIZE, Exiv2::kerCorruptedMetadata);
-            io_->readOrThrow(size_buff, WEBP_TAG_SIZE, Exiv2::kerCorruptedMetadata);
+        while (!io_->eof() && io_->tell() < index.end()) {
+            const WebPChunkIndex::Entry& chunk = index.readHeader(*io_);
+            const std::string& chunkId = chunk.type_;
+            const long size = static_cast<long>(chunk.length_);
 
-            const uint32_t size_u32 = Exiv2::getULong(size_buff, littleEndian);
-
-            // Check that `size_u32` is safe to cast to `long`.
-            enforce(static_cast<uint64_t>(size_u32) <= static_cast<unsigned long>(std::numeric_limits<long>::max()),
-                    Exiv2::kerCorruptedMetadata);
-            const long size = static_cast<long>(size_u32);
-
-            // Check that `size` is within bounds.
-            enforce(io_->tell() <= filesize, Exiv2::kerCorruptedMetadata);
-            enforce(size <= (filesize - io_->tell()), Exiv2::kerCorruptedMetadata);
-
-            DataBuf payload(size);
+            // The data of chunks which aren't decoded, like the image data, is skipped
+            DataBuf payload;
 
             if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_VP8X) && !has_canvas_data) {
                 enforce(size >= 10, Exiv2::kerCorruptedMetadata);
@@ -559,6 +710,8 @@ namespace Exiv2 {
                 has_canvas_data = true;
                 byte size_buf[WEBP_TAG_SIZE];
 
+                payload.alloc(size);
+
                 io_->readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
 
                 // Fetch width
@@ -574,6 +727,7 @@ namespace Exiv2 {
                 enforce(size >= 10, Exiv2::kerCorruptedMetadata);
 
                 has_canvas_data = true;
+                payload.alloc(size);
                 io_->readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
                 byte size_buf[WEBP_TAG_SIZE];
 
@@ -595,6 +749,8 @@ namespace Exiv2 {
                 byte size_buf_w[2];
                 byte size_buf_h[3];
 
+                payload.alloc(size);
+
                 io_->readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
 
                 // Fetch width
@@ -613,6 +769,8 @@ namespace Exiv2 {
                 has_canvas_data = true;
                 byte size_buf[WEBP_TAG_SIZE];
 
+                payload.alloc(size);
+
                 io_->readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
 
                 // Fetch width
@@ -625,9 +783,11 @@ namespace Exiv2 {
                 size_buf[3] = 0;
                 pixelHeight_ = Exiv2::getULong(size_buf, littleEndian) + 1;
             } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_ICCP)) {
+                payload.alloc(size);
                 io_->readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
                 this->setIccProfile(std::move(payload));
             } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_EXIF)) {
+                payload.alloc(size);
                 io_->readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
 
                 byte  size_buff2[2];
@@ -706,6 +866,7 @@ namespace Exiv2 {
                     exifData_.clear();
                 }
             } else if (equalsWebPTag(chunkId, WEBP_CHUNK_HEADER_XMP)) {
+                payload.alloc(size);
                 io_->readOrThrow(payload.data(), payload.size(), Exiv2::kerCorruptedMetadata);
                 xmpPacket_.assign(payload.c_str(), payload.size());
                 if (!xmpPacket_.empty() && XmpParser::decode(xmpData_, xmpPacket_)) {
@@ -772,6 +933,14 @@ namespace Exiv2 {
         return true;
     }
 
+    //! Overload of equalsWebPTag() for a chunk type of the chunk index
+    bool WebPImage::equalsWebPTag(const std::string& type, const char* str) {
+        for(int i = 0; i < 4; i++ )
+            if(toupper(static_cast<unsigned char>(type[i])) != str[i])
+                return false;
+        return true;
+    }
+
 
     /*!
      @brief Function used to add missing EXIF & XMP flags
@@ -841,14 +1010,9 @@ namespace Exiv2 {
     long WebPImage::getHeaderOffset(const byte* data, long data_size, const byte* header, long header_size)
     {
         if (data_size < header_size) { return -1; }
-        long pos = -1;
-        for (long i=0; i < data_size - header_size; i++) {
-            if (memcmp(header, &data[i], header_size) == 0) {
-                pos = i;
-                break;
-            }
-        }
-        return pos;
+        const byte* last = data + data_size;
+        const byte* pos = findPattern(data, last, std::string(reinterpret_cast<const char*>(header), header_size));
+        return pos == last ? -1 : static_cast<long>(pos - data);
     }
 
 } // namespace Exiv2
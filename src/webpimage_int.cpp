@@ -0,0 +1,67 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+// *****************************************************************************
+// included header files
+#include "config.h"
+
+#include "webpimage_int.hpp"
+#include "basicio.hpp"
+#include "enforce.hpp"
+#include "error.hpp"
+#include "image_int.hpp"
+
+// + standard includes
+#include <limits>
+
+// *****************************************************************************
+// class member definitions
+namespace Exiv2 {
+    namespace Internal {
+
+    WebPChunkIndex::WebPChunkIndex(const BasicIo& io, long end) : BlockIndex(io, end)
+    {
+    }
+
+    const WebPChunkIndex::Entry& WebPChunkIndex::readHeader(BasicIo& io)
+    {
+        const long offset = io.tell();
+        byte header[8];  // Chunk header: 4 bytes (chunk type) + 4 bytes (data size).
+        io.readOrThrow(header, sizeof(header), kerCorruptedMetadata);
+
+        // Check that the chunk data is within the container
+        const uint32_t length = getULong(header + 4, littleEndian);
+        enforce(static_cast<uint64_t>(length) <= static_cast<uint64_t>(std::numeric_limits<long>::max()),
+                kerCorruptedMetadata);
+        const long pos = io.tell();
+        enforce(pos <= end(), kerCorruptedMetadata);
+        enforce(static_cast<long>(length) <= end() - pos, kerCorruptedMetadata);
+
+        chunks_.push_back({std::string(reinterpret_cast<const char*>(header), 4), offset, length});
+        return chunks_.back();
+    }
+
+    long WebPChunkIndex::nextBlock(BasicIo& io)
+    {
+        // The next chunk starts at an even offset
+        const Entry& chunk = readHeader(io);
+        return chunk.offset_ + chunk.size();
+    }
+
+}}                                      // namespace Internal, Exiv2
@@ -0,0 +1,103 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef WEBPIMAGE_INT_HPP_
+#define WEBPIMAGE_INT_HPP_
+
+// *****************************************************************************
+// included header files
+#include "types.hpp"
+#include "image_int.hpp"
+
+// + standard includes
+#include <string>
+#include <vector>
+
+// *****************************************************************************
+// namespace extensions
+namespace Exiv2 {
+
+// *****************************************************************************
+// class declarations
+    class BasicIo;
+
+    namespace Internal {
+
+// *****************************************************************************
+// class definitions
+
+    /*!
+      @brief Index of the chunks of the RIFF container of a WebP image. It is
+             built in one pass over the chunk headers, either while the
+             chunks are read (readHeader()) or seeking over the chunk data
+             (readAll()).
+     */
+    class WebPChunkIndex : public BlockIndex {
+    public:
+        //! Position of a chunk in the image
+        struct Entry {
+            std::string type_;  //!< Chunk type, 4 characters
+            long offset_;       //!< Offset of the chunk, i.e., of its type
+            uint32_t length_;   //!< Length of the chunk data
+
+            //! Return the offset of the chunk data
+            long payload() const { return offset_ + 8; }
+            //! Return the size of the whole chunk: type, length, data and padding
+            long size() const { return 8 + static_cast<long>(length_) + static_cast<long>(length_ & 1); }
+        };
+
+        //! @name Creators
+        //@{
+        /*!
+          @brief Constructor for an empty index of the chunks of \em io, which
+                 end at \em end, the end of the RIFF container.
+         */
+        WebPChunkIndex(const BasicIo& io, long end);
+        //@}
+
+        //! @name Manipulators
+        //@{
+        /*!
+          @brief Read the header of the chunk at the current position of \em io
+                 and add the chunk to the index. On return, \em io is positioned
+                 at the chunk data.
+          @return The new entry.
+          @throw Error if the header can't be read or the chunk exceeds the container.
+         */
+        const Entry& readHeader(BasicIo& io);
+        //@}
+
+        //! @name Accessors
+        //@{
+        //! Return the chunks, in the order of the image.
+        const std::vector<Entry>& chunks() const { return chunks_; }
+        //@}
+
+    protected:
+        //! Add the chunk at the current position of \em io.
+        long nextBlock(BasicIo& io) override;
+
+    private:
+        // DATA
+        std::vector<Entry> chunks_;  //!< The chunks
+    }; // class WebPChunkIndex
+
+}}                                      // namespace Internal, Exiv2
+
+#endif                                  // #ifndef WEBPIMAGE_INT_HPP_
@@ -328,14 +328,23 @@ namespace Exiv2 {
     {
     }
 
+    Xmpdatum::Xmpdatum(Xmpdatum&& rhs) noexcept = default;
+
     Xmpdatum& Xmpdatum::operator=(const Xmpdatum& rhs)
     {
         if (this == &rhs) return *this;
         Metadatum::operator=(rhs);
-        *p_ = *rhs.p_;
+        if (p_) {
+            *p_ = *rhs.p_;
+        } else {
+            // Assignment to a moved-from object
+            p_ = std::make_unique<Impl>(*rhs.p_);
+        }
         return *this;
     }
 
+    Xmpdatum& Xmpdatum::operator=(Xmpdatum&& rhs) noexcept = default;
+
     Xmpdatum::~Xmpdatum() = default;
 
     std::string Xmpdatum::key() const
@@ -493,6 +502,12 @@ namespace Exiv2 {
         return 0;
     }
 
+    int XmpData::add(Xmpdatum&& xmpDatum)
+    {
+        xmpMetadata_.push_back(std::move(xmpDatum));
+        return 0;
+    }
+
     XmpData::const_iterator XmpData::findKey(const XmpKey& key) const
     {
         return std::find_if(xmpMetadata_.begin(), xmpMetadata_.end(),
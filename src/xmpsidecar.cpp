@@ -175,7 +175,7 @@ namespace Exiv2 {
             if (xmpPacket_.substr(0, 5)  != "<?xml") {
                 xmpPacket_ = xmlHeader + xmpPacket_ + xmlFooter;
             }
-            auto tempIo = std::make_unique<MemIo>();
+            auto tempIo = std::make_unique<TempIo>(*io_);
 
             // Write XMP packet
             if (   tempIo->write(reinterpret_cast<const byte*>(xmpPacket_.data()),
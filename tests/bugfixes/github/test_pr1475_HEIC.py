@@ -506,6 +506,10 @@ Exiv2::BmffImage::boxHandler: meta       28->921
        131 |       18 |   ID | 20006 | 359200,330132
        149 |       18 |   ID | 20007 | 689340, 28758
   Exiv2::BmffImage::boxHandler: iinf      175->140 
+    Exiv2::BmffImage::boxHandler: infe      191->31 ID = 20004 hvc1HEVC Image 
+    Exiv2::BmffImage::boxHandler: infe      222->31 ID = 20005 hvc1HEVC Image 
+    Exiv2::BmffImage::boxHandler: infe      253->31 ID = 20006 hvc1HEVC Image 
+    Exiv2::BmffImage::boxHandler: infe      284->31 ID = 20007 hvc1HEVC Image 
   Exiv2::BmffImage::boxHandler: iref      315->40 
   Exiv2::BmffImage::boxHandler: iprp      355->594 
     Exiv2::BmffImage::boxHandler: ipco      363->550 
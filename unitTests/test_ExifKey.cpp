@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <exiv2/error.hpp>
+#include <exiv2/tags.hpp>
+
+#include "tags_int.hpp"
+
+using namespace Exiv2;
+using namespace Exiv2::Internal;
+
+TEST(ExifKey, creationFromTagAndIfdIdMatchesKeyString)
+{
+    const ExifKey key(0x010f, ifd0Id, nullptr);
+    ASSERT_EQ(0x010f, key.tag());
+    ASSERT_EQ(ifd0Id, key.ifdId());
+    ASSERT_EQ("Image", key.groupName());
+    ASSERT_EQ("Make", key.tagName());
+    ASSERT_EQ("Exif.Image.Make", key.key());
+    ASSERT_EQ(ExifKey("Exif.Image.Make").key(), key.key());
+}
+
+TEST(ExifKey, creationFromTagAndIfdIdUsesGivenTagInfo)
+{
+    const TagInfo* ti = tagInfo(0x829a, exifId);
+    ASSERT_NE(nullptr, ti);
+    const ExifKey key(0x829a, exifId, ti);
+    ASSERT_EQ("Exif.Photo.ExposureTime", key.key());
+    ASSERT_EQ(ti->typeId_, key.defaultTypeId());
+}
+
+TEST(ExifKey, creationFromTagAndIfdIdWithUnknownTag)
+{
+    const ExifKey key(0xbeef, exifId, nullptr);
+    ASSERT_EQ("0xbeef", key.tagName());
+    ASSERT_EQ("Exif.Photo.0xbeef", key.key());
+}
+
+TEST(ExifKey, copyOfLazyKeyHasSameKey)
+{
+    const ExifKey key(0x0110, ifd0Id, nullptr);
+    const ExifKey copy(key);
+    auto clone = key.clone();
+    ASSERT_EQ("Exif.Image.Model", copy.key());
+    ASSERT_EQ("Exif.Image.Model", clone->key());
+    ASSERT_EQ("Exif.Image.Model", key.key());
+}
+
+TEST(ExifKey, creationFromTagAndNonExifIfdIdThrows)
+{
+    try {
+        ExifKey key(0x010f, ignoreId, nullptr);
+        FAIL();
+    } catch (const Exiv2::Error& e) {
+        ASSERT_EQ(kerInvalidIfdId, e.code());
+    }
+}
@@ -20,6 +20,13 @@
 
 #include "basicio.hpp"
 #include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
 using namespace Exiv2;
 
 namespace
@@ -108,3 +115,153 @@ TEST(AFileIO, canSeekBeyondEOF)
     ASSERT_FALSE(file.error());
     ASSERT_FALSE(file.eof());
 }
+
+TEST(AFileIO, readAtReadsWithoutMovingThePosition)
+{
+    FileIo file(imagePath);
+    file.open();
+    std::vector<byte> expected(64), actual(64);
+    ASSERT_EQ(0, file.seek(1000, BasicIo::beg));
+    ASSERT_EQ(64, file.read(expected.data(), 64));
+
+    ASSERT_EQ(0, file.seek(10, BasicIo::beg));
+    ASSERT_EQ(64, file.readAt(1000, actual.data(), 64));
+    ASSERT_EQ(expected, actual);
+    ASSERT_EQ(10, file.tell());
+}
+
+TEST(AFileIO, readAtStopsAtTheEndOfTheFile)
+{
+    FileIo file(imagePath);
+    file.open();
+    std::vector<byte> buf(64);
+    ASSERT_EQ(5, file.readAt(118680, buf.data(), 64));
+    ASSERT_EQ(0, file.readAt(118685, buf.data(), 64));
+    ASSERT_EQ(0, file.readAt(-1, buf.data(), 64));
+}
+
+TEST(AFileIO, readAtSeesBufferedWritesAndKeepsWriting)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "exiv2-test-readat").string();
+    FileIo file(path);
+    ASSERT_EQ(0, file.open("w+b"));
+    const byte data[] = {'a', 'b', 'c', 'd'};
+    ASSERT_EQ(4, file.write(data, 4));
+    byte buf[2] = {};
+    ASSERT_EQ(2, file.readAt(1, buf, 2));
+    ASSERT_EQ('b', buf[0]);
+    ASSERT_EQ('c', buf[1]);
+    ASSERT_EQ(4, file.tell());
+    ASSERT_EQ(4, file.write(data, 4));
+    ASSERT_EQ(0, file.close());
+    ASSERT_EQ(8u, std::filesystem::file_size(path));
+    std::filesystem::remove(path);
+}
+
+TEST(AFileIO, readAtCanBeUsedFromSeveralThreads)
+{
+    FileIo file(imagePath);
+    file.open();
+    const long size = static_cast<long>(file.size());
+    std::vector<byte> expected(size);
+    ASSERT_EQ(size, file.read(expected.data(), size));
+
+    const int threads = 4;
+    std::vector<std::vector<byte>> results(threads, std::vector<byte>(size));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (long offset = 0; offset < size; offset += 4096) {
+                const long n = std::min(4096L, size - offset);
+                file.readAt(offset, results[t].data() + offset, n);
+            }
+        });
+    }
+    for (auto&& w : workers)
+        w.join();
+    for (auto&& r : results)
+        ASSERT_EQ(expected, r);
+}
+
+namespace
+{
+    //! Return a path for a file in the temporary directory
+    std::string tempPath(const std::string& name)
+    {
+        return (std::filesystem::temp_directory_path() / ("exiv2-test-" + name)).string();
+    }
+
+    //! Return 64 KiB and a few bytes of data which differ from one block to the next
+    std::vector<byte> copyData()
+    {
+        std::vector<byte> data(64 * 1024 + 3);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<byte>(i * 7 + i / 4096);
+        }
+        return data;
+    }
+
+    //! Return the contents of the file \em path
+    std::vector<byte> fileContents(const std::string& path)
+    {
+        FileIo io(path);
+        EXPECT_EQ(0, io.open());
+        std::vector<byte> data(io.size());
+        if (!data.empty()) {
+            EXPECT_EQ(static_cast<long>(data.size()), io.read(data.data(), static_cast<long>(data.size())));
+        }
+        return data;
+    }
+}  // namespace
+
+TEST(AFileIO, writeCopiesTheRestOfAnotherFile)
+{
+    const std::vector<byte> data = copyData();
+    const std::string srcPath = tempPath("copy-src");
+    const std::string dstPath = tempPath("copy-dst");
+    {
+        FileIo src(srcPath);
+        ASSERT_EQ(0, src.open("w+b"));
+        ASSERT_EQ(static_cast<long>(data.size()), src.write(data.data(), static_cast<long>(data.size())));
+        ASSERT_EQ(0, src.seek(5, BasicIo::beg));
+
+        FileIo dst(dstPath);
+        ASSERT_EQ(0, dst.open("w+b"));
+        ASSERT_EQ(2, dst.write(data.data(), 2));
+        ASSERT_EQ(static_cast<long>(data.size()) - 5, dst.write(src));
+        ASSERT_EQ(static_cast<long>(data.size()), src.tell());
+        // Both files can be used as before
+        ASSERT_EQ('x', dst.putb('x'));
+        ASSERT_EQ(0, src.seek(-1, BasicIo::end));
+        ASSERT_EQ(data.back(), src.getb());
+    }
+    std::vector<byte> expected(data.begin(), data.begin() + 2);
+    expected.insert(expected.end(), data.begin() + 5, data.end());
+    expected.push_back('x');
+    EXPECT_EQ(expected, fileContents(dstPath));
+    std::remove(srcPath.c_str());
+    std::remove(dstPath.c_str());
+}
+
+TEST(AFileIO, transferCopiesTempIoData)
+{
+    std::vector<byte> data = copyData();
+    const std::string path = tempPath("transfer");
+    for (size_t threshold : {size_t(0), data.size()}) {
+        FileIo file(path);
+        ASSERT_EQ(0, file.open("w+b"));
+        ASSERT_EQ(1, file.write(data.data(), 1));
+        file.close();
+
+        TempIo io(file, threshold);
+        ASSERT_EQ(static_cast<long>(data.size()), io.write(data.data(), static_cast<long>(data.size())));
+        ASSERT_EQ(threshold == 0, io.isSpilled());
+        // Update the data like the writers which patch sizes in the end
+        data[1] = 'x';
+        ASSERT_EQ(0, io.seek(1, BasicIo::beg));
+        ASSERT_EQ('x', io.putb('x'));
+        file.transfer(io);
+        EXPECT_EQ(data, fileContents(path));
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/bmffimage.hpp>
+#include <exiv2/image.hpp>
+#include <exiv2/jp2image.hpp>
+#include <exiv2/jpgimage.hpp>
+#include <exiv2/pngimage.hpp>
+#include <exiv2/tiffimage.hpp>
+#include <exiv2/webpimage.hpp>
+#include <exiv2/xmpsidecar.hpp>
+
+#include <string>
+
+using namespace Exiv2;
+
+namespace {
+    //! MemIo which counts the number of read calls
+    class CountingMemIo : public MemIo {
+    public:
+        CountingMemIo(const byte* data, long size) : MemIo(data, size) {}
+
+        long read(byte* buf, long rcount) override
+        {
+            reads_++;
+            return MemIo::read(buf, rcount);
+        }
+        DataBuf read(long rcount) override
+        {
+            reads_++;
+            return MemIo::read(rcount);
+        }
+
+        int reads_{0};
+    };
+
+    int typeOf(const std::string& data, int* reads = nullptr)
+    {
+        CountingMemIo io(reinterpret_cast<const byte*>(data.data()), static_cast<long>(data.size()));
+        const int type = ImageFactory::getType(io);
+        if (reads)
+            *reads = io.reads_;
+        return type;
+    }
+}  // namespace
+
+TEST(ImageFactory, getTypeRecognizesSignatures)
+{
+    ASSERT_EQ(ImageType::jpeg, typeOf(std::string("\xff\xd8\xff\xe0\0\x10JFIF\0", 13)));
+    ASSERT_EQ(ImageType::exv, typeOf(std::string("\xff\x01" "Exiv2\xff\xd9", 9)));
+    ASSERT_EQ(ImageType::tiff, typeOf(std::string("II*\0\x08\0\0\0\0\0\0\0", 12)));
+    ASSERT_EQ(ImageType::tiff, typeOf(std::string("MM\0*\0\0\0\x08\0\0\0\0", 12)));
+    ASSERT_EQ(ImageType::webp, typeOf(std::string("RIFF\x04\0\0\0WEBP", 12)));
+#ifdef EXV_HAVE_LIBZ
+    ASSERT_EQ(ImageType::png, typeOf(std::string("\x89PNG\r\n\x1a\n\0\0\0\0", 12)));
+#endif
+    ASSERT_EQ(ImageType::xmp, typeOf("<?xpacket begin=\"\xef\xbb\xbf\" id=\"W5M0MpCehiHzreSzNTczkc9d\"?>\n"));
+#ifdef EXV_ENABLE_BMFF
+    const bool bmff = enableBMFF(true);
+    ASSERT_EQ(ImageType::bmff, typeOf(std::string("\0\0\0\x14" "ftypavif\0\0\0\0", 16)));
+    enableBMFF(bmff);
+#endif
+}
+
+TEST(ImageFactory, getTypeReturnsNoneForUnknownData)
+{
+    ASSERT_EQ(ImageType::none, typeOf(""));
+    ASSERT_EQ(ImageType::none, typeOf("X"));
+    ASSERT_EQ(ImageType::none, typeOf(std::string(1000, 'X')));
+    // Matching signature, but failing type check
+    ASSERT_EQ(ImageType::none, typeOf(std::string("II\0\0\0\0\0\0", 8)));
+}
+
+TEST(ImageFactory, getTypeReadsOnce)
+{
+    int reads = 0;
+    typeOf(std::string("\xff\xd8\xff\xe0\0\x10JFIF\0", 13), &reads);
+    ASSERT_EQ(1, reads);
+
+    // The last entries in the registry need the same single read
+    std::string data(4096, '\0');
+    data.replace(0, 12, "\0\0\0\x0cjP  \r\n\x87\n", 12);
+    ASSERT_EQ(ImageType::jp2, typeOf(data, &reads));
+    ASSERT_EQ(1, reads);
+
+    typeOf(std::string(4096, 'X'), &reads);
+    ASSERT_EQ(1, reads);
+}
+
+namespace {
+    ImageProbe probeFile(const std::string& name)
+    {
+        FileIo io(std::string(TESTDATA_PATH) + "/" + name);
+        return ImageFactory::probe(io);
+    }
+}  // namespace
+
+TEST(ImageFactory, probeJpegReadsOnlyTheHeaders)
+{
+    const ImageProbe probe = probeFile("Reagan.jpg");
+    ASSERT_EQ(ImageType::jpeg, probe.imageType_);
+    ASSERT_EQ("image/jpeg", probe.mimeType_);
+    ASSERT_EQ(200u, probe.pixelWidth_);
+    ASSERT_EQ(130u, probe.pixelHeight_);
+    ASSERT_TRUE(probe.hasExif_);
+    ASSERT_TRUE(probe.hasIptc_);
+    ASSERT_TRUE(probe.hasXmp_);
+    ASSERT_TRUE(probe.hasIccProfile_);
+    ASSERT_LT(probe.bytesRead_, 1024u);
+}
+
+#ifdef EXV_HAVE_LIBZ
+TEST(ImageFactory, probePng)
+{
+    const ImageProbe probe = probeFile("ReaganLargePng.png");
+    ASSERT_EQ(ImageType::png, probe.imageType_);
+    ASSERT_EQ(200u, probe.pixelWidth_);
+    ASSERT_EQ(130u, probe.pixelHeight_);
+    ASSERT_TRUE(probe.hasExif_);
+    ASSERT_TRUE(probe.hasIptc_);
+    ASSERT_TRUE(probe.hasXmp_);
+    ASSERT_TRUE(probe.hasIccProfile_);
+    ASSERT_LT(probe.bytesRead_, 1024u);
+}
+#endif
+
+TEST(ImageFactory, probeTiff)
+{
+    const ImageProbe probe = probeFile("Reagan.tiff");
+    ASSERT_EQ(ImageType::tiff, probe.imageType_);
+    ASSERT_EQ("image/tiff", probe.mimeType_);
+    ASSERT_EQ(200u, probe.pixelWidth_);
+    ASSERT_EQ(130u, probe.pixelHeight_);
+    ASSERT_TRUE(probe.hasExif_);
+    ASSERT_TRUE(probe.hasIptc_);
+    ASSERT_TRUE(probe.hasXmp_);
+    ASSERT_TRUE(probe.hasIccProfile_);
+}
+
+TEST(ImageFactory, probeTiffWithoutExifTags)
+{
+    // IFD0 with only ImageWidth and ImageLength
+    const std::string data("II*\0\x08\0\0\0\x02\0"
+                           "\0\x01\x03\0\x01\0\0\0\x0a\0\0\0"
+                           "\x01\x01\x03\0\x01\0\0\0\x05\0\0\0"
+                           "\0\0\0\0", 38);
+    MemIo io(reinterpret_cast<const byte*>(data.data()), static_cast<long>(data.size()));
+    ImageProbe probe = ImageFactory::probe(io);
+    ASSERT_EQ(ImageType::tiff, probe.imageType_);
+    ASSERT_EQ(10u, probe.pixelWidth_);
+    ASSERT_EQ(5u, probe.pixelHeight_);
+    ASSERT_FALSE(probe.hasExif_);
+
+    // The same IFD with an Exif IFD pointer
+    std::string exif(data);
+    exif.replace(8, 2, "\x03\0", 2);
+    exif.replace(34, 4, std::string("\x69\x87\x04\0\x01\0\0\0\0\0\0\0\0\0\0\0", 16));
+    MemIo exifIo(reinterpret_cast<const byte*>(exif.data()), static_cast<long>(exif.size()));
+    probe = ImageFactory::probe(exifIo);
+    ASSERT_EQ(10u, probe.pixelWidth_);
+    ASSERT_TRUE(probe.hasExif_);
+}
+
+#ifdef EXV_ENABLE_BMFF
+TEST(ImageFactory, probeBmffSkipsEmptyItemInfoEntries)
+{
+    const std::string data("\0\0\0\x10" "ftyp" "heic" "\0\0\0\0"
+                           "\0\0\0\x37" "meta" "\0\0\0\0"
+                           "\0\0\0\x2b" "iinf" "\0\0\0\0" "\0\x02"
+                           "\0\0\0\x15" "infe" "\x02\0\0\0" "\0\x01" "\0\0" "Exif" "\0"
+                           "\0\0\0\x08" "infe", 71);
+    MemIo io(reinterpret_cast<const byte*>(data.data()), static_cast<long>(data.size()));
+    const ImageProbe probe = ImageFactory::probe(io);
+    ASSERT_EQ(ImageType::bmff, probe.imageType_);
+    ASSERT_EQ("image/heic", probe.mimeType_);
+    ASSERT_TRUE(probe.hasExif_);
+    ASSERT_FALSE(probe.hasXmp_);
+}
+#endif
+
+TEST(ImageFactory, probeWebpNeedsOnlyThePrefix)
+{
+    const ImageProbe probe = probeFile("exiv2-bug1199.webp");
+    ASSERT_EQ(ImageType::webp, probe.imageType_);
+    ASSERT_EQ(1200u, probe.pixelWidth_);
+    ASSERT_EQ(800u, probe.pixelHeight_);
+    ASSERT_TRUE(probe.hasExif_);
+    ASSERT_FALSE(probe.hasIptc_);
+    ASSERT_TRUE(probe.hasXmp_);
+    ASSERT_TRUE(probe.hasIccProfile_);
+    ASSERT_EQ(128u, probe.bytesRead_);
+}
+
+TEST(ImageFactory, probeUnknownData)
+{
+    const std::string data(1000, 'X');
+    MemIo io(reinterpret_cast<const byte*>(data.data()), static_cast<long>(data.size()));
+    const ImageProbe probe = ImageFactory::probe(io);
+    ASSERT_EQ(ImageType::none, probe.imageType_);
+    ASSERT_TRUE(probe.mimeType_.empty());
+    ASSERT_EQ(0u, probe.pixelWidth_);
+    ASSERT_FALSE(probe.hasExif_);
+}
+
+TEST(ImageFactory, probeThrowsIfTheFileDoesNotExist)
+{
+    FileIo io("does-not-exist.jpg");
+    ASSERT_THROW(ImageFactory::probe(io), Exiv2::Error);
+}
@@ -0,0 +1,194 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2021 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <gtest/gtest.h>
+
+#include <exiv2/exif.hpp>
+#include <exiv2/iptc.hpp>
+#include <exiv2/xmp_exiv2.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+
+using namespace Exiv2;
+
+// This file is built into its own test program, unit_tests_allocations, as it
+// replaces the global operator new to count the allocations.
+namespace {
+    //! Number of calls to the global operator new since the start of the program
+    std::atomic<long> allocations{0};
+
+    //! Returns the number of allocations made by \em f
+    template <typename F>
+    long countAllocations(F f)
+    {
+        const long before = allocations.load();
+        f();
+        return allocations.load() - before;
+    }
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST(AMetadataContainer, addsExifKeyAndValueWithOneClone)
+{
+    const ExifKey key("Exif.Image.Make");
+    // Too large to be held inline
+    const AsciiValue value("Exiv2 metadata library");
+    const long perDatum = countAllocations([&] { Exifdatum datum(key, &value); });
+    ASSERT_GT(perDatum, 0);
+
+    ExifData exifData;
+    // One clone of key and value plus the list node
+    EXPECT_EQ(perDatum + 1, countAllocations([&] { exifData.add(key, &value); }));
+    EXPECT_EQ(perDatum + 1, countAllocations([&] { exifData.add(key, &value); }));
+    ASSERT_EQ(2, exifData.count());
+    EXPECT_EQ("Exiv2 metadata library", exifData.begin()->toString());
+}
+
+TEST(AMetadataContainer, addsIptcKeyAndValueWithOneClone)
+{
+    const IptcKey key("Iptc.Application2.Keywords");
+    StringValue value("Exiv2");
+    const long perDatum = countAllocations([&] { Iptcdatum datum(key, &value); });
+    ASSERT_GT(perDatum, 0);
+
+    IptcData iptcData;
+    // One clone of key and value, at most one allocation to grow the vector
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_LE(countAllocations([&] { iptcData.add(key, &value); }), perDatum + 1);
+    }
+    ASSERT_EQ(8, iptcData.count());
+    EXPECT_EQ("Exiv2", iptcData.begin()->toString());
+}
+
+TEST(AMetadataContainer, addsXmpKeyAndValueWithOneClone)
+{
+    const XmpKey key("Xmp.dc.format");
+    const XmpTextValue value("image/jpeg");
+    const long perDatum = countAllocations([&] { Xmpdatum datum(key, &value); });
+    ASSERT_GT(perDatum, 0);
+
+    XmpData xmpData;
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_LE(countAllocations([&] { xmpData.add(key, &value); }), perDatum + 1);
+    }
+    ASSERT_EQ(8, xmpData.count());
+    EXPECT_EQ("image/jpeg", xmpData.begin()->toString());
+}
+
+TEST(AMetadataContainer, takesOverAMovedDatumWithoutAllocating)
+{
+    ExifData exifData;
+    AsciiValue value("Exiv2");
+    Exifdatum datum(ExifKey("Exif.Image.Model"), &value);
+    EXPECT_EQ(1, countAllocations([&] { exifData.add(std::move(datum)); }));
+    ASSERT_EQ(1, exifData.count());
+    EXPECT_EQ("Exif.Image.Model", exifData.begin()->key());
+    EXPECT_EQ("Exiv2", exifData.begin()->toString());
+
+    XmpData xmpData;
+    XmpTextValue xmpValue("image/jpeg");
+    Xmpdatum xmpDatum(XmpKey("Xmp.dc.format"), &xmpValue);
+    EXPECT_LE(countAllocations([&] { xmpData.add(std::move(xmpDatum)); }), 1);
+    ASSERT_EQ(1, xmpData.count());
+    EXPECT_EQ("Xmp.dc.format", xmpData.begin()->key());
+    // A moved-from datum can be assigned to again
+    xmpDatum = *xmpData.begin();
+    EXPECT_EQ("image/jpeg", xmpDatum.toString());
+}
+
+TEST(AnExifdatum, holdsSmallValuesWithoutAllocating)
+{
+    const ExifKey key("Exif.Photo.ExposureTime");
+    URationalValue value;
+    value.value_.emplace_back(1, 250);
+
+    ExifData exifData;
+    // Only the list node is allocated
+    EXPECT_EQ(1, countAllocations([&] { exifData.add(key, &value); }));
+    const Exifdatum& datum = *exifData.begin();
+    EXPECT_EQ(0, countAllocations([&] { EXPECT_EQ(unsignedRational, datum.typeId()); }));
+    EXPECT_EQ(0, countAllocations([&] { EXPECT_EQ(1, datum.count()); }));
+    EXPECT_EQ(0, countAllocations([&] { EXPECT_EQ(8, datum.size()); }));
+    EXPECT_EQ(0, countAllocations([&] { EXPECT_EQ(0x829a, datum.tag()); }));
+    EXPECT_EQ("Exif.Photo.ExposureTime", datum.key());
+    EXPECT_EQ("1/250", datum.toString());
+    EXPECT_EQ("1/250 s", datum.print(&exifData));
+    // The value is made once, reading it again doesn't allocate
+    byte buf[8];
+    EXPECT_EQ(0, countAllocations([&] { EXPECT_EQ(Rational(1, 250), datum.toRational()); }));
+    EXPECT_EQ(0, countAllocations([&] { EXPECT_EQ(0, datum.toLong()); }));
+    EXPECT_EQ(0, countAllocations([&] { EXPECT_EQ(8, datum.copy(buf, bigEndian)); }));
+
+    Exifdatum copy(datum);
+    EXPECT_EQ(Rational(1, 250), copy.value().toRational());
+}
+
+TEST(AnExifdatum, keepsSmallValuesOfAllInlineTypes)
+{
+    ExifData exifData;
+    const char* const values[] = {"1 2 3 4", "-7", "65536 7", "-65536", "3/4", "-3/4", "1.5", "2.25", "abc", "1 2 3 4 5 6 7 8"};
+    const TypeId types[] = {unsignedShort, signedShort, unsignedLong, signedLong, unsignedRational,
+                            signedRational, tiffFloat, tiffDouble, asciiString, undefined};
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+        auto value = Value::create(types[i]);
+        ASSERT_EQ(0, value->read(values[i]));
+        Exifdatum datum(ExifKey("Exif.Image.Software"), value.get());
+        EXPECT_EQ(types[i], datum.typeId());
+        EXPECT_EQ(value->count(), datum.count());
+        EXPECT_EQ(value->toString(), datum.toString());
+        EXPECT_EQ(value->toString(), datum.value().toString());
+        EXPECT_EQ(value->toString(), datum.getValue()->toString());
+
+        byte expected[16];
+        byte actual[16];
+        ASSERT_EQ(value->copy(expected, bigEndian), datum.copy(actual, bigEndian));
+        EXPECT_EQ(0, memcmp(expected, actual, value->size()));
+    }
+}
+
+TEST(AnExifdatum, readsAStringIntoASmallValue)
+{
+    Exifdatum datum(ExifKey("Exif.Image.Orientation"));
+    datum = static_cast<uint16_t>(1);
+    EXPECT_EQ(1, datum.toLong());
+    EXPECT_EQ(0, datum.setValue("6"));
+    EXPECT_EQ(6, datum.toLong());
+    EXPECT_EQ(unsignedShort, datum.typeId());
+}
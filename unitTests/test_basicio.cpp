@@ -22,6 +22,11 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
 
 using namespace Exiv2;
 
@@ -166,3 +171,138 @@ TEST(MemIo, readMoreBytesThanAvailableReturnsAvailableBytes)
     MemIo io(buf1.data(), static_cast<long>(buf1.size()));
     ASSERT_EQ(10, io.read(buf2.data(), 15));
 }
+
+TEST(MemIo, readAtDoesNotMoveThePosition)
+{
+    std::array<byte, 10> buf1, buf2;
+    for (size_t i = 0; i < buf1.size(); ++i)
+        buf1[i] = static_cast<byte>(i);
+
+    MemIo io(buf1.data(), static_cast<long>(buf1.size()));
+    ASSERT_EQ(0, io.seek(2, BasicIo::beg));
+    ASSERT_EQ(3, io.readAt(5, buf2.data(), 3));
+    ASSERT_EQ(5, buf2[0]);
+    ASSERT_EQ(7, buf2[2]);
+    ASSERT_EQ(2, io.tell());
+    ASSERT_FALSE(io.eof());
+}
+
+TEST(MemIo, readAtBeyondTheEndReturnsAvailableBytes)
+{
+    std::array<byte, 10> buf1, buf2;
+    buf1.fill(1);
+
+    MemIo io(buf1.data(), static_cast<long>(buf1.size()));
+    ASSERT_EQ(4, io.readAt(6, buf2.data(), 10));
+    ASSERT_EQ(0, io.readAt(10, buf2.data(), 1));
+    ASSERT_EQ(0, io.readAt(-1, buf2.data(), 1));
+}
+
+TEST(TempIo, keepsSmallDataInMemory)
+{
+    MemIo target;
+    TempIo io(target, 16);
+    const std::array<byte, 16> buf = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    ASSERT_EQ(16, io.write(buf.data(), static_cast<long>(buf.size())));
+    ASSERT_FALSE(io.isSpilled());
+
+    target.transfer(io);
+    ASSERT_EQ(16u, target.size());
+    ASSERT_EQ(0, std::memcmp(buf.data(), target.mmap(), buf.size()));
+}
+
+TEST(TempIo, movesLargeDataToAFile)
+{
+    MemIo target;
+    TempIo io(target, 16);
+    std::array<byte, 10> buf;
+    buf.fill(1);
+    ASSERT_EQ(10, io.write(buf.data(), static_cast<long>(buf.size())));
+    ASSERT_FALSE(io.isSpilled());
+    buf.fill(2);
+    ASSERT_EQ(10, io.write(buf.data(), static_cast<long>(buf.size())));
+    ASSERT_TRUE(io.isSpilled());
+    ASSERT_EQ(20u, io.size());
+    ASSERT_EQ(20, io.tell());
+
+    // Overwrite and read back like any other BasicIo
+    ASSERT_EQ(0, io.seek(5, BasicIo::beg));
+    ASSERT_EQ(3, io.putb(3));
+    ASSERT_EQ(0, io.seek(-2, BasicIo::cur));
+    ASSERT_EQ(1, io.getb());
+    ASSERT_EQ(3, io.getb());
+    ASSERT_EQ(1, io.seek(21, BasicIo::beg));
+    ASSERT_TRUE(io.eof());
+    ASSERT_EQ(0, io.seek(-1, BasicIo::end));
+    ASSERT_EQ(2, io.getb());
+    ASSERT_EQ(EOF, io.getb());
+    ASSERT_TRUE(io.eof());
+
+    target.transfer(io);
+    ASSERT_EQ(20u, target.size());
+    const byte* data = target.mmap();
+    ASSERT_EQ(1, data[4]);
+    ASSERT_EQ(3, data[5]);
+    ASSERT_EQ(1, data[9]);
+    ASSERT_EQ(2, data[19]);
+}
+
+TEST(TempIo, mapsDataFromTheFile)
+{
+    MemIo target;
+    TempIo io(target, 0);
+    std::array<byte, 8> buf;
+    buf.fill(7);
+    ASSERT_EQ(8, io.write(buf.data(), static_cast<long>(buf.size())));
+    ASSERT_TRUE(io.isSpilled());
+
+    byte* data = io.mmap(true);
+    ASSERT_EQ(7, data[0]);
+    data[0] = 1;
+    ASSERT_EQ(0, io.munmap());
+    ASSERT_EQ(0, io.open());
+    ASSERT_EQ(1, io.getb());
+    ASSERT_EQ(7, io.getb());
+}
+
+namespace {
+    //! Return a path for a file in the temporary directory
+    std::string tempPath(const std::string& name)
+    {
+        return (std::filesystem::temp_directory_path() / ("exiv2-test-" + name)).string();
+    }
+
+    //! Return 64 KiB and a few bytes of data which differ from one block to the next
+    std::vector<byte> copyData()
+    {
+        std::vector<byte> data(64 * 1024 + 3);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<byte>(i * 7 + i / 4096);
+        }
+        return data;
+    }
+
+}  // namespace
+
+TEST(TempIo, copiesLargeFilesIntoAFile)
+{
+    const std::vector<byte> data = copyData();
+    const std::string path = tempPath("tempio-src");
+    FileIo src(path);
+    ASSERT_EQ(0, src.open("w+b"));
+    ASSERT_EQ(static_cast<long>(data.size()), src.write(data.data(), static_cast<long>(data.size())));
+    ASSERT_EQ(0, src.seek(0, BasicIo::beg));
+
+    TempIo io(src, 1024);
+    ASSERT_EQ(3, io.write(data.data(), 3));
+    ASSERT_FALSE(io.isSpilled());
+    ASSERT_EQ(static_cast<long>(data.size()), io.write(src));
+    ASSERT_TRUE(io.isSpilled());
+    ASSERT_EQ(data.size() + 3, io.size());
+    ASSERT_EQ(0, io.seek(3, BasicIo::beg));
+    std::vector<byte> buf(data.size());
+    ASSERT_EQ(static_cast<long>(buf.size()), io.read(buf.data(), static_cast<long>(buf.size())));
+    EXPECT_EQ(data, buf);
+    src.close();
+    std::remove(path.c_str());
+}
@@ -0,0 +1,321 @@
+#include <gtest/gtest.h>
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/bmffimage.hpp>
+#include <exiv2/exif.hpp>
+#include <exiv2/preview.hpp>
+#include <exiv2/xmp_exiv2.hpp>
+
+#include "bmffimage_int.hpp"  // This is not part of the public API
+#include "testhelpers.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+using namespace Exiv2::Test;
+
+#ifdef EXV_ENABLE_BMFF
+namespace {
+    /*!
+      Return the data of the items of the HEIF file \em data which are stored
+      in the file, except Exif and XMP items.
+     */
+    std::map<uint32_t, Blob> imageItems(const Blob& data)
+    {
+        using namespace Exiv2::Internal;
+        MemIo io(data.data(), static_cast<long>(data.size()));
+        std::map<uint32_t, Blob> items;
+        for (auto&& meta : readBoxHeaders(io, 0, data.size())) {
+            if (meta.type_ != 0x6d657461) continue;
+            const byte* payload = data.data() + meta.payload() + 4;
+            std::unique_ptr<IinfBox> iinf;
+            std::unique_ptr<IlocBox> iloc;
+            for (auto&& box : boxHeaders(payload, meta.length_ - meta.headerSize_ - 4)) {
+                if (box.type_ == 0x69696e66) iinf = std::make_unique<IinfBox>(payload + box.payload(), box.length_ - box.headerSize_);
+                if (box.type_ == 0x696c6f63) iloc = std::make_unique<IlocBox>(payload + box.payload(), box.length_ - box.headerSize_);
+            }
+            for (auto&& item : iloc->items_) {
+                const auto entry = std::find_if(iinf->entries_.begin(), iinf->entries_.end(),
+                                                [&item](const IinfBox::Entry& e) { return e.id_ == item.id_; });
+                if (item.constructionMethod_ != 0 || entry == iinf->entries_.end() || entry->type_ == 0x45786966 ||
+                    entry->type_ == 0x6d696d65) {
+                    continue;
+                }
+                Blob& itemData = items[item.id_];
+                for (auto&& extent : item.extents_) {
+                    const auto start = data.begin() + item.baseOffset_ + extent.offset_;
+                    itemData.insert(itemData.end(), start, start + extent.length_);
+                }
+            }
+        }
+        return items;
+    }
+
+    /*!
+      A HEIF file with an Exif item stored in an "mdat" box of \em mdatSize
+      bytes, followed by a "free" box of the same size.
+     */
+    std::vector<byte> heifData(const Blob& exif, uint32_t mdatSize)
+    {
+        std::vector<byte> heif;
+        appendBox(heif, "ftyp", {'h', 'e', 'i', 'c', 0, 0, 0, 0, 'm', 'i', 'f', '1', 'h', 'e', 'i', 'c'});
+
+        std::vector<byte> infe = {2, 0, 0, 0};
+        append16(infe, 1);  // item ID
+        append16(infe, 0);  // protection
+        infe.insert(infe.end(), {'E', 'x', 'i', 'f', 0});
+        std::vector<byte> iinf = {0, 0, 0, 0};
+        append16(iinf, 1);  // entry count
+        appendBox(iinf, "infe", infe);
+
+        std::vector<byte> item = {0, 0, 0, 6, 'E', 'x', 'i', 'f', 0, 0};
+        item.insert(item.end(), exif.begin(), exif.end());
+
+        std::vector<byte> meta = {0, 0, 0, 0};
+        appendBox(meta, "iinf", iinf);
+        // The item starts in the middle of the mdat box which follows
+        const auto metaSize = static_cast<uint32_t>(8 + meta.size() + 30);  // with the iloc box below
+        const auto itemOffset = static_cast<uint32_t>(heif.size() + metaSize + 8 + mdatSize / 2);
+        std::vector<byte> iloc = {0, 0, 0, 0, 0x44, 0};
+        append16(iloc, 1);  // item count
+        append16(iloc, 1);  // item ID
+        append16(iloc, 0);  // data reference index
+        append16(iloc, 1);  // extent count
+        append32(iloc, itemOffset);
+        append32(iloc, static_cast<uint32_t>(item.size()));
+        appendBox(meta, "iloc", iloc);
+        appendBox(heif, "meta", meta);
+
+        std::vector<byte> mdat(mdatSize, 0xAA);
+        std::copy(item.begin(), item.end(), mdat.begin() + mdatSize / 2);
+        appendBox(heif, "mdat", mdat);
+        appendBox(heif, "free", std::vector<byte>(mdatSize));
+        return heif;
+    }
+
+    class ABmffImage : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            enabled_ = enableBMFF(true);
+        }
+        void TearDown() override
+        {
+            enableBMFF(enabled_);
+        }
+        bool enabled_{false};
+    };
+}  // namespace
+
+TEST_F(ABmffImage, indexesTheBoxesOfAFile)
+{
+    ExifData exifData;
+    exifData["Exif.Image.Make"] = "Exiv2";
+    Blob exif;
+    ExifParser::encode(exif, littleEndian, exifData);
+    const std::vector<byte> heif = heifData(exif, 4096);
+
+    BmffImage image(std::make_unique<MemIo>(heif.data(), static_cast<long>(heif.size())), false);
+    image.readMetadata();
+    EXPECT_EQ("image/heic", image.mimeType());
+    EXPECT_EQ("Exiv2", image.exifData()["Exif.Image.Make"].toString());
+
+    const uint32_t types[] = {0x66747970, 0x6d657461, 0x69696e66, 0x696e6665, 0x696c6f63, 0x6d646174, 0x66726565};
+    const int32_t parents[] = {-1, -1, 1, 2, 1, -1, -1};
+    const std::vector<BmffBox>& boxes = image.boxes();
+    ASSERT_EQ(7u, boxes.size());
+    uint64_t offset = 0;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        EXPECT_EQ(types[i], boxes[i].type_) << i;
+        EXPECT_EQ(parents[i], boxes[i].parent_) << i;
+        if (boxes[i].parent_ == -1) {
+            EXPECT_EQ(offset, boxes[i].offset_) << i;
+            offset += boxes[i].length_;
+        }
+    }
+    EXPECT_EQ(heif.size(), offset);
+    EXPECT_EQ(boxes[1].offset_ + 12, boxes[2].offset_);
+}
+
+TEST_F(ABmffImage, onlyReadsTheMetadataOfLargeFiles)
+{
+    ExifData exifData;
+    exifData["Exif.Image.Make"] = "Exiv2";
+    Blob exif;
+    ExifParser::encode(exif, littleEndian, exifData);
+    const std::vector<byte> heif = heifData(exif, 4 * 1024 * 1024);
+
+    auto io = std::make_unique<CountingIo>(heif.data(), static_cast<long>(heif.size()));
+    const CountingIo& counter = *io;
+    BmffImage image(std::move(io), false);
+    image.readMetadata();
+    EXPECT_EQ("Exiv2", image.exifData()["Exif.Image.Make"].toString());
+    EXPECT_LT(counter.bytesRead_, 1024);
+}
+
+TEST_F(ABmffImage, writesExifAndXmpToTheSampleFiles)
+{
+    for (auto name : {"2021-02-13-1929.heic", "IMG_3578.heic", "Stonehenge.heic", "heic.heic", "Canon.HIF",
+                      "Sony.HIF", "avif.avif", "avif_exif_xmp.avif", "avif_metadata2.avif"}) {
+        const Blob original = testFile(name);
+        ASSERT_FALSE(original.empty()) << name;
+        BmffImage image(std::make_unique<MemIo>(original.data(), static_cast<long>(original.size())), false);
+        image.readMetadata();
+        const ExifData exifData = image.exifData();
+        image.exifData()["Exif.Image.Artist"] = "Exiv2";
+        image.xmpData()["Xmp.dc.title"] = "Exiv2";
+        image.writeMetadata();
+        EXPECT_EQ(mdExif | mdXmp, image.writtenMetadata()) << name;
+
+        const Blob written = contents(image.io());
+        BmffImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())), false);
+        result.readMetadata();
+        EXPECT_EQ("Exiv2", result.exifData()["Exif.Image.Artist"].toString()) << name;
+        EXPECT_EQ("lang=\"x-default\" Exiv2", result.xmpData()["Xmp.dc.title"].toString()) << name;
+        for (auto&& datum : exifData) {
+            // Offsets and the makernote change when the Exif data is encoded again
+            const std::string group = datum.groupName();
+            if ((group != "Image" && group != "Photo" && group != "GPSInfo") || datum.key() == "Exif.Image.Artist" ||
+                datum.key() == "Exif.Image.ExifTag" || datum.key() == "Exif.Image.GPSTag" ||
+                datum.key() == "Exif.Photo.InteroperabilityTag" || datum.key() == "Exif.Photo.MakerNote") {
+                continue;
+            }
+            auto pos = result.exifData().findKey(ExifKey(datum.key()));
+            ASSERT_NE(result.exifData().end(), pos) << name << " " << datum.key();
+            EXPECT_EQ(datum.toString(), pos->toString()) << name << " " << datum.key();
+        }
+        // The image data is where the item locations say
+        EXPECT_EQ(imageItems(original), imageItems(written)) << name;
+    }
+}
+
+TEST_F(ABmffImage, writesXmpToCr3Files)
+{
+    const Blob original = testFile("Canon-R6-pruned.CR3");
+    BmffImage image(std::make_unique<MemIo>(original.data(), static_cast<long>(original.size())), false);
+    image.readMetadata();
+    const PreviewPropertiesList previews = PreviewManager(image).getPreviewProperties();
+    image.xmpData()["Xmp.dc.title"] = "Exiv2";
+    image.writeMetadata();
+    EXPECT_EQ(mdXmp, image.writtenMetadata());
+
+    // The XMP box is padded with a free box, the file keeps its layout
+    const Blob written = contents(image.io());
+    EXPECT_EQ(original.size(), written.size());
+    BmffImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())), false);
+    result.readMetadata();
+    EXPECT_EQ("lang=\"x-default\" Exiv2", result.xmpData()["Xmp.dc.title"].toString());
+    EXPECT_EQ(image.exifData().count(), result.exifData().count());
+
+    PreviewManager before(image);
+    PreviewManager after(result);
+    const PreviewPropertiesList resultPreviews = after.getPreviewProperties();
+    ASSERT_EQ(previews.size(), resultPreviews.size());
+    for (size_t i = 0; i < previews.size(); ++i) {
+        const PreviewImage a = before.getPreviewImage(previews[i]);
+        const PreviewImage b = after.getPreviewImage(resultPreviews[i]);
+        ASSERT_EQ(a.size(), b.size());
+        EXPECT_EQ(0, std::memcmp(a.pData(), b.pData(), a.size()));
+    }
+}
+
+TEST_F(ABmffImage, writesInPlaceIfTheMetadataFits)
+{
+    ExifData exifData;
+    exifData["Exif.Image.Make"] = "Exiv2";
+    Blob exif;
+    ExifParser::encode(exif, littleEndian, exifData);
+    const std::vector<byte> heif = heifData(exif, 4 * 1024 * 1024);
+
+    auto io = std::make_unique<CountingIo>(heif.data(), static_cast<long>(heif.size()));
+    CountingIo& counter = *io;
+    BmffImage image(std::move(io), false);
+    image.readMetadata();
+    image.exifData()["Exif.Image.Make"] = "Exiv3";
+    counter.bytesRead_ = 0;
+    image.writeMetadata();
+    EXPECT_LT(counter.bytesRead_, 1024);
+
+    const Blob written = contents(image.io());
+    ASSERT_EQ(heif.size(), written.size());
+    BmffImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())), false);
+    result.readMetadata();
+    EXPECT_EQ("Exiv3", result.exifData()["Exif.Image.Make"].toString());
+}
+
+TEST_F(ABmffImage, removesTheItemsOfDeletedMetadata)
+{
+    const Blob original = testFile("Stonehenge.heic");
+    BmffImage image(std::make_unique<MemIo>(original.data(), static_cast<long>(original.size())), false);
+    image.readMetadata();
+    ASSERT_FALSE(image.exifData().empty());
+    ASSERT_FALSE(image.xmpData().empty());
+    image.clearExifData();
+    image.clearXmpData();
+    image.writeMetadata();
+
+    const Blob written = contents(image.io());
+    BmffImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())), false);
+    result.readMetadata();
+    EXPECT_TRUE(result.exifData().empty());
+    EXPECT_TRUE(result.xmpData().empty());
+    EXPECT_EQ(imageItems(original), imageItems(written));
+}
+
+TEST_F(ABmffImage, setsTheSizeOfALastMoovBoxOfSizeZero)
+{
+    ExifData exifData;
+    exifData["Exif.Image.Make"] = "Exiv2";
+    Blob exif;
+    ExifParser::encode(exif, littleEndian, exifData);
+    std::vector<byte> heif = heifData(exif, 1024);
+
+    // A moov box which extends to the end of the file, with a chunk in the mdat box
+    const auto chunk = static_cast<uint32_t>(heif.size() - 2 * (8 + 1024) + 8);
+    std::vector<byte> stco = {0, 0, 0, 0};
+    append32(stco, 1);  // entry count
+    append32(stco, chunk);
+    std::vector<byte> moov;
+    appendBox(moov, "stco", stco);
+    for (auto type : {"stbl", "minf", "mdia", "trak"}) {
+        std::vector<byte> parent;
+        appendBox(parent, type, moov);
+        moov = std::move(parent);
+    }
+    const size_t moovOffset = heif.size();
+    append32(heif, 0);
+    heif.insert(heif.end(), {'m', 'o', 'o', 'v'});
+    heif.insert(heif.end(), moov.begin(), moov.end());
+    const Blob chunkData(heif.begin() + chunk, heif.begin() + chunk + 16);
+
+    BmffImage image(std::make_unique<MemIo>(heif.data(), static_cast<long>(heif.size())), false);
+    image.readMetadata();
+    // The Exif data doesn't fit into the old item and goes into a new mdat box,
+    // the meta box grows with the new XMP item
+    image.exifData()["Exif.Image.Artist"] = std::string(200, 'x');
+    image.xmpData()["Xmp.dc.title"] = "Exiv2";
+    image.writeMetadata();
+
+    const Blob written = contents(image.io());
+    BmffImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())), false);
+    result.readMetadata();
+    EXPECT_EQ(std::string(200, 'x'), result.exifData()["Exif.Image.Artist"].toString());
+
+    MemIo io(written.data(), static_cast<long>(written.size()));
+    const auto boxes = Internal::readBoxHeaders(io, 0, written.size());
+    ASSERT_EQ(6u, boxes.size());
+    const Internal::BmffBoxHeader& box = boxes[4];
+    EXPECT_EQ(0x6d6f6f76u, box.type_);
+    EXPECT_FALSE(box.extendsToEnd_);
+    EXPECT_EQ(heif.size() - moovOffset, box.length_);
+    // The chunk offset moved along with the mdat box
+    const uint32_t moved = getULong(written.data() + box.payload() + 4 * 8 + 16, bigEndian);
+    EXPECT_NE(chunk, moved);
+    ASSERT_LE(moved + chunkData.size(), written.size());
+    EXPECT_EQ(chunkData, Blob(written.begin() + moved, written.begin() + moved + 16));
+}
+#endif
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <exiv2/error.hpp>
+#include <exiv2/exif.hpp>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Exiv2;
+
+namespace {
+    ExifData cameraData()
+    {
+        ExifData exifData;
+        exifData["Exif.Image.Make"] = "Canon";
+        exifData["Exif.Image.Model"] = "Canon EOS 40D";
+        exifData["Exif.Photo.FocalLength"] = URational(50, 1);
+        return exifData;
+    }
+}  // namespace
+
+TEST(AnExifPrintContext, findsKeysLikeExifData)
+{
+    const ExifData exifData = cameraData();
+    EXPECT_EQ(exifData.findKey(ExifKey("Exif.Image.Model")), ExifPrintContext::findKey(exifData, "Exif.Image.Model"));
+    EXPECT_EQ(exifData.end(), ExifPrintContext::findKey(exifData, "Exif.Image.Artist"));
+
+    const ExifPrintContext context(exifData);
+    EXPECT_EQ(exifData.findKey(ExifKey("Exif.Image.Model")), ExifPrintContext::findKey(exifData, "Exif.Image.Model"));
+    EXPECT_EQ(exifData.end(), ExifPrintContext::findKey(exifData, "Exif.Image.Artist"));
+    EXPECT_THROW(ExifPrintContext::findKey(exifData, "Exif.Image"), Error);
+}
+
+TEST(AnExifPrintContext, remembersLookupsUntilItEnds)
+{
+    ExifData exifData = cameraData();
+    {
+        const ExifPrintContext context(exifData);
+        EXPECT_EQ(exifData.end(), ExifPrintContext::findKey(exifData, "Exif.Image.Artist"));
+        // Modifying the metadata during a print pass is not supported, the lookup is not repeated
+        exifData["Exif.Image.Artist"] = "Exiv2";
+        EXPECT_EQ(exifData.end(), ExifPrintContext::findKey(exifData, "Exif.Image.Artist"));
+    }
+    EXPECT_EQ("Exiv2", ExifPrintContext::findKey(exifData, "Exif.Image.Artist")->toString());
+}
+
+TEST(AnExifPrintContext, onlyAppliesToItsExifData)
+{
+    ExifData exifData = cameraData();
+    ExifData other = cameraData();
+    const ExifPrintContext context(exifData);
+    EXPECT_EQ(other.end(), ExifPrintContext::findKey(other, "Exif.Image.Artist"));
+    other["Exif.Image.Artist"] = "Exiv2";
+    EXPECT_NE(other.end(), ExifPrintContext::findKey(other, "Exif.Image.Artist"));
+    {
+        // Nested contexts
+        const ExifPrintContext inner(other);
+        EXPECT_EQ(exifData.end(), ExifPrintContext::findKey(exifData, "Exif.Image.Artist"));
+        EXPECT_NE(other.end(), ExifPrintContext::findKey(other, "Exif.Image.Artist"));
+    }
+    exifData["Exif.Image.Artist"] = "Exiv2";
+    EXPECT_EQ(exifData.end(), ExifPrintContext::findKey(exifData, "Exif.Image.Artist"));
+}
+
+TEST(AnExifPrintContext, doesNotChangeThePrintedValues)
+{
+    ExifData exifData = cameraData();
+    exifData["Exif.CanonCs.LensType"] = static_cast<uint16_t>(1);
+    exifData["Exif.CanonCs.Lens"].setValue("50 50 1");
+    exifData["Exif.CanonCs.MaxAperture"] = static_cast<uint16_t>(0x48);
+    const std::string lensType = exifData["Exif.CanonCs.LensType"].print(&exifData);
+    const std::string focalLength = exifData["Exif.Photo.FocalLength"].print(&exifData);
+
+    const ExifPrintContext context(exifData);
+    EXPECT_EQ(lensType, exifData["Exif.CanonCs.LensType"].print(&exifData));
+    EXPECT_EQ(focalLength, exifData["Exif.Photo.FocalLength"].print(&exifData));
+}
+
+TEST(AnExifdatum, makesItsKeyFromTheTagAndGroup)
+{
+    const Exifdatum datum(ExifKey("Exif.Photo.FocalLength"));
+    EXPECT_EQ("Exif.Photo.FocalLength", datum.key());
+    EXPECT_EQ("FocalLength", datum.tagName());
+    EXPECT_EQ(ExifKey("Exif.Photo.FocalLength").tagLabel(), datum.tagLabel());
+
+    const Exifdatum unknown(ExifKey("Exif.Image.0xabcd"));
+    EXPECT_EQ("Exif.Image.0xabcd", unknown.key());
+    EXPECT_EQ("0xabcd", unknown.tagName());
+    EXPECT_EQ("", unknown.tagLabel());
+}
+
+TEST(AnExifData, sortsByKeyInTheOrderOfTheKeyStrings)
+{
+    ExifData exifData;
+    for (auto&& key : {"Exif.Photo.FocalLength", "Exif.Image2.ImageWidth", "Exif.Image.0xabcd", "Exif.Image.Make",
+                       "Exif.GPSInfo.GPSVersionID", "Exif.Image.Artist", "Exif.Thumbnail.Compression", "Exif.Image.0x0001"}) {
+        exifData[key] = static_cast<uint16_t>(1);
+    }
+    exifData.sortByKey();
+    std::vector<std::string> keys;
+    for (auto&& datum : exifData) keys.push_back(datum.key());
+    std::vector<std::string> sorted(keys);
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ(sorted, keys);
+}
+
+TEST(AnExifdatum, makesTheValueOfASmallValueOnceForAllThreads)
+{
+    Exifdatum datum(ExifKey("Exif.Image.Orientation"));
+    datum = static_cast<uint16_t>(6);
+    const Exifdatum& constDatum = datum;
+
+    std::vector<const Value*> values(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < values.size(); ++i) {
+        threads.emplace_back([&, i] { values[i] = &constDatum.value(); });
+    }
+    for (auto&& t : threads) t.join();
+    for (auto&& v : values) EXPECT_EQ(values[0], v);
+    EXPECT_EQ(6, values[0]->toLong());
+
+    // The value stays valid when it is changed through the datum
+    EXPECT_EQ(0, datum.setValue("3"));
+    EXPECT_EQ(values[0], &datum.value());
+    EXPECT_EQ(3, values[0]->toLong());
+}
@@ -62,6 +62,7 @@ TEST(getEnv, getsDefaultValueWhenExpectedEnvVariableDoesNotExist)
 {
     ASSERT_STREQ("/exiv2.php", getEnv(envHTTPPOST).c_str());
     ASSERT_STREQ("40", getEnv(envTIMEOUT).c_str());
+    ASSERT_STREQ("", getEnv(envREMOTECACHE).c_str());
 }
 
 TEST(getEnv, getsProperValuesWhenExpectedEnvVariableExists)
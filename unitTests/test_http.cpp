@@ -0,0 +1,332 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2021 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "basicio.hpp"
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Exiv2;
+
+namespace
+{
+    /*!
+      @brief Minimal HTTP/1.1 server on the loopback interface. It serves one
+          file from memory, supports single and multiple byte ranges and keeps
+          connections open between requests. HEAD responses report an ETag and
+          the Content-Length unless \em validator or \em length is false.
+          Without length, the whole file is sent in chunks of 1000 bytes.
+     */
+    class LoopbackServer
+    {
+    public:
+        explicit LoopbackServer(std::string content, bool validator = true, bool length = true)
+            : content_(std::move(content)), validator_(validator), length_(length)
+        {
+            listen_ = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            bind(listen_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            listen(listen_, 8);
+            socklen_t len = sizeof(addr);
+            getsockname(listen_, reinterpret_cast<sockaddr*>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+            thread_ = std::thread(&LoopbackServer::run, this);
+        }
+
+        ~LoopbackServer()
+        {
+            stop_ = true;
+            thread_.join();
+            close(listen_);
+        }
+
+        std::string url() const
+        {
+            return "http://127.0.0.1:" + std::to_string(port_) + "/image.jpg";
+        }
+
+        int connections() const
+        {
+            return connections_;
+        }
+        int gets() const
+        {
+            return gets_;
+        }
+        int multiRangeGets() const
+        {
+            return multiRangeGets_;
+        }
+
+    private:
+        //! Wait until \em fd is readable, giving up when the server is stopped
+        bool waitFor(int fd)
+        {
+            pollfd pfd{fd, POLLIN, 0};
+            while (!stop_) {
+                if (poll(&pfd, 1, 20) > 0)
+                    return true;
+            }
+            return false;
+        }
+
+        void run()
+        {
+            while (waitFor(listen_)) {
+                int fd = accept(listen_, nullptr, nullptr);
+                if (fd < 0)
+                    continue;
+                connections_++;
+                serve(fd);
+                close(fd);
+            }
+        }
+
+        void serve(int fd)
+        {
+            std::string in;
+            char buf[4096];
+            while (waitFor(fd)) {
+                ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0)
+                    return;
+                in.append(buf, n);
+                size_t end;
+                while ((end = in.find("\r\n\r\n")) != std::string::npos) {
+                    respond(fd, in.substr(0, end));
+                    in.erase(0, end + 4);
+                }
+            }
+        }
+
+        void respond(int fd, const std::string& request)
+        {
+            const bool head = request.compare(0, 4, "HEAD") == 0;
+            std::ostringstream os;
+            std::string body;
+            const size_t rangePos = request.find("Range: bytes=");
+            if (head) {
+                os << "HTTP/1.1 200 OK\r\n";
+                if (length_)
+                    os << "Content-Length: " << content_.size() << "\r\n";
+                if (validator_)
+                    os << "ETag: \"v1\"\r\n";
+                os << "\r\n";
+            } else if (rangePos == std::string::npos) {
+                gets_++;
+                if (length_) {
+                    body = content_;
+                    os << "HTTP/1.1 200 OK\r\nContent-Length: " << body.size() << "\r\n\r\n";
+                } else {
+                    std::ostringstream chunks;
+                    for (size_t pos = 0; pos < content_.size(); pos += 1000) {
+                        const std::string chunk = content_.substr(pos, 1000);
+                        chunks << std::hex << chunk.size() << "\r\n" << chunk << "\r\n";
+                    }
+                    chunks << "0\r\n\r\n";
+                    body = chunks.str();
+                    os << "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+                }
+            } else {
+                gets_++;
+                std::string spec = request.substr(rangePos + 13);
+                spec = spec.substr(0, spec.find("\r\n"));
+                std::vector<std::pair<size_t, size_t>> ranges;
+                std::istringstream is(spec);
+                std::string range;
+                while (std::getline(is, range, ',')) {
+                    size_t first = std::stoul(range);
+                    size_t last = std::min<size_t>(std::stoul(range.substr(range.find('-') + 1)), content_.size() - 1);
+                    ranges.emplace_back(first, last);
+                }
+                if (ranges.size() == 1) {
+                    body = content_.substr(ranges[0].first, ranges[0].second - ranges[0].first + 1);
+                    os << "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " << ranges[0].first << "-"
+                       << ranges[0].second << "/" << content_.size() << "\r\nContent-Length: " << body.size()
+                       << "\r\n\r\n";
+                } else {
+                    multiRangeGets_++;
+                    for (auto&& r : ranges) {
+                        body += "\r\n--EXIV2\r\nContent-Type: image/jpeg\r\nContent-Range: bytes " +
+                                std::to_string(r.first) + "-" + std::to_string(r.second) + "/" +
+                                std::to_string(content_.size()) + "\r\n\r\n" +
+                                content_.substr(r.first, r.second - r.first + 1);
+                    }
+                    body += "\r\n--EXIV2--\r\n";
+                    os << "HTTP/1.1 206 Partial Content\r\nContent-Type: multipart/byteranges; boundary=EXIV2"
+                       << "\r\nContent-Length: " << body.size() << "\r\n\r\n";
+                }
+            }
+            const std::string response = os.str() + body;
+            send(fd, response.data(), response.size(), 0);
+        }
+
+        std::string content_;
+        bool validator_;
+        bool length_;
+        int listen_{-1};
+        int port_{0};
+        std::atomic<bool> stop_{false};
+        std::atomic<int> connections_{0};
+        std::atomic<int> gets_{0};
+        std::atomic<int> multiRangeGets_{0};
+        std::thread thread_;
+    };
+
+    std::string makeContent(size_t size)
+    {
+        std::string content(size, '\0');
+        for (size_t i = 0; i < size; i++) {
+            content[i] = static_cast<char>((i * 7 + i / 256) & 0xff);
+        }
+        return content;
+    }
+
+    std::string readAt(BasicIo& io, long offset, long count)
+    {
+        io.seek(offset, BasicIo::beg);
+        std::string result(count, '\0');
+        long n = io.read(reinterpret_cast<byte*>(&result[0]), count);
+        result.resize(n);
+        return result;
+    }
+}  // namespace
+
+TEST(AHttpIo, reusesOneConnectionForAllRanges)
+{
+    const std::string content = makeContent(10000);
+    LoopbackServer server(content);
+    {
+        HttpIo io(server.url(), 1024);
+        ASSERT_EQ(0, io.open());
+        ASSERT_EQ(content.size(), io.size());
+        ASSERT_EQ(content.substr(0, 100), readAt(io, 0, 100));
+        ASSERT_EQ(content.substr(5000, 100), readAt(io, 5000, 100));
+        ASSERT_EQ(content.substr(9000, 1000), readAt(io, 9000, 1000));
+    }
+    ASSERT_EQ(3, server.gets());
+    ASSERT_EQ(1, server.connections());
+}
+
+TEST(AHttpIo, fetchesOnlyMissingBlocksWithAMultiRangeRequest)
+{
+    const std::string content = makeContent(10000);
+    LoopbackServer server(content);
+    HttpIo io(server.url(), 1024);
+    ASSERT_EQ(0, io.open());
+    ASSERT_EQ(content.substr(0, 10), readAt(io, 0, 10));        // block 0
+    ASSERT_EQ(content.substr(2048, 10), readAt(io, 2048, 10));  // block 2
+    ASSERT_EQ(0, server.multiRangeGets());
+
+    // blocks 1, 3 and 4 are missing
+    ASSERT_EQ(content.substr(0, 5000), readAt(io, 0, 5000));
+    ASSERT_EQ(1, server.multiRangeGets());
+    ASSERT_EQ(3, server.gets());
+}
+
+TEST(AHttpIo, servesBlocksFromTheOnDiskCacheOnTheNextOpen)
+{
+    namespace fs = std::filesystem;
+    const std::string dir = (fs::temp_directory_path() / "exiv2-httpcache-test").string();
+    fs::remove_all(dir);
+
+    const std::string content = makeContent(10000);
+    LoopbackServer server(content);
+    {
+        HttpIo io(server.url(), 1024);
+        io.setBlockCache(dir);
+        ASSERT_EQ(0, io.open());
+        ASSERT_EQ(content.substr(1000, 2000), readAt(io, 1000, 2000));
+        ASSERT_EQ(0U, io.cacheHits());
+        ASSERT_EQ(3U, io.cacheMisses());
+    }
+    const int gets = server.gets();
+    {
+        HttpIo io(server.url(), 1024);
+        io.setBlockCache(dir);
+        ASSERT_EQ(0, io.open());
+        ASSERT_EQ(content.substr(1000, 2000), readAt(io, 1000, 2000));
+        ASSERT_EQ(3U, io.cacheHits());
+        ASSERT_EQ(0U, io.cacheMisses());
+    }
+    ASSERT_EQ(gets, server.gets());
+    fs::remove_all(dir);
+}
+
+TEST(AHttpIo, doesNotCacheFilesWithoutValidator)
+{
+    namespace fs = std::filesystem;
+    const std::string dir = (fs::temp_directory_path() / "exiv2-httpcache-novalidator-test").string();
+    fs::remove_all(dir);
+
+    const std::string content = makeContent(10000);
+    LoopbackServer server(content, false);
+    for (int i = 0; i < 2; i++) {
+        HttpIo io(server.url(), 1024);
+        io.setBlockCache(dir);
+        ASSERT_EQ(0, io.open());
+        ASSERT_EQ(content.substr(1000, 2000), readAt(io, 1000, 2000));
+        ASSERT_EQ(0U, io.cacheHits());
+    }
+    ASSERT_EQ(2, server.gets());
+    ASSERT_TRUE(fs::is_empty(dir));
+    fs::remove_all(dir);
+}
+
+TEST(AHttpIo, readsNothingFromAnEmptyFileOfUnknownLength)
+{
+    LoopbackServer server("", true, false);
+    HttpIo io(server.url(), 1024);
+    ASSERT_EQ(0, io.open());
+    ASSERT_EQ(0U, io.size());
+    byte buf[10];
+    ASSERT_EQ(0, io.read(buf, sizeof(buf)));
+}
+
+TEST(AHttpIo, readsAFileOfUnknownLengthWhichIsSentInChunks)
+{
+    const std::string content = makeContent(200000);
+    LoopbackServer server(content, true, false);
+    HttpIo io(server.url(), 1024);
+    ASSERT_EQ(0, io.open());
+    ASSERT_EQ(content.size(), io.size());
+    ASSERT_EQ(content.substr(150000, 5000), readAt(io, 150000, 5000));
+    ASSERT_EQ(1, server.connections());
+}
+
+#endif  // _WIN32
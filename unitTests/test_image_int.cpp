@@ -22,6 +22,9 @@
 #include <gtest/gtest.h>
 #include <image_int.hpp>
 
+#include <string>
+#include <vector>
+
 using namespace Exiv2::Internal;
 using Exiv2::makeSlice;
 using Exiv2::Slice;
@@ -66,3 +69,32 @@ TEST(binaryToString, nonZeroStart)
     // start @ index 3, read until end
     checkBinaryToString(makeSlice(buf, 3, sizeof(buf)), "...e..a");
 }
+
+TEST(findEither, findsTheFirstOfTwoBytesAtEveryPosition)
+{
+    // Positions in and after the vector loop of each instruction set
+    std::vector<Exiv2::byte> data(100, 'x');
+    const Exiv2::byte* last = data.data() + data.size();
+    EXPECT_EQ(last, findEither(data.data(), last, '\r', '\n'));
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (i % 2 == 0) ? '\r' : '\n';
+        for (size_t start = 0; start <= i; ++start) {
+            ASSERT_EQ(data.data() + i, findEither(data.data() + start, last, '\r', '\n')) << i << " " << start;
+        }
+        EXPECT_EQ(data.data() + i, findEither(data.data() + i, data.data() + i, '\r', '\n'));
+        data[i] = 'x';
+    }
+}
+
+TEST(findPattern, findsTheFirstCompleteOccurrence)
+{
+    const std::string text = "<?xpack <?xpacket en<?xpacket end='w'?>";
+    const auto first = reinterpret_cast<const Exiv2::byte*>(text.data());
+    const Exiv2::byte* last = first + text.size();
+    EXPECT_EQ(first + 20, findPattern(first, last, "<?xpacket end="));
+    EXPECT_EQ(first + 37, findPattern(first, last, "?>"));
+    EXPECT_EQ(first, findPattern(first, last, "<"));
+    EXPECT_EQ(last, findPattern(first, last, "<?xpacket begin="));
+    EXPECT_EQ(last - 1, findPattern(first, last - 1, "?>"));
+    EXPECT_EQ(last, findPattern(first, last, ""));
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <exiv2/image.hpp>
+#include <exiv2/jpgimage.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace Exiv2;
+
+namespace fs = std::filesystem;
+
+namespace {
+    const std::string testData(TESTDATA_PATH);
+
+    //! Return the contents of the file \em path
+    Blob fileContents(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return Blob(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    //! Return the APP1 segment with the Exif data of the JPEG \em data, without the marker
+    Blob exifSegment(const Blob& data)
+    {
+        static const byte exifId[] = {'E', 'x', 'i', 'f', 0, 0};
+        size_t pos = 2;
+        while (pos + 4 <= data.size() && data[pos] == 0xff && data[pos + 1] != 0xda) {
+            const size_t size = data[pos + 2] << 8 | data[pos + 3];
+            if (data[pos + 1] == 0xe1 && size >= 8 && std::memcmp(&data[pos + 4], exifId, sizeof(exifId)) == 0) {
+                return Blob(data.begin() + pos + 2, data.begin() + pos + 2 + size);
+            }
+            pos += 2 + size;
+        }
+        return Blob();
+    }
+
+    //! Copy the test file \em name to a temporary file and return its path
+    std::string copyTestFile(const std::string& name)
+    {
+        const std::string path = (fs::temp_directory_path() / ("exiv2-test-" + name)).string();
+        fs::copy_file(testData + "/" + name, path, fs::copy_options::overwrite_existing);
+        return path;
+    }
+}  // namespace
+
+TEST(AJpegImage, skipsWritingUnchangedMetadata)
+{
+    const std::string path = copyTestFile("exiv2-nikon-d70.jpg");
+    const Blob original = fileContents(path);
+    auto image = ImageFactory::open(path);
+    // All supported metadata counts as changed before it was read
+    EXPECT_EQ(mdExif | mdIptc | mdXmp | mdComment, image->changedMetadata());
+    image->readMetadata();
+    EXPECT_EQ(mdNone, image->changedMetadata());
+
+    // Setting a value to what it already is does not change anything
+    const std::string model = image->exifData()["Exif.Image.Model"].toString();
+    image->exifData()["Exif.Image.Model"] = model;
+    EXPECT_EQ(mdNone, image->changedMetadata());
+    image->writeMetadata();
+    EXPECT_EQ(mdNone, image->writtenMetadata());
+    EXPECT_EQ(original, fileContents(path));
+    fs::remove(path);
+}
+
+TEST(AJpegImage, writesOnlyTheChangedMetadata)
+{
+    const std::string path = copyTestFile("exiv2-nikon-d70.jpg");
+    const Blob original = fileContents(path);
+    {
+        auto image = ImageFactory::open(path);
+        image->readMetadata();
+        image->xmpData()["Xmp.dc.format"] = "image/jpeg";
+        EXPECT_EQ(mdXmp, image->changedMetadata());
+        image->writeMetadata();
+        EXPECT_EQ(mdXmp, image->writtenMetadata());
+        EXPECT_EQ(mdNone, image->changedMetadata());
+    }
+    // The Exif data was not re-encoded
+    const Blob withXmp = fileContents(path);
+    EXPECT_NE(original, withXmp);
+    ASSERT_FALSE(exifSegment(original).empty());
+    EXPECT_EQ(exifSegment(original), exifSegment(withXmp));
+
+    auto image = ImageFactory::open(path);
+    image->readMetadata();
+    EXPECT_EQ("image/jpeg", image->xmpData()["Xmp.dc.format"].toString());
+    image->exifData()["Exif.Image.Artist"] = "Exiv2";
+    image->writeMetadata();
+    EXPECT_EQ(mdExif, image->writtenMetadata());
+
+    image = ImageFactory::open(path);
+    image->readMetadata();
+    EXPECT_EQ("Exiv2", image->exifData()["Exif.Image.Artist"].toString());
+    EXPECT_EQ("image/jpeg", image->xmpData()["Xmp.dc.format"].toString());
+    fs::remove(path);
+}
+
+TEST(AJpegImage, detectsChangesThroughAReferenceHandedOutEarlier)
+{
+    const std::string path = copyTestFile("exiv2-nikon-d70.jpg");
+    {
+        auto image = ImageFactory::open(path);
+        ExifData& exifData = image->exifData();
+        image->readMetadata();
+        exifData["Exif.Image.Artist"] = "Exiv2";
+        EXPECT_EQ(mdExif, image->changedMetadata());
+        image->writeMetadata();
+        EXPECT_EQ(mdExif, image->writtenMetadata());
+
+        // The reference is still in use after the metadata was written
+        exifData["Exif.Image.Artist"] = "Exiv2 again";
+        EXPECT_EQ(mdExif, image->changedMetadata());
+        image->writeMetadata();
+        EXPECT_EQ(mdExif, image->writtenMetadata());
+    }
+    auto image = ImageFactory::open(path);
+    image->readMetadata();
+    EXPECT_EQ("Exiv2 again", image->exifData()["Exif.Image.Artist"].toString());
+    fs::remove(path);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include "makernote_int.hpp"
+#include "tiffcomposite_int.hpp"
+
+using namespace Exiv2::Internal;
+
+namespace {
+    TiffCameraInfo camera(const std::string& model)
+    {
+        TiffCameraInfo info;
+        info.model_ = model;
+        return info;
+    }
+}  // namespace
+
+TEST(MakernoteSelector, sonyCsSelectorUsesCameraModel)
+{
+    EXPECT_EQ(-1, sonyCsSelector(0x0114, nullptr, 0, nullptr, camera("")));
+    EXPECT_EQ(0, sonyCsSelector(0x0114, nullptr, 0, nullptr, camera("DSLR-A700")));
+    EXPECT_EQ(1, sonyCsSelector(0x0114, nullptr, 0, nullptr, camera("DSLR-A330")));
+    EXPECT_EQ(1, sonyCsSelector(0x0114, nullptr, 0, nullptr, camera("DSLR-A380")));
+}
+
+TEST(MakernoteSelector, sony2010eSelectorMatchesWholeModelName)
+{
+    EXPECT_EQ(0, sony2010eSelector(0x2010, nullptr, 0, nullptr, camera("NEX-6")));
+    EXPECT_EQ(-1, sony2010eSelector(0x2010, nullptr, 0, nullptr, camera("NEX-7")));
+    EXPECT_EQ(-1, sony2010eSelector(0x2010, nullptr, 0, nullptr, camera("")));
+}
+
+TEST(MakernoteSelector, sony2FpSelectorRejectsModelPrefixes)
+{
+    EXPECT_EQ(-1, sony2FpSelector(0x9402, nullptr, 0, nullptr, camera("SLT-A58")));
+    EXPECT_EQ(-1, sony2FpSelector(0x9402, nullptr, 0, nullptr, camera("ILCA-77M2")));
+    EXPECT_EQ(0, sony2FpSelector(0x9402, nullptr, 0, nullptr, camera("ILCE-7M3")));
+}
+
+TEST(TiffMnCreator, createsMakernoteForMakePrefix)
+{
+    const Exiv2::byte data[32] = {};
+    std::unique_ptr<TiffComponent> mn(
+        TiffMnCreator::create(0x927c, exifId, "Canon EOS", data, sizeof(data), Exiv2::littleEndian));
+    EXPECT_NE(nullptr, mn.get());
+    std::unique_ptr<TiffComponent> none(
+        TiffMnCreator::create(0x927c, exifId, "Can", data, sizeof(data), Exiv2::littleEndian));
+    EXPECT_EQ(nullptr, none.get());
+}
+
+TEST(NikonCrypt, usesTheKeyOfTheCameraInfo)
+{
+    Exiv2::byte data[20] = {'0', '2', '0', '5'};
+    for (int i = 4; i < 20; ++i) data[i] = static_cast<Exiv2::byte>(i);
+    TiffCameraInfo info = camera("NIKON D70");
+    EXPECT_EQ(0, nikonCrypt(0x0097, data, sizeof(data), nullptr, info).size());
+
+    info.nikonKey_ = true;
+    info.shutterCount_ = 1234;
+    info.serialNumber_ = "5678";
+    const Exiv2::DataBuf encrypted = nikonCrypt(0x0097, data, sizeof(data), nullptr, info);
+    ASSERT_EQ(20, encrypted.size());
+    EXPECT_EQ(0, encrypted.cmpBytes(0, data, 4));
+    EXPECT_NE(0, encrypted.cmpBytes(4, data + 4, 16));
+    const Exiv2::DataBuf decrypted = nikonCrypt(0x0097, encrypted.c_data(), 20, nullptr, info);
+    EXPECT_EQ(0, decrypted.cmpBytes(0, data, sizeof(data)));
+
+    // A serial number which is not a number falls back to a key by model
+    info.serialNumber_ = "abc";
+    EXPECT_EQ(20, nikonCrypt(0x0097, data, sizeof(data), nullptr, info).size());
+    info.model_.clear();
+    EXPECT_EQ(0, nikonCrypt(0x0097, data, sizeof(data), nullptr, info).size());
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <exiv2/exif.hpp>
+
+#include "nikonmn_int.hpp" // This is not part of the public API
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+using namespace Exiv2::Internal;
+
+namespace {
+    //! Print the lens id for the lens data \em raw, as stored in the NikonLd3 group
+    std::string lensId(const std::vector<byte>& raw)
+    {
+        static const char* tags[] = {"LensIDNumber",          "LensFStops",            "MinFocalLength",
+                                     "MaxFocalLength",        "MaxApertureAtMinFocal", "MaxApertureAtMaxFocal",
+                                     "MCUVersion"};
+        ExifData exifData;
+        for (size_t i = 0; i < 7; ++i) {
+            exifData[std::string("Exif.NikonLd3.") + tags[i]].setValue(std::to_string(raw[i]));
+        }
+        exifData["Exif.Nikon3.LensType"].setValue(std::to_string(raw[7]));
+        std::ostringstream os;
+        Nikon3MakerNote::printLensId(os, exifData["Exif.NikonLd3.LensIDNumber"].value(), &exifData, "NikonLd3");
+        return os.str();
+    }
+
+    //! Print the lens id for the LensIDNumber \em lid alone
+    std::string lensId(byte lid)
+    {
+        std::ostringstream os;
+        Nikon3MakerNote::printLensId(os, UShortValue(lid), nullptr, "NikonLd3");
+        return os.str();
+    }
+}  // namespace
+
+#ifdef EXV_HAVE_LENSDATA
+TEST(ANikonLensId, findsTheFirstLensWithTheSameData)
+{
+    // Also in the table as Sigma Macro 105mm F2.8 EX DG
+    EXPECT_EQ("Nikon AF Micro-Nikkor 105mm f/2.8D", lensId({0x32, 0x54, 0x6A, 0x6A, 0x24, 0x24, 0x35, 0x02}));
+    EXPECT_EQ("Tamron SP AF 90mm F/2.8 Macro 1:1", lensId({0x32, 0x53, 0x64, 0x64, 0x24, 0x24, 0x35, 0x02}));
+    EXPECT_EQ("Nikon AF Micro-Nikkor 105mm f/2.8D", lensId(0x32));
+}
+
+TEST(ANikonLensId, ignoresTheFStopsOfSigmaLensesOnly)
+{
+    EXPECT_EQ("Sigma 4.5mm F2.8 EX DC HSM Circular Fisheye",
+              lensId({0xFE, 0x47, 0x00, 0x00, 0x24, 0x24, 0x4B, 0x06}));
+    EXPECT_EQ("Sigma 4.5mm F2.8 EX DC HSM Circular Fisheye",
+              lensId({0xFE, 0x10, 0x00, 0x00, 0x24, 0x24, 0x4B, 0x06}));
+    EXPECT_EQ("Tamron SP 90mm F/2.8 Di VC USD MACRO 1:1", lensId({0xFE, 0x54, 0x64, 0x64, 0x24, 0x24, 0xDF, 0x0E}));
+    EXPECT_EQ("254", lensId({0xFE, 0x10, 0x64, 0x64, 0x24, 0x24, 0xDF, 0x0E}));
+}
+
+TEST(ANikonLensId, printsTheValueOfUnknownLenses)
+{
+    EXPECT_EQ("192", lensId({0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}));
+    EXPECT_EQ("192", lensId(0xC0));
+}
+#endif
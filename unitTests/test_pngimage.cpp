@@ -19,15 +19,32 @@
 
 #include <exiv2/pngimage.hpp>
 #include "pngchunk_int.hpp" // This is not part of the public API
+#include "testhelpers.hpp"
 
 #include <gtest/gtest.h>
+#include <zlib.h>
 
 #include <array>
 #include <algorithm>
 #include <memory>
 #include <sstream>
+#include <string>
+#include <vector>
 
 using namespace Exiv2;
+using namespace Exiv2::Test;
+
+namespace {
+    //! A PNG image with an IDAT chunk of \em idatSize bytes
+    std::vector<byte> pngData(size_t idatSize)
+    {
+        std::vector<byte> png = {0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A};
+        appendPngChunk(png, "IHDR", {0, 0, 0, 1, 0, 0, 0, 1, 8, 0, 0, 0, 0});
+        appendPngChunk(png, "IDAT", imageData(idatSize, 13));
+        appendPngChunk(png, "IEND", {});
+        return png;
+    }
+}  // namespace
 
 TEST(PngChunk, keyTxtChunkExtractsKeywordCorrectlyInPresenceOfNullChar)
 {
@@ -67,6 +84,122 @@ TEST(PngChunk, keyTxtChunkThrowsIfSizeIsNotEnough)
   ASSERT_THROW(Internal::PngChunk::keyTXTChunk(emptyChunk, false), Exiv2::Error);
 }
 
+TEST(PngChunkIndex, indexesAllChunksUpToIend)
+{
+    std::vector<byte> png = pngData(100);
+    appendPngChunk(png, "tEXt", {'a', 0, 'b'}); // after IEND, not indexed
+    MemIo io(png.data(), static_cast<long>(png.size()));
+    ASSERT_TRUE(isPngType(io, true));
+
+    Internal::PngChunkIndex index(io);
+    index.readAll(io);
+    const auto& chunks = index.chunks();
+    ASSERT_EQ(3u, chunks.size());
+    EXPECT_EQ("IHDR", chunks[0].type_);
+    EXPECT_EQ(8, chunks[0].offset_);
+    EXPECT_EQ(13u, chunks[0].length_);
+    EXPECT_EQ("IDAT", chunks[1].type_);
+    EXPECT_EQ(chunks[0].offset_ + chunks[0].size(), chunks[1].offset_);
+    EXPECT_EQ(100u, chunks[1].length_);
+    EXPECT_EQ("IEND", chunks[2].type_);
+    EXPECT_EQ(12, chunks[2].size());
+    // Only files can be checked for changes
+    EXPECT_FALSE(index.isCurrent(io));
+}
+
+TEST(PngChunkIndex, throwsIfAChunkExceedsTheData)
+{
+    std::vector<byte> png = pngData(100);
+    png.resize(png.size() - 30);
+    MemIo io(png.data(), static_cast<long>(png.size()));
+    ASSERT_TRUE(isPngType(io, true));
+
+    Internal::PngChunkIndex index(io);
+    ASSERT_THROW(index.readAll(io), Exiv2::Error);
+}
+
+TEST(PngImage, copiesLargeChunksUnchangedWhenWritingMetadata)
+{
+    const std::vector<byte> png = pngData(300 * 1024);
+    const TemporaryFile temp(".png");
+    const std::string& path = temp.path();
+    {
+        FileIo file(path);
+        ASSERT_EQ(0, file.open("wb"));
+        ASSERT_EQ(static_cast<long>(png.size()), file.write(png.data(), static_cast<long>(png.size())));
+    }
+    {
+        PngImage image(std::make_unique<FileIo>(path), false);
+        image.readMetadata();
+        image.setComment("Exiv2");
+        image.writeMetadata();
+    }
+
+    std::vector<byte> written;
+    {
+        FileIo file(path);
+        ASSERT_EQ(0, file.open());
+        written.resize(file.size());
+        ASSERT_EQ(static_cast<long>(written.size()), file.read(written.data(), static_cast<long>(written.size())));
+    }
+    // The IDAT and IEND chunks follow the new comment chunk unchanged
+    const size_t tail = png.size() - 33;
+    ASSERT_GT(written.size(), png.size());
+    EXPECT_TRUE(std::equal(png.begin(), png.begin() + 33, written.begin()));
+    EXPECT_TRUE(std::equal(png.end() - tail, png.end(), written.end() - tail));
+
+    PngImage image(std::make_unique<FileIo>(path), false);
+    image.readMetadata();
+    EXPECT_EQ("Exiv2", image.comment());
+}
+
+TEST(PngImage, keepsTheCompressedIccProfileWhileItIsUnchanged)
+{
+    std::vector<byte> profile(64 * 1024);
+    for (size_t i = 0; i < profile.size(); ++i) {
+        profile[i] = static_cast<byte>(i % 251 + i / 4096);
+    }
+    // Compressed with another level than the one Exiv2 uses
+    std::vector<byte> iccp = {'I', 'C', 'C', ' ', 'p', 'r', 'o', 'f', 'i', 'l', 'e', 0, 0};
+    uLongf compressedSize = compressBound(static_cast<uLong>(profile.size()));
+    std::vector<byte> compressed(compressedSize);
+    ASSERT_EQ(Z_OK, compress2(compressed.data(), &compressedSize, profile.data(), static_cast<uLong>(profile.size()),
+                              Z_BEST_SPEED));
+    iccp.insert(iccp.end(), compressed.begin(), compressed.begin() + compressedSize);
+
+    std::vector<byte> png = {0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A};
+    appendPngChunk(png, "IHDR", {0, 0, 0, 1, 0, 0, 0, 1, 8, 0, 0, 0, 0});
+    appendPngChunk(png, "iCCP", iccp);
+    appendPngChunk(png, "IDAT", {1, 2, 3});
+    appendPngChunk(png, "IEND", {});
+
+    PngImage image(std::make_unique<MemIo>(png.data(), static_cast<long>(png.size())), false);
+    image.readMetadata();
+    ASSERT_EQ(profile.size(), image.iccProfile().size());
+    EXPECT_TRUE(std::equal(profile.begin(), profile.end(), image.iccProfile().c_data()));
+
+    // Writing a comment copies the compressed profile
+    image.setComment("Exiv2");
+    image.writeMetadata();
+    {
+        const std::string written(reinterpret_cast<const char*>(image.io().mmap()), image.io().size());
+        image.io().munmap();
+        std::string chunk("iCCP");
+        chunk.append(iccp.begin(), iccp.end());
+        EXPECT_NE(std::string::npos, written.find(chunk));
+    }
+
+    // A new profile is compressed again
+    profile[0] ^= 0xFF;
+    image.setIccProfile(DataBuf(profile.data(), static_cast<long>(profile.size())), false);
+    image.writeMetadata();
+    PngImage result(std::make_unique<MemIo>(image.io().mmap(), image.io().size()), false);
+    result.readMetadata();
+    image.io().munmap();
+    ASSERT_EQ(profile.size(), result.iccProfile().size());
+    EXPECT_TRUE(std::equal(profile.begin(), profile.end(), result.iccProfile().c_data()));
+    EXPECT_EQ("Exiv2", result.comment());
+}
 
 TEST(PngImage, canBeCreatedFromScratch)
 {
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/iptc.hpp>
+#include <exiv2/psdimage.hpp>
+#include <exiv2/xmp_exiv2.hpp>
+#include "psdimage_int.hpp" // This is not part of the public API
+#include "testhelpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+using namespace Exiv2::Test;
+using Exiv2::Internal::PsdResourceIndex;
+
+namespace {
+    //! Offset of the length of the image resources section in the images of psdData()
+    const long resourcesOffset = 30;
+
+    //! A Photoshop image with the resource blocks \em resources, followed by \em imageSize bytes of image data
+    std::vector<byte> psdData(const std::vector<byte>& resources, size_t imageSize)
+    {
+        std::vector<byte> psd = {'8', 'B', 'P', 'S', 0, 1, 0, 0, 0, 0, 0, 0, 0, 3,
+                                 0, 0, 0, 20, 0, 0, 0, 10, 0, 8, 0, 3,
+                                 0, 0, 0, 0};  // No color mode data
+        append32(psd, static_cast<uint32_t>(resources.size()));
+        psd.insert(psd.end(), resources.begin(), resources.end());
+        const Blob image = imageData(imageSize, 7);
+        psd.insert(psd.end(), image.begin(), image.end());
+        return psd;
+    }
+
+    //! A Photoshop image with a resolution info block, an XMP packet and a clipping path name
+    std::vector<byte> psdWithXmp(size_t imageSize)
+    {
+        std::vector<byte> resources;
+        appendResource(resources, 0x03ed, "", std::vector<byte>(16, 0x11));
+        const std::string xmp =
+            "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+            "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+            "<rdf:Description rdf:about=\"\" xmlns:dc=\"http://purl.org/dc/elements/1.1/\" dc:format=\"image/x-photoshop\"/>"
+            "</rdf:RDF></x:xmpmeta>";
+        appendResource(resources, 0x0424, "", std::vector<byte>(xmp.begin(), xmp.end()));
+        appendResource(resources, 0x0bb7, "Path", std::vector<byte>(5, 0x22));
+        return psdData(resources, imageSize);
+    }
+
+    //! Return the resource blocks of the Photoshop image \em psd
+    std::vector<PsdResourceIndex::Entry> resources(const std::vector<byte>& psd)
+    {
+        MemIo io(psd.data(), static_cast<long>(psd.size()));
+        PsdResourceIndex index(io, resourcesOffset + 4, getULong(psd.data() + resourcesOffset, bigEndian));
+        io.seek(resourcesOffset + 4, BasicIo::beg);
+        index.readAll(io);
+        return index.resources();
+    }
+
+    //! Return the IDs of \em resources
+    std::vector<uint16_t> ids(const std::vector<PsdResourceIndex::Entry>& resources)
+    {
+        std::vector<uint16_t> result;
+        for (auto&& resource : resources) result.push_back(resource.id_);
+        return result;
+    }
+}  // namespace
+
+TEST(PsdResourceIndex, indexesAllResourceBlocksOfTheSection)
+{
+    const auto entries = resources(psdWithXmp(100));
+    ASSERT_EQ(3u, entries.size());
+    EXPECT_EQ(0x03ed, entries[0].id_);
+    EXPECT_EQ(34, entries[0].offset_);
+    EXPECT_EQ(0u, entries[0].nameLength_);
+    EXPECT_EQ(16u, entries[0].length_);
+    EXPECT_EQ(28, entries[0].size());
+    EXPECT_EQ(0x0424, entries[1].id_);
+    EXPECT_EQ(62, entries[1].offset_);
+    EXPECT_EQ(0x0bb7, entries[2].id_);
+    EXPECT_EQ(4u, entries[2].nameLength_);
+    EXPECT_EQ(5u, entries[2].length_);
+    EXPECT_EQ(entries[2].offset_ + 16, entries[2].data());
+    EXPECT_EQ(22, entries[2].size());
+}
+
+TEST(PsdResourceIndex, throwsIfABlockExceedsTheSection)
+{
+    std::vector<byte> psd = psdWithXmp(100);
+    ul2Data(psd.data() + 42, 15, bigEndian);  // Length of the resolution info, 16 with padding
+    MemIo io(psd.data(), static_cast<long>(psd.size()));
+    PsdResourceIndex index(io, resourcesOffset + 4, 28);
+    io.seek(resourcesOffset + 4, BasicIo::beg);
+    EXPECT_NO_THROW(index.readAll(io));
+
+    PsdResourceIndex shorter(io, resourcesOffset + 4, 27);
+    io.seek(resourcesOffset + 4, BasicIo::beg);
+    EXPECT_THROW(shorter.readAll(io), Exiv2::Error);
+}
+
+TEST(PsdImage, rewritesOnlyTheChangedResources)
+{
+    const std::vector<byte> psd = psdWithXmp(1024 * 1024 + 1);
+    PsdImage image(std::make_unique<MemIo>(psd.data(), static_cast<long>(psd.size())));
+    image.readMetadata();
+    image.xmpData()["Xmp.dc.title"] = "A title";
+    image.iptcData()["Iptc.Application2.Caption"] = "A caption";
+    image.writeMetadata();
+    EXPECT_EQ(mdIptc | mdXmp, image.writtenMetadata());
+
+    const std::vector<byte> written = contents(image.io());
+    const auto before = resources(psd);
+    const auto after = resources(written);
+    EXPECT_EQ(std::vector<uint16_t>({0x03ed, 0x0404, 0x0424, 0x0bb7}), ids(after));
+
+    // The other blocks and the image data are copied unchanged
+    EXPECT_TRUE(std::equal(psd.begin() + before[0].offset_, psd.begin() + before[0].offset_ + before[0].size(),
+                           written.begin() + after[0].offset_));
+    ASSERT_EQ(psd.size() - before[2].offset_, written.size() - after[3].offset_);
+    EXPECT_TRUE(std::equal(psd.begin() + before[2].offset_, psd.end(), written.begin() + after[3].offset_));
+
+    PsdImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())));
+    result.readMetadata();
+    EXPECT_EQ("lang=\"x-default\" A title", result.xmpData()["Xmp.dc.title"].toString());
+    EXPECT_EQ("A caption", result.iptcData()["Iptc.Application2.Caption"].toString());
+}
+
+TEST(PsdImage, removesTheResourceOfDeletedMetadata)
+{
+    const std::vector<byte> psd = psdWithXmp(1000);
+    PsdImage image(std::make_unique<MemIo>(psd.data(), static_cast<long>(psd.size())));
+    image.readMetadata();
+    image.clearXmpPacket();
+    image.clearXmpData();
+    image.writeMetadata();
+
+    const std::vector<byte> written = contents(image.io());
+    EXPECT_EQ(std::vector<uint16_t>({0x03ed, 0x0bb7}), ids(resources(written)));
+    EXPECT_EQ(psd.size() - resources(psd)[1].size(), written.size());
+}
+
+TEST(PsdImage, doesNotWriteUnchangedMetadata)
+{
+    const std::vector<byte> psd = psdWithXmp(1000);
+    PsdImage image(std::make_unique<MemIo>(psd.data(), static_cast<long>(psd.size())));
+    image.readMetadata();
+    image.writeMetadata();
+    EXPECT_EQ(mdNone, image.writtenMetadata());
+    EXPECT_EQ(psd, contents(image.io()));
+}
@@ -0,0 +1,161 @@
+// ***************************************************************** -*- C++ -*-
+/*
+ * Copyright (C) 2004-2021 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <remotecache_int.hpp>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace Exiv2;
+using namespace Exiv2::Internal;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    class ARemoteBlockCache : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            dir_ = (fs::temp_directory_path() / "exiv2-remotecache-test").string();
+            fs::remove_all(dir_);
+        }
+
+        void TearDown() override
+        {
+            fs::remove_all(dir_);
+        }
+
+        std::string dir_;
+    };
+
+    const byte block[] = {'e', 'x', 'i', 'v', '2', 0, 1, 2};
+}  // namespace
+
+TEST_F(ARemoteBlockCache, missesBlocksWhichWereNotStored)
+{
+    RemoteBlockCache cache(dir_, 1024);
+    cache.setKey("http://localhost/a.jpg", sizeof(block));
+    ASSERT_EQ(0, cache.load(0, sizeof(block)).size());
+    ASSERT_EQ(0U, cache.hits());
+    ASSERT_EQ(1U, cache.misses());
+}
+
+TEST_F(ARemoteBlockCache, returnsStoredBlocksAcrossInstances)
+{
+    {
+        RemoteBlockCache cache(dir_, 1024);
+        cache.setKey("http://localhost/a.jpg", sizeof(block));
+        cache.store(3, block, sizeof(block));
+    }
+    RemoteBlockCache cache(dir_, 1024);
+    cache.setKey("http://localhost/a.jpg", sizeof(block));
+    DataBuf buf = cache.load(3, sizeof(block));
+    ASSERT_EQ(static_cast<long>(sizeof(block)), buf.size());
+    ASSERT_EQ(0, buf.cmpBytes(0, block, sizeof(block)));
+    ASSERT_EQ(1U, cache.hits());
+    ASSERT_EQ(0U, cache.misses());
+}
+
+TEST_F(ARemoteBlockCache, ignoresBlocksOfOtherKeysAndSizes)
+{
+    RemoteBlockCache cache(dir_, 1024);
+    cache.setKey("http://localhost/a.jpg\netag:\"1\"", sizeof(block));
+    cache.store(0, block, sizeof(block));
+    ASSERT_EQ(0, cache.load(0, sizeof(block) - 1).size());
+    cache.setKey("http://localhost/a.jpg\netag:\"2\"", sizeof(block));
+    ASSERT_EQ(0, cache.load(0, sizeof(block)).size());
+    ASSERT_EQ(2U, cache.misses());
+}
+
+TEST_F(ARemoteBlockCache, packsTheBlocksOfAResourceIntoOneFile)
+{
+    RemoteBlockCache cache(dir_, 1024);
+    cache.setKey("http://localhost/a.jpg", sizeof(block));
+    for (size_t i = 0; i < 10; ++i) {
+        cache.store(i, block, sizeof(block));
+    }
+    cache.evict();
+
+    size_t files = 0;
+    for (auto&& entry : fs::directory_iterator(dir_)) {
+        (void)entry;
+        ++files;
+    }
+    ASSERT_EQ(2U, files);  // The data file and the manifest
+    ASSERT_TRUE(fs::exists(cache.dataPath()));
+    ASSERT_TRUE(fs::exists(cache.manifestPath()));
+}
+
+TEST_F(ARemoteBlockCache, ignoresBlocksWhichDoNotMatchTheirHash)
+{
+    RemoteBlockCache cache(dir_, 1024);
+    cache.setKey("http://localhost/a.jpg", sizeof(block));
+    cache.store(1, block, sizeof(block));
+    {
+        std::fstream file(cache.dataPath(), std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(8 + sizeof(block) + 8 + 2);  // A byte of the data of block 1
+        file.put('X');
+    }
+    ASSERT_EQ(0, cache.load(1, sizeof(block)).size());
+    ASSERT_EQ(0, cache.load(0, sizeof(block)).size());  // Never stored, a hole in the file
+    ASSERT_EQ(2U, cache.misses());
+}
+
+TEST_F(ARemoteBlockCache, countsABlockWhichIsStoredAgainOnce)
+{
+    RemoteBlockCache cache(dir_, 2 * (8 + sizeof(block)));
+    cache.setKey("http://localhost/a.jpg", sizeof(block));
+    for (int i = 0; i < 3; ++i) {
+        cache.store(0, block, sizeof(block));
+    }
+    cache.store(1, block, sizeof(block));
+    ASSERT_EQ(static_cast<long>(sizeof(block)), cache.load(1, sizeof(block)).size());
+    cache.store(2, block, sizeof(block));  // Over the limit
+    ASSERT_EQ(0, cache.load(2, sizeof(block)).size());
+}
+
+TEST_F(ARemoteBlockCache, evictsLeastRecentlyUsedResources)
+{
+    {
+        RemoteBlockCache cache(dir_, 2 * (8 + sizeof(block)));
+        cache.setKey("http://localhost/a.jpg", sizeof(block));
+        cache.store(0, block, sizeof(block));
+        cache.setKey("http://localhost/b.jpg", sizeof(block));
+        cache.store(0, block, sizeof(block));
+        cache.evict();
+    }
+    RemoteBlockCache cache(dir_, 2 * (8 + sizeof(block)));
+    cache.setKey("http://localhost/a.jpg", sizeof(block));  // Uses a.jpg again
+    const std::string a = cache.dataPath();
+    cache.setKey("http://localhost/b.jpg", sizeof(block));
+    const std::string b = cache.dataPath();
+    cache.setKey("http://localhost/a.jpg", sizeof(block));
+    cache.setKey("http://localhost/c.jpg", sizeof(block));
+    cache.store(0, block, sizeof(block));
+    cache.evict();
+
+    ASSERT_TRUE(fs::exists(a));
+    ASSERT_FALSE(fs::exists(b));
+    ASSERT_TRUE(fs::exists(cache.dataPath()));
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <exiv2/value.hpp>
+
+#include "tags_int.hpp" // This is not part of the public API
+
+#include <sstream>
+#include <string>
+
+using namespace Exiv2;
+using namespace Exiv2::Internal;
+
+namespace {
+    //! Unsorted table with several entries for some values, like the lens tables
+    constexpr TagDetails testLenses[] = {
+        {7, "Seven"}, {-1, "Minus one"}, {3, "Three a"}, {42, "Forty-two"}, {3, "Three b"},
+        {0, "Zero"},  {7, "Seven b"},    {3, "Three c"}, {1, "One"},
+    };
+
+    constexpr auto testIndex = sortTagDetails(testLenses);
+    using TestIndex = EXV_TAG_DETAILS_INDEX(testLenses);
+    static_assert(testLenses[testIndex[0]].val_ == -1, "The index is sorted at compile time");
+
+    std::string printed(long value)
+    {
+        std::ostringstream os;
+        EXV_PRINT_TAG(testLenses)(os, value, nullptr);
+        return os.str();
+    }
+}  // namespace
+
+TEST(ATagDetailsIndex, sortsEntriesByValueAndKeepsTheTableOrder)
+{
+    const uint16_t expected[] = {1, 5, 8, 2, 4, 7, 0, 6, 3};
+    ASSERT_EQ(EXV_COUNTOF(expected), testIndex.size());
+    for (size_t i = 0; i < testIndex.size(); ++i) {
+        EXPECT_EQ(expected[i], testIndex[i]);
+    }
+}
+
+TEST(ATagDetailsIndex, findsTheFirstEntryLikeALinearSearch)
+{
+    for (long value = -3; value < 50; ++value) {
+        EXPECT_EQ(find(testLenses, value), TestIndex::find(value)) << value;
+    }
+    EXPECT_EQ("Three a", printed(3));
+    EXPECT_EQ("Minus one", printed(-1));
+    EXPECT_EQ("(5)", printed(5));
+    EXPECT_EQ("(43)", printed(43));
+}
+
+TEST(ATagDetailsIndex, returnsAllEntriesWithAValueInTableOrder)
+{
+    std::string labels;
+    const auto range = TestIndex::equalRange(3);
+    for (auto pos = range.first; pos != range.second; ++pos) {
+        labels += testLenses[*pos].label_;
+        labels += ";";
+    }
+    EXPECT_EQ("Three a;Three b;Three c;", labels);
+
+    const auto none = TestIndex::equalRange(2);
+    EXPECT_EQ(none.first, none.second);
+}
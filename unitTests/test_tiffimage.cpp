@@ -0,0 +1,298 @@
+#include <gtest/gtest.h>
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/exif.hpp>
+#include <exiv2/image.hpp>
+#include <exiv2/tiffimage.hpp>
+
+#include "tiffimage_int.hpp" // This is not part of the public API
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+using namespace Exiv2;
+using namespace Exiv2::Internal;
+
+namespace fs = std::filesystem;
+
+namespace {
+    const std::string testData(TESTDATA_PATH);
+
+    //! TIFF data with a Nikon makernote and a thumbnail, encoded from the Exif data of a JPEG
+    Blob nikonTiffData()
+    {
+        auto image = ImageFactory::open(testData + "/exiv2-nikon-d70.jpg");
+        image->readMetadata();
+        Blob blob;
+        ExifParser::encode(blob, littleEndian, image->exifData());
+        return blob;
+    }
+
+    //! Decode \em data, keep the parsed tree and overwrite \em data, as if it was unmapped
+    std::unique_ptr<TiffParsedTree> parseAndDiscard(Blob& data, ExifData& exifData)
+    {
+        IptcData iptcData;
+        XmpData xmpData;
+        TiffComponent::UniquePtr rootDir;
+        TiffParserWorker::decode(exifData, iptcData, xmpData, data.data(), static_cast<uint32_t>(data.size()),
+                                 Tag::root, TiffMapping::findDecoder, nullptr, &rootDir);
+        auto tree = std::make_unique<TiffParsedTree>(std::move(rootDir), data.data(),
+                                                     static_cast<uint32_t>(data.size()), fs::file_time_type());
+        std::fill(data.begin(), data.end(), 0);
+        return tree;
+    }
+
+    //! Write \em data to a file in the temporary directory and return its path
+    std::string writeTempFile(const std::string& name, const Blob& data)
+    {
+        const std::string path = (fs::temp_directory_path() / ("exiv2-test-" + name)).string();
+        FileIo file(path);
+        if (file.open("wb") == 0) {
+            file.write(data.data(), static_cast<long>(data.size()));
+        }
+        return path;
+    }
+
+    //! Return the keys and values of \em exifData, one per line
+    std::string listed(const ExifData& exifData)
+    {
+        std::string list;
+        for (auto&& datum : exifData) {
+            list += datum.key() + " " + datum.value().toString() + " " + std::to_string(datum.sizeDataArea()) + "\n";
+        }
+        return list;
+    }
+
+    //! Encode \em exifData into \em data, optionally with a tree parsed before
+    WriteMethod encode(MemIo& io, Blob& data, const ExifData& exifData, TiffComponent::UniquePtr parsedTree)
+    {
+        TiffHeader header(littleEndian);
+        return TiffParserWorker::encode(io, data.data(), static_cast<uint32_t>(data.size()), exifData, IptcData(),
+                                        XmpData(), Tag::root, TiffMapping::findEncoder, &header, nullptr,
+                                        std::move(parsedTree));
+    }
+}  // namespace
+
+TEST(ATiffParsedTree, writesInPlaceLikeAFreshlyParsedTree)
+{
+    const Blob original = nikonTiffData();
+    Blob parsed = original;
+    ExifData exifData;
+    auto tree = parseAndDiscard(parsed, exifData);
+    exifData["Exif.Image.Orientation"] = static_cast<uint16_t>(8);
+
+    Blob reused = original;
+    auto rootDir = tree->take(reused.data(), static_cast<uint32_t>(reused.size()), fs::file_time_type());
+    ASSERT_NE(nullptr, rootDir);
+    MemIo reusedIo;
+    EXPECT_EQ(wmNonIntrusive, encode(reusedIo, reused, exifData, std::move(rootDir)));
+
+    Blob fresh = original;
+    MemIo freshIo;
+    EXPECT_EQ(wmNonIntrusive, encode(freshIo, fresh, exifData, nullptr));
+
+    EXPECT_NE(original, fresh);
+    EXPECT_EQ(fresh, reused);
+}
+
+TEST(ATiffParsedTree, copiesImageDataLikeAFreshlyParsedTree)
+{
+    const Blob original = nikonTiffData();
+    Blob parsed = original;
+    ExifData exifData;
+    auto tree = parseAndDiscard(parsed, exifData);
+    // A new tag requires a new TIFF structure
+    exifData["Exif.Image.Artist"] = "Exiv2";
+
+    Blob reused = original;
+    MemIo reusedIo;
+    EXPECT_EQ(wmIntrusive,
+              encode(reusedIo, reused, exifData,
+                     tree->take(reused.data(), static_cast<uint32_t>(reused.size()), fs::file_time_type())));
+
+    Blob fresh = original;
+    MemIo freshIo;
+    EXPECT_EQ(wmIntrusive, encode(freshIo, fresh, exifData, nullptr));
+
+    ASSERT_EQ(freshIo.size(), reusedIo.size());
+    EXPECT_EQ(0, std::memcmp(freshIo.mmap(), reusedIo.mmap(), freshIo.size()));
+}
+
+TEST(ATiffParsedTree, isOnlyReturnedOnceAndForTheSameFile)
+{
+    Blob data = nikonTiffData();
+    const auto size = static_cast<uint32_t>(data.size());
+    const auto mtime = fs::file_time_type() + std::chrono::seconds(1);
+    ExifData exifData;
+    TiffParsedTree tree(nullptr, data.data(), size, mtime);
+    EXPECT_EQ(nullptr, tree.take(data.data(), size, mtime));
+
+    auto parsed = parseAndDiscard(data, exifData);
+    TiffParsedTree changed(parsed->take(data.data(), size, fs::file_time_type()), data.data(), size, mtime);
+    EXPECT_EQ(nullptr, changed.take(data.data(), size - 1, mtime));
+    EXPECT_EQ(nullptr, changed.take(data.data(), size, fs::file_time_type()));
+    EXPECT_NE(nullptr, changed.take(data.data(), size, mtime));
+    EXPECT_EQ(nullptr, changed.take(data.data(), size, mtime));
+}
+
+TEST(ATiffImage, writesMetadataWithTheTreeRetainedFromReading)
+{
+    const std::string path = (fs::temp_directory_path() / "exiv2-test-retained-tree.tif").string();
+    fs::copy_file(testData + "/Reagan.tiff", path, fs::copy_options::overwrite_existing);
+    {
+        auto image = ImageFactory::open(path);
+        auto tiff = dynamic_cast<TiffImage*>(image.get());
+        ASSERT_NE(nullptr, tiff);
+        tiff->retainParsedTree(true);
+        image->readMetadata();
+        image->exifData()["Exif.Image.Orientation"] = static_cast<uint16_t>(8);
+        image->writeMetadata();
+        // The retained tree is gone after writing, the next write parses again
+        image->exifData()["Exif.Image.Artist"] = "Exiv2";
+        image->writeMetadata();
+    }
+    auto image = ImageFactory::open(path);
+    image->readMetadata();
+    EXPECT_EQ(8, image->exifData()["Exif.Image.Orientation"].toLong());
+    EXPECT_EQ("Exiv2", image->exifData()["Exif.Image.Artist"].toString());
+    fs::remove(path);
+}
+
+TEST(ATiffImage, ignoresTheRetainedTreeIfTheFileChanged)
+{
+    const std::string path = (fs::temp_directory_path() / "exiv2-test-changed-tree.tif").string();
+    fs::copy_file(testData + "/Reagan.tiff", path, fs::copy_options::overwrite_existing);
+    {
+        auto image = ImageFactory::open(path);
+        dynamic_cast<TiffImage&>(*image).retainParsedTree(true);
+        image->readMetadata();
+        // Replace the file with a different image behind the back of the Image
+        fs::copy_file(testData + "/mini9.tif", path, fs::copy_options::overwrite_existing);
+        image->exifData()["Exif.Image.Artist"] = "Exiv2";
+        image->writeMetadata();
+    }
+    auto image = ImageFactory::open(path);
+    image->readMetadata();
+    EXPECT_EQ("Exiv2", image->exifData()["Exif.Image.Artist"].toString());
+    fs::remove(path);
+}
+
+TEST(ATiffEncoder, marksEncodedEntriesWithoutChangingTheExifData)
+{
+    Blob data = nikonTiffData();
+    Blob parsed = data;
+    ExifData exifData;
+    parseAndDiscard(parsed, exifData);
+    const long count = exifData.count();
+
+    // Every entry, including makernote tags, finds its component
+    MemIo io;
+    EXPECT_EQ(wmNonIntrusive, encode(io, data, exifData, nullptr));
+    EXPECT_EQ(count, exifData.count());
+}
+
+TEST(ATiffEncoder, addsTagsSynthesizedFromIptcData)
+{
+    Blob data = nikonTiffData();
+    Blob parsed = data;
+    ExifData exifData;
+    parseAndDiscard(parsed, exifData);
+    const long count = exifData.count();
+    IptcData iptcData;
+    iptcData["Iptc.Application2.Headline"] = "Exiv2";
+
+    MemIo io;
+    TiffHeader header(littleEndian);
+    EXPECT_EQ(wmIntrusive, TiffParserWorker::encode(io, data.data(), static_cast<uint32_t>(data.size()), exifData,
+                                                    iptcData, XmpData(), Tag::root, TiffMapping::findEncoder,
+                                                    &header, nullptr));
+    EXPECT_EQ(count, exifData.count());
+
+    ExifData decoded;
+    IptcData decodedIptc;
+    XmpData decodedXmp;
+    TiffParserWorker::decode(decoded, decodedIptc, decodedXmp, io.mmap(), static_cast<uint32_t>(io.size()), Tag::root,
+                             TiffMapping::findDecoder);
+    EXPECT_NE(decoded.end(), decoded.findKey(ExifKey("Exif.Image.IPTCNAA")));
+    EXPECT_EQ("Exiv2", decodedIptc["Iptc.Application2.Headline"].toString());
+}
+
+TEST(ATiffSource, readsWindowsOfAFile)
+{
+    Blob data(200 * 1024);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<byte>(i / 7);
+    }
+    const std::string path = writeTempFile("tiffsource", data);
+    {
+        FileIo io(path);
+        ASSERT_EQ(0, io.open());
+        TiffSource source(io);
+        EXPECT_EQ(nullptr, source.buffer());
+        ASSERT_EQ(data.size(), source.size());
+
+        // Within a window, and spanning two windows
+        const byte* p = source.data(100, 12);
+        ASSERT_NE(nullptr, p);
+        EXPECT_EQ(0, std::memcmp(p, &data[100], 12));
+        const byte* q = source.data(64 * 1024 - 5, 12);
+        ASSERT_NE(nullptr, q);
+        EXPECT_EQ(0, std::memcmp(q, &data[64 * 1024 - 5], 12));
+        EXPECT_EQ(12u, source.available(q));
+
+        uint32_t offset = 0;
+        EXPECT_TRUE(source.offset(p + 4, offset));
+        EXPECT_EQ(104u, offset);
+        EXPECT_TRUE(source.offset(q, offset));
+        EXPECT_EQ(64u * 1024 - 5, offset);
+        EXPECT_FALSE(source.offset(data.data(), offset));
+
+        // The end of the data, but nothing beyond
+        const auto size = static_cast<uint32_t>(data.size());
+        const byte* end = source.data(size, 0);
+        ASSERT_NE(nullptr, end);
+        EXPECT_TRUE(source.offset(end, offset));
+        EXPECT_EQ(size, offset);
+        EXPECT_EQ(0u, source.available(end));
+        EXPECT_EQ(nullptr, source.data(size, 1));
+        EXPECT_EQ(nullptr, source.data(size - 4, 8));
+    }
+    std::remove(path.c_str());
+}
+
+TEST(ATiffSource, usesTheDataOfAMemIoDirectly)
+{
+    const Blob data = nikonTiffData();
+    MemIo io(data.data(), static_cast<long>(data.size()));
+    TiffSource source(io);
+    EXPECT_EQ(io.mmap(), source.buffer());
+    EXPECT_EQ(source.buffer() + 8, source.data(8, 4));
+    EXPECT_EQ(data.size() - 8, source.available(source.buffer() + 8));
+}
+
+TEST(ATiffParserWorker, decodesAFileLikeItsMappedData)
+{
+    const Blob data = nikonTiffData();
+    ExifData mapped;
+    IptcData iptcData;
+    XmpData xmpData;
+    TiffParserWorker::decode(mapped, iptcData, xmpData, data.data(), static_cast<uint32_t>(data.size()), Tag::root,
+                             TiffMapping::findDecoder);
+    ASSERT_NE(mapped.end(), mapped.findKey(ExifKey("Exif.Nikon3.Quality")));
+    ASSERT_NE(mapped.end(), mapped.findKey(ExifKey("Exif.Thumbnail.JPEGInterchangeFormat")));
+
+    const std::string path = writeTempFile("tiffsource.tif", data);
+    ExifData windowed;
+    {
+        FileIo io(path);
+        ASSERT_EQ(0, io.open());
+        EXPECT_EQ(littleEndian, TiffParserWorker::decode(windowed, iptcData, xmpData, io, Tag::root,
+                                                         TiffMapping::findDecoder));
+    }
+    std::remove(path.c_str());
+    EXPECT_EQ(listed(mapped), listed(windowed));
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/exif.hpp>
+#include <exiv2/webpimage.hpp>
+#include <exiv2/xmp_exiv2.hpp>
+#include "webpimage_int.hpp" // This is not part of the public API
+#include "testhelpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Exiv2;
+using namespace Exiv2::Test;
+using Exiv2::Internal::WebPChunkIndex;
+
+namespace {
+    //! A WebP image with a VP8 chunk of \em vp8Size bytes and \em exif and \em xmp, if not empty
+    std::vector<byte> webpData(size_t vp8Size, const Blob& exif, const std::string& xmp)
+    {
+        std::vector<byte> webp = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'E', 'B', 'P'};
+        appendRiffChunk(webp, "VP8X", {0x0c, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+        appendRiffChunk(webp, "VP8 ", imageData(vp8Size, 13));
+        if (!exif.empty()) appendRiffChunk(webp, "EXIF", exif);
+        if (!xmp.empty()) appendRiffChunk(webp, "XMP ", std::vector<byte>(xmp.begin(), xmp.end()));
+        ul2Data(webp.data() + 4, static_cast<uint32_t>(webp.size() - 8), littleEndian);
+        return webp;
+    }
+
+    //! A WebP image with Exif and XMP metadata
+    std::vector<byte> webpWithMetadata(size_t vp8Size)
+    {
+        ExifData exifData;
+        exifData["Exif.Image.Make"] = "Exiv2";
+        exifData["Exif.Image.Artist"] = "An artist with a long name";
+        Blob exif;
+        ExifParser::encode(exif, littleEndian, exifData);
+        return webpData(vp8Size, exif, "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\"/>");
+    }
+
+    //! Return the chunks of the WebP image \em webp
+    std::vector<WebPChunkIndex::Entry> chunks(const std::vector<byte>& webp)
+    {
+        MemIo io(webp.data(), static_cast<long>(webp.size()));
+        WebPChunkIndex index(io, static_cast<long>(getULong(webp.data() + 4, littleEndian) + 8));
+        io.seek(12, BasicIo::beg);
+        index.readAll(io);
+        return index.chunks();
+    }
+
+    //! Return the types of \em chunks
+    std::vector<std::string> types(const std::vector<WebPChunkIndex::Entry>& chunks)
+    {
+        std::vector<std::string> result;
+        for (auto&& chunk : chunks) result.push_back(chunk.type_);
+        return result;
+    }
+}  // namespace
+
+TEST(WebPChunkIndex, indexesAllChunksOfTheContainer)
+{
+    const std::vector<byte> webp = webpData(1001, {}, "<x/>");
+    const auto entries = chunks(webp);
+    ASSERT_EQ(3u, entries.size());
+    EXPECT_EQ("VP8X", entries[0].type_);
+    EXPECT_EQ(12, entries[0].offset_);
+    EXPECT_EQ(10u, entries[0].length_);
+    EXPECT_EQ("VP8 ", entries[1].type_);
+    EXPECT_EQ(30, entries[1].offset_);
+    EXPECT_EQ(1001u, entries[1].length_);
+    EXPECT_EQ(1010, entries[1].size());
+    EXPECT_EQ("XMP ", entries[2].type_);
+    EXPECT_EQ(1040, entries[2].offset_);
+}
+
+TEST(WebPChunkIndex, throwsIfAChunkExceedsTheContainer)
+{
+    std::vector<byte> webp = webpData(100, {}, "");
+    ul2Data(webp.data() + 34, 200, littleEndian);  // Length of the VP8 chunk
+    MemIo io(webp.data(), static_cast<long>(webp.size()));
+    WebPChunkIndex index(io, static_cast<long>(webp.size()));
+    io.seek(12, BasicIo::beg);
+    EXPECT_THROW(index.readAll(io), Exiv2::Error);
+}
+
+TEST(WebPImage, replacesTheExifChunkInPlaceIfItFits)
+{
+    const std::vector<byte> webp = webpWithMetadata(1024 * 1024);
+    auto io = std::make_unique<CountingIo>(webp.data(), static_cast<long>(webp.size()));
+    CountingIo& counter = *io;
+    WebPImage image(std::move(io));
+    image.readMetadata();
+    image.exifData().erase(image.exifData().findKey(ExifKey("Exif.Image.Artist")));
+    counter.bytesRead_ = 0;
+    image.writeMetadata();
+    EXPECT_LT(counter.bytesRead_, 1024);
+    EXPECT_EQ(mdExif, image.writtenMetadata());
+
+    const std::vector<byte> written = contents(image.io());
+    ASSERT_EQ(webp.size(), written.size());
+    EXPECT_EQ(std::vector<std::string>({"VP8X", "VP8 ", "EXIF", "JUNK", "XMP "}), types(chunks(written)));
+
+    WebPImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())));
+    result.readMetadata();
+    EXPECT_EQ("Exiv2", result.exifData()["Exif.Image.Make"].toString());
+    EXPECT_EQ(result.exifData().end(), result.exifData().findKey(ExifKey("Exif.Image.Artist")));
+}
+
+TEST(WebPImage, growsTheLastChunkInPlace)
+{
+    const std::vector<byte> webp = webpWithMetadata(1024 * 1024);
+    auto io = std::make_unique<CountingIo>(webp.data(), static_cast<long>(webp.size()));
+    CountingIo& counter = *io;
+    WebPImage image(std::move(io));
+    image.readMetadata();
+    image.xmpData()["Xmp.dc.title"] = "A title which does not fit into the old XMP chunk";
+    counter.bytesRead_ = 0;
+    image.writeMetadata();
+    EXPECT_LT(counter.bytesRead_, 1024);
+
+    const std::vector<byte> written = contents(image.io());
+    EXPECT_GT(written.size(), webp.size());
+    EXPECT_EQ(written.size(), getULong(written.data() + 4, littleEndian) + 8);
+    EXPECT_EQ(std::vector<std::string>({"VP8X", "VP8 ", "EXIF", "XMP "}), types(chunks(written)));
+    EXPECT_TRUE(std::equal(webp.begin() + 8, webp.begin() + 1024 * 1024, written.begin() + 8));
+
+    WebPImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())));
+    result.readMetadata();
+    EXPECT_EQ("lang=\"x-default\" A title which does not fit into the old XMP chunk",
+              result.xmpData()["Xmp.dc.title"].toString());
+    EXPECT_EQ("Exiv2", result.exifData()["Exif.Image.Make"].toString());
+}
+
+TEST(WebPImage, copiesTheImageDataWhenTheIccProfileChanges)
+{
+    const std::vector<byte> icc = testFile("small.icc");
+    ASSERT_FALSE(icc.empty());
+
+    const std::vector<byte> webp = webpWithMetadata(1024 * 1024 + 1);
+    WebPImage image(std::make_unique<MemIo>(webp.data(), static_cast<long>(webp.size())));
+    image.readMetadata();
+    image.setIccProfile(DataBuf(icc.data(), static_cast<long>(icc.size())));
+    image.writeMetadata();
+
+    const std::vector<byte> written = contents(image.io());
+    const auto entries = chunks(written);
+    EXPECT_EQ(std::vector<std::string>({"VP8X", "ICCP", "VP8 ", "EXIF", "XMP "}), types(entries));
+    EXPECT_EQ(0x2c, written[20]);  // ICC, EXIF and XMP flags
+    const auto vp8 = chunks(webp)[1];
+    EXPECT_TRUE(std::equal(webp.begin() + vp8.offset_, webp.begin() + vp8.offset_ + vp8.size(),
+                           written.begin() + entries[2].offset_));
+
+    WebPImage result(std::make_unique<MemIo>(written.data(), static_cast<long>(written.size())));
+    result.readMetadata();
+    EXPECT_EQ(icc.size(), static_cast<size_t>(result.iccProfile().size()));
+    EXPECT_EQ("Exiv2", result.exifData()["Exif.Image.Make"].toString());
+}
+
+TEST(WebPImage, doesNotWriteUnchangedMetadata)
+{
+    const std::vector<byte> webp = webpWithMetadata(1000);
+    WebPImage image(std::make_unique<MemIo>(webp.data(), static_cast<long>(webp.size())));
+    image.readMetadata();
+    image.writeMetadata();
+    EXPECT_EQ(mdNone, image.writtenMetadata());
+    EXPECT_EQ(webp, contents(image.io()));
+}
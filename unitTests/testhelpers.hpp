@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2004-2022 Exiv2 authors
+ * This program is part of the Exiv2 distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, 5th Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef TESTHELPERS_HPP_
+#define TESTHELPERS_HPP_
+
+// Helpers which build images in memory and watch how they are read, shared by the unit tests
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/types.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Exiv2 {
+    namespace Test {
+
+    //! MemIo which counts the bytes read from it
+    class CountingIo : public MemIo {
+    public:
+        CountingIo(const byte* data, long size) : MemIo(data, size)
+        {
+        }
+        using MemIo::read;
+        long read(byte* buf, long rcount) override
+        {
+            const long n = MemIo::read(buf, rcount);
+            bytesRead_ += n;
+            return n;
+        }
+        long readAt(int64_t offset, byte* buf, long rcount) override
+        {
+            const long n = MemIo::readAt(offset, buf, rcount);
+            bytesRead_ += n;
+            return n;
+        }
+        long bytesRead_{0};
+    };
+
+    //! A file in the temporary directory with a unique name, removed again by the destructor
+    class TemporaryFile {
+    public:
+        explicit TemporaryFile(const std::string& suffix)
+        {
+            std::random_device random;
+            std::ostringstream name;
+            name << "exiv2-test-" << std::hex << random() << random() << suffix;
+            path_ = (std::filesystem::temp_directory_path() / name.str()).string();
+        }
+        ~TemporaryFile()
+        {
+            std::error_code ec;
+            std::filesystem::remove(path_, ec);
+        }
+        TemporaryFile(const TemporaryFile&) = delete;
+        TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+        const std::string& path() const { return path_; }
+
+    private:
+        std::string path_;
+    };
+
+    //! Return the contents of the test file \em name
+    inline Blob testFile(const std::string& name)
+    {
+        std::ifstream file(std::string(TESTDATA_PATH) + "/" + name, std::ios::binary);
+        return Blob(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    //! Return the contents of \em io
+    inline Blob contents(BasicIo& io)
+    {
+        Blob data(io.size());
+        io.open();
+        io.read(data.data(), static_cast<long>(data.size()));
+        io.close();
+        return data;
+    }
+
+    /*!
+      @brief Return \em size bytes of image data, which don't repeat within a
+             few thousand bytes. The data is different for each \em seed.
+     */
+    inline Blob imageData(size_t size, size_t seed)
+    {
+        Blob data(size);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<byte>(i * seed + i / 1000);
+        }
+        return data;
+    }
+
+    //! Append \em value to \em data in \em byteOrder
+    inline void append16(Blob& data, uint16_t value, ByteOrder byteOrder = bigEndian)
+    {
+        byte buf[2];
+        us2Data(buf, value, byteOrder);
+        data.insert(data.end(), buf, buf + 2);
+    }
+
+    //! Append \em value to \em data in \em byteOrder
+    inline void append32(Blob& data, uint32_t value, ByteOrder byteOrder = bigEndian)
+    {
+        byte buf[4];
+        ul2Data(buf, value, byteOrder);
+        data.insert(data.end(), buf, buf + 4);
+    }
+
+    //! Append a PNG chunk of \em type with \em data to \em png, with a dummy CRC
+    inline void appendPngChunk(Blob& png, const char* type, const Blob& data)
+    {
+        append32(png, static_cast<uint32_t>(data.size()));
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        png.insert(png.end(), 4, 0x55);
+    }
+
+    //! Append a RIFF chunk of \em type with \em data to \em webp, padded to an even size
+    inline void appendRiffChunk(Blob& webp, const char* type, const Blob& data)
+    {
+        webp.insert(webp.end(), type, type + 4);
+        append32(webp, static_cast<uint32_t>(data.size()), littleEndian);
+        webp.insert(webp.end(), data.begin(), data.end());
+        if (data.size() % 2) webp.push_back(0);
+    }
+
+    //! Append a BMFF box of \em type with \em payload to \em data
+    inline void appendBox(Blob& data, const char* type, const Blob& payload)
+    {
+        append32(data, static_cast<uint32_t>(8 + payload.size()));
+        data.insert(data.end(), type, type + 4);
+        data.insert(data.end(), payload.begin(), payload.end());
+    }
+
+    //! Append a Photoshop image resource block \em id named \em name with \em data to \em psd
+    inline void appendResource(Blob& psd, uint16_t id, const std::string& name, const Blob& data)
+    {
+        psd.insert(psd.end(), {'8', 'B', 'I', 'M'});
+        append16(psd, id);
+        psd.push_back(static_cast<byte>(name.size()));
+        psd.insert(psd.end(), name.begin(), name.end());
+        if (name.size() % 2 == 0) psd.push_back(0);
+        append32(psd, static_cast<uint32_t>(data.size()));
+        psd.insert(psd.end(), data.begin(), data.end());
+        if (data.size() % 2) psd.push_back(0);
+    }
+
+}}                                      // namespace Test, Exiv2
+
+#endif                                  // #ifndef TESTHELPERS_HPP_